@@ -424,6 +424,8 @@ gst_cc_converter_fixate_caps (GstBaseTransform * base,
   return outcaps;
 }
 
+static gboolean gst_cc_converter_setup_conversion (GstCCConverter * self);
+
 static gboolean
 gst_cc_converter_set_caps (GstBaseTransform * base, GstCaps * incaps,
     GstCaps * outcaps)
@@ -449,6 +451,9 @@ gst_cc_converter_set_caps (GstBaseTransform * base, GstCaps * incaps,
           &self->out_fps_d))
     self->out_fps_n = self->out_fps_d = 0;
 
+  if (!gst_cc_converter_setup_conversion (self))
+    goto invalid_caps;
+
   gst_video_time_code_clear (&self->current_output_timecode);
 
   /* Caps can be different but we can passthrough as long as they can
@@ -491,6 +496,33 @@ static const struct cdp_fps_entry cdp_fps_table[] = {
   {0x8f, 60, 1, 10, 9, 1},
 };
 static const struct cdp_fps_entry null_fps_entry = { 0, 0, 0, 0 };
+/* Limits used when there's no CDP on either side of the conversion */
+static const struct cdp_fps_entry non_cdp_fps_entry = { 0, 0, 0, 25, 22, 3 };
+
+/* The amount of queued data that goes into one output frame */
+struct cc_frame
+{
+  guint ccp_len;
+  guint cea608_1_len;
+  guint cea608_2_len;
+  /* drop everything else that is queued once the frame is written */
+  gboolean discard_rest;
+};
+
+struct _GstCCConverterFormat
+{
+  GstVideoCaptionType caption_type;
+  /* whether the format can carry field 2 CEA608 and CEA708 ccp data */
+  gboolean has_cea608_2;
+  gboolean has_ccp;
+
+  /* queues the data of one input frame, may update @fps_entry from the data */
+  void (*read) (GstCCConverter * self, const guint8 * data, guint len,
+      GstVideoTimeCode * tc, const struct cdp_fps_entry ** fps_entry);
+  /* writes @frame from the front of the queues, returns the written size */
+  guint (*write) (GstCCConverter * self, const struct cc_frame * frame,
+      const struct cdp_fps_entry * fps_entry, guint8 * out, guint out_size);
+};
 
 static const struct cdp_fps_entry *
 cdp_fps_entry_from_id (guint8 id)
@@ -717,40 +749,77 @@ cc_data_extract_cea608 (guint8 * cc_data, guint cc_data_len,
   return i * 3;
 }
 
+/* Appends @len bytes of @data to one of the queues, dropping what doesn't
+ * fit anymore. @unit is the size of one entry of the queue */
 static void
-store_cc_data (GstCCConverter * self, const guint8 * ccp_data,
+queue_append (GstCCConverter * self, const gchar * name, guint8 * queue,
+    guint * queue_len, guint queue_size, guint unit, const guint8 * data,
+    guint len)
+{
+  if (*queue_len + len > queue_size) {
+    guint avail = queue_size - *queue_len;
+
+    avail -= avail % unit;
+    GST_WARNING_OBJECT (self, "Too much pending %s data, dropping %u bytes",
+        name, len - avail);
+    len = avail;
+  }
+
+  memcpy (&queue[*queue_len], data, len);
+  *queue_len += len;
+}
+
+/* Queues the data of one input frame. Data that can't be carried by the
+ * output format is dropped right away */
+static void
+queue_push (GstCCConverter * self, const guint8 * ccp_data,
     guint ccp_data_len, const guint8 * cea608_1, guint cea608_1_len,
     const guint8 * cea608_2, guint cea608_2_len)
 {
-  GST_DEBUG_OBJECT (self, "holding data of len ccp:%u, cea608 1:%u, "
-      "cea608 2:%u until next input buffer", ccp_data_len, cea608_1_len,
-      cea608_2_len);
+  const GstCCConverterFormat *out_format = self->out_format;
+
+  GST_LOG_OBJECT (self, "queueing data of len ccp:%u, cea608 1:%u, "
+      "cea608 2:%u", out_format->has_ccp ? ccp_data_len : 0, cea608_1_len,
+      out_format->has_cea608_2 ? cea608_2_len : 0);
+
+  if (out_format->has_ccp && ccp_data_len > 0)
+    queue_append (self, "ccp", self->queue_ccp, &self->queue_ccp_len,
+        sizeof (self->queue_ccp), 3, ccp_data, ccp_data_len);
+  if (cea608_1_len > 0)
+    queue_append (self, "cea608 field 1", self->queue_cea608_1,
+        &self->queue_cea608_1_len, sizeof (self->queue_cea608_1), 2,
+        cea608_1, cea608_1_len);
+  if (out_format->has_cea608_2 && cea608_2_len > 0)
+    queue_append (self, "cea608 field 2", self->queue_cea608_2,
+        &self->queue_cea608_2_len, sizeof (self->queue_cea608_2), 2,
+        cea608_2, cea608_2_len);
+}
 
-  if (ccp_data && ccp_data_len > 0) {
-    memcpy (self->scratch_ccp, ccp_data, ccp_data_len);
-    self->scratch_ccp_len = ccp_data_len;
-  } else {
-    self->scratch_ccp_len = 0;
-  }
-  g_assert_cmpint (self->scratch_ccp_len, <, sizeof (self->scratch_ccp));
+static void
+queue_drop_front (guint8 * queue, guint * queue_len, guint len)
+{
+  g_assert_cmpint (len, <=, *queue_len);
 
-  if (cea608_1 && cea608_1_len > 0) {
-    memcpy (self->scratch_cea608_1, cea608_1, cea608_1_len);
-    self->scratch_cea608_1_len = cea608_1_len;
-  } else {
-    self->scratch_cea608_1_len = 0;
-  }
-  g_assert_cmpint (self->scratch_cea608_1_len, <,
-      sizeof (self->scratch_cea608_1));
+  *queue_len -= len;
+  memmove (queue, &queue[len], *queue_len);
+}
 
-  if (cea608_2 && cea608_2_len > 0) {
-    memcpy (self->scratch_cea608_2, cea608_2, cea608_2_len);
-    self->scratch_cea608_2_len = cea608_2_len;
-  } else {
-    self->scratch_cea608_2_len = 0;
+/* Removes the data written for @frame from the queues */
+static void
+queue_pop (GstCCConverter * self, const struct cc_frame *frame)
+{
+  if (frame->discard_rest) {
+    self->queue_ccp_len = 0;
+    self->queue_cea608_1_len = 0;
+    self->queue_cea608_2_len = 0;
+    return;
   }
-  g_assert_cmpint (self->scratch_cea608_2_len, <,
-      sizeof (self->scratch_cea608_2));
+
+  queue_drop_front (self->queue_ccp, &self->queue_ccp_len, frame->ccp_len);
+  queue_drop_front (self->queue_cea608_1, &self->queue_cea608_1_len,
+      frame->cea608_1_len);
+  queue_drop_front (self->queue_cea608_2, &self->queue_cea608_2_len,
+      frame->cea608_2_len);
 }
 
 static gboolean
@@ -860,39 +929,33 @@ combine_cc_data (GstCCConverter * self, gboolean pad_cea608,
   return TRUE;
 }
 
-/* takes cc_data cea608_1, cea608_2 and attempts to fit it into a hypothetical
- * output packet.  Any leftover data is stored for later addition.  Returns
- * whether any output can be generated. @ccp_data_len, @cea608_1_len,
- * @cea608_2_len are also updated to reflect the size of that data to add to
- * the output packet */
+/* The framerate adaptation shared by all conversions: decides whether an
+ * output frame is due after the current input frame and how much of the
+ * queued data fits into it. The output time code is updated from @tc.
+ * Returns %FALSE if no output can be generated yet, in which case all data
+ * stays queued */
 static gboolean
-fit_and_scale_cc_data (GstCCConverter * self,
+take_output_frame (GstCCConverter * self,
     const struct cdp_fps_entry *in_fps_entry,
-    const struct cdp_fps_entry *out_fps_entry, const guint8 * ccp_data,
-    guint * ccp_data_len, const guint8 * cea608_1, guint * cea608_1_len,
-    const guint8 * cea608_2, guint * cea608_2_len, const GstVideoTimeCode * tc)
+    const struct cdp_fps_entry *out_fps_entry, const GstVideoTimeCode * tc,
+    struct cc_frame *frame)
 {
-  if (!in_fps_entry || in_fps_entry->fps_n == 0) {
-    in_fps_entry = cdp_fps_entry_from_fps (self->in_fps_n, self->in_fps_d);
-    if (!in_fps_entry || in_fps_entry->fps_n == 0)
-      g_assert_not_reached ();
-  }
+  gint scale_n = 1, scale_d = 1;
+  gboolean same_rate;
 
   /* This is slightly looser than checking for the exact framerate as the cdp
-   * spec allow for 0.1% difference between framerates to be considered equal */
-  if (in_fps_entry->max_cc_count == out_fps_entry->max_cc_count) {
-    if (tc && tc->config.fps_n != 0)
-      interpolate_time_code_with_framerate (self, tc, out_fps_entry->fps_n,
-          out_fps_entry->fps_d, 1, 1, &self->current_output_timecode);
-
-    self->scratch_ccp_len = 0;
-    self->scratch_cea608_1_len = 0;
-    self->scratch_cea608_2_len = 0;
+   * spec allow for 0.1% difference between framerates to be considered equal.
+   * Without framerates on both sides we can't do anything but convert each
+   * frame on its own */
+  same_rate = in_fps_entry->max_cc_count == out_fps_entry->max_cc_count
+      || self->in_fps_n == 0 || self->out_fps_n == 0;
+
+  if (same_rate) {
     self->input_frames = 0;
     self->output_frames = 0;
   } else {
-    int input_frame_n, input_frame_d, output_frame_n, output_frame_d;
-    int output_time_cmp, scale_n, scale_d, rate_cmp;
+    gint input_frame_n, input_frame_d, output_frame_n, output_frame_d;
+    gint output_time_cmp;
 
     /* TODO: handle input discont */
 
@@ -910,125 +973,55 @@ fit_and_scale_cc_data (GstCCConverter * self,
     output_time_cmp = gst_util_fraction_compare (input_frame_n, input_frame_d,
         output_frame_n, output_frame_d);
 
-    /* compute the relative rates of the two framerates */
-    get_framerate_output_scale (self, in_fps_entry, &scale_n, &scale_d);
-
-    rate_cmp = gst_util_fraction_compare (scale_n, scale_d, 1, 1);
-
-    GST_TRACE_OBJECT (self, "performing framerate conversion at scale %d/%d "
-        "of cc data of with sizes, ccp:%u, cea608-1:%u, cea608-2:%u", scale_n,
-        scale_d, VAL_OR_0 (ccp_data_len), VAL_OR_0 (cea608_1_len),
-        VAL_OR_0 (cea608_2_len));
-
-    if (rate_cmp == 0) {
-      /* we are not scaling. Should never happen with current conditions
-       * above */
-      g_assert_not_reached ();
-    } else if (output_time_cmp < 0) {
+    if (output_time_cmp < 0) {
       /* we can't generate an output yet */
-      guint cd_len = ccp_data_len ? *ccp_data_len : 0;
-      guint c1_len = cea608_1_len ? *cea608_1_len : 0;
-      guint c2_len = cea608_2_len ? *cea608_2_len : 0;
-
-      store_cc_data (self, ccp_data, cd_len, cea608_1, c1_len, cea608_2,
-          c2_len);
-      if (ccp_data_len)
-        *ccp_data_len = 0;
-      if (cea608_1_len)
-        *cea608_1_len = 0;
-      if (cea608_2_len)
-        *cea608_2_len = 0;
+      GST_DEBUG_OBJECT (self, "holding data of len ccp:%u, cea608 1:%u, "
+          "cea608 2:%u until next input buffer", self->queue_ccp_len,
+          self->queue_cea608_1_len, self->queue_cea608_2_len);
       return FALSE;
-    } else if (rate_cmp != 0) {
-      /* we are changing the framerate and may overflow the max output packet
-       * size. Split them where necessary. */
-      gint extra_ccp = 0, extra_cea608_1 = 0, extra_cea608_2 = 0;
-      gint ccp_off = 0, cea608_1_off = 0, cea608_2_off = 0;
-
-      if (output_time_cmp == 0) {
-        /* we have completed a cycle and can reset our counters to avoid
-         * overflow. Anything that fits into the output packet will be written */
-        GST_LOG_OBJECT (self, "cycle completed, resetting frame counters");
-        self->scratch_ccp_len = 0;
-        self->scratch_cea608_1_len = 0;
-        self->scratch_cea608_2_len = 0;
-        self->input_frames = 0;
-        self->output_frames = 0;
-      }
-
-      if (ccp_data_len) {
-        extra_ccp = *ccp_data_len - 3 * out_fps_entry->max_ccp_count;
-        extra_ccp = MAX (0, extra_ccp);
-        ccp_off = *ccp_data_len - extra_ccp;
-      }
-
-      if (cea608_1_len) {
-        extra_cea608_1 = *cea608_1_len - 2 * out_fps_entry->max_cea608_count;
-        extra_cea608_1 = MAX (0, extra_cea608_1);
-        cea608_1_off = *cea608_1_len - extra_cea608_1;
-      }
-
-      if (cea608_2_len) {
-        /* this prefers using field1 data first. This may not be quite correct */
-        if (extra_cea608_1 > 0) {
-          /* all the cea608 space is for field 1 */
-          extra_cea608_2 = *cea608_2_len;
-          cea608_2_off = 0;
-        } else if (cea608_1_len) {
-          /* cea608 space is shared between field 1 and field 2 */
-          extra_cea608_2 =
-              *cea608_1_len + *cea608_2_len -
-              2 * out_fps_entry->max_cea608_count;
-          extra_cea608_2 = MAX (0, extra_cea608_2);
-          cea608_2_off = *cea608_2_len - extra_cea608_2;
-        } else {
-          /* all of the cea608 space is for field 2 */
-          extra_cea608_2 = *cea608_2_len - 2 * out_fps_entry->max_cea608_count;
-          extra_cea608_2 = MAX (0, extra_cea608_2);
-          cea608_2_off = *cea608_2_len - extra_cea608_2;
-        }
-      }
+    }
 
-      if (extra_ccp > 0 || extra_cea608_1 > 0 || extra_cea608_2 > 0) {
-        /* packet would overflow, push extra bytes into the next packet */
-        GST_DEBUG_OBJECT (self, "buffer would overflow by %u ccp bytes, "
-            "%u cea608 field 1 bytes, or %u cea608 field 2 bytes", extra_ccp,
-            extra_cea608_1, extra_cea608_2);
-        store_cc_data (self, &ccp_data[ccp_off], extra_ccp,
-            &cea608_1[cea608_1_off], extra_cea608_1, &cea608_2[cea608_2_off],
-            extra_cea608_2);
-        if (ccp_data_len)
-          *ccp_data_len = MIN (*ccp_data_len, ccp_off);
-        if (cea608_1_len)
-          *cea608_1_len = MIN (*cea608_1_len, cea608_1_off);
-        if (cea608_2_len)
-          *cea608_2_len = MIN (*cea608_2_len, cea608_2_off);
-      } else {
-        GST_DEBUG_OBJECT (self, "section sizes of %u ccp bytes, "
-            "%u cea608 field 1 bytes, and %u cea608 field 2 bytes fit within "
-            "output packet", VAL_OR_0 (ccp_data_len), VAL_OR_0 (cea608_1_len),
-            VAL_OR_0 (cea608_2_len));
-        self->scratch_ccp_len = 0;
-        self->scratch_cea608_1_len = 0;
-        self->scratch_cea608_2_len = 0;
-      }
-    } else {
-      g_assert_not_reached ();
+    if (output_time_cmp == 0) {
+      /* we have completed a cycle and can reset our counters to avoid
+       * overflow */
+      GST_LOG_OBJECT (self, "cycle completed, resetting frame counters");
+      self->input_frames = 0;
+      self->output_frames = 0;
     }
 
-    if (tc && tc->config.fps_n != 0)
-      interpolate_time_code_with_framerate (self, tc, out_fps_entry->fps_n,
-          out_fps_entry->fps_d, scale_n, scale_d,
-          &self->current_output_timecode);
+    /* compute the relative rates of the two framerates */
+    get_framerate_output_scale (self, in_fps_entry, &scale_n, &scale_d);
   }
 
-  g_assert_cmpint (VAL_OR_0 (ccp_data_len) + (VAL_OR_0 (cea608_1_len) +
-          VAL_OR_0 (cea608_2_len)) / 2 * 3, <=,
-      3 * out_fps_entry->max_cc_count);
+  /* Split the queued data where it would overflow the output packet. This
+   * prefers using field 1 data first, which may not be quite correct */
+  frame->ccp_len = MIN (self->queue_ccp_len, 3 * out_fps_entry->max_ccp_count);
+  frame->cea608_1_len = MIN (self->queue_cea608_1_len,
+      2 * out_fps_entry->max_cea608_count);
+  frame->cea608_2_len = MIN (self->queue_cea608_2_len,
+      2 * out_fps_entry->max_cea608_count - frame->cea608_1_len);
+  /* At the same rate nothing is carried over to the next frame, and neither
+   * is anything if the output can't carry any data at all */
+  frame->discard_rest = same_rate || out_fps_entry->max_cc_count == 0;
+
+  if (frame->ccp_len < self->queue_ccp_len
+      || frame->cea608_1_len < self->queue_cea608_1_len
+      || frame->cea608_2_len < self->queue_cea608_2_len) {
+    GST_DEBUG_OBJECT (self, "%s %u ccp bytes, %u cea608 field 1 bytes and "
+        "%u cea608 field 2 bytes that don't fit into the output packet",
+        same_rate ? "dropping" : "holding",
+        self->queue_ccp_len - frame->ccp_len,
+        self->queue_cea608_1_len - frame->cea608_1_len,
+        self->queue_cea608_2_len - frame->cea608_2_len);
+  }
+
+  if (tc && tc->config.fps_n != 0)
+    interpolate_time_code_with_framerate (self, tc, out_fps_entry->fps_n,
+        out_fps_entry->fps_d, scale_n, scale_d,
+        &self->current_output_timecode);
 
   GST_DEBUG_OBJECT (self, "write out packet with lengths ccp:%u, cea608-1:%u, "
-      "cea608-2:%u", VAL_OR_0 (ccp_data_len), VAL_OR_0 (cea608_1_len),
-      VAL_OR_0 (cea608_2_len));
+      "cea608-2:%u", frame->ccp_len, frame->cea608_1_len, frame->cea608_2_len);
 
   return TRUE;
 }
@@ -1297,362 +1290,74 @@ convert_cea708_cdp_cea708_cc_data_internal (GstCCConverter * self,
   return len;
 }
 
-static gboolean
-copy_from_stored_data (GstCCConverter * self, guint8 * out_ccp,
-    guint * ccp_size, guint8 * cea608_1, guint * cea608_1_len,
-    guint8 * cea608_2, guint * cea608_2_len)
-{
-  guint ccp_in_size = 0, cea608_1_in_size = 0, cea608_2_in_size = 0;
-
-  g_assert ((out_ccp && ccp_size) || (!out_ccp && !ccp_size));
-  g_assert ((cea608_1 && cea608_1_len) || (!cea608_1 && !cea608_1_len));
-  g_assert ((cea608_2 && cea608_2_len) || (!cea608_2 && !cea608_2_len));
-
-  if (ccp_size) {
-    ccp_in_size = *ccp_size;
-    *ccp_size = 0;
-  }
-  if (cea608_1_len) {
-    cea608_1_in_size = *cea608_1_len;
-    *cea608_1_len = 0;
-  }
-  if (cea608_2_len) {
-    cea608_2_in_size = *cea608_2_len;
-    *cea608_2_len = 0;
-  }
-
-  if (out_ccp && self->scratch_ccp_len > 0) {
-    GST_DEBUG_OBJECT (self, "copying from previous scratch ccp buffer of "
-        "%u bytes", self->scratch_ccp_len);
-    if (ccp_in_size < *ccp_size + self->scratch_ccp_len) {
-      GST_WARNING_OBJECT (self, "output buffer too small %u < %u", ccp_in_size,
-          *ccp_size + self->scratch_ccp_len);
-      goto fail;
-    }
-    memcpy (&out_ccp[*ccp_size], self->scratch_ccp, self->scratch_ccp_len);
-    *ccp_size += self->scratch_ccp_len;
-  }
-
-  if (cea608_1 && self->scratch_cea608_1_len > 0) {
-    GST_DEBUG_OBJECT (self, "copying from previous scratch cea608 field 1 "
-        "buffer of %u bytes", self->scratch_cea608_1_len);
-    if (cea608_1_in_size < *cea608_1_len + self->scratch_cea608_1_len) {
-      GST_WARNING_OBJECT (self, "output buffer too small %u < %u",
-          cea608_1_in_size, *cea608_1_len + self->scratch_cea608_1_len);
-      goto fail;
-    }
-    memcpy (&cea608_1[*cea608_1_len], self->scratch_cea608_1,
-        self->scratch_cea608_1_len);
-    *cea608_1_len += self->scratch_cea608_1_len;
-  }
-
-  if (cea608_2 && self->scratch_cea608_2_len > 0) {
-    GST_DEBUG_OBJECT (self, "copying from previous scratch cea608 field 2 "
-        "buffer of %u bytes", self->scratch_cea608_2_len);
-    if (cea608_2_in_size < *cea608_2_len + self->scratch_cea608_2_len) {
-      GST_WARNING_OBJECT (self, "output buffer too small %u < %u",
-          cea608_2_in_size, *cea608_2_len + self->scratch_cea608_2_len);
-      goto fail;
-    }
-    memcpy (&cea608_2[*cea608_2_len], self->scratch_cea608_2,
-        self->scratch_cea608_2_len);
-    *cea608_2_len += self->scratch_cea608_2_len;
-  }
-
-  return TRUE;
-
-fail:
-  if (ccp_size)
-    *ccp_size = 0;
-  if (cea608_1_len)
-    *cea608_1_len = 0;
-  if (cea608_2_len)
-    *cea608_2_len = 0;
-  return FALSE;
-}
-
-static gboolean
-cc_data_to_cea608_ccp (GstCCConverter * self, guint8 * cc_data,
-    guint cc_data_len, guint8 * out_ccp, guint * ccp_size, guint8 * cea608_1,
-    guint * cea608_1_len, guint8 * cea608_2, guint * cea608_2_len,
-    const struct cdp_fps_entry *in_fps_entry)
-{
-  guint ccp_in_size = 0, cea608_1_in_size = 0, cea608_2_in_size = 0;
-
-  g_assert (cc_data || cc_data_len == 0);
-
-  if (ccp_size)
-    ccp_in_size = *ccp_size;
-  if (cea608_1_len)
-    cea608_1_in_size = *cea608_1_len;
-  if (cea608_2_len)
-    cea608_2_in_size = *cea608_2_len;
-
-  if (!copy_from_stored_data (self, out_ccp, ccp_size, cea608_1, cea608_1_len,
-          cea608_2, cea608_2_len))
-    goto fail;
-
-  if (cc_data) {
-    gint ccp_offset = 0;
-    guint new_cea608_1_len = 0, new_cea608_2_len = 0;
-    guint8 *new_cea608_1 = cea608_1, *new_cea608_2 = cea608_2;
-
-    if (cea608_1_len) {
-      new_cea608_1_len = cea608_1_in_size - *cea608_1_len;
-      new_cea608_1 = &cea608_1[*cea608_1_len];
-    }
-    if (cea608_2_len) {
-      new_cea608_2_len = cea608_2_in_size - *cea608_2_len;
-      new_cea608_2 = &cea608_2[*cea608_2_len];
-    }
-
-    cc_data_len = compact_cc_data (cc_data, cc_data_len);
-
-    if (cc_data_len / 3 > in_fps_entry->max_cc_count) {
-      GST_WARNING_OBJECT (self, "Too many cc_data triples in CDP packet %u. "
-          "Truncating to %u", cc_data_len / 3, in_fps_entry->max_cc_count);
-      cc_data_len = 3 * in_fps_entry->max_cc_count;
-    }
-
-    ccp_offset = cc_data_extract_cea608 (cc_data, cc_data_len, new_cea608_1,
-        &new_cea608_1_len, new_cea608_2, &new_cea608_2_len);
-    if (ccp_offset < 0) {
-      GST_WARNING_OBJECT (self, "Failed to extract cea608 from cc_data");
-      goto fail;
-    }
-
-    if ((new_cea608_1_len + new_cea608_2_len) / 2 >
-        in_fps_entry->max_cea608_count) {
-      GST_WARNING_OBJECT (self, "Too many cea608 triples in CDP packet %u. "
-          "Truncating to %u", (new_cea608_1_len + new_cea608_2_len) / 2,
-          in_fps_entry->max_cea608_count);
-      if ((new_cea608_1_len + new_cea608_2_len) / 2 >
-          in_fps_entry->max_cea608_count) {
-        new_cea608_1_len = 2 * in_fps_entry->max_cea608_count;
-        new_cea608_2_len = 0;
-      } else {
-        new_cea608_2_len =
-            2 * in_fps_entry->max_cea608_count - new_cea608_1_len;
-      }
-    }
-
-    if (cea608_1_len)
-      *cea608_1_len += new_cea608_1_len;
-    if (cea608_2_len)
-      *cea608_2_len += new_cea608_2_len;
-
-    if (out_ccp) {
-      if (ccp_in_size < *ccp_size + cc_data_len - ccp_offset) {
-        GST_WARNING_OBJECT (self, "output buffer too small %u < %u",
-            ccp_in_size, *ccp_size + cc_data_len - ccp_offset);
-        goto fail;
-      }
-      memcpy (&out_ccp[*ccp_size], &cc_data[ccp_offset],
-          cc_data_len - ccp_offset);
-      *ccp_size += cc_data_len - ccp_offset;
-    }
-  }
-
-  return TRUE;
-
-fail:
-  if (ccp_size)
-    *ccp_size = 0;
-  if (cea608_1_len)
-    *cea608_1_len = 0;
-  if (cea608_2_len)
-    *cea608_2_len = 0;
-  return FALSE;
-}
-
-static gboolean
-cdp_to_cea608_cc_data (GstCCConverter * self, GstBuffer * inbuf,
-    guint8 * out_ccp, guint * ccp_size, guint8 * cea608_1, guint * cea608_1_len,
-    guint8 * cea608_2, guint * cea608_2_len, GstVideoTimeCode * out_tc,
-    const struct cdp_fps_entry **in_fps_entry)
+/* Splits cc_data into the CEA608 field data and the remaining CEA708
+ * packet data and queues them. @cc_data is compacted in place */
+static void
+push_cc_data (GstCCConverter * self, guint8 * cc_data, guint cc_data_len,
+    const struct cdp_fps_entry *fps_entry)
 {
-  guint8 cc_data[MAX_CDP_PACKET_LEN];
-  guint cc_data_len = 0;
-  GstMapInfo in;
-
-  if (inbuf) {
-    gst_buffer_map (inbuf, &in, GST_MAP_READ);
-
-    cc_data_len =
-        convert_cea708_cdp_cea708_cc_data_internal (self, in.data, in.size,
-        cc_data, out_tc, in_fps_entry);
-
-    gst_buffer_unmap (inbuf, &in);
-    self->input_frames++;
-  }
-
-  return cc_data_to_cea608_ccp (self, inbuf ? cc_data : NULL, cc_data_len,
-      out_ccp, ccp_size, cea608_1, cea608_1_len, cea608_2, cea608_2_len,
-      inbuf ? *in_fps_entry : NULL);
-}
+  guint8 cea608_1[MAX_CEA608_LEN], cea608_2[MAX_CEA608_LEN];
+  guint cea608_1_len = MAX_CEA608_LEN, cea608_2_len = MAX_CEA608_LEN;
+  gint ccp_offset;
 
-static GstFlowReturn
-convert_cea608_raw_cea608_s334_1a (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf)
-{
-  GstMapInfo in, out;
-  guint i, n;
+  cc_data_len = compact_cc_data (cc_data, cc_data_len);
 
-  n = gst_buffer_get_size (inbuf);
-  if (n & 1) {
-    GST_WARNING_OBJECT (self, "Invalid raw CEA608 buffer size");
-    gst_buffer_set_size (outbuf, 0);
-    return GST_FLOW_OK;
+  if (cc_data_len / 3 > fps_entry->max_cc_count) {
+    GST_WARNING_OBJECT (self, "Too many cc_data triplets %u. Truncating to %u",
+        cc_data_len / 3, fps_entry->max_cc_count);
+    cc_data_len = 3 * fps_entry->max_cc_count;
   }
 
-  n /= 2;
-
-  if (n > 3) {
-    GST_WARNING_OBJECT (self, "Too many CEA608 pairs %u.  Truncating to %u", n,
-        3);
-    n = 3;
+  ccp_offset = cc_data_extract_cea608 (cc_data, cc_data_len, cea608_1,
+      &cea608_1_len, cea608_2, &cea608_2_len);
+  if (ccp_offset < 0) {
+    GST_WARNING_OBJECT (self, "Failed to extract cea608 from cc_data");
+    return;
   }
 
-  gst_buffer_set_size (outbuf, 3 * n);
-
-  gst_buffer_map (inbuf, &in, GST_MAP_READ);
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-
-  /* We have to assume that each value is from the first field and
-   * don't know from which line offset it originally is */
-  for (i = 0; i < n; i++) {
-    out.data[i * 3] = 0x80;
-    out.data[i * 3 + 1] = in.data[i * 2];
-    out.data[i * 3 + 2] = in.data[i * 2 + 1];
+  if ((cea608_1_len + cea608_2_len) / 2 > fps_entry->max_cea608_count) {
+    GST_WARNING_OBJECT (self, "Too many cea608 triplets %u. Truncating to %u",
+        (cea608_1_len + cea608_2_len) / 2, fps_entry->max_cea608_count);
+    cea608_1_len = MIN (cea608_1_len, 2 * fps_entry->max_cea608_count);
+    cea608_2_len = 2 * fps_entry->max_cea608_count - cea608_1_len;
   }
 
-  gst_buffer_unmap (inbuf, &in);
-  gst_buffer_unmap (outbuf, &out);
-
-  return GST_FLOW_OK;
+  queue_push (self, &cc_data[ccp_offset], cc_data_len - ccp_offset, cea608_1,
+      cea608_1_len, cea608_2, cea608_2_len);
 }
 
-static GstFlowReturn
-convert_cea608_raw_cea708_cc_data (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf)
+static void
+read_cea608_raw (GstCCConverter * self, const guint8 * data, guint len,
+    GstVideoTimeCode * tc, const struct cdp_fps_entry **fps_entry)
 {
-  GstMapInfo in, out;
-  guint i, n;
+  guint n = len;
 
-  n = gst_buffer_get_size (inbuf);
   if (n & 1) {
     GST_WARNING_OBJECT (self, "Invalid raw CEA608 buffer size");
-    gst_buffer_set_size (outbuf, 0);
-    return GST_FLOW_OK;
+    return;
   }
 
   n /= 2;
 
-  if (n > 3) {
+  if (n > (*fps_entry)->max_cea608_count) {
     GST_WARNING_OBJECT (self, "Too many CEA608 pairs %u. Truncating to %u", n,
-        3);
-    n = 3;
+        (*fps_entry)->max_cea608_count);
+    n = (*fps_entry)->max_cea608_count;
   }
 
-  gst_buffer_set_size (outbuf, 3 * n);
-
-  gst_buffer_map (inbuf, &in, GST_MAP_READ);
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-
   /* We have to assume that each value is from the first field and
    * don't know from which line offset it originally is */
-  for (i = 0; i < n; i++) {
-    out.data[i * 3] = 0xfc;
-    out.data[i * 3 + 1] = in.data[i * 2];
-    out.data[i * 3 + 2] = in.data[i * 2 + 1];
-  }
-
-  gst_buffer_unmap (inbuf, &in);
-  gst_buffer_unmap (outbuf, &out);
-
-  return GST_FLOW_OK;
+  queue_push (self, NULL, 0, data, n * 2, NULL, 0);
 }
 
-static GstFlowReturn
-convert_cea608_raw_cea708_cdp (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf, const GstVideoTimeCodeMeta * tc_meta)
-{
-  GstMapInfo in, out;
-  const struct cdp_fps_entry *in_fps_entry, *out_fps_entry;
-  guint cc_data_len = MAX_CDP_PACKET_LEN;
-  guint cea608_1_len = MAX_CDP_PACKET_LEN;
-  guint8 cc_data[MAX_CDP_PACKET_LEN], cea608_1[MAX_CEA608_LEN];
-
-  in_fps_entry = cdp_fps_entry_from_fps (self->in_fps_n, self->in_fps_d);
-  if (!in_fps_entry || in_fps_entry->fps_n == 0)
-    g_assert_not_reached ();
-
-  if (!copy_from_stored_data (self, NULL, 0, cea608_1, &cea608_1_len, NULL, 0))
-    goto drop;
-
-  if (inbuf) {
-    guint n = 0;
-
-    n = gst_buffer_get_size (inbuf);
-    if (n & 1) {
-      GST_WARNING_OBJECT (self, "Invalid raw CEA608 buffer size");
-      gst_buffer_set_size (outbuf, 0);
-      return GST_FLOW_OK;
-    }
-
-    n /= 2;
-
-    if (n > in_fps_entry->max_cea608_count) {
-      GST_WARNING_OBJECT (self, "Too many CEA608 pairs %u. Truncating to %u",
-          n, in_fps_entry->max_cea608_count);
-      n = in_fps_entry->max_cea608_count;
-    }
-
-    gst_buffer_map (inbuf, &in, GST_MAP_READ);
-    memcpy (&cea608_1[cea608_1_len], in.data, n * 2);
-    gst_buffer_unmap (inbuf, &in);
-    cea608_1_len += n * 2;
-    self->input_frames++;
-  }
-
-  out_fps_entry = cdp_fps_entry_from_fps (self->out_fps_n, self->out_fps_d);
-  if (!out_fps_entry || out_fps_entry->fps_n == 0)
-    g_assert_not_reached ();
-
-  if (!fit_and_scale_cc_data (self, in_fps_entry, out_fps_entry, NULL, 0,
-          cea608_1, &cea608_1_len, NULL, 0, tc_meta ? &tc_meta->tc : NULL))
-    goto drop;
-
-  if (!combine_cc_data (self, TRUE, out_fps_entry, NULL, 0, cea608_1,
-          cea608_1_len, NULL, 0, cc_data, &cc_data_len))
-    goto drop;
-
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-  cc_data_len =
-      convert_cea708_cc_data_cea708_cdp_internal (self, cc_data, cc_data_len,
-      out.data, out.size, &self->current_output_timecode, out_fps_entry);
-  self->output_frames++;
-  gst_buffer_unmap (outbuf, &out);
-
-out:
-  gst_buffer_set_size (outbuf, cc_data_len);
-
-  return GST_FLOW_OK;
-
-drop:
-  cc_data_len = 0;
-  goto out;
-}
-
-static GstFlowReturn
-convert_cea608_s334_1a_cea608_raw (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf)
+static void
+read_cea608_s334_1a (GstCCConverter * self, const guint8 * data, guint len,
+    GstVideoTimeCode * tc, const struct cdp_fps_entry **fps_entry)
 {
-  GstMapInfo in, out;
-  guint i, n;
-  guint cea608 = 0;
+  guint8 cea608_1[MAX_CEA608_LEN], cea608_2[MAX_CEA608_LEN];
+  guint cea608_1_len = 0, cea608_2_len = 0;
+  guint i, n = len;
 
-  n = gst_buffer_get_size (inbuf);
   if (n % 3 != 0) {
     GST_WARNING_OBJECT (self, "Invalid S334-1A CEA608 buffer size");
     n = n - (n % 3);
@@ -1660,489 +1365,170 @@ convert_cea608_s334_1a_cea608_raw (GstCCConverter * self, GstBuffer * inbuf,
 
   n /= 3;
 
-  if (n > 3) {
+  if (n > (*fps_entry)->max_cea608_count) {
     GST_WARNING_OBJECT (self, "Too many S334-1A CEA608 triplets %u", n);
-    n = 3;
+    n = (*fps_entry)->max_cea608_count;
   }
 
-  gst_buffer_map (inbuf, &in, GST_MAP_READ);
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-
   for (i = 0; i < n; i++) {
-    if (in.data[i * 3] & 0x80) {
-      out.data[i * 2] = in.data[i * 3 + 1];
-      out.data[i * 2 + 1] = in.data[i * 3 + 2];
-      cea608++;
+    if (data[i * 3] & 0x80) {
+      cea608_1[cea608_1_len++] = data[i * 3 + 1];
+      cea608_1[cea608_1_len++] = data[i * 3 + 2];
+    } else {
+      cea608_2[cea608_2_len++] = data[i * 3 + 1];
+      cea608_2[cea608_2_len++] = data[i * 3 + 2];
     }
   }
 
-  gst_buffer_unmap (inbuf, &in);
-  gst_buffer_unmap (outbuf, &out);
-
-  gst_buffer_set_size (outbuf, 2 * cea608);
-
-  return GST_FLOW_OK;
+  queue_push (self, NULL, 0, cea608_1, cea608_1_len, cea608_2, cea608_2_len);
 }
 
-static GstFlowReturn
-convert_cea608_s334_1a_cea708_cc_data (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf)
+static void
+read_cea708_cc_data (GstCCConverter * self, const guint8 * data, guint len,
+    GstVideoTimeCode * tc, const struct cdp_fps_entry **fps_entry)
 {
-  GstMapInfo in, out;
-  guint i, n;
-
-  n = gst_buffer_get_size (inbuf);
-  if (n % 3 != 0) {
-    GST_WARNING_OBJECT (self, "Invalid S334-1A CEA608 buffer size");
-    n = n - (n % 3);
-  }
-
-  n /= 3;
-
-  if (n > 3) {
-    GST_WARNING_OBJECT (self, "Too many S334-1A CEA608 triplets %u", n);
-    n = 3;
-  }
-
-  gst_buffer_set_size (outbuf, 3 * n);
-
-  gst_buffer_map (inbuf, &in, GST_MAP_READ);
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
+  guint8 cc_data[MAX_CDP_PACKET_LEN];
 
-  for (i = 0; i < n; i++) {
-    out.data[i * 3] = (in.data[i * 3] & 0x80) ? 0xfc : 0xfd;
-    out.data[i * 3 + 1] = in.data[i * 3 + 1];
-    out.data[i * 3 + 2] = in.data[i * 3 + 2];
+  if (len > sizeof (cc_data) - sizeof (cc_data) % 3) {
+    GST_WARNING_OBJECT (self, "Too large raw CEA708 buffer %u", len);
+    len = sizeof (cc_data) - sizeof (cc_data) % 3;
   }
 
-  gst_buffer_unmap (inbuf, &in);
-  gst_buffer_unmap (outbuf, &out);
-
-  return GST_FLOW_OK;
+  /* compaction works in place */
+  memcpy (cc_data, data, len);
+  push_cc_data (self, cc_data, len, *fps_entry);
 }
 
-static GstFlowReturn
-convert_cea608_s334_1a_cea708_cdp (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf, const GstVideoTimeCodeMeta * tc_meta)
+static void
+read_cea708_cdp (GstCCConverter * self, const guint8 * data, guint len,
+    GstVideoTimeCode * tc, const struct cdp_fps_entry **fps_entry)
 {
-  GstMapInfo in, out;
-  const struct cdp_fps_entry *in_fps_entry, *out_fps_entry;
-  guint cc_data_len = MAX_CDP_PACKET_LEN;
-  guint cea608_1_len = MAX_CDP_PACKET_LEN, cea608_2_len = MAX_CDP_PACKET_LEN;
   guint8 cc_data[MAX_CDP_PACKET_LEN];
-  guint8 cea608_1[MAX_CEA608_LEN], cea608_2[MAX_CEA608_LEN];
-  guint i, n;
-
-  in_fps_entry = cdp_fps_entry_from_fps (self->in_fps_n, self->in_fps_d);
-  if (!in_fps_entry || in_fps_entry->fps_n == 0)
-    g_assert_not_reached ();
-
-  if (!copy_from_stored_data (self, NULL, 0, cea608_1, &cea608_1_len,
-          cea608_2, &cea608_2_len))
-    goto drop;
-
-  if (inbuf) {
-    n = gst_buffer_get_size (inbuf);
-    if (n % 3 != 0) {
-      GST_WARNING_OBJECT (self, "Invalid S334-1A CEA608 buffer size");
-      n = n - (n % 3);
-    }
-
-    n /= 3;
-
-    if (n > in_fps_entry->max_cea608_count) {
-      GST_WARNING_OBJECT (self, "Too many S334-1A CEA608 triplets %u", n);
-      n = in_fps_entry->max_cea608_count;
-    }
-
-    gst_buffer_map (inbuf, &in, GST_MAP_READ);
-
-    for (i = 0; i < n; i++) {
-      if (in.data[i * 3] & 0x80) {
-        cea608_1[cea608_1_len++] = in.data[i * 3 + 1];
-        cea608_1[cea608_1_len++] = in.data[i * 3 + 2];
-      } else {
-        cea608_2[cea608_2_len++] = in.data[i * 3 + 1];
-        cea608_2[cea608_2_len++] = in.data[i * 3 + 2];
-      }
-    }
-    gst_buffer_unmap (inbuf, &in);
-    self->input_frames++;
-  }
-
-  out_fps_entry = cdp_fps_entry_from_fps (self->out_fps_n, self->out_fps_d);
-  if (!out_fps_entry || out_fps_entry->fps_n == 0)
-    g_assert_not_reached ();
-
-  if (!fit_and_scale_cc_data (self, in_fps_entry, out_fps_entry, NULL, 0,
-          cea608_1, &cea608_1_len, cea608_2, &cea608_2_len,
-          tc_meta ? &tc_meta->tc : NULL)) {
-    goto drop;
-  }
+  const struct cdp_fps_entry *cdp_fps_entry;
+  guint cc_data_len;
 
-  if (!combine_cc_data (self, TRUE, out_fps_entry, NULL, 0, cea608_1,
-          cea608_1_len, cea608_2, cea608_2_len, cc_data, &cc_data_len)) {
-    goto drop;
-  }
-
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-  cc_data_len =
-      convert_cea708_cc_data_cea708_cdp_internal (self, cc_data, cc_data_len,
-      out.data, out.size, &self->current_output_timecode, out_fps_entry);
-  self->output_frames++;
-  gst_buffer_unmap (outbuf, &out);
-
-out:
-  gst_buffer_set_size (outbuf, cc_data_len);
-
-  return GST_FLOW_OK;
+  cc_data_len = convert_cea708_cdp_cea708_cc_data_internal (self, data, len,
+      cc_data, tc, &cdp_fps_entry);
+  if (cdp_fps_entry->fps_n == 0)
+    return;
 
-drop:
-  cc_data_len = 0;
-  goto out;
+  *fps_entry = cdp_fps_entry;
+  push_cc_data (self, cc_data, cc_data_len, cdp_fps_entry);
 }
 
-static GstFlowReturn
-convert_cea708_cc_data_cea608_raw (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf)
+static guint
+write_cea608_raw (GstCCConverter * self, const struct cc_frame *frame,
+    const struct cdp_fps_entry *fps_entry, guint8 * out, guint out_size)
 {
-  GstMapInfo in, out;
-  guint i, n;
-  guint cea608 = 0;
-
-  n = gst_buffer_get_size (inbuf);
-  if (n % 3 != 0) {
-    GST_WARNING_OBJECT (self, "Invalid raw CEA708 buffer size");
-    n = n - (n % 3);
-  }
-
-  n /= 3;
+  g_assert_cmpint (frame->cea608_1_len, <=, out_size);
 
-  if (n > 25) {
-    GST_WARNING_OBJECT (self, "Too many CEA708 triplets %u", n);
-    n = 25;
-  }
+  /* We can only really copy the first field here as there can't be any
+   * signalling in raw CEA608 and we must not mix the streams of different
+   * fields */
+  memcpy (out, self->queue_cea608_1, frame->cea608_1_len);
 
-  gst_buffer_map (inbuf, &in, GST_MAP_READ);
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-
-  for (i = 0; i < n; i++) {
-    /* We can only really copy the first field here as there can't be any
-     * signalling in raw CEA608 and we must not mix the streams of different
-     * fields
-     */
-    if (in.data[i * 3] == 0xfc) {
-      out.data[cea608 * 2] = in.data[i * 3 + 1];
-      out.data[cea608 * 2 + 1] = in.data[i * 3 + 2];
-      cea608++;
-    }
-  }
-
-  gst_buffer_unmap (inbuf, &in);
-  gst_buffer_unmap (outbuf, &out);
-
-  gst_buffer_set_size (outbuf, 2 * cea608);
-
-  return GST_FLOW_OK;
+  return frame->cea608_1_len;
 }
 
-static GstFlowReturn
-convert_cea708_cc_data_cea608_s334_1a (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf)
+static guint
+write_cea608_s334_1a (GstCCConverter * self, const struct cc_frame *frame,
+    const struct cdp_fps_entry *fps_entry, guint8 * out, guint out_size)
 {
-  GstMapInfo in, out;
-  guint i, n;
-  guint cea608 = 0;
-
-  n = gst_buffer_get_size (inbuf);
-  if (n % 3 != 0) {
-    GST_WARNING_OBJECT (self, "Invalid raw CEA708 buffer size");
-    n = n - (n % 3);
-  }
-
-  n /= 3;
-
-  if (n > 25) {
-    GST_WARNING_OBJECT (self, "Too many CEA708 triplets %u", n);
-    n = 25;
-  }
-
-  gst_buffer_map (inbuf, &in, GST_MAP_READ);
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-
-  for (i = 0; i < n; i++) {
-    if (in.data[i * 3] == 0xfc || in.data[i * 3] == 0xfd) {
-      /* We have to assume a line offset of 0 */
-      out.data[cea608 * 3] = in.data[i * 3] == 0xfc ? 0x80 : 0x00;
-      out.data[cea608 * 3 + 1] = in.data[i * 3 + 1];
-      out.data[cea608 * 3 + 2] = in.data[i * 3 + 2];
-      cea608++;
-    }
-  }
+  guint i, len = out_size;
 
-  gst_buffer_unmap (inbuf, &in);
-  gst_buffer_unmap (outbuf, &out);
+  if (!combine_cc_data (self, FALSE, fps_entry, NULL, 0, self->queue_cea608_1,
+          frame->cea608_1_len, self->queue_cea608_2, frame->cea608_2_len, out,
+          &len))
+    return 0;
 
-  gst_buffer_set_size (outbuf, 3 * cea608);
+  for (i = 0; i < len / 3; i++)
+    /* We have to assume a line offset of 0 */
+    out[i * 3] = out[i * 3] == 0xfc ? 0x80 : 0x00;
 
-  return GST_FLOW_OK;
+  return len;
 }
 
-static GstFlowReturn
-convert_cea708_cc_data_cea708_cdp (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf, const GstVideoTimeCodeMeta * tc_meta)
+static guint
+write_cea708_cc_data (GstCCConverter * self, const struct cc_frame *frame,
+    const struct cdp_fps_entry *fps_entry, guint8 * out, guint out_size)
 {
-  GstMapInfo in, out;
-  const struct cdp_fps_entry *in_fps_entry, *out_fps_entry;
-  guint in_cc_data_len;
-  guint cc_data_len = MAX_CDP_PACKET_LEN, ccp_data_len = MAX_CDP_PACKET_LEN;
-  guint cea608_1_len = MAX_CEA608_LEN, cea608_2_len = MAX_CEA608_LEN;
-  guint8 cc_data[MAX_CDP_PACKET_LEN], ccp_data[MAX_CDP_PACKET_LEN];
-  guint8 cea608_1[MAX_CEA608_LEN], cea608_2[MAX_CEA608_LEN];
-  guint8 *in_cc_data;
-
-  if (inbuf) {
-    gst_buffer_map (inbuf, &in, GST_MAP_READ);
-    in_cc_data = in.data;
-    in_cc_data_len = in.size;
-    self->input_frames++;
-  } else {
-    in_cc_data = NULL;
-    in_cc_data_len = 0;
-  }
-
-  in_fps_entry = cdp_fps_entry_from_fps (self->in_fps_n, self->in_fps_d);
-  if (!in_fps_entry || in_fps_entry->fps_n == 0)
-    g_assert_not_reached ();
-
-  out_fps_entry = cdp_fps_entry_from_fps (self->out_fps_n, self->out_fps_d);
-  if (!out_fps_entry || out_fps_entry->fps_n == 0)
-    g_assert_not_reached ();
-
-  if (!cc_data_to_cea608_ccp (self, in_cc_data, in_cc_data_len, ccp_data,
-          &ccp_data_len, cea608_1, &cea608_1_len, cea608_2, &cea608_2_len,
-          in_fps_entry)) {
-    if (inbuf)
-      gst_buffer_unmap (inbuf, &in);
-    goto drop;
-  }
-
-  if (inbuf)
-    gst_buffer_unmap (inbuf, &in);
+  guint len = out_size;
 
-  if (!fit_and_scale_cc_data (self, in_fps_entry, out_fps_entry, ccp_data,
-          &ccp_data_len, cea608_1, &cea608_1_len, cea608_2, &cea608_2_len,
-          tc_meta ? &tc_meta->tc : NULL))
-    goto drop;
-
-  if (!combine_cc_data (self, TRUE, out_fps_entry, ccp_data, ccp_data_len,
-          cea608_1, cea608_1_len, cea608_2, cea608_2_len, cc_data,
-          &cc_data_len))
-    goto drop;
-
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-  cc_data_len =
-      convert_cea708_cc_data_cea708_cdp_internal (self, cc_data, cc_data_len,
-      out.data, out.size, &self->current_output_timecode, out_fps_entry);
-  self->output_frames++;
-  gst_buffer_unmap (outbuf, &out);
-
-out:
-  gst_buffer_set_size (outbuf, cc_data_len);
-
-  return GST_FLOW_OK;
+  if (!combine_cc_data (self, FALSE, fps_entry, self->queue_ccp,
+          frame->ccp_len, self->queue_cea608_1, frame->cea608_1_len,
+          self->queue_cea608_2, frame->cea608_2_len, out, &len))
+    return 0;
 
-drop:
-  cc_data_len = 0;
-  goto out;
+  return len;
 }
 
-static GstFlowReturn
-convert_cea708_cdp_cea608_raw (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf, const GstVideoTimeCodeMeta * tc_meta)
+static guint
+write_cea708_cdp (GstCCConverter * self, const struct cc_frame *frame,
+    const struct cdp_fps_entry *fps_entry, guint8 * out, guint out_size)
 {
-  GstMapInfo out;
-  GstVideoTimeCode tc = GST_VIDEO_TIME_CODE_INIT;
-  guint cea608_1_len;
-  const struct cdp_fps_entry *in_fps_entry = NULL, *out_fps_entry;
-
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-  cea608_1_len = (guint) out.size;
-  if (!cdp_to_cea608_cc_data (self, inbuf, NULL, NULL, out.data, &cea608_1_len,
-          NULL, NULL, &tc, &in_fps_entry)) {
-    gst_buffer_set_size (outbuf, 0);
-    return GST_FLOW_OK;
-  }
-
-  out_fps_entry = cdp_fps_entry_from_fps (self->out_fps_n, self->out_fps_d);
-  if (!out_fps_entry || out_fps_entry->fps_n == 0)
-    out_fps_entry = in_fps_entry;
-
-  if (fit_and_scale_cc_data (self, in_fps_entry, out_fps_entry, NULL, 0,
-          out.data, &cea608_1_len, NULL, NULL, &tc)) {
-    self->output_frames++;
-  } else {
-    cea608_1_len = 0;
-  }
-  gst_buffer_unmap (outbuf, &out);
-
-  gst_buffer_set_size (outbuf, cea608_1_len);
+  guint8 cc_data[MAX_CDP_PACKET_LEN];
+  guint cc_data_len = sizeof (cc_data);
 
-  if (self->current_output_timecode.config.fps_n != 0 && !tc_meta) {
-    gst_buffer_add_video_time_code_meta (outbuf,
-        &self->current_output_timecode);
-    gst_video_time_code_increment_frame (&self->current_output_timecode);
-  }
+  if (!combine_cc_data (self, TRUE, fps_entry, self->queue_ccp,
+          frame->ccp_len, self->queue_cea608_1, frame->cea608_1_len,
+          self->queue_cea608_2, frame->cea608_2_len, cc_data, &cc_data_len))
+    return 0;
 
-  return GST_FLOW_OK;
+  return convert_cea708_cc_data_cea708_cdp_internal (self, cc_data,
+      cc_data_len, out, out_size, &self->current_output_timecode, fps_entry);
 }
 
-static GstFlowReturn
-convert_cea708_cdp_cea608_s334_1a (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf, const GstVideoTimeCodeMeta * tc_meta)
-{
-  GstMapInfo out;
-  GstVideoTimeCode tc = GST_VIDEO_TIME_CODE_INIT;
-  const struct cdp_fps_entry *in_fps_entry = NULL, *out_fps_entry;
-  guint8 cea608_1[MAX_CEA608_LEN], cea608_2[MAX_CEA608_LEN];
-  guint cea608_1_len = MAX_CEA608_LEN, cea608_2_len = MAX_CEA608_LEN;
-  guint i, cc_data_len;
-
-  if (!cdp_to_cea608_cc_data (self, inbuf, NULL, NULL, cea608_1, &cea608_1_len,
-          cea608_2, &cea608_2_len, &tc, &in_fps_entry))
-    goto drop;
-
-  out_fps_entry = cdp_fps_entry_from_fps (self->out_fps_n, self->out_fps_d);
-  if (!out_fps_entry || out_fps_entry->fps_n == 0)
-    out_fps_entry = in_fps_entry;
-
-  if (!fit_and_scale_cc_data (self, in_fps_entry, out_fps_entry, NULL, 0,
-          cea608_1, &cea608_1_len, cea608_2, &cea608_2_len, &tc))
-    goto drop;
-
-  cc_data_len = gst_buffer_get_sizes (outbuf, NULL, NULL);
-
-  gst_buffer_map (outbuf, &out, GST_MAP_READWRITE);
-  if (!combine_cc_data (self, FALSE, out_fps_entry, NULL, 0, cea608_1,
-          cea608_1_len, cea608_2, cea608_2_len, out.data, &cc_data_len)) {
-    gst_buffer_unmap (outbuf, &out);
-    goto drop;
-  }
-
-  for (i = 0; i < cc_data_len / 3; i++)
-    /* We have to assume a line offset of 0 */
-    out.data[i * 3] = out.data[i * 3] == 0xfc ? 0x80 : 0x00;
-
-  gst_buffer_unmap (outbuf, &out);
-  self->output_frames++;
-
-  gst_buffer_set_size (outbuf, cc_data_len);
-
-  if (self->current_output_timecode.config.fps_n != 0 && !tc_meta) {
-    gst_buffer_add_video_time_code_meta (outbuf,
-        &self->current_output_timecode);
-    gst_video_time_code_increment_frame (&self->current_output_timecode);
-  }
-
-  return GST_FLOW_OK;
-
-drop:
-  gst_buffer_set_size (outbuf, 0);
-  return GST_FLOW_OK;
-}
+/* Every conversion goes through the same steps: the input is read into the
+ * queues, the scheduler decides how much of the queued data goes into the
+ * next output frame and the output is written from the front of the queues */
+static const GstCCConverterFormat cc_formats[] = {
+  {GST_VIDEO_CAPTION_TYPE_CEA608_RAW, FALSE, FALSE, read_cea608_raw,
+      write_cea608_raw},
+  {GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A, TRUE, FALSE, read_cea608_s334_1a,
+      write_cea608_s334_1a},
+  {GST_VIDEO_CAPTION_TYPE_CEA708_RAW, TRUE, TRUE, read_cea708_cc_data,
+      write_cea708_cc_data},
+  {GST_VIDEO_CAPTION_TYPE_CEA708_CDP, TRUE, TRUE, read_cea708_cdp,
+      write_cea708_cdp},
+};
 
-static GstFlowReturn
-convert_cea708_cdp_cea708_cc_data (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf, const GstVideoTimeCodeMeta * tc_meta)
+static const GstCCConverterFormat *
+cc_format_from_caption_type (GstVideoCaptionType caption_type)
 {
-  GstMapInfo out;
-  GstVideoTimeCode tc = GST_VIDEO_TIME_CODE_INIT;
-  const struct cdp_fps_entry *in_fps_entry = NULL, *out_fps_entry;
-  guint8 cea608_1[MAX_CEA608_LEN], cea608_2[MAX_CEA608_LEN];
-  guint8 ccp_data[MAX_CDP_PACKET_LEN];
-  guint cea608_1_len = MAX_CEA608_LEN, cea608_2_len = MAX_CEA608_LEN;
-  guint ccp_data_len = MAX_CDP_PACKET_LEN;
-  guint out_len = 0;
-
-  if (!cdp_to_cea608_cc_data (self, inbuf, ccp_data, &ccp_data_len,
-          cea608_1, &cea608_1_len, cea608_2, &cea608_2_len, &tc, &in_fps_entry))
-    goto out;
-
-  out_fps_entry = cdp_fps_entry_from_fps (self->out_fps_n, self->out_fps_d);
-  if (!out_fps_entry || out_fps_entry->fps_n == 0)
-    out_fps_entry = in_fps_entry;
-
-  if (!fit_and_scale_cc_data (self, in_fps_entry, out_fps_entry, ccp_data,
-          &ccp_data_len, cea608_1, &cea608_1_len, cea608_2, &cea608_2_len, &tc))
-    goto out;
-
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-  out_len = (guint) out.size;
-  if (!combine_cc_data (self, FALSE, out_fps_entry, ccp_data, ccp_data_len,
-          cea608_1, cea608_1_len, cea608_2, cea608_2_len, out.data, &out_len)) {
-    gst_buffer_unmap (outbuf, &out);
-    out_len = 0;
-    goto out;
-  }
-
-  gst_buffer_unmap (outbuf, &out);
-  self->output_frames++;
+  guint i;
 
-  if (self->current_output_timecode.config.fps_n != 0 && !tc_meta) {
-    gst_buffer_add_video_time_code_meta (outbuf,
-        &self->current_output_timecode);
-    gst_video_time_code_increment_frame (&self->current_output_timecode);
+  for (i = 0; i < G_N_ELEMENTS (cc_formats); i++) {
+    if (cc_formats[i].caption_type == caption_type)
+      return &cc_formats[i];
   }
 
-out:
-  gst_buffer_set_size (outbuf, out_len);
-
-  return GST_FLOW_OK;
+  return NULL;
 }
 
-static GstFlowReturn
-convert_cea708_cdp_cea708_cdp (GstCCConverter * self, GstBuffer * inbuf,
-    GstBuffer * outbuf)
+static gboolean
+gst_cc_converter_setup_conversion (GstCCConverter * self)
 {
-  GstMapInfo out;
-  GstVideoTimeCode tc = GST_VIDEO_TIME_CODE_INIT;
-  const struct cdp_fps_entry *in_fps_entry = NULL, *out_fps_entry;
-  guint8 cea608_1[MAX_CEA608_LEN], cea608_2[MAX_CEA608_LEN];
-  guint8 ccp_data[MAX_CDP_PACKET_LEN], cc_data[MAX_CDP_PACKET_LEN];
-  guint cea608_1_len = MAX_CEA608_LEN, cea608_2_len = MAX_CEA608_LEN;
-  guint ccp_data_len = MAX_CDP_PACKET_LEN, cc_data_len = MAX_CDP_PACKET_LEN;
-  guint out_len = 0;
-
-  if (!cdp_to_cea608_cc_data (self, inbuf, ccp_data, &ccp_data_len,
-          cea608_1, &cea608_1_len, cea608_2, &cea608_2_len, &tc, &in_fps_entry))
-    goto out;
-
-  out_fps_entry = cdp_fps_entry_from_fps (self->out_fps_n, self->out_fps_d);
-  if (!out_fps_entry || out_fps_entry->fps_n == 0)
-    out_fps_entry = in_fps_entry;
-
-  if (!fit_and_scale_cc_data (self, in_fps_entry, out_fps_entry, ccp_data,
-          &ccp_data_len, cea608_1, &cea608_1_len, cea608_2, &cea608_2_len, &tc))
-    goto out;
+  self->in_format = cc_format_from_caption_type (self->input_caption_type);
+  self->out_format = cc_format_from_caption_type (self->output_caption_type);
+  if (!self->in_format || !self->out_format)
+    return FALSE;
 
-  if (!combine_cc_data (self, TRUE, out_fps_entry, ccp_data, ccp_data_len,
-          cea608_1, cea608_1_len, cea608_2, cea608_2_len, cc_data,
-          &cc_data_len)) {
-    goto out;
+  if (self->input_caption_type == GST_VIDEO_CAPTION_TYPE_CEA708_CDP
+      || self->output_caption_type == GST_VIDEO_CAPTION_TYPE_CEA708_CDP) {
+    self->in_fps_entry =
+        cdp_fps_entry_from_fps (self->in_fps_n, self->in_fps_d);
+    self->out_fps_entry =
+        cdp_fps_entry_from_fps (self->out_fps_n, self->out_fps_d);
+    /* CDP input overrides this from the packets */
+    if (self->in_fps_entry->fps_n == 0)
+      self->in_fps_entry = self->out_fps_entry;
+  } else {
+    /* The framerate can't change without CDP on either side */
+    self->in_fps_entry = &non_cdp_fps_entry;
+    self->out_fps_entry = &non_cdp_fps_entry;
   }
 
-  gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
-  out_len =
-      convert_cea708_cc_data_cea708_cdp_internal (self, cc_data, cc_data_len,
-      out.data, out.size, &self->current_output_timecode, out_fps_entry);
-
-  gst_buffer_unmap (outbuf, &out);
-  self->output_frames++;
-
-out:
-  gst_buffer_set_size (outbuf, out_len);
-
-  return GST_FLOW_OK;
+  return TRUE;
 }
 
 static GstFlowReturn
@@ -2150,7 +1536,12 @@ gst_cc_converter_transform (GstCCConverter * self, GstBuffer * inbuf,
     GstBuffer * outbuf)
 {
   GstVideoTimeCodeMeta *tc_meta = NULL;
-  GstFlowReturn ret = GST_FLOW_OK;
+  GstVideoTimeCode cdp_tc = GST_VIDEO_TIME_CODE_INIT;
+  const GstVideoTimeCode *tc = NULL;
+  const struct cdp_fps_entry *in_fps_entry, *out_fps_entry;
+  struct cc_frame frame;
+  GstMapInfo map;
+  guint len = 0;
 
   GST_DEBUG_OBJECT (self, "Converting %" GST_PTR_FORMAT " from %u to %u", inbuf,
       self->input_caption_type, self->output_caption_type);
@@ -2177,112 +1568,49 @@ gst_cc_converter_transform (GstCCConverter * self, GstBuffer * inbuf,
     }
   }
 
-  switch (self->input_caption_type) {
-    case GST_VIDEO_CAPTION_TYPE_CEA608_RAW:
-
-      switch (self->output_caption_type) {
-        case GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A:
-          ret = convert_cea608_raw_cea608_s334_1a (self, inbuf, outbuf);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA708_RAW:
-          ret = convert_cea608_raw_cea708_cc_data (self, inbuf, outbuf);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA708_CDP:
-          ret = convert_cea608_raw_cea708_cdp (self, inbuf, outbuf, tc_meta);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA608_RAW:
-        default:
-          g_assert_not_reached ();
-          break;
-      }
+  if (inbuf) {
+    /* CDP input updates the input framerate from the packets, which is also
+     * used for draining */
+    gst_buffer_map (inbuf, &map, GST_MAP_READ);
+    self->in_format->read (self, map.data, map.size, &cdp_tc,
+        &self->in_fps_entry);
+    gst_buffer_unmap (inbuf, &map);
+    self->input_frames++;
+  }
+  in_fps_entry = self->in_fps_entry;
 
-      break;
-    case GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A:
-
-      switch (self->output_caption_type) {
-        case GST_VIDEO_CAPTION_TYPE_CEA608_RAW:
-          ret = convert_cea608_s334_1a_cea608_raw (self, inbuf, outbuf);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA708_RAW:
-          ret = convert_cea608_s334_1a_cea708_cc_data (self, inbuf, outbuf);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA708_CDP:
-          ret =
-              convert_cea608_s334_1a_cea708_cdp (self, inbuf, outbuf, tc_meta);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A:
-        default:
-          g_assert_not_reached ();
-          break;
-      }
+  /* CDP carries its own time code */
+  if (self->input_caption_type == GST_VIDEO_CAPTION_TYPE_CEA708_CDP)
+    tc = &cdp_tc;
+  else if (tc_meta)
+    tc = &tc_meta->tc;
 
-      break;
-    case GST_VIDEO_CAPTION_TYPE_CEA708_RAW:
-
-      switch (self->output_caption_type) {
-        case GST_VIDEO_CAPTION_TYPE_CEA608_RAW:
-          ret = convert_cea708_cc_data_cea608_raw (self, inbuf, outbuf);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A:
-          ret = convert_cea708_cc_data_cea608_s334_1a (self, inbuf, outbuf);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA708_CDP:
-          ret =
-              convert_cea708_cc_data_cea708_cdp (self, inbuf, outbuf, tc_meta);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA708_RAW:
-        default:
-          g_assert_not_reached ();
-          break;
-      }
+  out_fps_entry = self->out_fps_entry;
+  if (out_fps_entry->fps_n == 0)
+    out_fps_entry = in_fps_entry;
 
-      break;
-    case GST_VIDEO_CAPTION_TYPE_CEA708_CDP:
-
-      switch (self->output_caption_type) {
-        case GST_VIDEO_CAPTION_TYPE_CEA608_RAW:
-          ret = convert_cea708_cdp_cea608_raw (self, inbuf, outbuf, tc_meta);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A:
-          ret =
-              convert_cea708_cdp_cea608_s334_1a (self, inbuf, outbuf, tc_meta);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA708_RAW:
-          ret =
-              convert_cea708_cdp_cea708_cc_data (self, inbuf, outbuf, tc_meta);
-          break;
-        case GST_VIDEO_CAPTION_TYPE_CEA708_CDP:
-          ret = convert_cea708_cdp_cea708_cdp (self, inbuf, outbuf);
-          break;
-        default:
-          g_assert_not_reached ();
-          break;
-      }
+  if (take_output_frame (self, in_fps_entry, out_fps_entry, tc, &frame)) {
+    gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+    len = self->out_format->write (self, &frame, out_fps_entry, map.data,
+        map.size);
+    gst_buffer_unmap (outbuf, &map);
 
-      break;
-    default:
-      g_assert_not_reached ();
-      break;
+    queue_pop (self, &frame);
+    self->output_frames++;
   }
 
-  if (ret != GST_FLOW_OK) {
-    GST_DEBUG_OBJECT (self, "returning %s", gst_flow_get_name (ret));
-    return ret;
-  }
+  gst_video_time_code_clear (&cdp_tc);
+  gst_buffer_set_size (outbuf, len);
 
   GST_DEBUG_OBJECT (self, "Converted to %" GST_PTR_FORMAT, outbuf);
 
-  if (gst_buffer_get_size (outbuf) > 0) {
-    if (self->current_output_timecode.config.fps_n > 0) {
-      gst_buffer_add_video_time_code_meta (outbuf,
-          &self->current_output_timecode);
-      gst_video_time_code_increment_frame (&self->current_output_timecode);
-    }
-
-    return GST_FLOW_OK;
-  } else {
-    return GST_FLOW_OK;
+  if (len > 0 && self->current_output_timecode.config.fps_n > 0) {
+    gst_buffer_add_video_time_code_meta (outbuf,
+        &self->current_output_timecode);
+    gst_video_time_code_increment_frame (&self->current_output_timecode);
   }
+
+  return GST_FLOW_OK;
 }
 
 static gboolean
@@ -2332,9 +1660,9 @@ can_generate_output (GstCCConverter * self)
 static void
 reset_counters (GstCCConverter * self)
 {
-  self->scratch_ccp_len = 0;
-  self->scratch_cea608_1_len = 0;
-  self->scratch_cea608_2_len = 0;
+  self->queue_ccp_len = 0;
+  self->queue_cea608_1_len = 0;
+  self->queue_cea608_2_len = 0;
   self->input_frames = 0;
   self->output_frames = 1;
   gst_video_time_code_clear (&self->current_output_timecode);
@@ -2348,8 +1676,8 @@ drain_input (GstCCConverter * self)
   GstBaseTransform *trans = GST_BASE_TRANSFORM (self);
   GstFlowReturn ret = GST_FLOW_OK;
 
-  while (self->scratch_ccp_len > 0 || self->scratch_cea608_1_len > 0
-      || self->scratch_cea608_2_len > 0 || can_generate_output (self)) {
+  while (self->queue_ccp_len > 0 || self->queue_cea608_1_len > 0
+      || self->queue_cea608_2_len > 0 || can_generate_output (self)) {
     GstBuffer *outbuf;
 
     if (!self->previous_buffer) {
@@ -2483,9 +1811,9 @@ gst_cc_converter_start (GstBaseTransform * base)
   self->current_output_timecode = (GstVideoTimeCode) GST_VIDEO_TIME_CODE_INIT;
   self->input_frames = 0;
   self->output_frames = 1;
-  self->scratch_ccp_len = 0;
-  self->scratch_cea608_1_len = 0;
-  self->scratch_cea608_2_len = 0;
+  self->queue_ccp_len = 0;
+  self->queue_cea608_1_len = 0;
+  self->queue_cea608_2_len = 0;
 
   return TRUE;
 }
@@ -39,6 +39,8 @@ G_BEGIN_DECLS
 
 typedef struct _GstCCConverter GstCCConverter;
 typedef struct _GstCCConverterClass GstCCConverterClass;
+typedef struct _GstCCConverterFormat GstCCConverterFormat;
+struct cdp_fps_entry;
 
 #define MAX_CDP_PACKET_LEN 256
 #define MAX_CEA608_LEN 32
@@ -64,15 +66,21 @@ struct _GstCCConverter
   gint in_fps_n, in_fps_d;
   gint out_fps_n, out_fps_d;
 
+  /* Conversion functions and CDP framerate limits for the current caps */
+  const GstCCConverterFormat *in_format;
+  const GstCCConverterFormat *out_format;
+  const struct cdp_fps_entry *in_fps_entry;
+  const struct cdp_fps_entry *out_fps_entry;
+
   /* for framerate differences, we need to keep previous/next frames in order
    * to split/merge data across multiple input or output buffers.  The data is
-   * stored as cc_data */
-  guint8    scratch_cea608_1[MAX_CEA608_LEN];
-  guint     scratch_cea608_1_len;
-  guint8    scratch_cea608_2[MAX_CEA608_LEN];
-  guint     scratch_cea608_2_len;
-  guint8    scratch_ccp[MAX_CDP_PACKET_LEN];
-  guint     scratch_ccp_len;
+   * queued per field and for the CEA708 ccp data */
+  guint8    queue_cea608_1[MAX_CEA608_LEN];
+  guint     queue_cea608_1_len;
+  guint8    queue_cea608_2[MAX_CEA608_LEN];
+  guint     queue_cea608_2_len;
+  guint8    queue_ccp[MAX_CDP_PACKET_LEN];
+  guint     queue_ccp_len;
 
   guint     input_frames;
   guint     output_frames;
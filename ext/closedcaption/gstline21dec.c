@@ -337,12 +337,17 @@ gst_line_21_decoder_set_info (GstVideoFilter * filter,
       self->info = gst_video_info_new ();
       gst_video_info_set_format (self->info, GST_VIDEO_FORMAT_I420,
           GST_VIDEO_INFO_WIDTH (in_info), GST_VIDEO_INFO_HEIGHT (in_info));
-      /* Allocate space for two *I420* Y lines (with stride) */
+      /* Allocate space for all probed *I420* Y lines (with stride), plus
+       * the second field line of the last one */
       self->converted_lines =
-          g_malloc0 (2 * GST_VIDEO_INFO_COMP_STRIDE (self->info, 0));
+          g_malloc0 ((self->max_line_probes + 1) *
+          GST_VIDEO_INFO_COMP_STRIDE (self->info, 0));
     } else
       self->info = gst_video_info_copy (in_info);
 
+    self->luma_offset = GST_VIDEO_INFO_COMP_POFFSET (self->info, 0);
+    self->luma_pstride = GST_VIDEO_INFO_COMP_PSTRIDE (self->info, 0);
+
     /* initialize the decoder */
     if (self->zvbi_decoder.pattern != NULL)
       vbi_raw_decoder_reset (&self->zvbi_decoder);
@@ -450,27 +455,74 @@ convert_line_v210_luma (const guint8 * orig, guint8 * dest, guint width)
   }
 }
 
+/* Returns the data starting at @line, with the following line (of the
+ * other field) right after it */
 static guint8 *
 get_video_data (GstLine21Decoder * self, GstVideoFrame * frame, gint line)
 {
-  guint8 *data = self->converted_lines;
+  guint stride = GST_VIDEO_INFO_COMP_STRIDE (self->info, 0);
   guint8 *v210;
+  gint i;
 
   if (!self->convert_v210)
-    return (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame,
-        0) + line * GST_VIDEO_INFO_COMP_STRIDE (self->info, 0);
-
-  v210 = (guint8 *)
-      GST_VIDEO_FRAME_PLANE_DATA (frame,
-      0) + line * GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
-
-  /* Convert v210 to I420 */
-  convert_line_v210_luma (v210, data, GST_VIDEO_FRAME_WIDTH (frame));
-  v210 += GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
-  convert_line_v210_luma (v210, data + GST_VIDEO_INFO_COMP_STRIDE (self->info,
-          0), GST_VIDEO_FRAME_WIDTH (frame));
-  GST_MEMDUMP ("converted", self->converted_lines, 64);
-  return self->converted_lines;
+    return (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0) + line * stride;
+
+  /* Convert v210 to I420, each line at most once per frame */
+  for (i = line; i <= line + 1; i++) {
+    if (self->converted_mask & (G_GUINT64_CONSTANT (1) << i))
+      continue;
+
+    v210 = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0) +
+        i * GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+    convert_line_v210_luma (v210, self->converted_lines + i * stride,
+        GST_VIDEO_FRAME_WIDTH (frame));
+    self->converted_mask |= G_GUINT64_CONSTANT (1) << i;
+  }
+
+  GST_MEMDUMP ("converted", self->converted_lines + line * stride, 64);
+  return self->converted_lines + line * stride;
+}
+
+/* The clock run-in and data of line 21 are about 50 IRE, i.e. a luma range of
+ * about 110. Lines with a much smaller range can't carry CC and are skipped
+ * without running the bit slicer on them */
+#define MIN_CC_LUMA_RANGE 32
+
+static gboolean
+line_has_cc_range (const guint8 * data, guint width, guint pstride)
+{
+  guint8 min = 0xff, max = 0x00;
+  guint i;
+
+  /* Planar luma gets its own loop with a unit stride */
+  if (pstride == 1) {
+    for (i = 0; i < width; i++) {
+      min = MIN (min, data[i]);
+      max = MAX (max, data[i]);
+    }
+  } else {
+    for (i = 0; i < width; i++) {
+      min = MIN (min, data[i * pstride]);
+      max = MAX (max, data[i * pstride]);
+    }
+  }
+
+  return max - min >= MIN_CC_LUMA_RANGE;
+}
+
+/* Tries to decode CC from @line and the following line of the other field */
+static gboolean
+decode_lines (GstLine21Decoder * self, GstVideoFrame * frame, gint line,
+    vbi_sliced * sliced)
+{
+  gint n_lines;
+
+  n_lines = vbi_raw_decode (&self->zvbi_decoder,
+      get_video_data (self, frame, line), sliced);
+  GST_DEBUG_OBJECT (self, "i:%d n_lines:%d", line, n_lines);
+
+  /* Only accept when both fields have CC */
+  return n_lines == 2;
 }
 
 static gboolean
@@ -499,31 +551,44 @@ gst_line_21_decoder_scan (GstLine21Decoder * self, GstVideoFrame * frame)
     return FALSE;
   }
 
-  GST_DEBUG_OBJECT (self, "Starting probing. max_line_probes:%d",
-      self->max_line_probes);
+  self->converted_mask = 0;
 
-  i = self->line21_offset;
-  if (i == -1) {
-    GST_DEBUG_OBJECT (self, "Scanning from the beginning");
-    i = 0;
+  /* The line found in the previous frame is the most likely one, so try it
+   * alone first */
+  if (self->line21_offset != -1) {
+    i = self->line21_offset;
+    found = decode_lines (self, frame, i, sliced);
+    if (!found)
+      GST_DEBUG_OBJECT (self, "No CC at previous offset %d anymore", i);
   }
 
-  for (; i < self->max_line_probes && i < GST_VIDEO_FRAME_HEIGHT (frame); i++) {
-    gint n_lines;
-    data = get_video_data (self, frame, i);
-    /* Scan until we get n_lines == 2 */
-    n_lines = vbi_raw_decode (&self->zvbi_decoder, data, sliced);
-    GST_DEBUG_OBJECT (self, "i:%d n_lines:%d", i, n_lines);
-    if (n_lines == 2) {
-      GST_DEBUG_OBJECT (self, "Found 2 CC lines at offset %d", i);
-      self->line21_offset = i;
-      found = TRUE;
-      break;
-    } else if (i == self->line21_offset) {
-      /* Otherwise if this was the previously probed line offset,
-       * reset and start searching again from the beginning */
-      i = -1;
-      self->line21_offset = -1;
+  if (!found) {
+    gboolean has_range[64];
+    gint n_probes, width = GST_VIDEO_FRAME_WIDTH (frame);
+
+    n_probes = MIN (self->max_line_probes, GST_VIDEO_FRAME_HEIGHT (frame) - 1);
+
+    GST_DEBUG_OBJECT (self, "Starting probing. max_line_probes:%d", n_probes);
+
+    /* Check all candidate lines at once, only pairs of lines that both look
+     * like they could carry CC go through the bit slicer */
+    for (i = 0; i <= n_probes; i++) {
+      data = get_video_data (self, frame, MIN (i, n_probes - 1));
+      if (i == n_probes)
+        data += GST_VIDEO_INFO_COMP_STRIDE (self->info, 0);
+      has_range[i] = line_has_cc_range (data + self->luma_offset, width,
+          self->luma_pstride);
+    }
+
+    for (i = 0; i < n_probes; i++) {
+      if (i == self->line21_offset || !has_range[i] || !has_range[i + 1])
+        continue;
+
+      if (decode_lines (self, frame, i, sliced)) {
+        GST_DEBUG_OBJECT (self, "Found 2 CC lines at offset %d", i);
+        found = TRUE;
+        break;
+      }
     }
   }
 
@@ -533,6 +598,8 @@ gst_line_21_decoder_scan (GstLine21Decoder * self, GstVideoFrame * frame)
     guint base_line1 = 0, base_line2 = 0;
     guint8 ccdata[6] = { 0x80, 0x80, 0x80, 0x00, 0x80, 0x80 };  /* Initialize the ccdata */
 
+    self->line21_offset = i;
+
     if (GST_VIDEO_FRAME_HEIGHT (frame) == 525) {
       base_line1 = 9;
       base_line2 = 272;
@@ -63,8 +63,15 @@ struct _GstLine21Decoder
   /* Whether input data is v210 and needs to be converted before
    * processing */
   gboolean convert_v210;
+  /* One converted line per probed line, the bits of converted_mask tell
+   * which ones have been converted for the current frame */
   guint8 *converted_lines;
-  
+  guint64 converted_mask;
+
+  /* Location of the luma samples in a line, for probing lines */
+  guint luma_offset;
+  guint luma_pstride;
+
   GstVideoInfo *info;
 
   gboolean ntsc_only;
@@ -56,24 +56,6 @@ GST_DEBUG_CATEGORY_EXTERN (gst_debug_srtobject);
   GST_ELEMENT_WARNING (srtobject->element, RESOURCE, code, \
   ("Error on SRT socket. Trying to reconnect."), SRTSOCK_ERROR_DEBUG)
 
-enum
-{
-  PROP_URI = 1,
-  PROP_MODE,
-  PROP_LOCALADDRESS,
-  PROP_LOCALPORT,
-  PROP_PASSPHRASE,
-  PROP_PBKEYLEN,
-  PROP_POLL_TIMEOUT,
-  PROP_LATENCY,
-  PROP_MSG_SIZE,
-  PROP_STATS,
-  PROP_WAIT_FOR_CONNECTION,
-  PROP_STREAMID,
-  PROP_AUTHENTICATION,
-  PROP_LAST
-};
-
 typedef struct
 {
   SRTSOCKET sock;
@@ -361,6 +343,7 @@ gst_srt_object_new (GstElement * element)
   srtobject->element = element;
   srtobject->parameters = gst_structure_new_empty ("application/x-srt-params");
   srtobject->sock = SRT_INVALID_SOCK;
+  srtobject->read_sock = SRT_INVALID_SOCK;
   srtobject->poll_id = srt_epoll_create ();
   srtobject->listener_sock = SRT_INVALID_SOCK;
   srtobject->listener_poll_id = SRT_ERROR;
@@ -1413,6 +1396,8 @@ gst_srt_object_close (GstSRTObject * srtobject)
     srtobject->sock = SRT_INVALID_SOCK;
   }
 
+  srtobject->read_sock = SRT_INVALID_SOCK;
+
   if (srtobject->listener_poll_id != SRT_ERROR) {
     if (srtobject->listener_sock != SRT_INVALID_SOCK) {
       srt_epoll_remove_usock (srtobject->listener_poll_id,
@@ -1584,12 +1569,44 @@ gst_srt_object_read (GstSRTObject * srtobject,
         return -1;
       }
     }
+
+    srtobject->read_sock = rsock;
     break;
   }
 
   return len;
 }
 
+/* Receives a message that is already pending on the socket the last
+ * gst_srt_object_read() returned data from, without waiting. Returns 0 if
+ * there is none. Errors are left for the next gst_srt_object_read() to
+ * report. */
+gssize
+gst_srt_object_read_pending (GstSRTObject * srtobject, guint8 * data,
+    gsize size, SRT_MSGCTRL * mctrl)
+{
+  gssize len;
+
+  if (srtobject->read_sock == SRT_INVALID_SOCK)
+    return 0;
+
+  srt_msgctrl_init (mctrl);
+  len = srt_recvmsg2 (srtobject->read_sock, (char *) (data), size, mctrl);
+
+  if (len == SRT_ERROR) {
+    gint srt_errno = srt_getlasterror (NULL);
+
+    if (srt_errno != SRT_EASYNCRCV) {
+      GST_DEBUG_OBJECT (srtobject->element,
+          "Failed to receive pending message: %s", srt_getlasterror_str ());
+    }
+    srtobject->read_sock = SRT_INVALID_SOCK;
+    return 0;
+  }
+
+  return len;
+}
+
 void
 gst_srt_object_wakeup (GstSRTObject * srtobject, GCancellable * cancellable)
 {
@@ -43,6 +43,24 @@ G_BEGIN_DECLS
 #define GST_SRT_DEFAULT_MSG_SIZE 1316
 #define GST_SRT_DEFAULT_WAIT_FOR_CONNECTION (TRUE)
 
+enum
+{
+  PROP_URI = 1,
+  PROP_MODE,
+  PROP_LOCALADDRESS,
+  PROP_LOCALPORT,
+  PROP_PASSPHRASE,
+  PROP_PBKEYLEN,
+  PROP_POLL_TIMEOUT,
+  PROP_LATENCY,
+  PROP_MSG_SIZE,
+  PROP_STATS,
+  PROP_WAIT_FOR_CONNECTION,
+  PROP_STREAMID,
+  PROP_AUTHENTICATION,
+  PROP_LAST
+};
+
 typedef struct _GstSRTObject GstSRTObject;
 
 struct _GstSRTObject
@@ -56,6 +74,9 @@ struct _GstSRTObject
   gint                          poll_id;
   gboolean                      sent_headers;
 
+  /* Socket the last read returned data from */
+  SRTSOCKET                     read_sock;
+
   GTask                        *listener_task;
   SRTSOCKET                     listener_sock;
   gint                          listener_poll_id;
@@ -103,6 +124,10 @@ gssize          gst_srt_object_read     (GstSRTObject * srtobject,
                                          GError **err,
 					 SRT_MSGCTRL *mctrl);
 
+gssize          gst_srt_object_read_pending (GstSRTObject * srtobject,
+                                         guint8 *data, gsize size,
+                                         SRT_MSGCTRL *mctrl);
+
 gssize          gst_srt_object_write    (GstSRTObject * srtobject,
                                          GstBufferList * headers,
                                          const GstMapInfo * mapinfo,
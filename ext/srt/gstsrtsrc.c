@@ -48,6 +48,8 @@
 #include "gstsrtelements.h"
 #include "gstsrtsrc.h"
 
+#include <string.h>
+
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -67,6 +69,18 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+/* The properties shared with srtsink are installed by
+ * gst_srt_object_install_properties_helper() */
+enum
+{
+  PROP_CAPS = PROP_LAST,
+  PROP_MAX_MESSAGES,
+  PROP_COALESCE,
+};
+
+#define DEFAULT_MAX_MESSAGES 1
+#define DEFAULT_COALESCE FALSE
+
 static void gst_srt_src_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 static gchar *gst_srt_src_uri_get_uri (GstURIHandler * handler);
@@ -104,6 +118,38 @@ src_authentication_accumulator (GSignalInvocationHint * ihint,
   return ret;
 }
 
+/* Coalesced buffers hold all the messages of one wakeup, which is more than
+ * the negotiated pool hands out. They come from a pool of our own that is
+ * only reconfigured when blocksize or max-messages change. */
+static gboolean
+gst_srt_src_configure_coalesce_pool (GstSRTSrc * self, guint size)
+{
+  GstStructure *config;
+
+  if (self->coalesce_pool) {
+    if (self->coalesce_size == size)
+      return TRUE;
+
+    GST_DEBUG_OBJECT (self, "Resizing coalesce pool from %u to %u bytes",
+        self->coalesce_size, size);
+    gst_buffer_pool_set_active (self->coalesce_pool, FALSE);
+    gst_clear_object (&self->coalesce_pool);
+  }
+
+  self->coalesce_pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (self->coalesce_pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+
+  if (!gst_buffer_pool_set_config (self->coalesce_pool, config) ||
+      !gst_buffer_pool_set_active (self->coalesce_pool, TRUE)) {
+    gst_clear_object (&self->coalesce_pool);
+    return FALSE;
+  }
+  self->coalesce_size = size;
+
+  return TRUE;
+}
+
 static gboolean
 gst_srt_src_start (GstBaseSrc * bsrc)
 {
@@ -127,6 +173,24 @@ gst_srt_src_start (GstBaseSrc * bsrc)
   /* Reset expected pktseq */
   self->next_pktseq = 0;
 
+  if (ret) {
+    guint size;
+    gboolean coalesce;
+
+    GST_OBJECT_LOCK (self);
+    size = self->max_messages;
+    coalesce = self->coalesce;
+    GST_OBJECT_UNLOCK (self);
+    size *= gst_base_src_get_blocksize (bsrc);
+
+    if (coalesce && !gst_srt_src_configure_coalesce_pool (self, size)) {
+      GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ, (NULL),
+          ("Failed to set up a buffer pool of size %u", size));
+      gst_srt_object_close (self->srtobject);
+      ret = FALSE;
+    }
+  }
+
   return ret;
 }
 
@@ -137,47 +201,35 @@ gst_srt_src_stop (GstBaseSrc * bsrc)
 
   gst_srt_object_close (self->srtobject);
 
+  if (self->coalesce_pool) {
+    gst_buffer_pool_set_active (self->coalesce_pool, FALSE);
+    gst_clear_object (&self->coalesce_pool);
+  }
+
   return TRUE;
 }
 
-static GstFlowReturn
-gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
+/* Receives one message into @data. The first message of a batch waits for
+ * data to arrive, the following ones only take what is already pending. */
+static gssize
+gst_srt_src_receive (GstSRTSrc * self, gboolean wait, guint8 * data,
+    gsize size, GstClock * clock, GstClockTime base_time,
+    GstClockTime * timestamp, gboolean * discont, GError ** err)
 {
-  GstSRTSrc *self = GST_SRT_SRC (src);
-  GstFlowReturn ret = GST_FLOW_OK;
-  GstMapInfo info;
-  GError *err = NULL;
   gssize recv_len;
-  GstClock *clock;
-  GstClockTime base_time;
   GstClockTime capture_time;
   GstClockTimeDiff delay;
   int64_t srt_time;
   SRT_MSGCTRL mctrl;
 
-  if (g_cancellable_is_cancelled (self->cancellable)) {
-    ret = GST_FLOW_FLUSHING;
-  }
-
-  if (!gst_buffer_map (outbuf, &info, GST_MAP_WRITE)) {
-    GST_ELEMENT_ERROR (src, RESOURCE, READ,
-        ("Could not map the buffer for writing "), (NULL));
-    ret = GST_FLOW_ERROR;
-    goto out;
-  }
-
-  /* Get clock and values */
-  clock = gst_element_get_clock (GST_ELEMENT (src));
-  if (!clock) {
-    GST_DEBUG_OBJECT (src, "Clock missing, flushing");
-    return GST_FLOW_FLUSHING;
+  if (wait) {
+    recv_len = gst_srt_object_read (self->srtobject, data, size,
+        self->cancellable, err, &mctrl);
+  } else {
+    recv_len = gst_srt_object_read_pending (self->srtobject, data, size,
+        &mctrl);
   }
 
-  base_time = gst_element_get_base_time (GST_ELEMENT (src));
-
-  recv_len = gst_srt_object_read (self->srtobject, info.data,
-      gst_buffer_get_size (outbuf), self->cancellable, &err, &mctrl);
-
   /* Capture clock values ASAP */
   capture_time = gst_clock_get_time (clock);
 #if SRT_VERSION_VALUE >= 0x10402
@@ -187,34 +239,20 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
   /* Else use the unix epoch monotonic clock */
   srt_time = g_get_real_time ();
 #endif
-  gst_object_unref (clock);
 
-  gst_buffer_unmap (outbuf, &info);
+  if (recv_len <= 0)
+    return recv_len;
 
-  GST_LOG_OBJECT (src,
+  GST_LOG_OBJECT (self,
       "recv_len:%" G_GSIZE_FORMAT " pktseq:%d msgno:%d srctime:%"
       G_GINT64_FORMAT, recv_len, mctrl.pktseq, mctrl.msgno, mctrl.srctime);
 
-  if (g_cancellable_is_cancelled (self->cancellable)) {
-    ret = GST_FLOW_FLUSHING;
-    goto out;
-  }
-
-  if (recv_len < 0) {
-    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL), ("%s", err->message));
-    ret = GST_FLOW_ERROR;
-    g_clear_error (&err);
-    goto out;
-  } else if (recv_len == 0) {
-    ret = GST_FLOW_EOS;
-    goto out;
-  }
-
   /* Detect discontinuities */
+  *discont = FALSE;
   if (mctrl.pktseq != self->next_pktseq) {
-    GST_WARNING_OBJECT (src, "discont detected %d (expected: %d)",
+    GST_WARNING_OBJECT (self, "discont detected %d (expected: %d)",
         mctrl.pktseq, self->next_pktseq);
-    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+    *discont = TRUE;
   }
   /* pktseq is a 31bit field */
   self->next_pktseq = (mctrl.pktseq + 1) % G_MAXINT32;
@@ -225,10 +263,10 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
   else
     delay = 0;
 
-  GST_LOG_OBJECT (src, "delay: %" GST_STIME_FORMAT, GST_STIME_ARGS (delay));
+  GST_LOG_OBJECT (self, "delay: %" GST_STIME_FORMAT, GST_STIME_ARGS (delay));
 
   if (delay < 0) {
-    GST_WARNING_OBJECT (src,
+    GST_WARNING_OBJECT (self,
         "Calculated SRT delay %" GST_STIME_FORMAT " is negative, clamping to 0",
         GST_STIME_ARGS (delay));
     delay = 0;
@@ -244,20 +282,190 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
     capture_time -= delay;
   else
     capture_time = 0;
-  GST_BUFFER_TIMESTAMP (outbuf) = capture_time;
+  *timestamp = capture_time;
 
-  gst_buffer_resize (outbuf, 0, recv_len);
+  return recv_len;
+}
 
-  GST_LOG_OBJECT (src,
+/* Coalesced buffers come from the coalesce pool and have its size, the
+ * other ones have @size */
+static GstFlowReturn
+gst_srt_src_alloc_buffer (GstSRTSrc * self, gboolean coalesce, gsize size,
+    GstBuffer ** buffer, GstMapInfo * info)
+{
+  GstBaseSrc *bsrc = GST_BASE_SRC (self);
+  GstFlowReturn ret;
+
+  if (coalesce)
+    ret = gst_buffer_pool_acquire_buffer (self->coalesce_pool, buffer, NULL);
+  else
+    ret = GST_BASE_SRC_GET_CLASS (bsrc)->alloc (bsrc, -1, size, buffer);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  if (!gst_buffer_map (*buffer, info, GST_MAP_WRITE)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, READ,
+        ("Could not map the buffer for writing "), (NULL));
+    gst_clear_buffer (buffer);
+    return GST_FLOW_ERROR;
+  }
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_srt_src_finish_buffer (GstSRTSrc * self, GstBuffer * buffer,
+    GstMapInfo * info, gsize size, GstBufferList * list)
+{
+  gst_buffer_unmap (buffer, info);
+  gst_buffer_resize (buffer, 0, size);
+
+  GST_LOG_OBJECT (self,
       "filled buffer from _get of size %" G_GSIZE_FORMAT ", ts %"
       GST_TIME_FORMAT ", dur %" GST_TIME_FORMAT
       ", offset %" G_GINT64_FORMAT ", offset_end %" G_GINT64_FORMAT,
-      gst_buffer_get_size (outbuf),
-      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (outbuf)),
-      GST_TIME_ARGS (GST_BUFFER_DURATION (outbuf)),
-      GST_BUFFER_OFFSET (outbuf), GST_BUFFER_OFFSET_END (outbuf));
+      gst_buffer_get_size (buffer),
+      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)),
+      GST_TIME_ARGS (GST_BUFFER_DURATION (buffer)),
+      GST_BUFFER_OFFSET (buffer), GST_BUFFER_OFFSET_END (buffer));
+
+  gst_buffer_list_add (list, buffer);
+}
+
+static GstFlowReturn
+gst_srt_src_create (GstPushSrc * src, GstBuffer ** outbuf)
+{
+  GstSRTSrc *self = GST_SRT_SRC (src);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList *list;
+  GstBuffer *buffer = NULL;
+  GstMapInfo info;
+  GError *err = NULL;
+  gssize recv_len;
+  GstClock *clock;
+  GstClockTime base_time;
+  GstClockTime timestamp;
+  gboolean discont, coalesce;
+  guint blocksize, max_messages, n;
+  gsize offset = 0;
+
+  if (g_cancellable_is_cancelled (self->cancellable)) {
+    return GST_FLOW_FLUSHING;
+  }
+
+  /* Get clock and values */
+  clock = gst_element_get_clock (GST_ELEMENT (src));
+  if (!clock) {
+    GST_DEBUG_OBJECT (src, "Clock missing, flushing");
+    return GST_FLOW_FLUSHING;
+  }
+
+  base_time = gst_element_get_base_time (GST_ELEMENT (src));
+
+  GST_OBJECT_LOCK (self);
+  max_messages = self->max_messages;
+  coalesce = self->coalesce;
+  GST_OBJECT_UNLOCK (self);
+
+  blocksize = gst_base_src_get_blocksize (GST_BASE_SRC (src));
+  if (coalesce && !gst_srt_src_configure_coalesce_pool (self,
+          blocksize * max_messages)) {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("Failed to set up a buffer pool of size %u",
+            blocksize * max_messages));
+    gst_object_unref (clock);
+    return GST_FLOW_ERROR;
+  }
+
+  list = gst_buffer_list_new_sized (coalesce ? 1 : max_messages);
+
+  for (n = 0; n < max_messages; n++) {
+    if (buffer && info.size - offset < blocksize) {
+      gst_srt_src_finish_buffer (self, buffer, &info, offset, list);
+      buffer = NULL;
+    }
+
+    if (!buffer) {
+      ret = gst_srt_src_alloc_buffer (self, coalesce, blocksize, &buffer,
+          &info);
+      if (ret != GST_FLOW_OK)
+        goto out;
+      offset = 0;
+    }
+
+    recv_len = gst_srt_src_receive (self, n == 0, info.data + offset,
+        info.size - offset, clock, base_time, &timestamp, &discont, &err);
+
+    if (n == 0) {
+      if (g_cancellable_is_cancelled (self->cancellable)) {
+        ret = GST_FLOW_FLUSHING;
+        goto out;
+      }
+
+      if (recv_len < 0) {
+        GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL), ("%s", err->message));
+        ret = GST_FLOW_ERROR;
+        g_clear_error (&err);
+        goto out;
+      } else if (recv_len == 0) {
+        ret = GST_FLOW_EOS;
+        goto out;
+      }
+    } else if (recv_len <= 0) {
+      /* Nothing pending anymore */
+      break;
+    }
+
+    if (discont && offset > 0) {
+      GstBuffer *next;
+      GstMapInfo next_info;
+
+      /* Don't hide a discontinuity inside a coalesced buffer */
+      ret = gst_srt_src_alloc_buffer (self, coalesce, blocksize, &next,
+          &next_info);
+      if (ret != GST_FLOW_OK)
+        goto out;
+
+      memcpy (next_info.data, info.data + offset, recv_len);
+      gst_srt_src_finish_buffer (self, buffer, &info, offset, list);
+      buffer = next;
+      info = next_info;
+      offset = 0;
+    }
+
+    if (offset == 0) {
+      GST_BUFFER_TIMESTAMP (buffer) = timestamp;
+      if (discont)
+        GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    }
+
+    offset += recv_len;
+  }
+
+  if (offset > 0) {
+    gst_srt_src_finish_buffer (self, buffer, &info, offset, list);
+    buffer = NULL;
+  }
+
+  if (gst_buffer_list_length (list) == 1) {
+    *outbuf = gst_buffer_ref (gst_buffer_list_get (list, 0));
+  } else {
+    GST_LOG_OBJECT (src, "pushing list of %u buffers",
+        gst_buffer_list_length (list));
+    gst_base_src_submit_buffer_list (GST_BASE_SRC (src),
+        g_steal_pointer (&list));
+    *outbuf = NULL;
+  }
 
 out:
+  if (buffer) {
+    gst_buffer_unmap (buffer, &info);
+    gst_buffer_unref (buffer);
+  }
+  if (list)
+    gst_buffer_list_unref (list);
+  gst_object_unref (clock);
+
   return ret;
 }
 
@@ -274,6 +482,8 @@ gst_srt_src_init (GstSRTSrc * self)
 
   gst_srt_object_set_uri (self->srtobject, GST_SRT_DEFAULT_URI, NULL);
 
+  self->max_messages = DEFAULT_MAX_MESSAGES;
+  self->coalesce = DEFAULT_COALESCE;
 }
 
 static void
@@ -283,6 +493,7 @@ gst_srt_src_finalize (GObject * object)
 
   g_clear_object (&self->cancellable);
   gst_srt_object_destroy (self->srtobject);
+  gst_clear_caps (&self->caps);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -313,9 +524,38 @@ gst_srt_src_set_property (GObject * object,
 {
   GstSRTSrc *self = GST_SRT_SRC (object);
 
-  if (!gst_srt_object_set_property_helper (self->srtobject, prop_id, value,
-          pspec)) {
-    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  switch (prop_id) {
+    case PROP_CAPS:{
+      const GstCaps *new_caps = gst_value_get_caps (value);
+      GstCaps *old_caps;
+
+      GST_OBJECT_LOCK (self);
+      old_caps = self->caps;
+      self->caps = new_caps ? gst_caps_copy (new_caps) : NULL;
+      GST_OBJECT_UNLOCK (self);
+
+      if (old_caps)
+        gst_caps_unref (old_caps);
+
+      gst_pad_mark_reconfigure (GST_BASE_SRC_PAD (self));
+      break;
+    }
+    case PROP_MAX_MESSAGES:
+      GST_OBJECT_LOCK (self);
+      self->max_messages = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_COALESCE:
+      GST_OBJECT_LOCK (self);
+      self->coalesce = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      if (!gst_srt_object_set_property_helper (self->srtobject, prop_id, value,
+              pspec)) {
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      }
+      break;
   }
 }
 
@@ -325,12 +565,54 @@ gst_srt_src_get_property (GObject * object,
 {
   GstSRTSrc *self = GST_SRT_SRC (object);
 
-  if (!gst_srt_object_get_property_helper (self->srtobject, prop_id, value,
-          pspec)) {
-    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  switch (prop_id) {
+    case PROP_CAPS:
+      GST_OBJECT_LOCK (self);
+      gst_value_set_caps (value, self->caps);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_MESSAGES:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_messages);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_COALESCE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->coalesce);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      if (!gst_srt_object_get_property_helper (self->srtobject, prop_id, value,
+              pspec)) {
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      }
+      break;
   }
 }
 
+static GstCaps *
+gst_srt_src_get_caps (GstBaseSrc * basesrc, GstCaps * filter)
+{
+  GstSRTSrc *self = GST_SRT_SRC (basesrc);
+  GstCaps *caps, *result;
+
+  GST_OBJECT_LOCK (self);
+  caps = self->caps ? gst_caps_ref (self->caps) : NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  if (!caps)
+    return GST_BASE_SRC_CLASS (parent_class)->get_caps (basesrc, filter);
+
+  if (filter) {
+    result = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (caps);
+  } else {
+    result = caps;
+  }
+
+  return result;
+}
+
 static gboolean
 gst_srt_src_query (GstBaseSrc * basesrc, GstQuery * query)
 {
@@ -426,6 +708,53 @@ gst_srt_src_class_init (GstSRTSrcClass * klass)
 
   gst_srt_object_install_properties_helper (gobject_class);
 
+  /**
+   * GstSRTSrc:caps:
+   *
+   * The caps of the source pad, e.g. video/mpegts,systemstream=true to skip
+   * typefinding of an MPEG-TS stream.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CAPS,
+      g_param_spec_boxed ("caps", "Caps",
+          "The caps of the source pad", GST_TYPE_CAPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSrc:max-messages:
+   *
+   * Maximum number of messages to receive per wakeup. When more than one
+   * message is already waiting on the socket, they are all received at once
+   * and pushed downstream as a buffer list.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_MESSAGES,
+      g_param_spec_uint ("max-messages", "Maximum messages",
+          "Maximum number of messages to receive per wakeup", 1, 1024,
+          DEFAULT_MAX_MESSAGES,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSrc:coalesce:
+   *
+   * Put the messages received in one wakeup (see #GstSRTSrc:max-messages)
+   * back to back into a single buffer instead of one buffer per message.
+   * The message boundaries are lost, so this is only suitable for stream
+   * oriented payloads such as MPEG-TS. A discontinuity always starts a new
+   * buffer.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_COALESCE,
+      g_param_spec_boolean ("coalesce", "Coalesce",
+          "Merge messages received at once into a single buffer",
+          DEFAULT_COALESCE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
   gst_element_class_set_metadata (gstelement_class,
       "SRT source", "Source/Network",
@@ -437,8 +766,9 @@ gst_srt_src_class_init (GstSRTSrcClass * klass)
   gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_srt_src_unlock);
   gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_srt_src_unlock_stop);
   gstbasesrc_class->query = GST_DEBUG_FUNCPTR (gst_srt_src_query);
+  gstbasesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_srt_src_get_caps);
 
-  gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_srt_src_fill);
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_srt_src_create);
 }
 
 static GstURIType
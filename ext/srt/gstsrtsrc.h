@@ -51,6 +51,13 @@ struct _GstSRTSrc {
   GCancellable *cancellable;
 
   guint32       next_pktseq;
+
+  guint         max_messages;
+  gboolean      coalesce;
+
+  /* buffers for coalesce mode, of coalesce_size bytes */
+  GstBufferPool *coalesce_pool;
+  guint         coalesce_size;
 };
 
 struct _GstSRTSrcClass {
@@ -211,6 +211,10 @@ static GstFlowReturn gst_srtp_dec_chain_rtp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
 static GstFlowReturn gst_srtp_dec_chain_rtcp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_srtp_dec_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
+static GstFlowReturn gst_srtp_dec_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
 
 static GstStateChangeReturn gst_srtp_dec_change_state (GstElement * element,
     GstStateChange transition);
@@ -383,6 +387,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtp));
   gst_pad_set_chain_function (filter->rtp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtp));
+  gst_pad_set_chain_list_function (filter->rtp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtp));
 
   filter->rtp_srcpad =
       gst_pad_new_from_static_template (&rtp_src_template, "rtp_src");
@@ -406,6 +412,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (filter->rtcp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtcp));
+  gst_pad_set_chain_list_function (filter->rtcp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtcp));
 
   filter->rtcp_srcpad =
       gst_pad_new_from_static_template (&rtcp_src_template, "rtcp_src");
@@ -1316,7 +1324,8 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
 }
 
 /*
- * This function should be called while holding the filter lock
+ * This function should be called while holding the filter lock.
+ * The protection is removed in place, so @buf must be writable.
  */
 static gboolean
 gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
@@ -1330,10 +1339,12 @@ gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
       " with SSRC = %u", is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (buf),
       ssrc);
 
-  /* Change buffer to remove protection */
-  buf = gst_buffer_make_writable (buf);
+  g_return_val_if_fail (gst_buffer_is_writable (buf), FALSE);
 
-  gst_buffer_map (buf, &map, GST_MAP_READWRITE);
+  if (!gst_buffer_map (buf, &map, GST_MAP_READWRITE)) {
+    GST_WARNING_OBJECT (pad, "Could not map buffer, dropping");
+    return FALSE;
+  }
   size = map.size;
 
 unprotect:
@@ -1447,6 +1458,24 @@ err:
   return FALSE;
 }
 
+/* Returns the source pad for @is_rtcp packets, after making sure the events
+ * needed before pushing data on it have been sent */
+static GstPad *
+gst_srtp_dec_get_src_pad (GstSrtpDec * filter, gboolean is_rtcp)
+{
+  if (is_rtcp) {
+    if (!filter->rtcp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
+          filter->rtp_srcpad, TRUE);
+    return filter->rtcp_srcpad;
+  } else {
+    if (!filter->rtp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
+          filter->rtcp_srcpad, FALSE);
+    return filter->rtp_srcpad;
+  }
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     gboolean is_rtcp)
@@ -1472,6 +1501,9 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     goto push_out;
   }
 
+  /* Change buffer to remove protection */
+  buf = gst_buffer_make_writable (buf);
+
   if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, ssrc)) {
     GST_OBJECT_UNLOCK (filter);
     goto drop_buffer;
@@ -1485,17 +1517,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 push_out:
   /* Push buffer to source pad */
-  if (is_rtcp) {
-    otherpad = filter->rtcp_srcpad;
-    if (!filter->rtcp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
-          filter->rtp_srcpad, TRUE);
-  } else {
-    otherpad = filter->rtp_srcpad;
-    if (!filter->rtp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
-          filter->rtcp_srcpad, FALSE);
-  }
+  otherpad = gst_srtp_dec_get_src_pad (filter, is_rtcp);
   ret = gst_pad_push (otherpad, buf);
 
   return ret;
@@ -1520,6 +1542,132 @@ gst_srtp_dec_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_dec_chain (pad, parent, buf, TRUE);
 }
 
+/* Unprotects all the packets of @buf_list with a single acquisition of the
+ * filter lock. Packets that fail are removed from the list, and packets that
+ * turn out to be of the other kind (rtcp-mux) are moved to @other_list.
+ * Returns the SSRCs that reached the soft limit of their key. */
+static GArray *
+gst_srtp_dec_decode_list (GstSrtpDec * filter, GstPad * pad,
+    GstBufferList * buf_list, gboolean is_rtcp, GstBufferList * other_list)
+{
+  GArray *soft_limit_ssrcs = NULL;
+  guint i = 0;
+
+  GST_OBJECT_LOCK (filter);
+
+  while (i < gst_buffer_list_length (buf_list)) {
+    GstBuffer *buf = gst_buffer_list_get (buf_list, i);
+    GstSrtpDecSsrcStream *stream;
+    gboolean buf_is_rtcp = is_rtcp;
+    guint32 ssrc = 0;
+
+    if (!(stream = validate_buffer (filter, buf, &ssrc, &buf_is_rtcp))) {
+      GST_WARNING_OBJECT (filter, "Invalid buffer, dropping");
+      gst_buffer_list_remove (buf_list, i, 1);
+      continue;
+    }
+
+    if (STREAM_HAS_CRYPTO (stream)) {
+      /* Change buffer to remove protection, in place if possible */
+      buf = gst_buffer_list_get_writable (buf_list, i);
+
+      if (!gst_srtp_dec_decode_buffer (filter, pad, buf, buf_is_rtcp, ssrc)) {
+        gst_buffer_list_remove (buf_list, i, 1);
+        continue;
+      }
+
+      if (gst_srtp_get_soft_limit_reached ()) {
+        if (!soft_limit_ssrcs)
+          soft_limit_ssrcs = g_array_new (FALSE, FALSE, sizeof (guint32));
+        g_array_append_val (soft_limit_ssrcs, ssrc);
+      }
+    }
+
+    if (buf_is_rtcp != is_rtcp) {
+      gst_buffer_list_add (other_list, gst_buffer_ref (buf));
+      gst_buffer_list_remove (buf_list, i, 1);
+      continue;
+    }
+
+    i++;
+  }
+
+  GST_OBJECT_UNLOCK (filter);
+
+  return soft_limit_ssrcs;
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  GstBufferList *other_list;
+  GArray *soft_limit_ssrcs;
+  GstFlowReturn ret = GST_FLOW_OK, other_ret = GST_FLOW_OK;
+  guint i;
+
+  GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
+      gst_buffer_list_length (buf_list));
+
+  buf_list = gst_buffer_list_make_writable (buf_list);
+  other_list = gst_buffer_list_new ();
+
+  soft_limit_ssrcs =
+      gst_srtp_dec_decode_list (filter, pad, buf_list, is_rtcp, other_list);
+
+  /* If all is well, we may have reached soft limit */
+  if (soft_limit_ssrcs) {
+    for (i = 0; i < soft_limit_ssrcs->len; i++) {
+      guint32 ssrc = g_array_index (soft_limit_ssrcs, guint32, i);
+      guint j;
+
+      /* only signal once per stream */
+      for (j = 0; j < i; j++) {
+        if (g_array_index (soft_limit_ssrcs, guint32, j) == ssrc)
+          break;
+      }
+      if (j == i)
+        request_key_with_signal (filter, ssrc, SIGNAL_SOFT_LIMIT);
+    }
+    g_array_free (soft_limit_ssrcs, TRUE);
+  }
+
+  /* Push buffers to source pads */
+  if (gst_buffer_list_length (other_list) > 0)
+    other_ret = gst_pad_push_list (gst_srtp_dec_get_src_pad (filter, !is_rtcp),
+        other_list);
+  else
+    gst_buffer_list_unref (other_list);
+
+  if (gst_buffer_list_length (buf_list) > 0)
+    ret = gst_pad_push_list (gst_srtp_dec_get_src_pad (filter, is_rtcp),
+        buf_list);
+  else
+    gst_buffer_list_unref (buf_list);
+
+  /* Packets on the other pad are only a side channel of this one */
+  if (ret == GST_FLOW_OK && other_ret != GST_FLOW_OK
+      && other_ret != GST_FLOW_NOT_LINKED)
+    ret = other_ret;
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, TRUE);
+}
+
 static GstStateChangeReturn
 gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
 {
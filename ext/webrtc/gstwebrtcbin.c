@@ -80,6 +80,14 @@
  * of streams that will be sent to the receiver and will be associated with a
  * GstWebRTCRTPTransceiver (very similar to W3 RTPTransceiver's).
  *
+ * The same payloaded RTP stream can be sent to many peers by linking it to a
+ * sink pad of each of their webrtcbins, for example through a tee.  Buffers
+ * are shared between the peers: if a peer negotiated a different payload
+ * type, only the RTP header is copied to rewrite it, and SRTP is applied per
+ * peer.  Key unit requests triggered by the PLI/FIR of several peers for the
+ * same stream (identified by its SSRC) are merged at the element fanning the
+ * stream out, e.g. the tee, before reaching the encoder.
+ *
  * On the receiving side, RTPTransceiver's are created in response to setting
  * a remote description.  Output pads for the receiving streams in the set
  * description are also created when data is received.
@@ -240,6 +248,8 @@ gst_webrtc_bin_pad_finalize (GObject * object)
     gst_caps_unref (pad->received_caps);
   pad->received_caps = NULL;
 
+  gst_clear_object (&pad->key_unit_upstream);
+
   G_OBJECT_CLASS (gst_webrtc_bin_pad_parent_class)->finalize (object);
 }
 
@@ -274,6 +284,83 @@ gst_webrtc_bin_pad_update_ssrc_event (GstWebRTCBinPad * wpad)
   }
 }
 
+/* Must be called with the PC lock held */
+static void
+gst_webrtc_bin_pad_update_send_pt (GstWebRTCBinPad * wpad)
+{
+  WebRTCTransceiver *trans;
+  const GstStructure *s;
+  const gchar *encoding_name;
+  GstCaps *pt_caps;
+  gint in_pt = -1, out_pt, send_pt = -1;
+
+  if (GST_PAD_DIRECTION (wpad) != GST_PAD_SINK || !wpad->trans
+      || !wpad->received_caps || gst_caps_is_empty (wpad->received_caps))
+    goto out;
+
+  trans = WEBRTC_TRANSCEIVER (wpad->trans);
+  if (!trans->stream)
+    goto out;
+
+  s = gst_caps_get_structure (wpad->received_caps, 0);
+  encoding_name = gst_structure_get_string (s, "encoding-name");
+  if (!encoding_name || !gst_structure_get_int (s, "payload", &in_pt))
+    goto out;
+
+  /* the input payload type was negotiated for this codec, nothing to do */
+  pt_caps = transport_stream_get_caps_for_pt (trans->stream, in_pt);
+  if (pt_caps && !gst_caps_is_empty (pt_caps)
+      && !g_strcmp0 (gst_structure_get_string (gst_caps_get_structure
+              (pt_caps, 0), "encoding-name"), encoding_name))
+    goto out;
+
+  out_pt = transport_stream_get_pt (trans->stream, encoding_name);
+  if (out_pt > 0)
+    send_pt = out_pt;
+
+out:
+  if (g_atomic_int_get (&wpad->send_pt) != send_pt) {
+    if (send_pt >= 0)
+      GST_INFO_OBJECT (wpad, "rewriting payload type %d to %d", in_pt,
+          send_pt);
+    g_atomic_int_set (&wpad->send_pt, send_pt);
+    g_atomic_int_set (&wpad->send_caps_pending, TRUE);
+  }
+}
+
+/* Returns the caps to forward for @caps, with the payload type the stream is
+ * sent with */
+static GstCaps *
+_get_send_caps (GstCaps * caps, gint pt)
+{
+  if (pt < 0)
+    return gst_caps_ref (caps);
+
+  caps = gst_caps_copy (caps);
+  gst_caps_set_simple (caps, "payload", G_TYPE_INT, pt, NULL);
+
+  return caps;
+}
+
+/* Called from the streaming thread before pushing data, so the caps
+ * downstream always match the payload type of the buffers */
+static void
+gst_webrtc_bin_pad_push_send_caps (GstWebRTCBinPad * wpad, GstObject * parent,
+    gint pt)
+{
+  GstCaps *caps;
+
+  if (!g_atomic_int_compare_and_exchange (&wpad->send_caps_pending, TRUE,
+          FALSE) || !wpad->received_caps)
+    return;
+
+  caps = _get_send_caps (wpad->received_caps, pt);
+  GST_DEBUG_OBJECT (wpad, "payload type changed, updating caps to %"
+      GST_PTR_FORMAT, caps);
+  gst_pad_event_default (GST_PAD (wpad), parent, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+}
+
 static gboolean
 gst_webrtcbin_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -289,6 +376,24 @@ gst_webrtcbin_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
         || gst_caps_is_equal (wpad->received_caps, caps));
     gst_caps_replace (&wpad->received_caps, caps);
 
+    PC_LOCK (webrtc);
+    gst_webrtc_bin_pad_update_send_pt (wpad);
+    PC_UNLOCK (webrtc);
+
+    /* forward the payload type the buffers will carry */
+    g_atomic_int_set (&wpad->send_caps_pending, FALSE);
+    if (g_atomic_int_get (&wpad->send_pt) >= 0) {
+      GstCaps *send_caps = _get_send_caps (caps,
+          g_atomic_int_get (&wpad->send_pt));
+      GstEvent *send_event = gst_event_new_caps (send_caps);
+
+      gst_event_set_seqnum (send_event, gst_event_get_seqnum (event));
+      gst_caps_unref (send_caps);
+      gst_event_unref (event);
+      event = send_event;
+      gst_event_parse_caps (event, &caps);
+    }
+
     GST_DEBUG_OBJECT (parent,
         "On %" GST_PTR_FORMAT " checking negotiation? %u, caps %"
         GST_PTR_FORMAT, pad, check_negotiation, caps);
@@ -388,9 +493,257 @@ gst_webrtcbin_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 }
 
 
+static GstFlowReturn
+gst_webrtcbin_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstWebRTCBinPad *wpad = GST_WEBRTC_BIN_PAD (pad);
+  gint pt = g_atomic_int_get (&wpad->send_pt);
+
+  gst_webrtc_bin_pad_push_send_caps (wpad, parent, pt);
+  if (pt >= 0)
+    buffer = _rtp_buffer_rewrite_payload_type (buffer, pt);
+
+  return gst_proxy_pad_chain_default (pad, parent, buffer);
+}
+
+static gboolean
+_rewrite_payload_type_func (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  *buffer = _rtp_buffer_rewrite_payload_type (*buffer,
+      GPOINTER_TO_INT (user_data));
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_webrtcbin_sink_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstWebRTCBinPad *wpad = GST_WEBRTC_BIN_PAD (pad);
+  gint pt = g_atomic_int_get (&wpad->send_pt);
+
+  gst_webrtc_bin_pad_push_send_caps (wpad, parent, pt);
+  if (pt >= 0) {
+    list = gst_buffer_list_make_writable (list);
+    gst_buffer_list_foreach (list, _rewrite_payload_type_func,
+        GINT_TO_POINTER (pt));
+  }
+
+  return gst_proxy_pad_chain_list_default (pad, parent, list);
+}
+
+/* When a single encoder feeds many webrtcbins (e.g. through a tee), every
+ * peer's PLI/FIR would turn into a key unit request for that same encoder.
+ * Requests are tracked on the first pad upstream of the fan-out point, per
+ * SSRC, and the ones coming from different webrtcbins are only forwarded
+ * once per KEY_UNIT_REQUEST_INTERVAL. The state lives as qdata on that pad
+ * and goes away with it. That pad is looked up when the sink pad is linked,
+ * and again on a request only while no fan-out was found. */
+#define KEY_UNIT_REQUEST_INTERVAL (250 * GST_MSECOND)
+#define KEY_UNIT_REQUEST_MAX_STREAMS 64
+#define KEY_UNIT_REQUEST_MAX_DEPTH 16
+
+static GQuark key_unit_requests_quark;
+
+typedef struct
+{
+  /* only used for comparisons, never dereferenced */
+  gconstpointer webrtc;
+  GstClockTime time;
+} KeyUnitRequest;
+
+/* Walks upstream from @pad through elements with a single sink pad until
+ * one of them has several source pads. Returns that element's sink pad, or
+ * the last pad reached when there is no fan-out, so unrelated branches never
+ * share state. @fanout is set to whether a fan-out was found. */
+static GstPad *
+_find_key_unit_upstream_pad (GstPad * pad, gboolean * fanout)
+{
+  GstPad *peer = gst_pad_get_peer (pad);
+  guint depth;
+
+  *fanout = FALSE;
+
+  for (depth = 0; peer && depth < KEY_UNIT_REQUEST_MAX_DEPTH; depth++) {
+    GstElement *parent = gst_pad_get_parent_element (peer);
+    GstPad *sinkpad = NULL, *next;
+
+    if (!parent)
+      break;
+
+    GST_OBJECT_LOCK (parent);
+    if (parent->numsinkpads == 1)
+      sinkpad = gst_object_ref (parent->sinkpads->data);
+    *fanout = parent->numsrcpads > 1;
+    GST_OBJECT_UNLOCK (parent);
+    gst_object_unref (parent);
+
+    if (!sinkpad)
+      break;
+
+    if (*fanout) {
+      gst_object_unref (peer);
+      return sinkpad;
+    }
+
+    next = gst_pad_get_peer (sinkpad);
+    gst_object_unref (sinkpad);
+    if (!next)
+      break;
+
+    gst_object_unref (peer);
+    peer = next;
+  }
+
+  return peer;
+}
+
+/* Returns a new reference to the pad key unit requests on @wpad are merged
+ * on, or NULL when @wpad is not linked */
+static GstPad *
+gst_webrtc_bin_pad_update_key_unit_upstream (GstWebRTCBinPad * wpad)
+{
+  GstPad *upstream, *old;
+  gboolean fanout;
+
+  upstream = _find_key_unit_upstream_pad (GST_PAD (wpad), &fanout);
+
+  GST_OBJECT_LOCK (wpad);
+  old = wpad->key_unit_upstream;
+  wpad->key_unit_upstream = upstream ? gst_object_ref (upstream) : NULL;
+  wpad->key_unit_fanout = fanout;
+  GST_OBJECT_UNLOCK (wpad);
+
+  if (old)
+    gst_object_unref (old);
+
+  if (fanout)
+    GST_DEBUG_OBJECT (wpad, "merging key unit requests on %" GST_PTR_FORMAT,
+        upstream);
+
+  return upstream;
+}
+
+static void
+_on_sink_pad_linked (GstPad * pad, GstPad * peer, gpointer user_data)
+{
+  GstPad *upstream =
+      gst_webrtc_bin_pad_update_key_unit_upstream (GST_WEBRTC_BIN_PAD (pad));
+
+  if (upstream)
+    gst_object_unref (upstream);
+}
+
+static void
+_on_sink_pad_unlinked (GstPad * pad, GstPad * peer, gpointer user_data)
+{
+  GstWebRTCBinPad *wpad = GST_WEBRTC_BIN_PAD (pad);
+  GstPad *upstream;
+
+  GST_OBJECT_LOCK (wpad);
+  upstream = wpad->key_unit_upstream;
+  wpad->key_unit_upstream = NULL;
+  wpad->key_unit_fanout = FALSE;
+  GST_OBJECT_UNLOCK (wpad);
+
+  if (upstream)
+    gst_object_unref (upstream);
+}
+
+static gboolean
+_key_unit_request_is_expired (gpointer key, KeyUnitRequest * request,
+    GstClockTime * now)
+{
+  return *now - request->time >= KEY_UNIT_REQUEST_INTERVAL;
+}
+
+static gboolean
+_key_unit_request_should_forward (GstWebRTCBin * webrtc, GstPad * upstream,
+    guint32 ssrc)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+  GHashTable *requests;
+  KeyUnitRequest *request;
+  gboolean ret = TRUE;
+
+  GST_OBJECT_LOCK (upstream);
+  requests = g_object_get_qdata (G_OBJECT (upstream), key_unit_requests_quark);
+  if (!requests) {
+    requests = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+    g_object_set_qdata_full (G_OBJECT (upstream), key_unit_requests_quark,
+        requests, (GDestroyNotify) g_hash_table_unref);
+  }
+
+  request = g_hash_table_lookup (requests, GUINT_TO_POINTER (ssrc));
+  if (request && request->webrtc != webrtc
+      && now - request->time < KEY_UNIT_REQUEST_INTERVAL) {
+    ret = FALSE;
+  } else {
+    if (!request) {
+      if (g_hash_table_size (requests) >= KEY_UNIT_REQUEST_MAX_STREAMS)
+        g_hash_table_foreach_remove (requests,
+            (GHRFunc) _key_unit_request_is_expired, &now);
+      request = g_new0 (KeyUnitRequest, 1);
+      g_hash_table_insert (requests, GUINT_TO_POINTER (ssrc), request);
+    }
+    request->webrtc = webrtc;
+    request->time = now;
+  }
+  GST_OBJECT_UNLOCK (upstream);
+
+  return ret;
+}
+
+static GstPadProbeReturn
+_sink_pad_upstream_event_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstWebRTCBinPad *wpad = GST_WEBRTC_BIN_PAD (pad);
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstWebRTCBin *webrtc;
+  GstPad *upstream;
+  gboolean forward, fanout;
+  guint32 ssrc;
+
+  if (!gst_event_has_name (event, "GstForceKeyUnit") || !wpad->trans)
+    return GST_PAD_PROBE_OK;
+
+  ssrc = WEBRTC_TRANSCEIVER (wpad->trans)->current_ssrc;
+  if (ssrc == 0)
+    return GST_PAD_PROBE_OK;
+
+  webrtc = GST_WEBRTC_BIN (GST_PAD_PARENT (pad));
+  if (!webrtc)
+    return GST_PAD_PROBE_OK;
+
+  GST_OBJECT_LOCK (wpad);
+  upstream = wpad->key_unit_upstream ?
+      gst_object_ref (wpad->key_unit_upstream) : NULL;
+  fanout = wpad->key_unit_fanout;
+  GST_OBJECT_UNLOCK (wpad);
+
+  /* the fan-out may have been added upstream after this pad was linked */
+  if (!fanout) {
+    if (upstream)
+      gst_object_unref (upstream);
+    upstream = gst_webrtc_bin_pad_update_key_unit_upstream (wpad);
+  }
+  if (!upstream)
+    return GST_PAD_PROBE_OK;
+
+  forward = _key_unit_request_should_forward (webrtc, upstream, ssrc);
+  if (!forward)
+    GST_DEBUG_OBJECT (pad, "dropping key unit request for ssrc %u, another "
+        "peer behind %" GST_PTR_FORMAT " requested one recently", ssrc,
+        upstream);
+  gst_object_unref (upstream);
+
+  return forward ? GST_PAD_PROBE_OK : GST_PAD_PROBE_DROP;
+}
+
 static void
 gst_webrtc_bin_pad_init (GstWebRTCBinPad * pad)
 {
+  pad->send_pt = -1;
 }
 
 static GstWebRTCBinPad *
@@ -414,6 +767,17 @@ gst_webrtc_bin_pad_new (const gchar * name, GstPadDirection direction)
   gst_pad_set_event_function (GST_PAD (pad), gst_webrtcbin_sink_event);
   gst_pad_set_query_function (GST_PAD (pad), gst_webrtcbin_sink_query);
 
+  if (direction == GST_PAD_SINK) {
+    gst_pad_set_chain_function (GST_PAD (pad), gst_webrtcbin_sink_chain);
+    gst_pad_set_chain_list_function (GST_PAD (pad),
+        gst_webrtcbin_sink_chain_list);
+    gst_pad_add_probe (GST_PAD (pad), GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+        _sink_pad_upstream_event_probe, NULL, NULL);
+    g_signal_connect (pad, "linked", G_CALLBACK (_on_sink_pad_linked), NULL);
+    g_signal_connect (pad, "unlinked", G_CALLBACK (_on_sink_pad_unlinked),
+        NULL);
+  }
+
   GST_DEBUG_OBJECT (pad, "new visible pad with direction %s",
       direction == GST_PAD_SRC ? "src" : "sink");
   return pad;
@@ -440,6 +804,7 @@ enum
   ON_ICE_CANDIDATE_SIGNAL,
   ON_NEW_TRANSCEIVER_SIGNAL,
   GET_STATS_SIGNAL,
+  GET_TRANSCEIVER_STATS_SIGNAL,
   ADD_TRANSCEIVER_SIGNAL,
   GET_TRANSCEIVER_SIGNAL,
   GET_TRANSCEIVERS_SIGNAL,
@@ -709,6 +1074,10 @@ _remove_pad (GstWebRTCBin * webrtc, GstWebRTCBinPad * pad)
   _remove_pending_pad (webrtc, pad);
 
   gst_element_remove_pad (GST_ELEMENT (webrtc), GST_PAD (pad));
+
+  g_mutex_lock (&webrtc->priv->stats_lock);
+  g_hash_table_remove (webrtc->priv->stats_cache, pad);
+  g_mutex_unlock (&webrtc->priv->stats_lock);
 }
 
 typedef struct
@@ -1770,6 +2139,8 @@ static void
 _on_ice_transport_notify_state (GstWebRTCICETransport * transport,
     GParamSpec * pspec, GstWebRTCBin * webrtc)
 {
+  /* the candidate pair and transport statistics changed */
+  gst_webrtc_bin_invalidate_stats (webrtc, G_MAXUINT);
   _update_ice_connection_state (webrtc);
   _update_peer_connection_state (webrtc);
 }
@@ -1785,6 +2156,7 @@ static void
 _on_dtls_transport_notify_state (GstWebRTCDTLSTransport * transport,
     GParamSpec * pspec, GstWebRTCBin * webrtc)
 {
+  gst_webrtc_bin_invalidate_stats (webrtc, G_MAXUINT);
   _update_peer_connection_state (webrtc);
 }
 
@@ -5250,6 +5622,12 @@ _set_description_task (GstWebRTCBin * webrtc, struct set_description *sd)
     if (!_update_transceivers_from_sdp (webrtc, sd->source, sd->sdp, &error))
       goto out;
 
+    /* the negotiated payload types may differ from the input streams' */
+    GST_OBJECT_LOCK (webrtc);
+    g_list_foreach (GST_ELEMENT (webrtc)->sinkpads,
+        (GFunc) gst_webrtc_bin_pad_update_send_pt, NULL);
+    GST_OBJECT_UNLOCK (webrtc);
+
     for (tmp = webrtc->priv->pending_sink_transceivers; tmp;) {
       GstWebRTCBinPad *pad = GST_WEBRTC_BIN_PAD (tmp->data);
       GstWebRTCRTPTransceiverDirection new_dir;
@@ -5423,6 +5801,9 @@ _set_description_task (GstWebRTCBin * webrtc, struct set_description *sd)
 out:
   g_strfreev (bundled);
 
+  /* transceivers may have been moved to other transports */
+  gst_webrtc_bin_invalidate_stats (webrtc, G_MAXUINT);
+
   if (error) {
     GstStructure *s = gst_structure_new ("application/x-gstwebrtcbin-error",
         "error", G_TYPE_ERROR, error, NULL);
@@ -5653,15 +6034,15 @@ _on_local_ice_candidate_cb (GstWebRTCICE * ice, guint session_id,
 
 struct get_stats
 {
-  GstPad *pad;
+  GPtrArray *pads;
   GstPromise *promise;
 };
 
 static void
 _free_get_stats (struct get_stats *stats)
 {
-  if (stats->pad)
-    gst_object_unref (stats->pad);
+  if (stats->pads)
+    g_ptr_array_unref (stats->pads);
   if (stats->promise)
     gst_promise_unref (stats->promise);
   g_free (stats);
@@ -5675,23 +6056,51 @@ _get_stats_task (GstWebRTCBin * webrtc, struct get_stats *stats)
    * https://www.w3.org/TR/webrtc/#dfn-stats-selection-algorithm
    */
 
-  return gst_webrtc_bin_create_stats (webrtc, stats->pad);
+  return gst_webrtc_bin_create_stats (webrtc, stats->pads);
+}
+
+static gboolean
+_append_stats_pad (GstElement * element, GstPad * pad, GPtrArray * pads)
+{
+  g_ptr_array_add (pads, gst_object_ref (pad));
+  return TRUE;
 }
 
+struct transceiver_stats_selector
+{
+  GstWebRTCRTPTransceiver *trans;
+  GPtrArray *pads;
+};
+
+static gboolean
+_append_transceiver_stats_pad (GstElement * element, GstPad * pad,
+    struct transceiver_stats_selector *selector)
+{
+  if (GST_WEBRTC_BIN_PAD (pad)->trans == selector->trans)
+    g_ptr_array_add (selector->pads, gst_object_ref (pad));
+  return TRUE;
+}
+
+/* Answers @promise with the statistics of @pads, directly from the caller's
+ * thread if none of them changed since they were last collected, or by
+ * collecting the outdated ones on the peerconnection thread otherwise.
+ * Takes ownership of @pads. */
 static void
-gst_webrtc_bin_get_stats (GstWebRTCBin * webrtc, GstPad * pad,
+_get_stats_for_pads (GstWebRTCBin * webrtc, GPtrArray * pads,
     GstPromise * promise)
 {
   struct get_stats *stats;
+  GstStructure *s;
 
-  g_return_if_fail (promise != NULL);
-  g_return_if_fail (pad == NULL || GST_IS_WEBRTC_BIN_PAD (pad));
+  if ((s = gst_webrtc_bin_get_cached_stats (webrtc, pads))) {
+    gst_promise_reply (promise, s);
+    g_ptr_array_unref (pads);
+    return;
+  }
 
   stats = g_new0 (struct get_stats, 1);
   stats->promise = gst_promise_ref (promise);
-  /* FIXME: check that pad exists in element */
-  if (pad)
-    stats->pad = gst_object_ref (pad);
+  stats->pads = pads;
 
   if (!gst_webrtc_bin_enqueue_task (webrtc, (GstWebRTCBinFunc) _get_stats_task,
           stats, (GDestroyNotify) _free_get_stats, promise)) {
@@ -5707,6 +6116,44 @@ gst_webrtc_bin_get_stats (GstWebRTCBin * webrtc, GstPad * pad,
   }
 }
 
+static void
+gst_webrtc_bin_get_stats (GstWebRTCBin * webrtc, GstPad * pad,
+    GstPromise * promise)
+{
+  GPtrArray *pads;
+
+  g_return_if_fail (promise != NULL);
+  g_return_if_fail (pad == NULL || GST_IS_WEBRTC_BIN_PAD (pad));
+
+  pads = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_object_unref);
+  /* FIXME: check that pad exists in element */
+  if (pad)
+    g_ptr_array_add (pads, gst_object_ref (pad));
+  else
+    gst_element_foreach_pad (GST_ELEMENT (webrtc),
+        (GstElementForeachPadFunc) _append_stats_pad, pads);
+
+  _get_stats_for_pads (webrtc, pads, promise);
+}
+
+static void
+gst_webrtc_bin_get_transceiver_stats (GstWebRTCBin * webrtc,
+    GstWebRTCRTPTransceiver * trans, GstPromise * promise)
+{
+  struct transceiver_stats_selector selector;
+
+  g_return_if_fail (promise != NULL);
+  g_return_if_fail (GST_IS_WEBRTC_RTP_TRANSCEIVER (trans));
+
+  selector.trans = trans;
+  selector.pads =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_object_unref);
+  gst_element_foreach_pad (GST_ELEMENT (webrtc),
+      (GstElementForeachPadFunc) _append_transceiver_stats_pad, &selector);
+
+  _get_stats_for_pads (webrtc, selector.pads, promise);
+}
+
 static GstWebRTCRTPTransceiver *
 gst_webrtc_bin_add_transceiver (GstWebRTCBin * webrtc,
     GstWebRTCRTPTransceiverDirection direction, GstCaps * caps)
@@ -6334,6 +6781,8 @@ on_rtpbin_bye_ssrc (GstElement * rtpbin, guint session_id, guint ssrc,
     GstWebRTCBin * webrtc)
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u received bye", session_id, ssrc);
+
+  gst_webrtc_bin_invalidate_stats (webrtc, session_id);
 }
 
 static void
@@ -6341,6 +6790,8 @@ on_rtpbin_bye_timeout (GstElement * rtpbin, guint session_id, guint ssrc,
     GstWebRTCBin * webrtc)
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u bye timeout", session_id, ssrc);
+
+  gst_webrtc_bin_invalidate_stats (webrtc, session_id);
 }
 
 static void
@@ -6349,6 +6800,8 @@ on_rtpbin_sender_timeout (GstElement * rtpbin, guint session_id, guint ssrc,
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u sender timeout", session_id,
       ssrc);
+
+  gst_webrtc_bin_invalidate_stats (webrtc, session_id);
 }
 
 static void
@@ -6356,6 +6809,8 @@ on_rtpbin_new_ssrc (GstElement * rtpbin, guint session_id, guint ssrc,
     GstWebRTCBin * webrtc)
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u new ssrc", session_id, ssrc);
+
+  gst_webrtc_bin_invalidate_stats (webrtc, session_id);
 }
 
 static void
@@ -6363,6 +6818,8 @@ on_rtpbin_ssrc_active (GstElement * rtpbin, guint session_id, guint ssrc,
     GstWebRTCBin * webrtc)
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u active", session_id, ssrc);
+
+  gst_webrtc_bin_update_ssrc_stats (webrtc, session_id, ssrc);
 }
 
 static void
@@ -6377,6 +6834,8 @@ on_rtpbin_ssrc_sdes (GstElement * rtpbin, guint session_id, guint ssrc,
     GstWebRTCBin * webrtc)
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u sdes", session_id, ssrc);
+
+  gst_webrtc_bin_update_ssrc_stats (webrtc, session_id, ssrc);
 }
 
 static void
@@ -6384,6 +6843,8 @@ on_rtpbin_ssrc_validated (GstElement * rtpbin, guint session_id, guint ssrc,
     GstWebRTCBin * webrtc)
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u validated", session_id, ssrc);
+
+  gst_webrtc_bin_invalidate_stats (webrtc, session_id);
 }
 
 static void
@@ -6391,6 +6852,8 @@ on_rtpbin_timeout (GstElement * rtpbin, guint session_id, guint ssrc,
     GstWebRTCBin * webrtc)
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u timeout", session_id, ssrc);
+
+  gst_webrtc_bin_invalidate_stats (webrtc, session_id);
 }
 
 static void
@@ -6399,6 +6862,8 @@ on_rtpbin_new_sender_ssrc (GstElement * rtpbin, guint session_id, guint ssrc,
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u new sender ssrc", session_id,
       ssrc);
+
+  gst_webrtc_bin_invalidate_stats (webrtc, session_id);
 }
 
 static void
@@ -6407,6 +6872,8 @@ on_rtpbin_sender_ssrc_active (GstElement * rtpbin, guint session_id, guint ssrc,
 {
   GST_INFO_OBJECT (webrtc, "session %u ssrc %u sender ssrc active", session_id,
       ssrc);
+
+  gst_webrtc_bin_update_ssrc_stats (webrtc, session_id, ssrc);
 }
 
 static void
@@ -7028,6 +7495,7 @@ gst_webrtc_bin_finalize (GObject * object)
   g_mutex_clear (ICE_GET_LOCK (webrtc));
   g_mutex_clear (PC_GET_LOCK (webrtc));
   g_cond_clear (PC_GET_COND (webrtc));
+  gst_webrtc_bin_clear_stats (webrtc);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -7042,6 +7510,9 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
   element_class->release_pad = gst_webrtc_bin_release_pad;
   element_class->change_state = gst_webrtc_bin_change_state;
 
+  key_unit_requests_quark =
+      g_quark_from_static_string ("GstWebRTCBinKeyUnitRequests");
+
   gst_element_class_add_static_pad_template_with_gtype (element_class,
       &sink_template, GST_TYPE_WEBRTC_BIN_PAD);
   gst_element_class_add_static_pad_template (element_class, &src_template);
@@ -7283,6 +7754,12 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
    * and is constantly changing these statistics may be changed to fit with
    * the latest spec.
    *
+   * The statistics of each pad are cached for at most 100 milliseconds, and
+   * collected again earlier if the RTP session behind it sent or received
+   * RTCP, or the pads, session descriptions or transport states changed.
+   * If the cached statistics are still valid, the @promise is replied to
+   * directly from the calling thread.
+   *
    * Each field key is a unique identifier for each RTCStats
    * (https://www.w3.org/TR/webrtc/#rtcstats-dictionary) value (another
    * GstStructure) in the RTCStatsReport
@@ -7346,6 +7823,24 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
       G_CALLBACK (gst_webrtc_bin_get_stats), NULL, NULL, NULL,
       G_TYPE_NONE, 2, GST_TYPE_PAD, GST_TYPE_PROMISE);
 
+  /**
+   * GstWebRTCBin::get-transceiver-stats:
+   * @object: the #webrtcbin
+   * @transceiver: the #GstWebRTCRTPTransceiver to get the stats for
+   * @promise: a #GstPromise for the result
+   *
+   * Like #GstWebRTCBin::get-stats but only contains the statistics of the
+   * pads associated with @transceiver, in addition to the peer connection
+   * statistics.
+   *
+   * Since: 1.20
+   */
+  gst_webrtc_bin_signals[GET_TRANSCEIVER_STATS_SIGNAL] =
+      g_signal_new_class_handler ("get-transceiver-stats",
+      G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_webrtc_bin_get_transceiver_stats), NULL, NULL, NULL,
+      G_TYPE_NONE, 2, GST_TYPE_WEBRTC_RTP_TRANSCEIVER, GST_TYPE_PROMISE);
+
   /**
    * GstWebRTCBin::on-negotiation-needed:
    * @object: the #webrtcbin
@@ -7504,6 +7999,7 @@ gst_webrtc_bin_init (GstWebRTCBin * webrtc)
 
   g_mutex_init (ICE_GET_LOCK (webrtc));
   g_mutex_init (DC_GET_LOCK (webrtc));
+  gst_webrtc_bin_init_stats (webrtc);
 
   webrtc->rtpbin = _create_rtpbin (webrtc);
   gst_bin_add (GST_BIN (webrtc), webrtc->rtpbin);
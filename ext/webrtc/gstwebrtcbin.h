@@ -47,6 +47,18 @@ struct _GstWebRTCBinPad
   gulong                block_id;
 
   GstCaps              *received_caps;
+
+  /* payload type negotiated for the input stream if it differs from the one
+   * in received_caps, -1 otherwise. Accessed atomically */
+  gint                  send_pt;
+  /* set when send_pt changed after the input caps were forwarded, the next
+   * buffer then sends updated caps first. Accessed atomically */
+  gint                  send_caps_pending;
+
+  /* pad key unit requests are merged on, resolved when the pad is linked.
+   * Protected by the object lock */
+  GstPad               *key_unit_upstream;
+  gboolean              key_unit_fanout;
 };
 
 struct _GstWebRTCBinPadClass
@@ -142,6 +154,12 @@ struct _GstWebRTCBinPrivate
   GstWebRTCSessionDescription *last_generated_answer;
 
   gboolean tos_attached;
+
+  /* stats_lock protects the stats cache, which maps each pad to its part of
+   * the statistics report. Entries are built on the peerconnection thread
+   * and read by get-stats from any thread. */
+  GMutex stats_lock;
+  GHashTable *stats_cache;
 };
 
 typedef GstStructure *(*GstWebRTCBinFunc) (GstWebRTCBin * webrtc, gpointer data);
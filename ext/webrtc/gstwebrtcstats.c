@@ -317,7 +317,7 @@ _get_stats_from_rtp_source_stats (GstWebRTCBin * webrtc,
 
     gst_structure_get (source_stats, "have-sr", G_TYPE_BOOLEAN, &have_sr, NULL);
 
-    for (i = 0; i < stream->remote_ssrcmap->len; i++) {
+    for (i = 0; stream && i < stream->remote_ssrcmap->len; i++) {
       SsrcMapItem *item = g_ptr_array_index (stream->remote_ssrcmap, i);
 
       if (item->ssrc == ssrc) {
@@ -835,22 +835,144 @@ out:
   return TRUE;
 }
 
-GstStructure *
-gst_webrtc_bin_create_stats (GstWebRTCBin * webrtc, GstPad * pad)
+/* The statistics of a pad as last collected on the peerconnection thread.
+ * The RTP source counters in it are kept up to date by
+ * gst_webrtc_bin_update_ssrc_stats(), so an entry only needs collecting
+ * again once it is marked dirty. */
+typedef struct
 {
-  GstStructure *s = gst_structure_new_empty ("application/x-webrtc-stats");
-  double ts = monotonic_time_as_double_milliseconds ();
-  GstStructure *pc_stats;
+  GstStructure *stats;
+  guint session_id;
+  gboolean dirty;
+} StatsCacheEntry;
 
-  _init_debug ();
+static inline gboolean
+_stats_cache_entry_is_valid (StatsCacheEntry * entry)
+{
+  return entry && !entry->dirty;
+}
 
-  gst_structure_set (s, "timestamp", G_TYPE_DOUBLE, ts, NULL);
+static void
+_free_stats_cache_entry (StatsCacheEntry * entry)
+{
+  gst_structure_free (entry->stats);
+  g_free (entry);
+}
 
-  /* FIXME: better unique IDs */
-  /* FIXME: rate limitting stat updates? */
-  /* FIXME: all stats need to be kept forever */
+static gboolean
+_merge_stats_field (GQuark field_id, const GValue * value, GstStructure * s)
+{
+  gst_structure_id_set_value (s, field_id, value);
+  return TRUE;
+}
 
-  GST_DEBUG_OBJECT (webrtc, "updating stats at time %f", ts);
+/* Like _merge_stats_field() but only overwrites the fields of the
+ * sub-structures that are present in @value, keeping the others */
+static gboolean
+_update_stats_field (GQuark field_id, const GValue * value, GstStructure * s)
+{
+  const GValue *old = gst_structure_id_get_value (s, field_id);
+
+  if (old && GST_VALUE_HOLDS_STRUCTURE (old)
+      && GST_VALUE_HOLDS_STRUCTURE (value)) {
+    GstStructure *merged;
+
+    if (!gst_value_get_structure (value))
+      return TRUE;
+
+    merged = gst_structure_copy (gst_value_get_structure (old));
+    gst_structure_foreach (gst_value_get_structure (value),
+        (GstStructureForeachFunc) _merge_stats_field, merged);
+    _gst_structure_take_structure (s, g_quark_to_string (field_id), &merged);
+  } else {
+    gst_structure_id_set_value (s, field_id, value);
+  }
+
+  return TRUE;
+}
+
+/* Looks up the codec and transport ids of the stream statistics @id in
+ * @pad_stats, returns FALSE if the pad has no such statistics */
+static gboolean
+_get_cached_stream_ids (const GstStructure * pad_stats, const gchar * id,
+    gchar ** codec_id, gchar ** transport_id)
+{
+  GstStructure *stream_stats = NULL;
+
+  if (!gst_structure_get (pad_stats, id, GST_TYPE_STRUCTURE, &stream_stats,
+          NULL))
+    return FALSE;
+
+  *codec_id = NULL;
+  *transport_id = NULL;
+  gst_structure_get (stream_stats, "codec-id", G_TYPE_STRING, codec_id,
+      "transport-id", G_TYPE_STRING, transport_id, NULL);
+  gst_structure_free (stream_stats);
+
+  return TRUE;
+}
+
+/* Rebuilds the stream statistics of @pad_stats that are derived from
+ * @source_stats. Fields collected from elsewhere, like the jitterbuffer
+ * statistics, keep their last collected value. */
+static void
+_update_cached_source_stats (GstWebRTCBin * webrtc, GstStructure * pad_stats,
+    const GstStructure * source_stats, double ts)
+{
+  GstStructure *update;
+  gchar *id, *codec_id, *transport_id;
+  gboolean internal = FALSE;
+  guint ssrc = 0, rb_ssrc;
+
+  gst_structure_get (source_stats, "ssrc", G_TYPE_UINT, &ssrc, "internal",
+      G_TYPE_BOOLEAN, &internal, NULL);
+
+  update = gst_structure_new_empty ("application/x-webrtc-stats");
+  gst_structure_set (update, "timestamp", G_TYPE_DOUBLE, ts, NULL);
+
+  if (internal)
+    id = g_strdup_printf ("rtp-outbound-stream-stats_%u", ssrc);
+  else
+    id = g_strdup_printf ("rtp-inbound-stream-stats_%u", ssrc);
+  if (_get_cached_stream_ids (pad_stats, id, &codec_id, &transport_id)) {
+    _get_stats_from_rtp_source_stats (webrtc, NULL, source_stats, codec_id,
+        transport_id, update);
+    g_free (codec_id);
+    g_free (transport_id);
+  }
+  g_free (id);
+
+  /* a report block the peer sent about one of our streams */
+  if (!internal && gst_structure_get_uint (source_stats, "rb-ssrc", &rb_ssrc)) {
+    id = g_strdup_printf ("rtp-outbound-stream-stats_%u", rb_ssrc);
+    if (_get_cached_stream_ids (pad_stats, id, &codec_id, &transport_id)) {
+      GstStructure *codec = NULL;
+      guint clock_rate = 0;
+
+      if (codec_id && gst_structure_get (pad_stats, codec_id,
+              GST_TYPE_STRUCTURE, &codec, NULL)) {
+        gst_structure_get_uint (codec, "clock-rate", &clock_rate);
+        gst_structure_free (codec);
+      }
+      _get_stats_from_remote_rtp_source_stats (webrtc, NULL, source_stats,
+          rb_ssrc, clock_rate, codec_id, transport_id, update);
+      g_free (codec_id);
+      g_free (transport_id);
+    }
+    g_free (id);
+  }
+
+  gst_structure_remove_field (update, "timestamp");
+  gst_structure_foreach (update, (GstStructureForeachFunc) _update_stats_field,
+      pad_stats);
+  gst_structure_free (update);
+}
+
+static GstStructure *
+_new_stats_report (GstWebRTCBin * webrtc, double ts)
+{
+  GstStructure *s = gst_structure_new_empty ("application/x-webrtc-stats");
+  GstStructure *pc_stats;
 
   if ((pc_stats = _get_peer_connection_stats (webrtc))) {
     const gchar *id = "peer-connection-stats";
@@ -859,13 +981,186 @@ gst_webrtc_bin_create_stats (GstWebRTCBin * webrtc, GstPad * pad)
     gst_structure_free (pc_stats);
   }
 
-  if (pad)
-    _get_stats_from_pad (webrtc, pad, s);
-  else
-    gst_element_foreach_pad (GST_ELEMENT (webrtc),
-        (GstElementForeachPadFunc) _get_stats_from_pad, s);
+  return s;
+}
+
+void
+gst_webrtc_bin_init_stats (GstWebRTCBin * webrtc)
+{
+  g_mutex_init (&webrtc->priv->stats_lock);
+  webrtc->priv->stats_cache = g_hash_table_new_full (NULL, NULL,
+      (GDestroyNotify) gst_object_unref,
+      (GDestroyNotify) _free_stats_cache_entry);
+}
+
+void
+gst_webrtc_bin_clear_stats (GstWebRTCBin * webrtc)
+{
+  g_clear_pointer (&webrtc->priv->stats_cache, g_hash_table_destroy);
+  g_mutex_clear (&webrtc->priv->stats_lock);
+}
+
+/* Marks the cached statistics of all pads using @session_id as outdated, or
+ * drops the whole cache if @session_id is G_MAXUINT. Called whenever sources
+ * join or leave a session, and whenever pads, transceivers or transports
+ * change. */
+void
+gst_webrtc_bin_invalidate_stats (GstWebRTCBin * webrtc, guint session_id)
+{
+  GHashTableIter iter;
+  StatsCacheEntry *entry;
+
+  g_mutex_lock (&webrtc->priv->stats_lock);
+  if (session_id == G_MAXUINT) {
+    g_hash_table_remove_all (webrtc->priv->stats_cache);
+  } else {
+    g_hash_table_iter_init (&iter, webrtc->priv->stats_cache);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & entry)) {
+      if (entry->session_id == session_id)
+        entry->dirty = TRUE;
+    }
+  }
+  g_mutex_unlock (&webrtc->priv->stats_lock);
+}
+
+/* Refreshes the counters of @ssrc in the cached statistics of the pads using
+ * @session_id, without collecting anything else. Called from the rtpbin
+ * signal handlers for RTP/RTCP activity, on streaming threads. */
+void
+gst_webrtc_bin_update_ssrc_stats (GstWebRTCBin * webrtc, guint session_id,
+    guint ssrc)
+{
+  GObject *rtp_session = NULL, *source = NULL;
+  GstStructure *source_stats = NULL;
+  GHashTableIter iter;
+  StatsCacheEntry *entry;
+  double ts;
+
+  g_signal_emit_by_name (webrtc->rtpbin, "get-internal-session", session_id,
+      &rtp_session);
+  if (!rtp_session)
+    return;
+  g_signal_emit_by_name (rtp_session, "get-source-by-ssrc", ssrc, &source);
+  g_object_unref (rtp_session);
+  if (!source)
+    return;
+  g_object_get (source, "stats", &source_stats, NULL);
+  g_object_unref (source);
+  if (!source_stats)
+    return;
+
+  ts = monotonic_time_as_double_milliseconds ();
+
+  g_mutex_lock (&webrtc->priv->stats_lock);
+  g_hash_table_iter_init (&iter, webrtc->priv->stats_cache);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & entry)) {
+    if (entry->session_id == session_id && !entry->dirty)
+      _update_cached_source_stats (webrtc, entry->stats, source_stats, ts);
+  }
+  g_mutex_unlock (&webrtc->priv->stats_lock);
+
+  gst_structure_free (source_stats);
+}
+
+/* Returns the statistics report for @pads from the cache, or %NULL if any of
+ * them is missing or outdated. Only takes the stats lock, so it can be
+ * called from any thread without waiting on the peerconnection thread. */
+GstStructure *
+gst_webrtc_bin_get_cached_stats (GstWebRTCBin * webrtc, GPtrArray * pads)
+{
+  GstStructure *s;
+  guint i;
+
+  _init_debug ();
+
+  g_mutex_lock (&webrtc->priv->stats_lock);
+  for (i = 0; i < pads->len; i++) {
+    StatsCacheEntry *entry =
+        g_hash_table_lookup (webrtc->priv->stats_cache,
+        g_ptr_array_index (pads, i));
+
+    if (!_stats_cache_entry_is_valid (entry)) {
+      g_mutex_unlock (&webrtc->priv->stats_lock);
+      return NULL;
+    }
+  }
+
+  s = _new_stats_report (webrtc, monotonic_time_as_double_milliseconds ());
+
+  for (i = 0; i < pads->len; i++) {
+    StatsCacheEntry *entry =
+        g_hash_table_lookup (webrtc->priv->stats_cache,
+        g_ptr_array_index (pads, i));
+
+    gst_structure_foreach (entry->stats,
+        (GstStructureForeachFunc) _merge_stats_field, s);
+  }
+  g_mutex_unlock (&webrtc->priv->stats_lock);
+
+  GST_TRACE_OBJECT (webrtc, "answered stats for %u pads from cache", pads->len);
+
+  return s;
+}
+
+/* Builds the statistics report for @pads, only collecting the statistics of
+ * pads that are not cached or whose cached statistics are outdated. */
+GstStructure *
+gst_webrtc_bin_create_stats (GstWebRTCBin * webrtc, GPtrArray * pads)
+{
+  double ts = monotonic_time_as_double_milliseconds ();
+  GstStructure *s;
+  guint i, n_updated = 0;
+
+  _init_debug ();
+
+  /* FIXME: better unique IDs */
+  /* FIXME: all stats need to be kept forever */
+
+  GST_DEBUG_OBJECT (webrtc, "updating stats at time %f", ts);
+
+  s = _new_stats_report (webrtc, ts);
+
+  for (i = 0; i < pads->len; i++) {
+    GstPad *pad = g_ptr_array_index (pads, i);
+    GstWebRTCBinPad *wpad = GST_WEBRTC_BIN_PAD (pad);
+    StatsCacheEntry *entry;
+    GstStructure *pad_stats;
+    guint session_id = G_MAXUINT;
+
+    g_mutex_lock (&webrtc->priv->stats_lock);
+    entry = g_hash_table_lookup (webrtc->priv->stats_cache, pad);
+    if (_stats_cache_entry_is_valid (entry)) {
+      gst_structure_foreach (entry->stats,
+          (GstStructureForeachFunc) _merge_stats_field, s);
+      g_mutex_unlock (&webrtc->priv->stats_lock);
+      continue;
+    }
+    g_mutex_unlock (&webrtc->priv->stats_lock);
+
+    pad_stats = gst_structure_new_empty ("application/x-webrtc-stats");
+    gst_structure_set (pad_stats, "timestamp", G_TYPE_DOUBLE, ts, NULL);
+    _get_stats_from_pad (webrtc, pad, pad_stats);
+    gst_structure_remove_field (pad_stats, "timestamp");
+    n_updated++;
+
+    if (wpad->trans && WEBRTC_TRANSCEIVER (wpad->trans)->stream)
+      session_id = WEBRTC_TRANSCEIVER (wpad->trans)->stream->session_id;
+
+    gst_structure_foreach (pad_stats,
+        (GstStructureForeachFunc) _merge_stats_field, s);
+
+    entry = g_new0 (StatsCacheEntry, 1);
+    entry->stats = pad_stats;
+    entry->session_id = session_id;
+
+    g_mutex_lock (&webrtc->priv->stats_lock);
+    g_hash_table_replace (webrtc->priv->stats_cache, gst_object_ref (pad),
+        entry);
+    g_mutex_unlock (&webrtc->priv->stats_lock);
+  }
 
-  gst_structure_remove_field (s, "timestamp");
+  GST_DEBUG_OBJECT (webrtc, "updated stats of %u out of %u pads", n_updated,
+      pads->len);
 
   return s;
 }
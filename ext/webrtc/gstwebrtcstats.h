@@ -27,9 +27,23 @@
 
 G_BEGIN_DECLS
 
+G_GNUC_INTERNAL
+void               gst_webrtc_bin_init_stats           (GstWebRTCBin * webrtc);
+G_GNUC_INTERNAL
+void               gst_webrtc_bin_clear_stats          (GstWebRTCBin * webrtc);
+G_GNUC_INTERNAL
+void               gst_webrtc_bin_invalidate_stats     (GstWebRTCBin * webrtc,
+                                                        guint session_id);
+G_GNUC_INTERNAL
+void               gst_webrtc_bin_update_ssrc_stats    (GstWebRTCBin * webrtc,
+                                                        guint session_id,
+                                                        guint ssrc);
+G_GNUC_INTERNAL
+GstStructure *     gst_webrtc_bin_get_cached_stats     (GstWebRTCBin * webrtc,
+                                                        GPtrArray * pads);
 G_GNUC_INTERNAL
 GstStructure *     gst_webrtc_bin_create_stats         (GstWebRTCBin * webrtc,
-                                                        GstPad * pad);
+                                                        GPtrArray * pads);
 
 G_END_DECLS
 
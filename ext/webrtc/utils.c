@@ -229,3 +229,38 @@ webrtc_kind_from_caps (const GstCaps * caps)
 
   return GST_WEBRTC_KIND_UNKNOWN;
 }
+
+#define RTP_FIXED_HEADER_LEN 12
+
+/* Returns a buffer carrying the RTP packet in @buffer with its payload type
+ * set to @pt. Only the fixed RTP header is copied, the rest of the packet
+ * keeps sharing the memory of @buffer so that a stream payloaded once can be
+ * sent to many peers. Takes ownership of @buffer. */
+GstBuffer *
+_rtp_buffer_rewrite_payload_type (GstBuffer * buffer, guint8 pt)
+{
+  guint8 header[RTP_FIXED_HEADER_LEN];
+  GstBuffer *ret, *payload;
+
+  if (gst_buffer_extract (buffer, 0, header,
+          RTP_FIXED_HEADER_LEN) != RTP_FIXED_HEADER_LEN)
+    return buffer;
+
+  /* not RTP version 2 or already the right payload type */
+  if ((header[0] >> 6) != 2 || (header[1] & 0x7f) == pt)
+    return buffer;
+
+  header[1] = (header[1] & 0x80) | (pt & 0x7f);
+
+  ret = gst_buffer_new_allocate (NULL, RTP_FIXED_HEADER_LEN, NULL);
+  gst_buffer_fill (ret, 0, header, RTP_FIXED_HEADER_LEN);
+  gst_buffer_copy_into (ret, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+
+  payload = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY,
+      RTP_FIXED_HEADER_LEN, -1);
+  ret = gst_buffer_append (ret, payload);
+
+  gst_buffer_unref (buffer);
+
+  return ret;
+}
@@ -85,6 +85,9 @@ G_GNUC_INTERNAL
 GstCaps *               _rtp_caps_from_media        (const GstSDPMedia * media);
 G_GNUC_INTERNAL
 GstWebRTCKind           webrtc_kind_from_caps       (const GstCaps * caps);
+G_GNUC_INTERNAL
+GstBuffer *             _rtp_buffer_rewrite_payload_type (GstBuffer * buffer,
+                                                          guint8 pt);
 
 G_END_DECLS
 
@@ -0,0 +1,114 @@
+/* GStreamer
+ *
+ * gst-row-bands-private.h: helpers for video filters processing a frame in
+ * bands of rows on several threads
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_ROW_BANDS_PRIVATE_H__
+#define __GST_ROW_BANDS_PRIVATE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Task pool the bands are pushed to. Band 0 always runs on the calling
+ * thread, so a pool is only created when more than one band is used. The
+ * structure is zero-initialized together with the element. */
+typedef struct
+{
+  GstTaskPool *task_pool;
+  guint n_threads;
+} GstRowBands;
+
+typedef void (*GstRowBandsFunc) (gpointer band);
+
+/* The "n-threads" property shared by the elements using GstRowBands */
+static inline GParamSpec *
+gst_row_bands_param_spec_n_threads (guint default_value)
+{
+  return g_param_spec_uint ("n-threads", "Threads",
+      "Maximum number of threads to use (0 = number of processors)",
+      0, G_MAXINT, default_value, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+}
+
+static inline void
+gst_row_bands_clear (GstRowBands * row_bands)
+{
+  if (row_bands->task_pool) {
+    gst_task_pool_cleanup (row_bands->task_pool);
+    gst_object_unref (row_bands->task_pool);
+    row_bands->task_pool = NULL;
+  }
+  row_bands->n_threads = 0;
+}
+
+/* Returns the number of bands @n_rows rows are split in for the value
+ * @n_threads of the "n-threads" property, and makes sure the task pool has
+ * enough threads for them. A larger pool is kept, so that callers working
+ * on different numbers of rows do not recreate it. */
+static inline guint
+gst_row_bands_prepare (GstRowBands * row_bands, GstObject * object,
+    guint n_threads, guint n_rows)
+{
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_threads = CLAMP (n_threads, 1, MAX (n_rows, 1));
+
+  if (n_threads > 1 && row_bands->n_threads < n_threads) {
+    gst_row_bands_clear (row_bands);
+
+    GST_DEBUG_OBJECT (object, "Using %u threads", n_threads);
+    row_bands->task_pool = gst_shared_task_pool_new ();
+    gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL
+        (row_bands->task_pool), n_threads - 1);
+    gst_task_pool_prepare (row_bands->task_pool, NULL);
+    row_bands->n_threads = n_threads;
+  }
+
+  return n_threads;
+}
+
+/* Calls @func on each of the @n_bands elements of size @band_size of
+ * @bands, all but the first one on the task pool, and waits for them. */
+static inline void
+gst_row_bands_run (GstRowBands * row_bands, GstRowBandsFunc func,
+    gpointer bands, gsize band_size, guint n_bands)
+{
+  gpointer *ids = g_newa (gpointer, n_bands);
+  guint i;
+
+  for (i = 1; i < n_bands; i++) {
+    gpointer band = (guint8 *) bands + i * band_size;
+
+    ids[i] = gst_task_pool_push (row_bands->task_pool,
+        (GstTaskPoolFunction) func, band, NULL);
+    if (ids[i] == NULL)
+      func (band);
+  }
+
+  func (bands);
+
+  for (i = 1; i < n_bands; i++) {
+    if (ids[i])
+      gst_task_pool_join (row_bands->task_pool, ids[i]);
+  }
+}
+
+G_END_DECLS
+
+#endif /* __GST_ROW_BANDS_PRIVATE_H__ */
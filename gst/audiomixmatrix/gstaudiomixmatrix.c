@@ -232,6 +232,14 @@ gst_audio_mix_matrix_init (GstAudioMixMatrix * self)
   self->s16_conv_matrix = NULL;
   self->s32_conv_matrix = NULL;
   self->mode = GST_AUDIO_MIX_MATRIX_MODE_MANUAL;
+  self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_SPARSE;
+  self->nz_offsets = NULL;
+  self->nz_in = NULL;
+  self->nz_plane = NULL;
+  self->nz_index = NULL;
+  self->used_in = NULL;
+  self->n_used_in = 0;
+  self->planes = NULL;
 }
 
 static void
@@ -244,6 +252,13 @@ gst_audio_mix_matrix_dispose (GObject * object)
     self->matrix = NULL;
   }
 
+  g_clear_pointer (&self->nz_offsets, g_free);
+  g_clear_pointer (&self->nz_in, g_free);
+  g_clear_pointer (&self->nz_plane, g_free);
+  g_clear_pointer (&self->nz_index, g_free);
+  g_clear_pointer (&self->used_in, g_free);
+  g_clear_pointer (&self->planes, g_free);
+
   G_OBJECT_CLASS (gst_audio_mix_matrix_parent_class)->dispose (object);
 }
 
@@ -283,6 +298,93 @@ gst_audio_mix_matrix_convert_s32_matrix (GstAudioMixMatrix * self)
   }
 }
 
+/* Number of samples processed at once by the sparse kernels */
+#define MIX_BLOCK_SIZE 128
+
+/* Collects the non-zero coefficients of each output channel and picks the
+ * cheapest way to apply the matrix: most matrices used for routing or
+ * downmixing many channels only have a few non-zero coefficients per
+ * output. */
+static void
+gst_audio_mix_matrix_update_kernel (GstAudioMixMatrix * self)
+{
+  guint in, out, n = 0;
+  gboolean route = TRUE, unit_gain = TRUE, identity;
+  gint *planes;
+
+  g_clear_pointer (&self->nz_offsets, g_free);
+  g_clear_pointer (&self->nz_in, g_free);
+  g_clear_pointer (&self->nz_plane, g_free);
+  g_clear_pointer (&self->nz_index, g_free);
+  g_clear_pointer (&self->used_in, g_free);
+  g_clear_pointer (&self->planes, g_free);
+  self->n_used_in = 0;
+  self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_SPARSE;
+
+  if (!self->matrix)
+    return;
+
+  self->nz_offsets = g_new (guint, self->out_channels + 1);
+  self->nz_in = g_new (guint, self->in_channels * self->out_channels);
+  self->nz_plane = g_new (guint, self->in_channels * self->out_channels);
+  self->nz_index = g_new (guint, self->in_channels * self->out_channels);
+  self->used_in = g_new (guint, self->in_channels);
+
+  /* planar copy of each input channel used by the sparse kernels */
+  planes = g_new (gint, self->in_channels);
+  for (in = 0; in < self->in_channels; in++)
+    planes[in] = -1;
+
+  identity = self->in_channels == self->out_channels;
+
+  for (out = 0; out < self->out_channels; out++) {
+    self->nz_offsets[out] = n;
+
+    for (in = 0; in < self->in_channels; in++) {
+      guint index = out * self->in_channels + in;
+      gdouble coefficient = self->matrix[index];
+
+      if (coefficient == 0.0)
+        continue;
+
+      if (planes[in] < 0) {
+        planes[in] = self->n_used_in;
+        self->used_in[self->n_used_in++] = in;
+      }
+
+      self->nz_in[n] = in;
+      self->nz_plane[n] = planes[in];
+      self->nz_index[n] = index;
+      n++;
+
+      if (coefficient != 1.0)
+        unit_gain = FALSE;
+      if (in != out)
+        identity = FALSE;
+    }
+
+    if (n - self->nz_offsets[out] > 1)
+      route = FALSE;
+    if (n - self->nz_offsets[out] != 1)
+      identity = FALSE;
+  }
+  self->nz_offsets[self->out_channels] = n;
+  g_free (planes);
+
+  if (identity && unit_gain)
+    self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_IDENTITY;
+  else if (route && unit_gain)
+    self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_COPY;
+  else if (route)
+    self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_ROUTE;
+  else
+    /* large enough for the widest accumulator type */
+    self->planes = g_malloc (MAX (self->n_used_in, 1) * MIX_BLOCK_SIZE *
+        sizeof (gint64));
+
+  GST_DEBUG_OBJECT (self, "using kernel %d, %u of %u coefficients are non-zero",
+      self->kernel, n, self->in_channels * self->out_channels);
+}
 
 static void
 gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
@@ -292,42 +394,65 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_IN_CHANNELS:
-      self->in_channels = g_value_get_uint (value);
-      if (self->matrix) {
-        gst_audio_mix_matrix_convert_s16_matrix (self);
-        gst_audio_mix_matrix_convert_s32_matrix (self);
-      }
-      break;
-    case PROP_OUT_CHANNELS:
-      self->out_channels = g_value_get_uint (value);
-      if (self->matrix) {
-        gst_audio_mix_matrix_convert_s16_matrix (self);
-        gst_audio_mix_matrix_convert_s32_matrix (self);
+    case PROP_OUT_CHANNELS:{
+      guint channels = g_value_get_uint (value);
+      guint *prop_channels = prop_id == PROP_IN_CHANNELS ?
+          &self->in_channels : &self->out_channels;
+
+      GST_OBJECT_LOCK (self);
+      /* the matrix no longer has the right size, a new one has to be set */
+      if (*prop_channels != channels && self->matrix) {
+        GST_DEBUG_OBJECT (self, "number of channels changed, dropping matrix");
+        g_clear_pointer (&self->matrix, g_free);
       }
+      *prop_channels = channels;
+      gst_audio_mix_matrix_update_kernel (self);
+      GST_OBJECT_UNLOCK (self);
       break;
+    }
     case PROP_MATRIX:{
-      gint in, out;
+      guint in, out, in_channels, out_channels;
+      gdouble *matrix;
 
-      if (self->matrix)
-        g_free (self->matrix);
-      self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
+      GST_OBJECT_LOCK (self);
+      in_channels = self->in_channels;
+      out_channels = self->out_channels;
+      GST_OBJECT_UNLOCK (self);
 
-      g_return_if_fail (gst_value_array_get_size (value) == self->out_channels);
-      for (out = 0; out < self->out_channels; out++) {
+      g_return_if_fail (gst_value_array_get_size (value) == out_channels);
+      for (out = 0; out < out_channels; out++) {
         const GValue *row = gst_value_array_get_value (value, out);
-        g_return_if_fail (gst_value_array_get_size (row) == self->in_channels);
-        for (in = 0; in < self->in_channels; in++) {
-          const GValue *itm;
-          gdouble coefficient;
+        g_return_if_fail (gst_value_array_get_size (row) == in_channels);
+        for (in = 0; in < in_channels; in++)
+          g_return_if_fail (G_VALUE_HOLDS_DOUBLE (gst_value_array_get_value
+                  (row, in)));
+      }
 
-          itm = gst_value_array_get_value (row, in);
-          g_return_if_fail (G_VALUE_HOLDS_DOUBLE (itm));
-          coefficient = g_value_get_double (itm);
-          self->matrix[out * self->in_channels + in] = coefficient;
-        }
+      matrix = g_new (gdouble, in_channels * out_channels);
+      for (out = 0; out < out_channels; out++) {
+        const GValue *row = gst_value_array_get_value (value, out);
+
+        for (in = 0; in < in_channels; in++)
+          matrix[out * in_channels + in] =
+              g_value_get_double (gst_value_array_get_value (row, in));
+      }
+
+      /* the streaming thread uses the matrix and the kernel state under the
+       * object lock, replace them all at once */
+      GST_OBJECT_LOCK (self);
+      if (in_channels != self->in_channels
+          || out_channels != self->out_channels) {
+        GST_OBJECT_UNLOCK (self);
+        g_warning ("number of channels changed while setting the matrix");
+        g_free (matrix);
+        break;
       }
+      g_free (self->matrix);
+      self->matrix = matrix;
       gst_audio_mix_matrix_convert_s16_matrix (self);
       gst_audio_mix_matrix_convert_s32_matrix (self);
+      gst_audio_mix_matrix_update_kernel (self);
+      GST_OBJECT_UNLOCK (self);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -358,8 +483,11 @@ gst_audio_mix_matrix_get_property (GObject * object, guint prop_id,
     case PROP_MATRIX:{
       gint in, out;
 
-      if (self->matrix == NULL)
+      GST_OBJECT_LOCK (self);
+      if (self->matrix == NULL) {
+        GST_OBJECT_UNLOCK (self);
         break;
+      }
 
       for (out = 0; out < self->out_channels; out++) {
         GValue row = G_VALUE_INIT;
@@ -374,6 +502,7 @@ gst_audio_mix_matrix_get_property (GObject * object, guint prop_id,
         gst_value_array_append_value (value, &row);
         g_value_unset (&row);
       }
+      GST_OBJECT_UNLOCK (self);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -414,16 +543,141 @@ gst_audio_mix_matrix_change_state (GstElement * element,
 }
 
 
+#define SHIFT_NONE(v, n) ((void) (n), (v))
+#define SHIFT_RIGHT(v, n) ((v) >> (n))
+
+/* Only goes through the non-zero coefficients of each output. Samples are
+ * handled in blocks of MIX_BLOCK_SIZE: the inputs that are used are first
+ * converted to planar accumulator-sized arrays, so that each coefficient is
+ * applied by a contiguous multiply-add loop the compiler can vectorise, and
+ * the result is interleaved again at the end of the block. */
+#define DEFINE_MIX_SPARSE(name, type, acc_type, coef_type, SHIFT)              \
+static void                                                                     \
+name (GstAudioMixMatrix * self, const type * inarray, type * outarray,         \
+    guint n_samples, const coef_type * coefs)                                  \
+{                                                                               \
+  const guint *nz_offsets = self->nz_offsets;                                  \
+  const guint *nz_plane = self->nz_plane;                                      \
+  const guint *nz_index = self->nz_index;                                      \
+  const guint *used_in = self->used_in;                                        \
+  acc_type *planes = self->planes;                                             \
+  acc_type acc[MIX_BLOCK_SIZE];                                                \
+  guint inchannels = self->in_channels;                                        \
+  guint outchannels = self->out_channels;                                      \
+  guint n = self->shift_bytes;                                                 \
+  guint start, len, p, out, i, k;                                              \
+                                                                                \
+  for (start = 0; start < n_samples; start += MIX_BLOCK_SIZE) {                \
+    len = MIN (MIX_BLOCK_SIZE, n_samples - start);                             \
+                                                                                \
+    for (p = 0; p < self->n_used_in; p++) {                                    \
+      acc_type *plane = planes + p * MIX_BLOCK_SIZE;                           \
+      const type *src = inarray + used_in[p];                                  \
+      for (k = 0; k < len; k++)                                                \
+        plane[k] = src[k * inchannels];                                        \
+    }                                                                          \
+                                                                                \
+    for (out = 0; out < outchannels; out++) {                                  \
+      for (k = 0; k < len; k++)                                                \
+        acc[k] = 0;                                                            \
+      for (i = nz_offsets[out]; i < nz_offsets[out + 1]; i++) {                \
+        const acc_type *plane = planes + nz_plane[i] * MIX_BLOCK_SIZE;         \
+        acc_type coef = coefs[nz_index[i]];                                    \
+        for (k = 0; k < len; k++)                                              \
+          acc[k] += plane[k] * coef;                                           \
+      }                                                                        \
+      for (k = 0; k < len; k++)                                                \
+        outarray[k * outchannels + out] = (type) SHIFT (acc[k], n);            \
+    }                                                                          \
+                                                                                \
+    inarray += len * inchannels;                                               \
+    outarray += len * outchannels;                                             \
+  }                                                                            \
+}
+
+/* Every output takes at most one input, scaled by its coefficient */
+#define DEFINE_MIX_ROUTE(name, type, acc_type, coef_type, SHIFT)               \
+static void                                                                     \
+name (GstAudioMixMatrix * self, const type * inarray, type * outarray,         \
+    guint n_samples, const coef_type * coefs)                                  \
+{                                                                               \
+  const guint *nz_offsets = self->nz_offsets;                                  \
+  const guint *nz_in = self->nz_in;                                            \
+  const guint *nz_index = self->nz_index;                                      \
+  guint inchannels = self->in_channels;                                        \
+  guint outchannels = self->out_channels;                                      \
+  guint n = self->shift_bytes;                                                 \
+  guint sample, out, i;                                                        \
+                                                                                \
+  for (sample = 0; sample < n_samples; sample++) {                             \
+    for (out = 0; out < outchannels; out++) {                                  \
+      i = nz_offsets[out];                                                     \
+      if (i == nz_offsets[out + 1]) {                                          \
+        outarray[out] = 0;                                                     \
+      } else {                                                                 \
+        acc_type outval = inarray[nz_in[i]] * coefs[nz_index[i]];              \
+        outarray[out] = (type) SHIFT (outval, n);                              \
+      }                                                                        \
+    }                                                                          \
+    inarray += inchannels;                                                     \
+    outarray += outchannels;                                                   \
+  }                                                                            \
+}
+
+/* Every output is a copy of at most one input, the sample format does not
+ * matter as long as the width is the same */
+#define DEFINE_MIX_COPY(name, type)                                            \
+static void                                                                     \
+name (GstAudioMixMatrix * self, const type * inarray, type * outarray,         \
+    guint n_samples)                                                           \
+{                                                                               \
+  const guint *nz_offsets = self->nz_offsets;                                  \
+  const guint *nz_in = self->nz_in;                                            \
+  guint inchannels = self->in_channels;                                        \
+  guint outchannels = self->out_channels;                                      \
+  guint sample, out;                                                           \
+                                                                                \
+  for (sample = 0; sample < n_samples; sample++) {                             \
+    for (out = 0; out < outchannels; out++) {                                  \
+      if (nz_offsets[out] == nz_offsets[out + 1])                              \
+        outarray[out] = 0;                                                     \
+      else                                                                     \
+        outarray[out] = inarray[nz_in[nz_offsets[out]]];                       \
+    }                                                                          \
+    inarray += inchannels;                                                     \
+    outarray += outchannels;                                                   \
+  }                                                                            \
+}
+
+DEFINE_MIX_SPARSE (mix_sparse_f32, gfloat, gfloat, gdouble, SHIFT_NONE);
+DEFINE_MIX_SPARSE (mix_sparse_f64, gdouble, gdouble, gdouble, SHIFT_NONE);
+DEFINE_MIX_SPARSE (mix_sparse_s16, gint16, gint32, gint32, SHIFT_RIGHT);
+DEFINE_MIX_SPARSE (mix_sparse_s32, gint32, gint64, gint64, SHIFT_RIGHT);
+
+DEFINE_MIX_ROUTE (mix_route_f32, gfloat, gfloat, gdouble, SHIFT_NONE);
+DEFINE_MIX_ROUTE (mix_route_f64, gdouble, gdouble, gdouble, SHIFT_NONE);
+DEFINE_MIX_ROUTE (mix_route_s16, gint16, gint32, gint32, SHIFT_RIGHT);
+DEFINE_MIX_ROUTE (mix_route_s32, gint32, gint64, gint64, SHIFT_RIGHT);
+
+DEFINE_MIX_COPY (mix_copy_16, guint16);
+DEFINE_MIX_COPY (mix_copy_32, guint32);
+DEFINE_MIX_COPY (mix_copy_64, guint64);
+
 static GstFlowReturn
 gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     GstBuffer * inbuf, GstBuffer * outbuf)
 {
   GstMapInfo inmap, outmap;
   GstAudioMixMatrix *self = GST_AUDIO_MIX_MATRIX (vfilter);
-  gint in, out, sample;
-  guint inchannels = self->in_channels;
-  guint outchannels = self->out_channels;
-  gdouble *matrix = self->matrix;
+  const GstAudioFormatInfo *finfo;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean route;
+  guint n_samples, width;
+
+  finfo = gst_audio_format_get_info (self->format);
+  if (!finfo)
+    return GST_FLOW_NOT_SUPPORTED;
+  width = GST_AUDIO_FORMAT_INFO_WIDTH (finfo);
 
   if (!gst_buffer_map (inbuf, &inmap, GST_MAP_READ)) {
     return GST_FLOW_ERROR;
@@ -433,107 +687,101 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     return GST_FLOW_ERROR;
   }
 
+  /* the matrix and the kernel state can be replaced from the application */
+  GST_OBJECT_LOCK (self);
+  if (!self->nz_offsets) {
+    ret = GST_FLOW_NOT_SUPPORTED;
+    goto done;
+  }
+  route = self->kernel == GST_AUDIO_MIX_MATRIX_KERNEL_ROUTE;
+
+  /* the number of channels may have changed since the caps were set */
+  n_samples = MIN (outmap.size / ((width / 8) * self->out_channels),
+      inmap.size / ((width / 8) * self->in_channels));
+
+  if (self->kernel == GST_AUDIO_MIX_MATRIX_KERNEL_IDENTITY) {
+    memcpy (outmap.data, inmap.data, MIN (inmap.size, outmap.size));
+    goto done;
+  }
+
+  if (self->kernel == GST_AUDIO_MIX_MATRIX_KERNEL_COPY) {
+    switch (width) {
+      case 16:
+        mix_copy_16 (self, (const guint16 *) inmap.data,
+            (guint16 *) outmap.data, n_samples);
+        goto done;
+      case 32:
+        mix_copy_32 (self, (const guint32 *) inmap.data,
+            (guint32 *) outmap.data, n_samples);
+        goto done;
+      case 64:
+        mix_copy_64 (self, (const guint64 *) inmap.data,
+            (guint64 *) outmap.data, n_samples);
+        goto done;
+      default:
+        break;
+    }
+  }
+
   switch (self->format) {
     case GST_AUDIO_FORMAT_F32LE:
     case GST_AUDIO_FORMAT_F32BE:{
-      const gfloat *inarray;
-      gfloat *outarray;
-      guint n_samples = outmap.size / (sizeof (gfloat) * outchannels);
-
-      inarray = (gfloat *) inmap.data;
-      outarray = (gfloat *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gfloat outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
+      const gfloat *inarray = (const gfloat *) inmap.data;
+      gfloat *outarray = (gfloat *) outmap.data;
+
+      if (route)
+        mix_route_f32 (self, inarray, outarray, n_samples, self->matrix);
+      else
+        mix_sparse_f32 (self, inarray, outarray, n_samples, self->matrix);
       break;
     }
     case GST_AUDIO_FORMAT_F64LE:
     case GST_AUDIO_FORMAT_F64BE:{
-      const gdouble *inarray;
-      gdouble *outarray;
-      guint n_samples = outmap.size / (sizeof (gdouble) * outchannels);
-
-      inarray = (gdouble *) inmap.data;
-      outarray = (gdouble *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gdouble outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
+      const gdouble *inarray = (const gdouble *) inmap.data;
+      gdouble *outarray = (gdouble *) outmap.data;
+
+      if (route)
+        mix_route_f64 (self, inarray, outarray, n_samples, self->matrix);
+      else
+        mix_sparse_f64 (self, inarray, outarray, n_samples, self->matrix);
       break;
     }
     case GST_AUDIO_FORMAT_S16LE:
     case GST_AUDIO_FORMAT_S16BE:{
-      const gint16 *inarray;
-      gint16 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint16) * outchannels);
-      guint n = self->shift_bytes;
-      gint32 *conv_matrix = self->s16_conv_matrix;
-
-      inarray = (gint16 *) inmap.data;
-      outarray = (gint16 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint32 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint32) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint16) (outval >> n);
-        }
-      }
+      const gint16 *inarray = (const gint16 *) inmap.data;
+      gint16 *outarray = (gint16 *) outmap.data;
+
+      if (route)
+        mix_route_s16 (self, inarray, outarray, n_samples,
+            self->s16_conv_matrix);
+      else
+        mix_sparse_s16 (self, inarray, outarray, n_samples,
+            self->s16_conv_matrix);
       break;
     }
     case GST_AUDIO_FORMAT_S32LE:
     case GST_AUDIO_FORMAT_S32BE:{
-      const gint32 *inarray;
-      gint32 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint32) * outchannels);
-      guint n = self->shift_bytes;
-      gint64 *conv_matrix = self->s32_conv_matrix;
-
-      inarray = (gint32 *) inmap.data;
-      outarray = (gint32 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint64 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint64) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint32) (outval >> n);
-        }
-      }
+      const gint32 *inarray = (const gint32 *) inmap.data;
+      gint32 *outarray = (gint32 *) outmap.data;
+
+      if (route)
+        mix_route_s32 (self, inarray, outarray, n_samples,
+            self->s32_conv_matrix);
+      else
+        mix_sparse_s32 (self, inarray, outarray, n_samples,
+            self->s32_conv_matrix);
       break;
     }
     default:
-      gst_buffer_unmap (inbuf, &inmap);
-      gst_buffer_unmap (outbuf, &outmap);
-      return GST_FLOW_NOT_SUPPORTED;
-
+      ret = GST_FLOW_NOT_SUPPORTED;
+      break;
   }
 
+done:
+  GST_OBJECT_UNLOCK (self);
   gst_buffer_unmap (inbuf, &inmap);
   gst_buffer_unmap (outbuf, &outmap);
-  return GST_FLOW_OK;
+  return ret;
 }
 
 static gboolean
@@ -563,6 +811,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
   if (!gst_audio_info_from_caps (&out_info, outcaps))
     return FALSE;
 
+  GST_OBJECT_LOCK (self);
   self->format = info.finfo->format;
 
   if (self->mode == GST_AUDIO_MIX_MATRIX_MODE_FIRST_CHANNELS) {
@@ -571,6 +820,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     self->in_channels = info.channels;
     self->out_channels = out_info.channels;
 
+    g_free (self->matrix);
     self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
 
     for (out = 0; out < self->out_channels; out++) {
@@ -580,6 +830,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     }
   } else if (!self->matrix || info.channels != self->in_channels ||
       out_info.channels != self->out_channels) {
+    GST_OBJECT_UNLOCK (self);
     GST_ELEMENT_ERROR (self, LIBRARY, SETTINGS,
         ("Erroneous matrix detected"),
         ("Please enter a matrix with the correct input and output channels"));
@@ -600,6 +851,10 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     default:
       break;
   }
+
+  gst_audio_mix_matrix_update_kernel (self);
+  GST_OBJECT_UNLOCK (self);
+
   return TRUE;
 }
 
@@ -43,6 +43,19 @@ typedef enum _GstAudioMixMatrixMode
   GST_AUDIO_MIX_MATRIX_MODE_FIRST_CHANNELS = 1
 } GstAudioMixMatrixMode;
 
+/* How the matrix is applied, chosen from its coefficients */
+typedef enum
+{
+  /* sum of the non-zero coefficients of each output */
+  GST_AUDIO_MIX_MATRIX_KERNEL_SPARSE,
+  /* every output takes at most one input, scaled */
+  GST_AUDIO_MIX_MATRIX_KERNEL_ROUTE,
+  /* every output takes at most one input, unscaled */
+  GST_AUDIO_MIX_MATRIX_KERNEL_COPY,
+  /* identity matrix */
+  GST_AUDIO_MIX_MATRIX_KERNEL_IDENTITY
+} GstAudioMixMatrixKernel;
+
 /**
  * GstAudioMixMatrix:
  *
@@ -62,6 +75,22 @@ struct _GstAudioMixMatrix
   gint64 *s32_conv_matrix;
   gint shift_bytes;
 
+  /* non-zero coefficients of each output channel: for output out, the
+   * entries nz_offsets[out] to nz_offsets[out + 1] - 1 of nz_in, nz_plane
+   * and nz_index hold the input channel, its planar copy and the index in
+   * the matrix */
+  GstAudioMixMatrixKernel kernel;
+  guint *nz_offsets;
+  guint *nz_in;
+  guint *nz_plane;
+  guint *nz_index;
+
+  /* input channels with at least one non-zero coefficient, and the planar
+   * scratch space the sparse kernels copy them to */
+  guint *used_in;
+  guint n_used_in;
+  gpointer planes;
+
   GstAudioFormat format;
 };
 
@@ -0,0 +1,352 @@
+/* GStreamer
+ *
+ * gstscopeanalysis.c: spectrum analysis shared by the scopes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The scopes of a monitoring wall are often fed from a tee, so they all get
+ * the same upstream buffers. GstAudioVisualizer maps the samples of a frame
+ * straight from the upstream buffer when they are not split over several of
+ * them, so each scope remembers the last buffers it received and recognises
+ * the buffer and offset the samples come from. The spectra are attached to
+ * that buffer, and only the first scope pays for the windowing and the FFT.
+ * They go away with the buffer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+
+#include "gstscopeanalysis.h"
+
+/* upstream buffers the samples being analysed can come from */
+#define MAX_INPUTS 8
+
+typedef struct
+{
+  GstBuffer *buffer;
+  const guint8 *data;
+  gsize size;
+} GstScopeAnalysisInput;
+
+/* a spectrum of the samples at @offset of an upstream buffer */
+typedef struct
+{
+  gsize offset;
+  guint n_samples;
+  guint channels;
+  gint channel;
+  GstFFTWindow window;
+
+  GstFFTF32Complex *freq;       /* n_samples / 2 + 1 */
+} GstScopeAnalysisSpectrum;
+
+/* protects the spectra attached to the upstream buffers, which are shared by
+ * the streaming threads of all the scopes they are pushed to */
+G_LOCK_DEFINE_STATIC (spectra_lock);
+
+G_DEFINE_QUARK (GstScopeAnalysisSpectra, gst_scope_analysis_spectra);
+
+struct _GstScopeAnalysis
+{
+  guint n_samples;
+  GstFFTF32 *fft;
+  gfloat *tdata;
+
+  GstPad *sinkpad;
+  gulong probe_id;
+  /* GstScopeAnalysisInput, oldest first, only used from the streaming
+   * thread */
+  GQueue inputs;
+};
+
+GType
+gst_scope_fft_window_get_type (void)
+{
+  static GType gtype = 0;
+
+  if (gtype == 0) {
+    static const GEnumValue values[] = {
+      {GST_FFT_WINDOW_RECTANGULAR, "Rectangular window", "rectangular"},
+      {GST_FFT_WINDOW_HAMMING, "Hamming window", "hamming"},
+      {GST_FFT_WINDOW_HANN, "Hann window", "hann"},
+      {GST_FFT_WINDOW_BARTLETT, "Bartlett window", "bartlett"},
+      {GST_FFT_WINDOW_BLACKMAN, "Blackman window", "blackman"},
+      {0, NULL, NULL}
+    };
+
+    gtype = g_enum_register_static ("GstScopeFFTWindow", values);
+  }
+  return gtype;
+}
+
+static void
+gst_scope_analysis_input_free (GstScopeAnalysisInput * input)
+{
+  gst_buffer_unref (input->buffer);
+  g_free (input);
+}
+
+static void
+gst_scope_analysis_clear_inputs (GstScopeAnalysis * analysis)
+{
+  GstScopeAnalysisInput *input;
+
+  while ((input = g_queue_pop_head (&analysis->inputs)))
+    gst_scope_analysis_input_free (input);
+}
+
+static void
+gst_scope_analysis_spectra_free (GSList * spectra)
+{
+  GSList *l;
+
+  for (l = spectra; l; l = l->next) {
+    GstScopeAnalysisSpectrum *spectrum = l->data;
+
+    g_free (spectrum->freq);
+    g_free (spectrum);
+  }
+  g_slist_free (spectra);
+}
+
+static GstPadProbeReturn
+gst_scope_analysis_sink_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstScopeAnalysis *analysis = user_data;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    GstScopeAnalysisInput *input;
+    GstMemory *mem;
+    GstMapInfo map;
+
+    /* the adapter copies samples spread over several memories */
+    if (gst_buffer_n_memory (buffer) != 1)
+      return GST_PAD_PROBE_OK;
+
+    mem = gst_buffer_peek_memory (buffer, 0);
+    if (!gst_memory_map (mem, &map, GST_MAP_READ))
+      return GST_PAD_PROBE_OK;
+
+    input = g_new (GstScopeAnalysisInput, 1);
+    input->buffer = gst_buffer_ref (buffer);
+    input->data = map.data;
+    input->size = map.size;
+    gst_memory_unmap (mem, &map);
+
+    g_queue_push_tail (&analysis->inputs, input);
+    if (analysis->inputs.length > MAX_INPUTS)
+      gst_scope_analysis_input_free (g_queue_pop_head (&analysis->inputs));
+  } else {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP
+        || GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+      gst_scope_analysis_clear_inputs (analysis);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* gst_scope_analysis_new:
+ * @scope: the scope element
+ * @n_samples: number of samples per channel analysed at once
+ *
+ * Creates the analysis of a scope. It watches the buffers arriving on the
+ * sink pad of @scope, to share the spectra with the other scopes the same
+ * buffers are pushed to.
+ */
+GstScopeAnalysis *
+gst_scope_analysis_new (GstElement * scope, guint n_samples)
+{
+  GstScopeAnalysis *analysis;
+
+  g_return_val_if_fail (GST_IS_ELEMENT (scope), NULL);
+  g_return_val_if_fail (n_samples > 0 && n_samples % 2 == 0, NULL);
+
+  analysis = g_new0 (GstScopeAnalysis, 1);
+  analysis->n_samples = n_samples;
+  analysis->fft = gst_fft_f32_new (n_samples, FALSE);
+  analysis->tdata = g_new (gfloat, n_samples);
+  g_queue_init (&analysis->inputs);
+
+  analysis->sinkpad = gst_element_get_static_pad (scope, "sink");
+  if (analysis->sinkpad) {
+    analysis->probe_id = gst_pad_add_probe (analysis->sinkpad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+        GST_PAD_PROBE_TYPE_EVENT_FLUSH, gst_scope_analysis_sink_probe,
+        analysis, NULL);
+  }
+
+  return analysis;
+}
+
+void
+gst_scope_analysis_free (GstScopeAnalysis * analysis)
+{
+  if (!analysis)
+    return;
+
+  if (analysis->sinkpad) {
+    gst_pad_remove_probe (analysis->sinkpad, analysis->probe_id);
+    gst_object_unref (analysis->sinkpad);
+  }
+  gst_scope_analysis_clear_inputs (analysis);
+
+  gst_fft_f32_free (analysis->fft);
+  g_free (analysis->tdata);
+  g_free (analysis);
+}
+
+/* Returns the upstream buffer @data is mapped from and the offset of @data
+ * in it, or %NULL if the samples were copied */
+static GstBuffer *
+gst_scope_analysis_find_input (GstScopeAnalysis * analysis,
+    const guint8 * data, gsize size, gsize * offset)
+{
+  GList *l;
+
+  for (l = analysis->inputs.head; l; l = l->next) {
+    GstScopeAnalysisInput *input = l->data;
+
+    if (data >= input->data && data + size <= input->data + input->size) {
+      /* the older buffers have been consumed */
+      while (analysis->inputs.head != l)
+        gst_scope_analysis_input_free (g_queue_pop_head (&analysis->inputs));
+
+      *offset = data - input->data;
+      return input->buffer;
+    }
+  }
+
+  return NULL;
+}
+
+static gboolean
+gst_scope_analysis_lookup (GstBuffer * buffer,
+    const GstScopeAnalysisSpectrum * key, GstFFTF32Complex * freq)
+{
+  GSList *l;
+
+  G_LOCK (spectra_lock);
+  for (l = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (buffer),
+          gst_scope_analysis_spectra_quark ()); l; l = l->next) {
+    GstScopeAnalysisSpectrum *spectrum = l->data;
+
+    if (spectrum->offset == key->offset
+        && spectrum->n_samples == key->n_samples
+        && spectrum->channels == key->channels
+        && spectrum->channel == key->channel
+        && spectrum->window == key->window) {
+      memcpy (freq, spectrum->freq,
+          (key->n_samples / 2 + 1) * sizeof (GstFFTF32Complex));
+      G_UNLOCK (spectra_lock);
+      return TRUE;
+    }
+  }
+  G_UNLOCK (spectra_lock);
+
+  return FALSE;
+}
+
+static void
+gst_scope_analysis_attach (GstBuffer * buffer,
+    const GstScopeAnalysisSpectrum * key, const GstFFTF32Complex * freq)
+{
+  GstScopeAnalysisSpectrum *spectrum;
+  GSList *spectra;
+
+  spectrum = g_new (GstScopeAnalysisSpectrum, 1);
+  *spectrum = *key;
+  spectrum->freq = g_memdup2 (freq,
+      (key->n_samples / 2 + 1) * sizeof (GstFFTF32Complex));
+
+  G_LOCK (spectra_lock);
+  spectra = gst_mini_object_steal_qdata (GST_MINI_OBJECT_CAST (buffer),
+      gst_scope_analysis_spectra_quark ());
+  spectra = g_slist_prepend (spectra, spectrum);
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (buffer),
+      gst_scope_analysis_spectra_quark (), spectra,
+      (GDestroyNotify) gst_scope_analysis_spectra_free);
+  G_UNLOCK (spectra_lock);
+}
+
+/* gst_scope_analysis_spectrum:
+ * @analysis: a #GstScopeAnalysis
+ * @adata: the interleaved samples, n_samples per channel
+ * @channels: number of channels in @adata
+ * @channel: channel to analyse, or %GST_SCOPE_ANALYSIS_MIXDOWN
+ * @window: window function applied before the transform
+ * @freq: (out caller-allocates): n_samples / 2 + 1 frequency bins
+ *
+ * Computes the spectrum of a block of samples. The bins are scaled by
+ * 1 / n_samples, for samples in the range [-1.0, 1.0].
+ */
+void
+gst_scope_analysis_spectrum (GstScopeAnalysis * analysis,
+    const gint16 * adata, guint channels, gint channel, GstFFTWindow window,
+    GstFFTF32Complex * freq)
+{
+  guint n_samples = analysis->n_samples;
+  gfloat *tdata = analysis->tdata;
+  GstScopeAnalysisSpectrum key;
+  GstBuffer *input;
+  gfloat scale;
+  guint i, c;
+
+  key.n_samples = n_samples;
+  key.channels = channels;
+  key.channel = channel;
+  key.window = window;
+  input = gst_scope_analysis_find_input (analysis, (const guint8 *) adata,
+      n_samples * channels * sizeof (gint16), &key.offset);
+  if (input && gst_scope_analysis_lookup (input, &key, freq))
+    return;
+
+  if (channel == GST_SCOPE_ANALYSIS_MIXDOWN && channels > 1) {
+    scale = 1.0f / (32768.0f * channels);
+    for (i = 0; i < n_samples; i++) {
+      gint v = 0;
+
+      for (c = 0; c < channels; c++)
+        v += adata[i * channels + c];
+      tdata[i] = v * scale;
+    }
+  } else {
+    if (channel < 0)
+      channel = 0;
+    for (i = 0; i < n_samples; i++)
+      tdata[i] = adata[i * channels + channel] * (1.0f / 32768.0f);
+  }
+
+  if (window != GST_FFT_WINDOW_RECTANGULAR)
+    gst_fft_f32_window (analysis->fft, tdata, window);
+  gst_fft_f32_fft (analysis->fft, tdata, freq);
+
+  scale = 1.0f / n_samples;
+  for (i = 0; i < n_samples / 2 + 1; i++) {
+    freq[i].r *= scale;
+    freq[i].i *= scale;
+  }
+
+  if (input)
+    gst_scope_analysis_attach (input, &key, freq);
+}
@@ -0,0 +1,48 @@
+/* GStreamer
+ *
+ * gstscopeanalysis.h: spectrum analysis shared by the scopes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_SCOPE_ANALYSIS_H__
+#define __GST_SCOPE_ANALYSIS_H__
+
+#include <gst/gst.h>
+#include <gst/fft/gstfftf32.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_SCOPE_FFT_WINDOW (gst_scope_fft_window_get_type ())
+GType gst_scope_fft_window_get_type (void);
+
+/* mixes all channels down instead of analysing a single one */
+#define GST_SCOPE_ANALYSIS_MIXDOWN (-1)
+
+typedef struct _GstScopeAnalysis GstScopeAnalysis;
+
+GstScopeAnalysis * gst_scope_analysis_new (GstElement * scope,
+    guint n_samples);
+
+void gst_scope_analysis_free (GstScopeAnalysis * analysis);
+
+void gst_scope_analysis_spectrum (GstScopeAnalysis * analysis,
+    const gint16 * adata, guint channels, gint channel, GstFFTWindow window,
+    GstFFTF32Complex * freq);
+
+G_END_DECLS
+
+#endif /* __GST_SCOPE_ANALYSIS_H__ */
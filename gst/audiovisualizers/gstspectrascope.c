@@ -27,6 +27,10 @@
  * Spectrascope is a simple spectrum visualisation element. It renders the
  * frequency spectrum as a series of bars.
  *
+ * The spectrum is computed with a float FFT after applying the
+ * #GstSpectraScope:window function. Several scopes analysing the same
+ * samples, e.g. behind a tee, share the analysis.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 audiotestsrc ! audioconvert ! spectrascope ! ximagesink
@@ -68,6 +72,18 @@ GST_STATIC_PAD_TEMPLATE ("sink",
 GST_DEBUG_CATEGORY_STATIC (spectra_scope_debug);
 #define GST_CAT_DEFAULT spectra_scope_debug
 
+enum
+{
+  PROP_0,
+  PROP_WINDOW
+};
+
+#define DEFAULT_WINDOW GST_FFT_WINDOW_HAMMING
+
+static void gst_spectra_scope_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_spectra_scope_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_spectra_scope_finalize (GObject * object);
 
 static gboolean gst_spectra_scope_setup (GstAudioVisualizer * scope);
@@ -88,8 +104,23 @@ gst_spectra_scope_class_init (GstSpectraScopeClass * g_class)
   GstElementClass *element_class = (GstElementClass *) g_class;
   GstAudioVisualizerClass *scope_class = (GstAudioVisualizerClass *) g_class;
 
+  gobject_class->set_property = gst_spectra_scope_set_property;
+  gobject_class->get_property = gst_spectra_scope_get_property;
   gobject_class->finalize = gst_spectra_scope_finalize;
 
+  /**
+   * GstSpectraScope:window:
+   *
+   * Window function applied to the samples before the FFT.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_WINDOW,
+      g_param_spec_enum ("window", "Window",
+          "Window function applied before the FFT",
+          GST_TYPE_SCOPE_FFT_WINDOW, DEFAULT_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (element_class,
       "Frequency spectrum scope", "Visualization",
       "Simple frequency spectrum scope", "Stefan Kost <ensonic@users.sf.net>");
@@ -101,12 +132,50 @@ gst_spectra_scope_class_init (GstSpectraScopeClass * g_class)
 
   scope_class->setup = GST_DEBUG_FUNCPTR (gst_spectra_scope_setup);
   scope_class->render = GST_DEBUG_FUNCPTR (gst_spectra_scope_render);
+
+  gst_type_mark_as_plugin_api (GST_TYPE_SCOPE_FFT_WINDOW, 0);
 }
 
 static void
 gst_spectra_scope_init (GstSpectraScope * scope)
 {
-  /* do nothing */
+  scope->window = DEFAULT_WINDOW;
+}
+
+static void
+gst_spectra_scope_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSpectraScope *scope = GST_SPECTRA_SCOPE (object);
+
+  switch (prop_id) {
+    case PROP_WINDOW:
+      GST_OBJECT_LOCK (scope);
+      scope->window = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (scope);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_spectra_scope_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSpectraScope *scope = GST_SPECTRA_SCOPE (object);
+
+  switch (prop_id) {
+    case PROP_WINDOW:
+      GST_OBJECT_LOCK (scope);
+      g_value_set_enum (value, scope->window);
+      GST_OBJECT_UNLOCK (scope);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static void
@@ -114,9 +183,9 @@ gst_spectra_scope_finalize (GObject * object)
 {
   GstSpectraScope *scope = GST_SPECTRA_SCOPE (object);
 
-  if (scope->fft_ctx) {
-    gst_fft_s16_free (scope->fft_ctx);
-    scope->fft_ctx = NULL;
+  if (scope->analysis) {
+    gst_scope_analysis_free (scope->analysis);
+    scope->analysis = NULL;
   }
   if (scope->freq_data) {
     g_free (scope->freq_data);
@@ -132,14 +201,14 @@ gst_spectra_scope_setup (GstAudioVisualizer * bscope)
   GstSpectraScope *scope = GST_SPECTRA_SCOPE (bscope);
   guint num_freq = GST_VIDEO_INFO_WIDTH (&bscope->vinfo) + 1;
 
-  if (scope->fft_ctx)
-    gst_fft_s16_free (scope->fft_ctx);
+  gst_scope_analysis_free (scope->analysis);
   g_free (scope->freq_data);
 
   /* we'd need this amount of samples per render() call */
   bscope->req_spf = num_freq * 2 - 2;
-  scope->fft_ctx = gst_fft_s16_new (bscope->req_spf, FALSE);
-  scope->freq_data = g_new (GstFFTS16Complex, num_freq);
+  scope->analysis = gst_scope_analysis_new (GST_ELEMENT (bscope),
+      bscope->req_spf);
+  scope->freq_data = g_new (GstFFTF32Complex, num_freq);
 
   return TRUE;
 }
@@ -173,8 +242,8 @@ gst_spectra_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
     GstVideoFrame * video)
 {
   GstSpectraScope *scope = GST_SPECTRA_SCOPE (bscope);
-  gint16 *mono_adata;
-  GstFFTS16Complex *fdata = scope->freq_data;
+  GstFFTF32Complex *fdata = scope->freq_data;
+  GstFFTWindow window;
   guint x, y, off, l;
   guint w = GST_VIDEO_INFO_WIDTH (&bscope->vinfo);
   guint h = GST_VIDEO_INFO_HEIGHT (&bscope->vinfo) - 1;
@@ -183,39 +252,30 @@ gst_spectra_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
   guint32 *vdata;
   gint channels;
 
+  GST_OBJECT_LOCK (scope);
+  window = scope->window;
+  GST_OBJECT_UNLOCK (scope);
+
   gst_buffer_map (audio, &amap, GST_MAP_READ);
   vdata = (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (video, 0);
 
   channels = GST_AUDIO_INFO_CHANNELS (&bscope->ainfo);
 
-  mono_adata = g_memdup2 (amap.data, amap.size);
-
-  if (channels > 1) {
-    guint ch = channels;
-    guint num_samples = amap.size / (ch * sizeof (gint16));
-    guint i, c, v, s = 0;
-
-    /* deinterleave and mixdown adata */
-    for (i = 0; i < num_samples; i++) {
-      v = 0;
-      for (c = 0; c < ch; c++) {
-        v += mono_adata[s++];
-      }
-      mono_adata[i] = v / ch;
-    }
+  if (amap.size < bscope->req_spf * channels * sizeof (gint16)) {
+    gst_buffer_unmap (audio, &amap);
+    return TRUE;
   }
 
-  /* run fft */
-  gst_fft_s16_window (scope->fft_ctx, mono_adata, GST_FFT_WINDOW_HAMMING);
-  gst_fft_s16_fft (scope->fft_ctx, mono_adata, fdata);
-  g_free (mono_adata);
+  /* mixdown and run fft */
+  gst_scope_analysis_spectrum (scope->analysis, (const gint16 *) amap.data,
+      channels, GST_SCOPE_ANALYSIS_MIXDOWN, window, fdata);
 
   /* draw lines */
   for (x = 0; x < w; x++) {
     /* figure out the range so that we don't need to clip,
      * or even better do a log mapping? */
-    fr = (gfloat) fdata[1 + x].r / 512.0;
-    fi = (gfloat) fdata[1 + x].i / 512.0;
+    fr = fdata[1 + x].r * 64.0;
+    fi = fdata[1 + x].i * 64.0;
     y = (guint) (h * sqrt (fr * fr + fi * fi));
     if (y > h)
       y = h;
@@ -26,6 +26,10 @@
  * Synaescope is an audio visualisation element. It analyzes frequencies and
  * out-of phase properties of audio and draws this as clouds of stars.
  *
+ * The spectra are computed with a float FFT, by default without windowing
+ * (see #GstSynaeScope:window). Several scopes analysing the same samples,
+ * e.g. behind a tee, share the analysis.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 audiotestsrc ! audioconvert ! synaescope ! ximagesink
@@ -66,6 +70,18 @@ GST_STATIC_PAD_TEMPLATE ("sink",
 GST_DEBUG_CATEGORY_STATIC (synae_scope_debug);
 #define GST_CAT_DEFAULT synae_scope_debug
 
+enum
+{
+  PROP_0,
+  PROP_WINDOW
+};
+
+#define DEFAULT_WINDOW GST_FFT_WINDOW_RECTANGULAR
+
+static void gst_synae_scope_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_synae_scope_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_synae_scope_finalize (GObject * object);
 
 static gboolean gst_synae_scope_setup (GstAudioVisualizer * scope);
@@ -86,8 +102,23 @@ gst_synae_scope_class_init (GstSynaeScopeClass * g_class)
   GstElementClass *element_class = (GstElementClass *) g_class;
   GstAudioVisualizerClass *scope_class = (GstAudioVisualizerClass *) g_class;
 
+  gobject_class->set_property = gst_synae_scope_set_property;
+  gobject_class->get_property = gst_synae_scope_get_property;
   gobject_class->finalize = gst_synae_scope_finalize;
 
+  /**
+   * GstSynaeScope:window:
+   *
+   * Window function applied to the samples before the FFT.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_WINDOW,
+      g_param_spec_enum ("window", "Window",
+          "Window function applied before the FFT",
+          GST_TYPE_SCOPE_FFT_WINDOW, DEFAULT_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (element_class, "Synaescope",
       "Visualization",
       "Creates video visualizations of audio input, using stereo and pitch information",
@@ -100,6 +131,8 @@ gst_synae_scope_class_init (GstSynaeScopeClass * g_class)
 
   scope_class->setup = GST_DEBUG_FUNCPTR (gst_synae_scope_setup);
   scope_class->render = GST_DEBUG_FUNCPTR (gst_synae_scope_render);
+
+  gst_type_mark_as_plugin_api (GST_TYPE_SCOPE_FFT_WINDOW, 0);
 }
 
 static void
@@ -124,6 +157,44 @@ gst_synae_scope_init (GstSynaeScope * scope)
 
   for (i = 0; i < 256; i++)
     shade[i] = i * 200 >> 8;
+
+  scope->window = DEFAULT_WINDOW;
+}
+
+static void
+gst_synae_scope_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSynaeScope *scope = GST_SYNAE_SCOPE (object);
+
+  switch (prop_id) {
+    case PROP_WINDOW:
+      GST_OBJECT_LOCK (scope);
+      scope->window = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (scope);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_synae_scope_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSynaeScope *scope = GST_SYNAE_SCOPE (object);
+
+  switch (prop_id) {
+    case PROP_WINDOW:
+      GST_OBJECT_LOCK (scope);
+      g_value_set_enum (value, scope->window);
+      GST_OBJECT_UNLOCK (scope);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static void
@@ -131,9 +202,9 @@ gst_synae_scope_finalize (GObject * object)
 {
   GstSynaeScope *scope = GST_SYNAE_SCOPE (object);
 
-  if (scope->fft_ctx) {
-    gst_fft_s16_free (scope->fft_ctx);
-    scope->fft_ctx = NULL;
+  if (scope->analysis) {
+    gst_scope_analysis_free (scope->analysis);
+    scope->analysis = NULL;
   }
   if (scope->freq_data_l) {
     g_free (scope->freq_data_l);
@@ -143,14 +214,6 @@ gst_synae_scope_finalize (GObject * object)
     g_free (scope->freq_data_r);
     scope->freq_data_r = NULL;
   }
-  if (scope->adata_l) {
-    g_free (scope->adata_l);
-    scope->adata_l = NULL;
-  }
-  if (scope->adata_r) {
-    g_free (scope->adata_r);
-    scope->adata_r = NULL;
-  }
 
   G_OBJECT_CLASS (gst_synae_scope_parent_class)->finalize (object);
 }
@@ -161,23 +224,18 @@ gst_synae_scope_setup (GstAudioVisualizer * bscope)
   GstSynaeScope *scope = GST_SYNAE_SCOPE (bscope);
   guint num_freq = GST_VIDEO_INFO_HEIGHT (&bscope->vinfo) + 1;
 
-  if (scope->fft_ctx)
-    gst_fft_s16_free (scope->fft_ctx);
+  gst_scope_analysis_free (scope->analysis);
   g_free (scope->freq_data_l);
   g_free (scope->freq_data_r);
-  g_free (scope->adata_l);
-  g_free (scope->adata_r);
 
   /* FIXME: we could have horizontal or vertical layout */
 
   /* we'd need this amount of samples per render() call */
   bscope->req_spf = num_freq * 2 - 2;
-  scope->fft_ctx = gst_fft_s16_new (bscope->req_spf, FALSE);
-  scope->freq_data_l = g_new (GstFFTS16Complex, num_freq);
-  scope->freq_data_r = g_new (GstFFTS16Complex, num_freq);
-
-  scope->adata_l = g_new (gint16, bscope->req_spf);
-  scope->adata_r = g_new (gint16, bscope->req_spf);
+  scope->analysis = gst_scope_analysis_new (GST_ELEMENT (bscope),
+      bscope->req_spf);
+  scope->freq_data_l = g_new (GstFFTF32Complex, num_freq);
+  scope->freq_data_r = g_new (GstFFTF32Complex, num_freq);
 
   return TRUE;
 }
@@ -213,11 +271,10 @@ gst_synae_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
   GstSynaeScope *scope = GST_SYNAE_SCOPE (bscope);
   GstMapInfo amap;
   guint32 *vdata;
-  gint16 *adata;
-  gint16 *adata_l = scope->adata_l;
-  gint16 *adata_r = scope->adata_r;
-  GstFFTS16Complex *fdata_l = scope->freq_data_l;
-  GstFFTS16Complex *fdata_r = scope->freq_data_r;
+  const gint16 *adata;
+  GstFFTF32Complex *fdata_l = scope->freq_data_l;
+  GstFFTF32Complex *fdata_r = scope->freq_data_r;
+  GstFFTWindow window;
   gint x, y;
   guint off;
   guint w = GST_VIDEO_INFO_WIDTH (&bscope->vinfo);
@@ -226,40 +283,39 @@ gst_synae_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
   guint *shade = scope->shade;
   //guint w2 = w /2;
   guint ch = GST_AUDIO_INFO_CHANNELS (&bscope->ainfo);
-  guint num_samples;
-  gint i, j, b;
+  gint i, b;
   gint br, br1, br2;
   gint clarity;
   gdouble fc, r, l, rr, ll;
   gdouble frl, fil, frr, fir;
   const guint sl = 30;
 
+  GST_OBJECT_LOCK (scope);
+  window = scope->window;
+  GST_OBJECT_UNLOCK (scope);
+
   gst_buffer_map (audio, &amap, GST_MAP_READ);
 
   vdata = (guint32 *) GST_VIDEO_FRAME_PLANE_DATA (video, 0);
-  adata = (gint16 *) amap.data;
-
-  num_samples = amap.size / (ch * sizeof (gint16));
+  adata = (const gint16 *) amap.data;
 
-  /* deinterleave */
-  for (i = 0, j = 0; i < num_samples; i++) {
-    adata_l[i] = adata[j++];
-    adata_r[i] = adata[j++];
+  if (amap.size < bscope->req_spf * ch * sizeof (gint16)) {
+    gst_buffer_unmap (audio, &amap);
+    return TRUE;
   }
 
-  /* run fft */
-  /*gst_fft_s16_window (scope->fft_ctx, adata_l, GST_FFT_WINDOW_HAMMING); */
-  gst_fft_s16_fft (scope->fft_ctx, adata_l, fdata_l);
-  /*gst_fft_s16_window (scope->fft_ctx, adata_r, GST_FFT_WINDOW_HAMMING); */
-  gst_fft_s16_fft (scope->fft_ctx, adata_r, fdata_r);
+  /* deinterleave and run fft */
+  gst_scope_analysis_spectrum (scope->analysis, adata, ch, 0, window, fdata_l);
+  gst_scope_analysis_spectrum (scope->analysis, adata, ch, 1, window, fdata_r);
 
   /* draw stars */
   for (y = 0; y < h; y++) {
     b = h - y;
-    frl = (gdouble) fdata_l[b].r;
-    fil = (gdouble) fdata_l[b].i;
-    frr = (gdouble) fdata_r[b].r;
-    fir = (gdouble) fdata_r[b].i;
+    /* in the range of the former 16 bit integer fft */
+    frl = fdata_l[b].r * 32768.0;
+    fil = fdata_l[b].i * 32768.0;
+    frr = fdata_r[b].r * 32768.0;
+    fir = fdata_r[b].i * 32768.0;
 
     ll = (frl + fil) * (frl + fil) + (frr - fir) * (frr - fir);
     l = sqrt (ll);
@@ -26,6 +26,17 @@
  * @title: bayer2rgb
  *
  * Decodes raw camera bayer (fourcc BA81) to RGB.
+ *
+ * Besides 8 bit bayer, samples stored on 16 bits with 10, 12, 14 or 16
+ * significant bits (e.g. "bggr12le") are accepted and scaled down to 8 bit
+ * RGB.
+ *
+ * The default #GstBayer2RGB:method is a fast bilinear interpolation. The
+ * "edge-aware" method interpolates the green channel along edges and the
+ * red and blue channels from colour differences, which avoids most of the
+ * zipper artefacts of the bilinear interpolation at a higher CPU cost.
+ * High resolutions can be converted on several threads with
+ * #GstBayer2RGB:n-threads.
  */
 
 /*
@@ -79,6 +90,7 @@
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
 #include <gst/video/video.h>
+#include <gst/gst-row-bands-private.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -100,6 +112,32 @@ enum
   GST_BAYER_2_RGB_FORMAT_RGGB
 };
 
+typedef enum
+{
+  GST_BAYER_2_RGB_METHOD_BILINEAR = 0,
+  GST_BAYER_2_RGB_METHOD_EDGE_AWARE
+} GstBayer2RGBMethod;
+
+#define GST_TYPE_BAYER_2_RGB_METHOD (gst_bayer2rgb_method_get_type ())
+static GType
+gst_bayer2rgb_method_get_type (void)
+{
+  static GType method_type = 0;
+
+  static const GEnumValue method_types[] = {
+    {GST_BAYER_2_RGB_METHOD_BILINEAR, "Bilinear", "bilinear"},
+    {GST_BAYER_2_RGB_METHOD_EDGE_AWARE,
+        "Edge aware interpolation of green and colour differences",
+        "edge-aware"},
+    {0, NULL, NULL}
+  };
+
+  if (!method_type) {
+    method_type = g_enum_register_static ("GstBayer2RGBMethod", method_types);
+  }
+  return method_type;
+}
+
 
 #define GST_TYPE_BAYER2RGB            (gst_bayer2rgb_get_type())
 #define GST_BAYER2RGB(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_BAYER2RGB,GstBayer2RGB))
@@ -124,6 +162,14 @@ struct _GstBayer2RGB
   int g_off;                    /* offset for green */
   int b_off;                    /* offset for blue */
   int format;
+  int bits;                     /* significant bits per sample */
+  gboolean big_endian;          /* for samples stored on 16 bits */
+
+  /* properties, protected by the object lock */
+  GstBayer2RGBMethod method;
+  guint n_threads;
+
+  GstRowBands row_bands;
 };
 
 struct _GstBayer2RGBClass
@@ -134,14 +180,23 @@ struct _GstBayer2RGBClass
 #define	SRC_CAPS                                 \
   GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR }")
 
-#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb}," \
+#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb," \
+  "bggr10le,grbg10le,gbrg10le,rggb10le,bggr10be,grbg10be,gbrg10be,rggb10be," \
+  "bggr12le,grbg12le,gbrg12le,rggb12le,bggr12be,grbg12be,gbrg12be,rggb12be," \
+  "bggr14le,grbg14le,gbrg14le,rggb14le,bggr14be,grbg14be,gbrg14be,rggb14be," \
+  "bggr16le,grbg16le,gbrg16le,rggb16le,bggr16be,grbg16be,gbrg16be,rggb16be}," \
   "width=(int)[1,MAX],height=(int)[1,MAX],framerate=(fraction)[0/1,MAX]"
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_METHOD GST_BAYER_2_RGB_METHOD_BILINEAR
+#define DEFAULT_N_THREADS 1
+
 GType gst_bayer2rgb_get_type (void);
 
 #define gst_bayer2rgb_parent_class parent_class
@@ -163,6 +218,8 @@ static GstCaps *gst_bayer2rgb_transform_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static gboolean gst_bayer2rgb_get_unit_size (GstBaseTransform * base,
     GstCaps * caps, gsize * size);
+static gboolean gst_bayer2rgb_stop (GstBaseTransform * base);
+static void gst_bayer2rgb_finalize (GObject * object);
 
 
 static void
@@ -176,6 +233,30 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 
   gobject_class->set_property = gst_bayer2rgb_set_property;
   gobject_class->get_property = gst_bayer2rgb_get_property;
+  gobject_class->finalize = gst_bayer2rgb_finalize;
+
+  /**
+   * GstBayer2RGB:method:
+   *
+   * Interpolation method used to reconstruct the missing colours.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method", "Interpolation method",
+          GST_TYPE_BAYER_2_RGB_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBayer2RGB:n-threads:
+   *
+   * Number of threads a frame is converted with, each one working on a band
+   * of rows.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      gst_row_bands_param_spec_n_threads (DEFAULT_N_THREADS));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Bayer to RGB decoder for cameras", "Filter/Converter/Video",
@@ -197,6 +278,10 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_set_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->transform =
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_transform);
+  GST_BASE_TRANSFORM_CLASS (klass)->stop =
+      GST_DEBUG_FUNCPTR (gst_bayer2rgb_stop);
+
+  gst_type_mark_as_plugin_api (GST_TYPE_BAYER_2_RGB_METHOD, 0);
 
   GST_DEBUG_CATEGORY_INIT (gst_bayer2rgb_debug, "bayer2rgb", 0,
       "bayer2rgb element");
@@ -207,15 +292,36 @@ gst_bayer2rgb_init (GstBayer2RGB * filter)
 {
   gst_bayer2rgb_reset (filter);
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (filter), TRUE);
+
+  filter->method = DEFAULT_METHOD;
+  filter->n_threads = DEFAULT_N_THREADS;
+}
+
+static void
+gst_bayer2rgb_finalize (GObject * object)
+{
+  gst_row_bands_clear (&GST_BAYER2RGB (object)->row_bands);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
-/* No properties are implemented, so only a warning is produced */
 static void
 gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (filter);
+      filter->method = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -226,14 +332,71 @@ static void
 gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_enum (value, filter->method);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* Parses a bayer format like "bggr" or "rggb12le" into the arrangement,
+ * the number of significant bits and the endianness of 16 bit samples */
+static gboolean
+gst_bayer2rgb_parse_format (const gchar * format, int *arrangement,
+    int *bits, gboolean * big_endian)
+{
+  gchar *end = NULL;
+  guint64 b;
+
+  if (format == NULL || strlen (format) < 4)
+    return FALSE;
+
+  if (g_str_has_prefix (format, "bggr")) {
+    *arrangement = GST_BAYER_2_RGB_FORMAT_BGGR;
+  } else if (g_str_has_prefix (format, "gbrg")) {
+    *arrangement = GST_BAYER_2_RGB_FORMAT_GBRG;
+  } else if (g_str_has_prefix (format, "grbg")) {
+    *arrangement = GST_BAYER_2_RGB_FORMAT_GRBG;
+  } else if (g_str_has_prefix (format, "rggb")) {
+    *arrangement = GST_BAYER_2_RGB_FORMAT_RGGB;
+  } else {
+    return FALSE;
+  }
+
+  format += 4;
+  if (*format == '\0') {
+    *bits = 8;
+    *big_endian = FALSE;
+    return TRUE;
+  }
+
+  b = g_ascii_strtoull (format, &end, 10);
+  if (end == format || b <= 8 || b > 16)
+    return FALSE;
+
+  *bits = b;
+  if (g_str_equal (end, "le"))
+    *big_endian = FALSE;
+  else if (g_str_equal (end, "be"))
+    *big_endian = TRUE;
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
 static gboolean
 gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
     GstCaps * outcaps)
@@ -252,17 +415,9 @@ gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
   gst_structure_get_int (structure, "height", &bayer2rgb->height);
 
   format = gst_structure_get_string (structure, "format");
-  if (g_str_equal (format, "bggr")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_BGGR;
-  } else if (g_str_equal (format, "gbrg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GBRG;
-  } else if (g_str_equal (format, "grbg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GRBG;
-  } else if (g_str_equal (format, "rggb")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_RGGB;
-  } else {
+  if (!gst_bayer2rgb_parse_format (format, &bayer2rgb->format,
+          &bayer2rgb->bits, &bayer2rgb->big_endian))
     return FALSE;
-  }
 
   /* To cater for different RGB formats, we need to set params for later */
   gst_video_info_from_caps (&info, outcaps);
@@ -283,6 +438,8 @@ gst_bayer2rgb_reset (GstBayer2RGB * filter)
   filter->r_off = 0;
   filter->g_off = 0;
   filter->b_off = 0;
+  filter->bits = 8;
+  filter->big_endian = FALSE;
   gst_video_info_init (&filter->info);
 }
 
@@ -337,7 +494,14 @@ gst_bayer2rgb_get_unit_size (GstBaseTransform * base, GstCaps * caps,
     name = gst_structure_get_name (structure);
     /* Our name must be either video/x-bayer video/x-raw */
     if (strcmp (name, "video/x-raw")) {
-      *size = GST_ROUND_UP_4 (width) * height;
+      int arrangement, bits;
+      gboolean big_endian;
+
+      if (!gst_bayer2rgb_parse_format (gst_structure_get_string (structure,
+                  "format"), &arrangement, &bits, &big_endian))
+        bits = 8;
+
+      *size = GST_ROUND_UP_4 (width * (bits > 8 ? 2 : 1)) * height;
       return TRUE;
     } else {
       /* For output, calculate according to format (always 32 bits) */
@@ -384,14 +548,305 @@ typedef void (*process_func) (guint8 * d0, const guint8 * s0, const guint8 * s1,
     const guint8 * s2, const guint8 * s3, const guint8 * s4, const guint8 * s5,
     int n);
 
+/* Rows above and below the band a band needs to look at */
+#define BAND_MARGIN 3
+
+typedef struct
+{
+  GstBayer2RGB *bayer2rgb;
+  GstBayer2RGBMethod method;
+  process_func merge[2];
+
+  const guint8 *src;
+  int src_stride;
+  guint8 *dest;
+  int dest_stride;
+
+  int start, end;
+
+  /* 8 bit rows start - BAND_MARGIN to end + BAND_MARGIN, mirrored at the
+   * picture edges */
+  const guint8 **rows;
+  guint8 *converted;
+} GstBayer2RGBBand;
+
+static inline int
+mirror (int v, int size)
+{
+  if (v < 0)
+    v = -v;
+  if (v >= size)
+    v = 2 * (size - 1) - v;
+  return CLAMP (v, 0, size - 1);
+}
+
+#define BAND_ROW(band, y) ((band)->rows[(y) - (band)->start + BAND_MARGIN])
+
+static void
+convert_row_16 (guint8 * dest, const guint8 * src, int n, int shift,
+    gboolean big_endian)
+{
+  int i;
+
+  if (big_endian) {
+    for (i = 0; i < n; i++)
+      dest[i] = MIN (GST_READ_UINT16_BE (src + 2 * i) >> shift, 255);
+  } else {
+    for (i = 0; i < n; i++)
+      dest[i] = MIN (GST_READ_UINT16_LE (src + 2 * i) >> shift, 255);
+  }
+}
+
+static void
+gst_bayer2rgb_band_map_rows (GstBayer2RGBBand * band)
+{
+  GstBayer2RGB *bayer2rgb = band->bayer2rgb;
+  int n_rows = band->end - band->start + 2 * BAND_MARGIN;
+  int width = bayer2rgb->width;
+  int i;
+
+  band->rows = g_new (const guint8 *, n_rows);
+  band->converted = NULL;
+  if (bayer2rgb->bits > 8)
+    band->converted = g_malloc (n_rows * width);
+
+  for (i = 0; i < n_rows; i++) {
+    int y = mirror (band->start - BAND_MARGIN + i, bayer2rgb->height);
+    const guint8 *src = band->src + y * band->src_stride;
+
+    if (band->converted) {
+      guint8 *row = band->converted + i * width;
+
+      convert_row_16 (row, src, width, bayer2rgb->bits - 8,
+          bayer2rgb->big_endian);
+      band->rows[i] = row;
+    } else {
+      band->rows[i] = src;
+    }
+  }
+}
+
+static void
+gst_bayer2rgb_process_bilinear (GstBayer2RGBBand * band)
+{
+  GstBayer2RGB *bayer2rgb = band->bayer2rgb;
+  int width = bayer2rgb->width;
+  guint8 *tmp;
+  int j;
+
+  tmp = g_malloc (2 * 4 * width);
+#define LINE(x) (tmp + ((x)&7) * width)
+
+  j = band->start - 1;
+  gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
+      BAND_ROW (band, j), width);
+  j = band->start;
+  gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
+      BAND_ROW (band, j), width);
+
+  for (j = band->start; j < band->end; j++) {
+    gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
+        LINE ((j + 1) * 2 + 1), BAND_ROW (band, j + 1), width);
+
+    band->merge[j & 1] (band->dest + j * band->dest_stride,
+        LINE (j * 2 - 2), LINE (j * 2 - 1),
+        LINE (j * 2 + 0), LINE (j * 2 + 1),
+        LINE (j * 2 + 2), LINE (j * 2 + 3), width >> 1);
+  }
+#undef LINE
+
+  g_free (tmp);
+}
+
+/* Green at the red and blue sites of row @y, interpolated along the
+ * direction with the smallest gradient and corrected with the laplacian of
+ * the site's own colour. @raw are the rows y - 2 to y + 2 */
+static void
+edge_aware_green (guint8 * g, const guint8 * const *raw, int width,
+    int c_par)
+{
+  const guint8 *c = raw[2];
+  int x;
+
+  for (x = 0; x < width; x++) {
+    int xl1, xr1, xl2, xr2;
+    int lh, lv, dh, dv, gh, gv, v;
+
+    if ((x & 1) != c_par) {
+      g[x] = c[x];
+      continue;
+    }
+
+    if (x >= 2 && x < width - 2) {
+      xl1 = x - 1;
+      xr1 = x + 1;
+      xl2 = x - 2;
+      xr2 = x + 2;
+    } else {
+      xl1 = mirror (x - 1, width);
+      xr1 = mirror (x + 1, width);
+      xl2 = mirror (x - 2, width);
+      xr2 = mirror (x + 2, width);
+    }
+
+    lh = 2 * c[x] - c[xl2] - c[xr2];
+    lv = 2 * c[x] - raw[0][x] - raw[4][x];
+    dh = ABS (c[xl1] - c[xr1]) + ABS (lh);
+    dv = ABS (raw[1][x] - raw[3][x]) + ABS (lv);
+    gh = 2 * (c[xl1] + c[xr1]) + lh;
+    gv = 2 * (raw[1][x] + raw[3][x]) + lv;
+
+    if (dh < dv)
+      v = (gh + 2) >> 2;
+    else if (dv < dh)
+      v = (gv + 2) >> 2;
+    else
+      v = (gh + gv + 4) >> 3;
+
+    g[x] = CLAMP (v, 0, 255);
+  }
+}
+
+/* Red and blue of row @y from the colour differences to the interpolated
+ * green. @raw and @g are the rows y - 1 to y + 1 */
+static void
+edge_aware_line (guint8 * dest, const guint8 * const *raw,
+    const guint8 * const *g, int width, gboolean red_row, int c_par,
+    int r_off, int g_off, int b_off)
+{
+  int a_off = 6 - r_off - g_off - b_off;
+  int x;
+
+  for (x = 0; x < width; x++) {
+    int xl, xr, gc, h, v, r, b;
+
+    xl = x > 0 ? x - 1 : mirror (x - 1, width);
+    xr = x < width - 1 ? x + 1 : mirror (x + 1, width);
+    gc = g[1][x];
+
+    if ((x & 1) != c_par) {
+      /* green site, one colour in this row and the other in the
+       * rows above and below */
+      h = gc + ((raw[1][xl] - g[1][xl] + raw[1][xr] - g[1][xr]) >> 1);
+      v = gc + ((raw[0][x] - g[0][x] + raw[2][x] - g[2][x]) >> 1);
+      r = red_row ? h : v;
+      b = red_row ? v : h;
+    } else {
+      /* red or blue site, the other colour is on the diagonals */
+      int d = gc + ((raw[0][xl] - g[0][xl] + raw[0][xr] - g[0][xr] +
+              raw[2][xl] - g[2][xl] + raw[2][xr] - g[2][xr] + 2) >> 2);
+
+      r = red_row ? raw[1][x] : d;
+      b = red_row ? d : raw[1][x];
+    }
+
+    dest[4 * x + r_off] = CLAMP (r, 0, 255);
+    dest[4 * x + g_off] = gc;
+    dest[4 * x + b_off] = CLAMP (b, 0, 255);
+    dest[4 * x + a_off] = 0xff;
+  }
+}
+
+static void
+gst_bayer2rgb_process_edge_aware (GstBayer2RGBBand * band)
+{
+  GstBayer2RGB *bayer2rgb = band->bayer2rgb;
+  int width = bayer2rgb->width;
+  int rx, ry, y;
+  guint8 *green;
+
+  /* position of the red sample in the 2x2 pattern */
+  switch (bayer2rgb->format) {
+    case GST_BAYER_2_RGB_FORMAT_BGGR:
+      rx = 1;
+      ry = 1;
+      break;
+    case GST_BAYER_2_RGB_FORMAT_GBRG:
+      rx = 0;
+      ry = 1;
+      break;
+    case GST_BAYER_2_RGB_FORMAT_GRBG:
+      rx = 1;
+      ry = 0;
+      break;
+    case GST_BAYER_2_RGB_FORMAT_RGGB:
+    default:
+      rx = 0;
+      ry = 0;
+      break;
+  }
+
+  /* green of the rows start - 1 to end */
+  green = g_malloc ((band->end - band->start + 2) * width);
+#define GREEN(y) (green + ((y) - band->start + 1) * width)
+
+  for (y = band->start - 1; y <= band->end; y++) {
+    const guint8 *raw[5];
+    int i;
+
+    for (i = 0; i < 5; i++)
+      raw[i] = BAND_ROW (band, y - 2 + i);
+    edge_aware_green (GREEN (y), raw, width,
+        (y & 1) == ry ? rx : 1 - rx);
+  }
+
+  for (y = band->start; y < band->end; y++) {
+    const guint8 *raw[3], *g[3];
+    int i;
+
+    for (i = 0; i < 3; i++) {
+      raw[i] = BAND_ROW (band, y - 1 + i);
+      g[i] = GREEN (y - 1 + i);
+    }
+    edge_aware_line (band->dest + y * band->dest_stride, raw, g, width,
+        (y & 1) == ry, (y & 1) == ry ? rx : 1 - rx, bayer2rgb->r_off,
+        bayer2rgb->g_off, bayer2rgb->b_off);
+  }
+#undef GREEN
+
+  g_free (green);
+}
+
+static void
+gst_bayer2rgb_process_band (GstBayer2RGBBand * band)
+{
+  /* bands are aligned on even rows, so small frames can leave some empty */
+  if (band->start >= band->end)
+    return;
+
+  gst_bayer2rgb_band_map_rows (band);
+
+  if (band->method == GST_BAYER_2_RGB_METHOD_EDGE_AWARE)
+    gst_bayer2rgb_process_edge_aware (band);
+  else
+    gst_bayer2rgb_process_bilinear (band);
+
+  g_free (band->rows);
+  g_free (band->converted);
+}
+
+static gboolean
+gst_bayer2rgb_stop (GstBaseTransform * base)
+{
+  gst_row_bands_clear (&GST_BAYER2RGB (base)->row_bands);
+
+  return TRUE;
+}
+
 static void
 gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
     int dest_stride, uint8_t * src, int src_stride)
 {
-  int j;
-  guint8 *tmp;
   process_func merge[2] = { NULL, NULL };
   int r_off, g_off, b_off;
+  GstBayer2RGBMethod method;
+  GstBayer2RGBBand *bands;
+  guint n_threads, n_bands, i;
+
+  GST_OBJECT_LOCK (bayer2rgb);
+  method = bayer2rgb->method;
+  n_threads = bayer2rgb->n_threads;
+  GST_OBJECT_UNLOCK (bayer2rgb);
 
   /* We exploit some symmetry in the functions here.  The base functions
    * are all named for the BGGR arrangement.  For RGGB, we swap the
@@ -426,28 +881,28 @@ gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
     merge[1] = tmp;
   }
 
-  tmp = g_malloc (2 * 4 * bayer2rgb->width);
-#define LINE(x) (tmp + ((x)&7) * bayer2rgb->width)
-
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (3 * 2 + 0), LINE (3 * 2 + 1),
-      src + 1 * src_stride, bayer2rgb->width);
-  j = 0;
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
-      src + j * src_stride, bayer2rgb->width);
-
-  for (j = 0; j < bayer2rgb->height; j++) {
-    if (j < bayer2rgb->height - 1) {
-      gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
-          LINE ((j + 1) * 2 + 1), src + (j + 1) * src_stride, bayer2rgb->width);
-    }
-
-    merge[j & 1] (dest + j * dest_stride,
-        LINE (j * 2 - 2), LINE (j * 2 - 1),
-        LINE (j * 2 + 0), LINE (j * 2 + 1),
-        LINE (j * 2 + 2), LINE (j * 2 + 3), bayer2rgb->width >> 1);
+  n_bands = gst_row_bands_prepare (&bayer2rgb->row_bands,
+      GST_OBJECT_CAST (bayer2rgb), n_threads, bayer2rgb->height);
+  bands = g_newa (GstBayer2RGBBand, n_bands);
+
+  for (i = 0; i < n_bands; i++) {
+    bands[i].bayer2rgb = bayer2rgb;
+    bands[i].method = method;
+    bands[i].merge[0] = merge[0];
+    bands[i].merge[1] = merge[1];
+    bands[i].src = src;
+    bands[i].src_stride = src_stride;
+    bands[i].dest = dest;
+    bands[i].dest_stride = dest_stride;
+    /* keep the bands on even rows so each starts on the same pattern row */
+    bands[i].start = (bayer2rgb->height * i / n_bands) & ~1;
+    bands[i].end = i == n_bands - 1 ? bayer2rgb->height :
+        (bayer2rgb->height * (i + 1) / n_bands) & ~1;
   }
 
-  g_free (tmp);
+  gst_row_bands_run (&bayer2rgb->row_bands,
+      (GstRowBandsFunc) gst_bayer2rgb_process_band, bands,
+      sizeof (GstBayer2RGBBand), n_bands);
 }
 
 
@@ -474,7 +929,7 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
 
   output = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
   gst_bayer2rgb_process (filter, output, frame.info.stride[0],
-      map.data, GST_ROUND_UP_4 (filter->width));
+      map.data, GST_ROUND_UP_4 (filter->width * (filter->bits > 8 ? 2 : 1)));
 
   gst_video_frame_unmap (&frame);
   gst_buffer_unmap (inbuf, &map);
@@ -82,6 +82,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_field_analysis_debug);
 #define DEFAULT_BLOCK_HEIGHT 16
 #define DEFAULT_BLOCK_THRESH 80
 #define DEFAULT_IGNORED_LINES 2
+#define DEFAULT_N_THREADS 1
 
 enum
 {
@@ -96,7 +97,8 @@ enum
   PROP_BLOCK_WIDTH,
   PROP_BLOCK_HEIGHT,
   PROP_BLOCK_THRESH,
-  PROP_IGNORED_LINES
+  PROP_IGNORED_LINES,
+  PROP_N_THREADS
 };
 
 static GstStaticPadTemplate sink_factory =
@@ -281,6 +283,17 @@ gst_field_analysis_class_init (GstFieldAnalysisClass * klass)
           2, G_MAXUINT64, DEFAULT_IGNORED_LINES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFieldAnalysis:n-threads:
+   *
+   * Number of threads the metrics are evaluated with, each one working on a
+   * band of rows. The results do not depend on the number of threads.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      gst_row_bands_param_spec_n_threads (DEFAULT_N_THREADS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_field_analysis_change_state);
 
@@ -306,12 +319,18 @@ static gfloat same_parity_3_tap (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2]);
 static gfloat opposite_parity_5_tap (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2]);
-static guint64 block_score_for_row_32detect (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
-static guint64 block_score_for_row_iscombed (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
-static guint64 block_score_for_row_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+static void comb_mask_for_line_32detect (GstFieldAnalysis * filter,
+    const guint8 * fjm2, const guint8 * fjm1, const guint8 * fj,
+    const guint8 * fjp1, const guint8 * fjp2, gint incr, gint width,
+    guint8 * comb_mask);
+static void comb_mask_for_line_iscombed (GstFieldAnalysis * filter,
+    const guint8 * fjm2, const guint8 * fjm1, const guint8 * fj,
+    const guint8 * fjp1, const guint8 * fjp2, gint incr, gint width,
+    guint8 * comb_mask);
+static void comb_mask_for_line_5_tap (GstFieldAnalysis * filter,
+    const guint8 * fjm2, const guint8 * fjm1, const guint8 * fj,
+    const guint8 * fjp1, const guint8 * fjp2, gint incr, gint width,
+    guint8 * comb_mask);
 static gfloat opposite_parity_windowed_comb (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2]);
 
@@ -334,10 +353,6 @@ gst_field_analysis_reset (GstFieldAnalysis * filter)
   filter->is_telecine = FALSE;
   filter->first_buffer = TRUE;
   gst_video_info_init (&filter->vinfo);
-  g_free (filter->comb_mask);
-  filter->comb_mask = NULL;
-  g_free (filter->block_scores);
-  filter->block_scores = NULL;
 }
 
 static void
@@ -361,12 +376,13 @@ gst_field_analysis_init (GstFieldAnalysis * filter)
   filter->same_frame = &opposite_parity_5_tap;
   filter->frame_thresh = DEFAULT_FRAME_THRESH;
   filter->noise_floor = DEFAULT_NOISE_FLOOR;
-  filter->block_score_for_row = &block_score_for_row_5_tap;
+  filter->comb_mask_for_line = &comb_mask_for_line_5_tap;
   filter->spatial_thresh = DEFAULT_SPATIAL_THRESH;
   filter->block_width = DEFAULT_BLOCK_WIDTH;
   filter->block_height = DEFAULT_BLOCK_HEIGHT;
   filter->block_thresh = DEFAULT_BLOCK_THRESH;
   filter->ignored_lines = DEFAULT_IGNORED_LINES;
+  filter->n_threads = DEFAULT_N_THREADS;
 }
 
 static void
@@ -415,13 +431,13 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
     case PROP_COMB_METHOD:
       switch (g_value_get_enum (value)) {
         case METHOD_32DETECT:
-          filter->block_score_for_row = &block_score_for_row_32detect;
+          filter->comb_mask_for_line = &comb_mask_for_line_32detect;
           break;
         case METHOD_IS_COMBED:
-          filter->block_score_for_row = &block_score_for_row_iscombed;
+          filter->comb_mask_for_line = &comb_mask_for_line_iscombed;
           break;
         case METHOD_5_TAP:
-          filter->block_score_for_row = &block_score_for_row_5_tap;
+          filter->comb_mask_for_line = &comb_mask_for_line_5_tap;
           break;
         default:
           break;
@@ -432,18 +448,6 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
       break;
     case PROP_BLOCK_WIDTH:
       filter->block_width = g_value_get_uint64 (value);
-      if (GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame)) {
-        const gint frame_width =
-            GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame);
-        if (filter->block_scores) {
-          gsize nbytes = (frame_width / filter->block_width) * sizeof (guint);
-          filter->block_scores = g_realloc (filter->block_scores, nbytes);
-          memset (filter->block_scores, 0, nbytes);
-        } else {
-          filter->block_scores =
-              g_malloc0 ((frame_width / filter->block_width) * sizeof (guint));
-        }
-      }
       break;
     case PROP_BLOCK_HEIGHT:
       filter->block_height = g_value_get_uint64 (value);
@@ -454,6 +458,11 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       filter->ignored_lines = g_value_get_uint64 (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -503,11 +512,11 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
     case PROP_COMB_METHOD:
     {
       FieldAnalysisCombMethod method = DEFAULT_COMB_METHOD;
-      if (filter->block_score_for_row == &block_score_for_row_32detect) {
+      if (filter->comb_mask_for_line == &comb_mask_for_line_32detect) {
         method = METHOD_32DETECT;
-      } else if (filter->block_score_for_row == &block_score_for_row_iscombed) {
+      } else if (filter->comb_mask_for_line == &comb_mask_for_line_iscombed) {
         method = METHOD_IS_COMBED;
-      } else if (filter->block_score_for_row == &block_score_for_row_5_tap) {
+      } else if (filter->comb_mask_for_line == &comb_mask_for_line_5_tap) {
         method = METHOD_5_TAP;
       }
       g_value_set_enum (value, method);
@@ -528,6 +537,9 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       g_value_set_uint64 (value, filter->ignored_lines);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -537,7 +549,6 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
 static void
 gst_field_analysis_update_format (GstFieldAnalysis * filter, GstCaps * caps)
 {
-  gint width;
   GQueue *outbufs;
   GstVideoInfo vinfo;
 
@@ -574,22 +585,6 @@ gst_field_analysis_update_format (GstFieldAnalysis * filter, GstCaps * caps)
   filter->flushing = FALSE;
 
   filter->vinfo = vinfo;
-  width = GST_VIDEO_INFO_WIDTH (&filter->vinfo);
-
-  /* update allocations for metric scores */
-  if (filter->comb_mask) {
-    filter->comb_mask = g_realloc (filter->comb_mask, width);
-  } else {
-    filter->comb_mask = g_malloc (width);
-  }
-  if (filter->block_scores) {
-    gsize nbytes = (width / filter->block_width) * sizeof (guint);
-    filter->block_scores = g_realloc (filter->block_scores, nbytes);
-    memset (filter->block_scores, 0, nbytes);
-  } else {
-    filter->block_scores =
-        g_malloc0 ((width / filter->block_width) * sizeof (guint));
-  }
 
   GST_OBJECT_UNLOCK (filter);
   return;
@@ -811,45 +806,123 @@ gst_field_analysis_sink_event (GstPad * pad, GstObject * parent,
 }
 
 
+/* The metrics are evaluated in bands of rows, in parallel if n-threads allows
+ * it. Every row stores its partial results and they are summed up in row
+ * order afterwards, so that the floating point results do not depend on the
+ * number of threads. */
+typedef struct _FieldAnalysisBand FieldAnalysisBand;
+typedef void (*FieldAnalysisBandFunc) (FieldAnalysisBand * band);
+
+struct _FieldAnalysisBand
+{
+  GstFieldAnalysis *filter;
+  FieldAnalysisFields (*history)[2];
+  gint start, end;              /* rows processed by this band */
+  gint n_rows;                  /* rows of the whole metric */
+  guint32 *results;             /* per-row results of the whole metric */
+};
+
+/* called with the object lock */
+static void
+gst_field_analysis_run_bands (GstFieldAnalysis * filter,
+    FieldAnalysisFields (*history)[2], FieldAnalysisBandFunc func,
+    gint n_rows, guint32 * results)
+{
+  FieldAnalysisBand *bands;
+  guint n_bands, i;
+
+  if (n_rows <= 0)
+    return;
+
+  n_bands = gst_row_bands_prepare (&filter->row_bands, GST_OBJECT_CAST (filter),
+      filter->n_threads, n_rows);
+  bands = g_newa (FieldAnalysisBand, n_bands);
+
+  for (i = 0; i < n_bands; i++) {
+    bands[i].filter = filter;
+    bands[i].history = history;
+    bands[i].start = n_rows * i / n_bands;
+    bands[i].end = n_rows * (i + 1) / n_bands;
+    bands[i].n_rows = n_rows;
+    bands[i].results = results;
+  }
+
+  gst_row_bands_run (&filter->row_bands, (GstRowBandsFunc) func, bands,
+      sizeof (FieldAnalysisBand), n_bands);
+}
+
+/* line of the luma plane of a frame */
+static inline guint8 *
+frame_line (GstVideoFrame * frame, gint line)
+{
+  return GST_VIDEO_FRAME_COMP_DATA (frame, 0) +
+      GST_VIDEO_FRAME_COMP_OFFSET (frame, 0) +
+      line * GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+}
+
+/* line of a field */
+static inline guint8 *
+field_line (FieldAnalysisFields * field, gint line)
+{
+  return frame_line (&field->frame, field->parity + 2 * line);
+}
+
+static void
+same_parity_sad_rows (FieldAnalysisBand * band)
+{
+  FieldAnalysisFields (*history)[2] = band->history;
+  const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
+  const guint32 noise_floor = band->filter->noise_floor;
+  gint j;
+
+  for (j = band->start; j < band->end; j++) {
+    guint32 tempsum = 0;
+    fieldanalysis_orc_same_parity_sad_planar_yuv (&tempsum,
+        field_line (&(*history)[0], j), field_line (&(*history)[1], j),
+        noise_floor, width);
+    band->results[j] = tempsum;
+  }
+}
+
 static gfloat
 same_parity_sad (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
 {
   gint j;
   gfloat sum;
-  guint8 *f1j, *f2j;
+  guint32 *results;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
-  const guint32 noise_floor = filter->noise_floor;
-
-  f1j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-      0) +
-      (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
-      (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+
+  results = g_new (guint32, height >> 1);
+  gst_field_analysis_run_bands (filter, history, same_parity_sad_rows,
+      height >> 1, results);
 
   sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
+  for (j = 0; j < (height >> 1); j++)
+    sum += results[j];
+  g_free (results);
+
+  return sum / (0.5f * width * height);
+}
+
+static void
+same_parity_ssd_rows (FieldAnalysisBand * band)
+{
+  FieldAnalysisFields (*history)[2] = band->history;
+  const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
+  /* noise floor needs to be squared for SSD */
+  const guint32 noise_floor =
+      band->filter->noise_floor * band->filter->noise_floor;
+  gint j;
+
+  for (j = band->start; j < band->end; j++) {
     guint32 tempsum = 0;
-    fieldanalysis_orc_same_parity_sad_planar_yuv (&tempsum, f1j, f2j,
+    fieldanalysis_orc_same_parity_ssd_planar_yuv (&tempsum,
+        field_line (&(*history)[0], j), field_line (&(*history)[1], j),
         noise_floor, width);
-    sum += tempsum;
-    f1j += stride0x2;
-    f2j += stride1x2;
+    band->results[j] = tempsum;
   }
-
-  return sum / (0.5f * width * height);
 }
 
 static gfloat
@@ -857,474 +930,373 @@ same_parity_ssd (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
 {
   gint j;
   gfloat sum;
-  guint8 *f1j, *f2j;
+  guint32 *results;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
-  /* noise floor needs to be squared for SSD */
-  const guint32 noise_floor = filter->noise_floor * filter->noise_floor;
-
-  f1j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-      0) +
-      (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
-      (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+
+  results = g_new (guint32, height >> 1);
+  gst_field_analysis_run_bands (filter, history, same_parity_ssd_rows,
+      height >> 1, results);
 
   sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
-    guint32 tempsum = 0;
-    fieldanalysis_orc_same_parity_ssd_planar_yuv (&tempsum, f1j, f2j,
-        noise_floor, width);
-    sum += tempsum;
-    f1j += stride0x2;
-    f2j += stride1x2;
-  }
+  for (j = 0; j < (height >> 1); j++)
+    sum += results[j];
+  g_free (results);
 
   return sum / (0.5f * width * height); /* field is half height */
 }
 
-/* horizontal [1,4,1] diff between fields - is this a good idea or should the
- * current sample be emphasised more or less? */
-static gfloat
-same_parity_3_tap (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
+/* three results per row: left edge, middle, right edge */
+static void
+same_parity_3_tap_rows (FieldAnalysisBand * band)
 {
-  gint i, j;
-  gfloat sum;
-  guint8 *f1j, *f2j;
-
+  FieldAnalysisFields (*history)[2] = band->history;
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
-  const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
   /* noise floor needs to be *6 for [1,4,1] */
-  const guint32 noise_floor = filter->noise_floor * 6;
-
-  f1j = GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame, 0) +
-      GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0) +
-      (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
-      (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+  const guint32 noise_floor = band->filter->noise_floor * 6;
+  gint i, j;
 
-  sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
-    guint32 tempsum = 0;
+  for (j = band->start; j < band->end; j++) {
+    guint8 *f1j = field_line (&(*history)[0], j);
+    guint8 *f2j = field_line (&(*history)[1], j);
+    guint32 *results = &band->results[3 * j];
     guint32 diff;
 
     /* unroll first as it is a special case */
     diff = abs (((f1j[0] << 2) + (f1j[incr] << 1))
         - ((f2j[0] << 2) + (f2j[incr] << 1)));
-    if (diff > noise_floor)
-      sum += diff;
+    results[0] = diff > noise_floor ? diff : 0;
 
-    fieldanalysis_orc_same_parity_3_tap_planar_yuv (&tempsum, f1j, &f1j[incr],
-        &f1j[incr << 1], f2j, &f2j[incr], &f2j[incr << 1], noise_floor,
-        width - 1);
-    sum += tempsum;
+    /* the samples between the two edges */
+    results[1] = 0;
+    fieldanalysis_orc_same_parity_3_tap_planar_yuv (&results[1], f1j,
+        &f1j[incr], &f1j[incr << 1], f2j, &f2j[incr], &f2j[incr << 1],
+        noise_floor, width - 2);
 
     /* unroll last as it is a special case */
     i = width - 1;
     diff = abs (((f1j[i - incr] << 1) + (f1j[i] << 2))
         - ((f2j[i - incr] << 1) + (f2j[i] << 2)));
-    if (diff > noise_floor)
-      sum += diff;
-
-    f1j += stride0x2;
-    f2j += stride1x2;
+    results[2] = diff > noise_floor ? diff : 0;
   }
-
-  return sum / ((6.0f / 2.0f) * width * height);        /* 1 + 4 + 1 = 6; field is half height */
 }
 
-/* vertical [1,-3,4,-3,1] - same as is used in FieldDiff from TIVTC,
- * tritical's AVISynth IVTC filter */
-/* 0th field's parity defines operation */
+/* horizontal [1,4,1] diff between fields - is this a good idea or should the
+ * current sample be emphasised more or less? */
 static gfloat
-opposite_parity_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2])
+same_parity_3_tap (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
 {
   gint j;
   gfloat sum;
-  guint8 *fjm2, *fjm1, *fj, *fjp1, *fjp2;
-  guint32 tempsum;
+  guint32 *results;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
-  /* noise floor needs to be *6 for [1,-3,4,-3,1] */
-  const guint32 noise_floor = filter->noise_floor * 6;
+
+  results = g_new (guint32, 3 * (height >> 1));
+  gst_field_analysis_run_bands (filter, history, same_parity_3_tap_rows,
+      height >> 1, results);
 
   sum = 0.0f;
+  for (j = 0; j < 3 * (height >> 1); j++)
+    sum += results[j];
+  g_free (results);
 
-  /* fj is line j of the combined frame made from the top field even lines of
-   *   field 0 and the bottom field odd lines from field 1
-   * fjp1 is one line down from fj
-   * fjm2 is two lines up from fj
-   * fj with j == 0 is the 0th line of the top field
-   * fj with j == 1 is the 0th line of the bottom field or the 1st field of
-   *   the frame*/
+  return sum / ((6.0f / 2.0f) * width * height);        /* 1 + 4 + 1 = 6; field is half height */
+}
 
-  /* unroll first line as it is a special case */
+/* fj is line j of the combined frame made from the top field even lines of
+ *   field 0 and the bottom field odd lines from field 1
+ * fjp1 is one line down from fj
+ * fjm2 is two lines up from fj
+ * fj with j == 0 is the 0th line of the top field
+ * fj with j == 1 is the 0th line of the bottom field or the 1st field of
+ *   the frame */
+static void
+opposite_parity_5_tap_rows (FieldAnalysisBand * band)
+{
+  FieldAnalysisFields (*history)[2] = band->history;
+  const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
+  /* noise floor needs to be *6 for [1,-3,4,-3,1] */
+  const guint32 noise_floor = band->filter->noise_floor * 6;
+  GstVideoFrame *top, *bottom;
+  gint j;
+
+  /* 0th field's parity defines operation */
   if ((*history)[0].parity == TOP_FIELD) {
-    fj = GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0);
-    fjp1 =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0);
-    fjp2 = fj + stride0x2;
+    top = &(*history)[0].frame;
+    bottom = &(*history)[1].frame;
   } else {
-    fj = GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame, 0);
-    fjp1 =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
-    fjp2 = fj + stride1x2;
+    top = &(*history)[1].frame;
+    bottom = &(*history)[0].frame;
   }
 
-  tempsum = 0;
-  fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjp2, fjp1, fj,
-      fjp1, fjp2, noise_floor, width);
-  sum += tempsum;
-
-  for (j = 1; j < (height >> 1) - 1; j++) {
-    /* shift everything down a line in the field of interest (means += stridex2) */
-    fjm2 = fj;
-    fjm1 = fjp1;
-    fj = fjp2;
-    if ((*history)[0].parity == TOP_FIELD) {
-      fjp1 += stride1x2;
-      fjp2 += stride0x2;
+  for (j = band->start; j < band->end; j++) {
+    guint8 *fj = frame_line (top, 2 * j);
+    guint8 *fjp1 = frame_line (bottom, 2 * j + 1);
+    guint32 tempsum = 0;
+
+    if (j == 0) {
+      /* the first line is a special case */
+      guint8 *fjp2 = frame_line (top, 2 * j + 2);
+
+      fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjp2,
+          fjp1, fj, fjp1, fjp2, noise_floor, width);
+    } else if (j == band->n_rows - 1) {
+      /* and so is the last line */
+      guint8 *fjm1 = frame_line (bottom, 2 * j - 1);
+      guint8 *fjm2 = frame_line (top, 2 * j - 2);
+
+      fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2,
+          fjm1, fj, fjm1, fjm2, noise_floor, width);
     } else {
-      fjp1 += stride0x2;
-      fjp2 += stride1x2;
+      guint8 *fjm1 = frame_line (bottom, 2 * j - 1);
+      guint8 *fjm2 = frame_line (top, 2 * j - 2);
+      guint8 *fjp2 = frame_line (top, 2 * j + 2);
+
+      fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2,
+          fjm1, fj, fjp1, fjp2, noise_floor, width);
     }
 
-    tempsum = 0;
-    fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2, fjm1,
-        fj, fjp1, fjp2, noise_floor, width);
-    sum += tempsum;
+    band->results[j] = tempsum;
   }
+}
+
+/* vertical [1,-3,4,-3,1] - same as is used in FieldDiff from TIVTC,
+ * tritical's AVISynth IVTC filter */
+/* 0th field's parity defines operation */
+static gfloat
+opposite_parity_5_tap (GstFieldAnalysis * filter,
+    FieldAnalysisFields (*history)[2])
+{
+  gint j;
+  gfloat sum;
+  guint32 *results;
+
+  const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
+  const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
+  /* the first and the last lines are always processed */
+  const gint n_rows = MAX (height >> 1, 2);
 
-  /* unroll the last line as it is a special case */
-  /* shift everything down a line in the field of interest (means += stridex2) */
-  fjm2 = fj;
-  fjm1 = fjp1;
-  fj = fjp2;
+  results = g_new (guint32, n_rows);
+  gst_field_analysis_run_bands (filter, history, opposite_parity_5_tap_rows,
+      n_rows, results);
 
-  tempsum = 0;
-  fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2, fjm1, fj,
-      fjm1, fjm2, noise_floor, width);
-  sum += tempsum;
+  sum = 0.0f;
+  for (j = 0; j < n_rows; j++)
+    sum += results[j];
+  g_free (results);
 
   return sum / ((6.0f / 2.0f) * width * height);        /* 1 + 4 + 1 == 3 + 3 == 6; field is half height */
 }
 
-/* this metric was sourced from HandBrake but originally from transcode
- * the return value is the highest block score for the row of blocks */
-static inline guint64
-block_score_for_row_32detect (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+/* this metric was sourced from HandBrake but originally from transcode */
+static void
+comb_mask_for_line_32detect (GstFieldAnalysis * filter, const guint8 * fjm2,
+    const guint8 * fjm1, const guint8 * fj, const guint8 * fjp1,
+    const guint8 * fjp2, gint incr, gint width, guint8 * comb_mask)
 {
-  guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
-  guint64 block_score;
-  guint8 *fjm2, *fjm1, *fj, *fjp1;
-  const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
-  const gint stridex2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const guint64 block_width = filter->block_width;
-  const guint64 block_height = filter->block_height;
   const gint64 spatial_thresh = filter->spatial_thresh;
-  const gint width =
-      GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) -
-      (GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) % block_width);
+  gint i;
 
-  fjm2 = base_fj - stridex2;
-  fjm1 = base_fjp1 - stridex2;
-  fj = base_fj;
-  fjp1 = base_fjp1;
+  for (i = 0; i < width; i++) {
+    const gint idx = i * incr;
+    const gint diff1 = fj[idx] - fjm1[idx];
+    const gint diff2 = fj[idx] - fjp1[idx];
 
-  for (j = 0; j < block_height; j++) {
-    /* we have to work one result ahead of ourselves which results in some small
-     * peculiarities below */
-    gint diff1, diff2;
+    /* change in the same direction */
+    comb_mask[i] = ((diff1 > spatial_thresh && diff2 > spatial_thresh)
+        || (diff1 < -spatial_thresh && diff2 < -spatial_thresh))
+        && abs (fj[idx] - fjm2[idx]) < 10 && abs (fj[idx] - fjm1[idx]) > 15;
+  }
+}
+
+/* this metric was sourced from HandBrake but originally from
+ * tritical's isCombedT Avisynth function */
+static void
+comb_mask_for_line_iscombed (GstFieldAnalysis * filter, const guint8 * fjm2,
+    const guint8 * fjm1, const guint8 * fj, const guint8 * fjp1,
+    const guint8 * fjp2, gint incr, gint width, guint8 * comb_mask)
+{
+  const gint64 spatial_thresh = filter->spatial_thresh;
+  const gint64 spatial_thresh_squared = spatial_thresh * spatial_thresh;
+  gint i;
+
+  for (i = 0; i < width; i++) {
+    const gint idx = i * incr;
+    const gint diff1 = fj[idx] - fjm1[idx];
+    const gint diff2 = fj[idx] - fjp1[idx];
 
-    diff1 = fj[0] - fjm1[0];
-    diff2 = fj[0] - fjp1[0];
     /* change in the same direction */
-    if ((diff1 > spatial_thresh && diff2 > spatial_thresh)
-        || (diff1 < -spatial_thresh && diff2 < -spatial_thresh)) {
-      comb_mask[0] = abs (fj[0] - fjm2[0]) < 10 && abs (fj[0] - fjm1[0]) > 15;
-    } else {
-      comb_mask[0] = FALSE;
-    }
+    comb_mask[i] = ((diff1 > spatial_thresh && diff2 > spatial_thresh)
+        || (diff1 < -spatial_thresh && diff2 < -spatial_thresh))
+        && (fjm1[idx] - fj[idx]) * (fjp1[idx] - fj[idx]) >
+        spatial_thresh_squared;
+  }
+}
 
-    for (i = 1; i < width; i++) {
-      const guint64 idx = i * incr;
-      const guint64 res_idx = (i - 1) / block_width;
+/* this metric was sourced from HandBrake but originally from
+ * tritical's isCombedT Avisynth function */
+static void
+comb_mask_for_line_5_tap (GstFieldAnalysis * filter, const guint8 * fjm2,
+    const guint8 * fjm1, const guint8 * fj, const guint8 * fjp1,
+    const guint8 * fjp2, gint incr, gint width, guint8 * comb_mask)
+{
+  const gint64 spatial_thresh = filter->spatial_thresh;
+  const gint64 spatial_threshx6 = 6 * spatial_thresh;
+  gint i;
 
-      diff1 = fj[idx] - fjm1[idx];
-      diff2 = fj[idx] - fjp1[idx];
-      if ((diff1 > spatial_thresh && diff2 > spatial_thresh)
-          || (diff1 < -spatial_thresh && diff2 < -spatial_thresh)) {
-        comb_mask[i] = abs (fj[idx] - fjm2[idx]) < 10
-            && abs (fj[idx] - fjm1[idx]) > 15;
-      } else {
-        comb_mask[i] = FALSE;
-      }
+  for (i = 0; i < width; i++) {
+    const gint idx = i * incr;
+    const gint diff1 = fj[idx] - fjm1[idx];
+    const gint diff2 = fj[idx] - fjp1[idx];
 
-      if (i == 1 && comb_mask[i - 1] && comb_mask[i]) {
-        /* left edge */
-        block_scores[res_idx]++;
-      } else if (i == width - 1) {
-        /* right edge */
-        if (comb_mask[i - 2] && comb_mask[i - 1] && comb_mask[i])
-          block_scores[res_idx]++;
-        if (comb_mask[i - 1] && comb_mask[i])
-          block_scores[i / block_width]++;
-      } else if (comb_mask[i - 2] && comb_mask[i - 1] && comb_mask[i]) {
-        block_scores[res_idx]++;
-      }
-    }
-    /* advance down a line */
-    fjm2 = fjm1;
-    fjm1 = fj;
-    fj = fjp1;
-    fjp1 = fjm1 + stridex2;
+    /* change in the same direction */
+    comb_mask[i] = ((diff1 > spatial_thresh && diff2 > spatial_thresh)
+        || (diff1 < -spatial_thresh && diff2 < -spatial_thresh))
+        && abs (fjm2[idx] + (fj[idx] << 2) + fjp2[idx] - 3 * (fjm1[idx] +
+            fjp1[idx])) > spatial_threshx6;
+
+    /* motion detection that needs previous and next frames
+       this isn't really necessary, but acts as an optimisation if the
+       additional delay isn't a problem
+       if (motion_detection) {
+       if (abs(fpj[idx] - fj[idx]               ) > motion_thresh &&
+       abs(           fjm1[idx] - fnjm1[idx]) > motion_thresh &&
+       abs(           fjp1[idx] - fnjp1[idx]) > motion_thresh)
+       motion++;
+       if (abs(             fj[idx]   - fnj[idx]) > motion_thresh &&
+       abs(fpjm1[idx] - fjm1[idx]           ) > motion_thresh &&
+       abs(fpjp1[idx] - fjp1[idx]           ) > motion_thresh)
+       motion++;
+       } else {
+       motion = 1;
+       }
+     */
   }
+}
 
-  block_score = 0;
-  for (i = 0; i < width / block_width; i++) {
-    if (block_scores[i] > block_score)
-      block_score = block_scores[i];
+/* if the samples to the left and right are combed, a combed sample
+ * contributes to the score of its block. at the edges of the line, two
+ * combed samples are enough */
+static void
+block_scores_add_line (const guint8 * comb_mask, gint width,
+    guint64 block_width, guint * block_scores)
+{
+  const guint64 n_blocks = width / block_width;
+  guint64 b, i;
+
+  if (width < 2)
+    return;
+
+  /* left edge */
+  if (comb_mask[0] && comb_mask[1])
+    block_scores[0]++;
+
+  /* sample i is accounted to block (i - 1) / block_width, go block by block
+   * so that the inner loop is a plain sum */
+  for (b = 0; b < n_blocks; b++) {
+    const guint64 start = MAX (b * block_width + 1, 2);
+    const guint64 end = MIN ((b + 1) * block_width + 1, (guint64) width - 1);
+    guint score = 0;
+
+    for (i = start; i < end; i++)
+      score += comb_mask[i - 2] & comb_mask[i - 1] & comb_mask[i];
+    block_scores[b] += score;
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
-  return block_score;
+  /* right edge */
+  if (width > 2) {
+    i = width - 1;
+    if (comb_mask[i - 2] && comb_mask[i - 1] && comb_mask[i])
+      block_scores[(i - 1) / block_width]++;
+    if (comb_mask[i - 1] && comb_mask[i])
+      block_scores[i / block_width]++;
+  }
 }
 
-/* this metric was sourced from HandBrake but originally from
- * tritical's isCombedT Avisynth function
- * the return value is the highest block score for the row of blocks */
-static inline guint64
-block_score_for_row_iscombed (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+/* the return value is the highest block score for the row of blocks */
+static guint64
+block_score_for_row (GstFieldAnalysis * filter,
+    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1,
+    guint8 * comb_mask, guint * block_scores)
 {
-  guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
+  guint64 i;
+  gint64 j;
   guint64 block_score;
-  guint8 *fjm1, *fj, *fjp1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
   const gint stridex2 =
       GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
   const guint64 block_width = filter->block_width;
   const guint64 block_height = filter->block_height;
-  const gint64 spatial_thresh = filter->spatial_thresh;
-  const gint64 spatial_thresh_squared = spatial_thresh * spatial_thresh;
   const gint width =
       GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) -
       (GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) % block_width);
 
-  fjm1 = base_fjp1 - stridex2;
-  fj = base_fj;
-  fjp1 = base_fjp1;
+  /* line k of the combined frame, lines of base_fj are the even ones */
+#define COMB_LINE(k) \
+  (((k) & 1 ? base_fjp1 : base_fj) + (((k) - ((k) & 1)) / 2) * stridex2)
 
-  for (j = 0; j < block_height; j++) {
-    /* we have to work one result ahead of ourselves which results in some small
-     * peculiarities below */
-    gint diff1, diff2;
+  memset (block_scores, 0, (width / block_width) * sizeof (guint));
 
-    diff1 = fj[0] - fjm1[0];
-    diff2 = fj[0] - fjp1[0];
-    /* change in the same direction */
-    if ((diff1 > spatial_thresh && diff2 > spatial_thresh)
-        || (diff1 < -spatial_thresh && diff2 < -spatial_thresh)) {
-      comb_mask[0] =
-          (fjm1[0] - fj[0]) * (fjp1[0] - fj[0]) > spatial_thresh_squared;
-    } else {
-      comb_mask[0] = FALSE;
-    }
-
-    for (i = 1; i < width; i++) {
-      const guint64 idx = i * incr;
-      const guint64 res_idx = (i - 1) / block_width;
-
-      diff1 = fj[idx] - fjm1[idx];
-      diff2 = fj[idx] - fjp1[idx];
-      if ((diff1 > spatial_thresh && diff2 > spatial_thresh)
-          || (diff1 < -spatial_thresh && diff2 < -spatial_thresh)) {
-        comb_mask[i] =
-            (fjm1[idx] - fj[idx]) * (fjp1[idx] - fj[idx]) >
-            spatial_thresh_squared;
-      } else {
-        comb_mask[i] = FALSE;
-      }
-
-      if (i == 1 && comb_mask[i - 1] && comb_mask[i]) {
-        /* left edge */
-        block_scores[res_idx]++;
-      } else if (i == width - 1) {
-        /* right edge */
-        if (comb_mask[i - 2] && comb_mask[i - 1] && comb_mask[i])
-          block_scores[res_idx]++;
-        if (comb_mask[i - 1] && comb_mask[i])
-          block_scores[i / block_width]++;
-      } else if (comb_mask[i - 2] && comb_mask[i - 1] && comb_mask[i]) {
-        block_scores[res_idx]++;
-      }
-    }
-    /* advance down a line */
-    fjm1 = fj;
-    fj = fjp1;
-    fjp1 = fjm1 + stridex2;
+  for (j = 0; j < block_height; j++) {
+    filter->comb_mask_for_line (filter, COMB_LINE (j - 2), COMB_LINE (j - 1),
+        COMB_LINE (j), COMB_LINE (j + 1), COMB_LINE (j + 2), incr, width,
+        comb_mask);
+    block_scores_add_line (comb_mask, width, block_width, block_scores);
   }
 
+#undef COMB_LINE
+
   block_score = 0;
   for (i = 0; i < width / block_width; i++) {
     if (block_scores[i] > block_score)
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
-/* this metric was sourced from HandBrake but originally from
- * tritical's isCombedT Avisynth function
- * the return value is the highest block score for the row of blocks */
-static inline guint64
-block_score_for_row_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+static void
+opposite_parity_windowed_comb_rows (FieldAnalysisBand * band)
 {
-  guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
-  guint64 block_score;
-  guint8 *fjm2, *fjm1, *fj, *fjp1, *fjp2;
-  const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
-  const gint stridex2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
+  GstFieldAnalysis *filter = band->filter;
+  FieldAnalysisFields (*history)[2] = band->history;
+  const gint frame_width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
+  const gint stride = GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
   const guint64 block_width = filter->block_width;
   const guint64 block_height = filter->block_height;
-  const gint64 spatial_thresh = filter->spatial_thresh;
-  const gint64 spatial_threshx6 = 6 * spatial_thresh;
-  const gint width =
-      GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) -
-      (GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) % block_width);
-
-
-  fjm2 = base_fj - stridex2;
-  fjm1 = base_fjp1 - stridex2;
-  fj = base_fj;
-  fjp1 = base_fjp1;
-  fjp2 = fj + stridex2;
-
-  for (j = 0; j < block_height; j++) {
-    /* we have to work one result ahead of ourselves which results in some small
-     * peculiarities below */
-    gint diff1, diff2;
+  guint8 *base_fj, *base_fjp1;
+  guint8 *comb_mask;
+  guint *block_scores;
+  gint j;
 
-    diff1 = fj[0] - fjm1[0];
-    diff2 = fj[0] - fjp1[0];
-    /* change in the same direction */
-    if ((diff1 > spatial_thresh && diff2 > spatial_thresh)
-        || (diff1 < -spatial_thresh && diff2 < -spatial_thresh)) {
-      comb_mask[0] =
-          abs (fjm2[0] + (fj[0] << 2) + fjp2[0] - 3 * (fjm1[0] + fjp1[0])) >
-          spatial_threshx6;
-
-      /* motion detection that needs previous and next frames
-         this isn't really necessary, but acts as an optimisation if the
-         additional delay isn't a problem
-         if (motion_detection) {
-         if (abs(fpj[idx] - fj[idx]               ) > motion_thresh &&
-         abs(           fjm1[idx] - fnjm1[idx]) > motion_thresh &&
-         abs(           fjp1[idx] - fnjp1[idx]) > motion_thresh)
-         motion++;
-         if (abs(             fj[idx]   - fnj[idx]) > motion_thresh &&
-         abs(fpjm1[idx] - fjm1[idx]           ) > motion_thresh &&
-         abs(fpjp1[idx] - fjp1[idx]           ) > motion_thresh)
-         motion++;
-         } else {
-         motion = 1;
-         }
-       */
-    } else {
-      comb_mask[0] = FALSE;
-    }
+  /* 0th field's parity defines operation */
+  if ((*history)[0].parity == TOP_FIELD) {
+    base_fj = frame_line (&(*history)[0].frame, 0);
+    base_fjp1 = frame_line (&(*history)[1].frame, 1);
+  } else {
+    base_fj = frame_line (&(*history)[1].frame, 0);
+    base_fjp1 = frame_line (&(*history)[0].frame, 1);
+  }
 
-    for (i = 1; i < width; i++) {
-      const guint64 idx = i * incr;
-      const guint64 res_idx = (i - 1) / block_width;
-
-      diff1 = fj[idx] - fjm1[idx];
-      diff2 = fj[idx] - fjp1[idx];
-      if ((diff1 > spatial_thresh && diff2 > spatial_thresh)
-          || (diff1 < -spatial_thresh && diff2 < -spatial_thresh)) {
-        comb_mask[i] =
-            abs (fjm2[idx] + (fj[idx] << 2) + fjp2[idx] - 3 * (fjm1[idx] +
-                fjp1[idx])) > spatial_threshx6;
-      } else {
-        comb_mask[i] = FALSE;
-      }
+  /* scratch space of this band */
+  comb_mask = g_malloc (frame_width);
+  block_scores = g_new (guint, frame_width / block_width + 1);
 
-      if (i == 1 && comb_mask[i - 1] && comb_mask[i]) {
-        /* left edge */
-        block_scores[res_idx]++;
-      } else if (i == width - 1) {
-        /* right edge */
-        if (comb_mask[i - 2] && comb_mask[i - 1] && comb_mask[i])
-          block_scores[res_idx]++;
-        if (comb_mask[i - 1] && comb_mask[i])
-          block_scores[i / block_width]++;
-      } else if (comb_mask[i - 2] && comb_mask[i - 1] && comb_mask[i]) {
-        block_scores[res_idx]++;
-      }
-    }
-    /* advance down a line */
-    fjm2 = fjm1;
-    fjm1 = fj;
-    fj = fjp1;
-    fjp1 = fjp2;
-    fjp2 = fj + stridex2;
-  }
+  /* we operate on a row of blocks of height block_height through each iteration */
+  for (j = band->start; j < band->end; j++) {
+    guint64 line_offset = (filter->ignored_lines + j * block_height) * stride;
 
-  block_score = 0;
-  for (i = 0; i < width / block_width; i++) {
-    if (block_scores[i] > block_score)
-      block_score = block_scores[i];
+    band->results[j] =
+        block_score_for_row (filter, history, base_fj + line_offset,
+        base_fjp1 + line_offset, comb_mask, block_scores);
   }
 
   g_free (block_scores);
   g_free (comb_mask);
-  return block_score;
 }
 
 /* a pass is made over the field using one of three comb-detection metrics
@@ -1340,41 +1312,27 @@ static gfloat
 opposite_parity_windowed_comb (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2])
 {
-  gint j;
+  gint j, n_rows;
   gboolean slightly_combed;
+  guint32 *results;
+  gfloat ret;
 
-  const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride = GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
+  const guint64 height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
   const guint64 block_thresh = filter->block_thresh;
   const guint64 block_height = filter->block_height;
-  guint8 *base_fj, *base_fjp1;
 
-  if ((*history)[0].parity == TOP_FIELD) {
-    base_fj =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0);
-    base_fjp1 =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0);
-  } else {
-    base_fj =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame, 0);
-    base_fjp1 =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
-  }
+  if (block_height == 0 || height < filter->ignored_lines + block_height)
+    return 0.0f;
+
+  n_rows = (height - filter->ignored_lines - block_height) / block_height + 1;
+  results = g_new (guint32, n_rows);
+  gst_field_analysis_run_bands (filter, history,
+      opposite_parity_windowed_comb_rows, n_rows, results);
 
-  /* we operate on a row of blocks of height block_height through each iteration */
   slightly_combed = FALSE;
-  for (j = 0; j <= height - filter->ignored_lines - block_height;
-      j += block_height) {
-    guint64 line_offset = (filter->ignored_lines + j) * stride;
-    guint block_score =
-        filter->block_score_for_row (filter, history, base_fj + line_offset,
-        base_fjp1 + line_offset);
+  ret = -1.0f;
+  for (j = 0; j < n_rows; j++) {
+    guint block_score = results[j];
 
     if (block_score > (block_thresh >> 1)
         && block_score <= block_thresh) {
@@ -1383,12 +1341,17 @@ opposite_parity_windowed_comb (GstFieldAnalysis * filter,
     } else if (block_score > block_thresh) {
       if (GST_VIDEO_INFO_INTERLACE_MODE (&(*history)[0].frame.info) ==
           GST_VIDEO_INTERLACE_MODE_INTERLEAVED) {
-        return 1.0f;            /* blend */
+        ret = 1.0f;             /* blend */
       } else {
-        return 2.0f;            /* deinterlace */
+        ret = 2.0f;             /* deinterlace */
       }
+      break;
     }
   }
+  g_free (results);
+
+  if (ret >= 0.0f)
+    return ret;
 
   return (gfloat) slightly_combed;      /* TRUE means blend, else don't */
 }
@@ -1825,6 +1788,7 @@ gst_field_analysis_change_state (GstElement * element,
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_field_analysis_reset (filter);
+      gst_row_bands_clear (&filter->row_bands);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
     default:
@@ -1840,6 +1804,7 @@ gst_field_analysis_finalize (GObject * object)
   GstFieldAnalysis *filter = GST_FIELDANALYSIS (object);
 
   gst_field_analysis_reset (filter);
+  gst_row_bands_clear (&filter->row_bands);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
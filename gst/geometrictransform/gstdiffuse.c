@@ -153,11 +153,11 @@ diffuse_prepare (GstGeometricTransform * trans)
   GstDiffuse *diffuse = GST_DIFFUSE_CAST (trans);
   gint i;
 
-  if (diffuse->sin_table)
-    return TRUE;
-
-  diffuse->sin_table = g_malloc0 (sizeof (gdouble) * 256);
-  diffuse->cos_table = g_malloc0 (sizeof (gdouble) * 256);
+  /* called again when the scale changes */
+  if (!diffuse->sin_table) {
+    diffuse->sin_table = g_malloc0 (sizeof (gdouble) * 256);
+    diffuse->cos_table = g_malloc0 (sizeof (gdouble) * 256);
+  }
 
   for (i = 0; i < 256; i++) {
     gdouble angle = (G_PI * 2 * i) / 256.0;
@@ -24,6 +24,7 @@
 #include "gstgeometrictransform.h"
 #include "geometricmath.h"
 #include <string.h>
+#include <math.h>
 
 GST_DEBUG_CATEGORY_STATIC (geometric_transform_debug);
 #define GST_CAT_DEFAULT geometric_transform_debug
@@ -49,7 +50,9 @@ static GstVideoFilterClass *parent_class = NULL;
 enum
 {
   PROP_0,
-  PROP_OFF_EDGE_PIXELS
+  PROP_OFF_EDGE_PIXELS,
+  PROP_INTERPOLATION,
+  PROP_N_THREADS
 };
 
 #define GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE ( \
@@ -74,23 +77,126 @@ gst_geometric_transform_off_edges_pixels_method_get_type (void)
   return method_type;
 }
 
+#define GST_GT_INTERPOLATION_METHOD_TYPE ( \
+    gst_geometric_transform_interpolation_method_get_type())
+static GType
+gst_geometric_transform_interpolation_method_get_type (void)
+{
+  static GType method_type = 0;
+
+  static const GEnumValue method_types[] = {
+    {GST_GT_INTERPOLATION_NEAREST, "Nearest neighbour", "nearest"},
+    {GST_GT_INTERPOLATION_BILINEAR, "Bilinear", "bilinear"},
+    {0, NULL, NULL}
+  };
+
+  if (!method_type) {
+    method_type =
+        g_enum_register_static ("GstGeometricTransformInterpolationMethod",
+        method_types);
+  }
+  return method_type;
+}
+
 #define DEFAULT_OFF_EDGE_PIXELS GST_GT_OFF_EDGES_PIXELS_IGNORE
+#define DEFAULT_INTERPOLATION GST_GT_INTERPOLATION_NEAREST
+#define DEFAULT_N_THREADS 1
+
+typedef struct
+{
+  GstGeometricTransform *gt;
+  const guint8 *in_data;
+  guint8 *out_data;
+  gint out_stride;
+  gint y_start, y_end;
+  gboolean failed;
+} GstGeometricTransformBand;
 
 /* must be called with the object lock */
+static void
+gst_geometric_transform_map_entry_init (GstGeometricTransform * gt,
+    GstGeometricTransformMapEntry * entry, gdouble in_x, gdouble in_y)
+{
+  gint x0, y0;
+
+  entry->offset = -1;
+  entry->fx = 0;
+  entry->fy = 0;
+
+  /* operate on out of edge pixels */
+  switch (gt->off_edge_pixels) {
+    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
+      in_x = CLAMP (in_x, 0, gt->width - 1);
+      in_y = CLAMP (in_y, 0, gt->height - 1);
+      break;
+
+    case GST_GT_OFF_EDGES_PIXELS_WRAP:
+      in_x = gst_gm_mod_float (in_x, gt->width);
+      in_y = gst_gm_mod_float (in_y, gt->height);
+      if (in_x < 0)
+        in_x += gt->width;
+      if (in_y < 0)
+        in_y += gt->height;
+      break;
+
+    default:
+      break;
+  }
+
+  /* also filters out NaN */
+  if (!(in_x > -1.0 && in_x < gt->width && in_y > -1.0 && in_y < gt->height))
+    return;
+
+  if (gt->interpolation == GST_GT_INTERPOLATION_BILINEAR) {
+    gdouble floor_x = floor (in_x);
+    gdouble floor_y = floor (in_y);
+
+    x0 = (gint) floor_x;
+    y0 = (gint) floor_y;
+    if (x0 < gt->width - 1)
+      entry->fx = (guint8) MIN ((in_x - floor_x) * 256, 255);
+    if (y0 < gt->height - 1)
+      entry->fy = (guint8) MIN ((in_y - floor_y) * 256, 255);
+  } else {
+    x0 = (gint) in_x;
+    y0 = (gint) in_y;
+  }
+
+  /* only set the values if the values are valid */
+  if (x0 >= 0 && x0 < gt->width && y0 >= 0 && y0 < gt->height)
+    entry->offset = y0 * gt->row_stride + x0 * gt->pixel_stride;
+}
+
+/* must be called with the object lock, fills the map entries of row @y */
 static gboolean
-gst_geometric_transform_generate_map (GstGeometricTransform * gt)
+gst_geometric_transform_map_row (GstGeometricTransform * gt,
+    GstGeometricTransformMapEntry * entry, gint y)
 {
-  gint x, y;
+  GstGeometricTransformClass *klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
   gdouble in_x, in_y;
+  gint x;
+
+  for (x = 0; x < gt->width; x++) {
+    if (!klass->map_func (gt, x, y, &in_x, &in_y)) {
+      /* child should have warned */
+      return FALSE;
+    }
+
+    gst_geometric_transform_map_entry_init (gt, entry + x, in_x, in_y);
+  }
+
+  return TRUE;
+}
+
+/* must be called with the object lock */
+static gboolean
+gst_geometric_transform_generate_map (GstGeometricTransform * gt)
+{
+  gint y;
   gboolean ret = TRUE;
   GstGeometricTransformClass *klass;
-  gdouble *ptr;
-
-  GST_INFO_OBJECT (gt, "Generating new transform map");
 
-  /* cleanup old map */
-  g_free (gt->map);
-  gt->map = NULL;
+  GST_DEBUG_OBJECT (gt, "Generating new transform map");
 
   klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
 
@@ -98,26 +204,20 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
   g_return_val_if_fail (klass->map_func, FALSE);
 
   /*
-   * (x,y) pairs of the inverse mapping
+   * input pixel offset and interpolation weights of the inverse mapping,
+   * the map is kept as long as the frame size doesn't change
    */
-  gt->map = g_malloc0 (sizeof (gdouble) * gt->width * gt->height * 2);
-  ptr = gt->map;
+  if (gt->map == NULL)
+    gt->map = g_new (GstGeometricTransformMapEntry, gt->width * gt->height);
 
   for (y = 0; y < gt->height; y++) {
-    for (x = 0; x < gt->width; x++) {
-      if (!klass->map_func (gt, x, y, &in_x, &in_y)) {
-        /* child should have warned */
-        ret = FALSE;
-        goto end;
-      }
-
-      ptr[0] = in_x;
-      ptr[1] = in_y;
-      ptr += 2;
+    if (!gst_geometric_transform_map_row (gt, gt->map + (gsize) y * gt->width,
+            y)) {
+      ret = FALSE;
+      break;
     }
   }
 
-end:
   if (!ret) {
     GST_WARNING_OBJECT (gt, "Generating transform map failed");
     g_free (gt->map);
@@ -145,6 +245,7 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
 
   gt->width = in_info->width;
   gt->height = in_info->height;
+  gt->format = GST_VIDEO_INFO_FORMAT (in_info);
   gt->row_stride = in_info->stride[0];
   gt->pixel_stride = GST_VIDEO_INFO_COMP_PSTRIDE (in_info, 0);
 
@@ -152,6 +253,9 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   GST_OBJECT_LOCK (gt);
   if (gt->map == NULL || old_width == 0 || old_height == 0
       || gt->width != old_width || gt->height != old_height) {
+    g_free (gt->map);
+    gt->map = NULL;
+
     if (klass->prepare_func)
       if (!klass->prepare_func (gt)) {
         GST_OBJECT_UNLOCK (gt);
@@ -159,53 +263,198 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
       }
     if (gt->precalc_map)
       gst_geometric_transform_generate_map (gt);
+    else
+      gt->needs_remap = FALSE;
   }
   GST_OBJECT_UNLOCK (gt);
   return ret;
 }
 
+#define SAMPLE_NEAREST(ps)                                      \
+  for (x = 0; x < width; x++) {                                 \
+    if (entry[x].offset >= 0)                                   \
+      memcpy (out + x * (ps), in + entry[x].offset, (ps));      \
+  }
+
 static void
-gst_geometric_transform_do_map (GstGeometricTransform * gt, guint8 * in_data,
-    guint8 * out_data, gint x, gint y, gdouble in_x, gdouble in_y)
+gst_geometric_transform_sample_nearest (const GstGeometricTransformMapEntry *
+    entry, const guint8 * in, guint8 * out, gint width, gint pixel_stride)
 {
-  gint in_offset;
-  gint out_offset;
+  gint x;
 
-  out_offset = y * gt->row_stride + x * gt->pixel_stride;
-
-  /* operate on out of edge pixels */
-  switch (gt->off_edge_pixels) {
-    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
-      in_x = CLAMP (in_x, 0, gt->width - 1);
-      in_y = CLAMP (in_y, 0, gt->height - 1);
+  /* constant sizes let the compiler turn the memcpy into plain moves */
+  switch (pixel_stride) {
+    case 1:
+      SAMPLE_NEAREST (1);
       break;
-
-    case GST_GT_OFF_EDGES_PIXELS_WRAP:
-      in_x = gst_gm_mod_float (in_x, gt->width);
-      in_y = gst_gm_mod_float (in_y, gt->height);
-      if (in_x < 0)
-        in_x += gt->width;
-      if (in_y < 0)
-        in_y += gt->height;
+    case 2:
+      SAMPLE_NEAREST (2);
+      break;
+    case 3:
+      SAMPLE_NEAREST (3);
+      break;
+    case 4:
+      SAMPLE_NEAREST (4);
       break;
-
     default:
+      SAMPLE_NEAREST (pixel_stride);
       break;
   }
+}
+
+#undef SAMPLE_NEAREST
+
+static void
+gst_geometric_transform_sample_bilinear (const GstGeometricTransformMapEntry *
+    entry, const guint8 * in, guint8 * out, gint width, gint pixel_stride,
+    gint row_stride)
+{
+  gint x, c;
+
+  for (x = 0; x < width; x++, out += pixel_stride) {
+    const guint8 *p;
+    guint fx, fy, dx, dy;
+
+    if (entry[x].offset < 0)
+      continue;
 
-  {
-    gint trunc_x = (gint) in_x;
-    gint trunc_y = (gint) in_y;
-    /* only set the values if the values are valid */
-    if (trunc_x >= 0 && trunc_x < gt->width && trunc_y >= 0 &&
-        trunc_y < gt->height) {
-      in_offset = trunc_y * gt->row_stride + trunc_x * gt->pixel_stride;
+    p = in + entry[x].offset;
+    fx = entry[x].fx;
+    fy = entry[x].fy;
+    dx = fx ? pixel_stride : 0;
+    dy = fy ? row_stride : 0;
 
-      memcpy (out_data + out_offset, in_data + in_offset, gt->pixel_stride);
+    for (c = 0; c < pixel_stride; c++) {
+      guint top = p[c] * (256 - fx) + p[dx + c] * fx;
+      guint bottom = p[dy + c] * (256 - fx) + p[dy + dx + c] * fx;
+
+      out[c] = (top * (256 - fy) + bottom * fy + (1 << 15)) >> 16;
     }
   }
 }
 
+static void
+gst_geometric_transform_sample_bilinear_16 (const GstGeometricTransformMapEntry
+    * entry, const guint8 * in, guint8 * out, gint width, gint row_stride,
+    gboolean big_endian)
+{
+  gint x;
+
+#define READ_16(p) (big_endian ? GST_READ_UINT16_BE (p) : GST_READ_UINT16_LE (p))
+  for (x = 0; x < width; x++, out += 2) {
+    const guint8 *p;
+    guint32 fx, fy, dx, dy, top, bottom, v;
+
+    if (entry[x].offset < 0)
+      continue;
+
+    p = in + entry[x].offset;
+    fx = entry[x].fx;
+    fy = entry[x].fy;
+    dx = fx ? 2 : 0;
+    dy = fy ? row_stride : 0;
+
+    top = READ_16 (p) * (256 - fx) + READ_16 (p + dx) * fx;
+    bottom = READ_16 (p + dy) * (256 - fx) + READ_16 (p + dy + dx) * fx;
+    v = (top * (256 - fy) + bottom * fy + (1 << 15)) >> 16;
+
+    if (big_endian)
+      GST_WRITE_UINT16_BE (out, v);
+    else
+      GST_WRITE_UINT16_LE (out, v);
+  }
+#undef READ_16
+}
+
+static void
+gst_geometric_transform_process_band (GstGeometricTransformBand * band)
+{
+  GstGeometricTransform *gt = band->gt;
+  GstGeometricTransformMapEntry *row = NULL;
+  gint width = gt->width;
+  gint y, i;
+
+  /* without a precalculated map, the mapping changes for every frame and
+   * each row is mapped right before it is sampled */
+  if (!gt->precalc_map)
+    row = g_new (GstGeometricTransformMapEntry, width);
+
+  for (y = band->y_start; y < band->y_end; y++) {
+    const GstGeometricTransformMapEntry *entry;
+    guint8 *out = band->out_data + (gsize) y * band->out_stride;
+
+    if (row) {
+      if (!gst_geometric_transform_map_row (gt, row, y)) {
+        band->failed = TRUE;
+        break;
+      }
+      entry = row;
+    } else {
+      entry = gt->map + (gsize) y * width;
+    }
+
+    if (gt->format == GST_VIDEO_FORMAT_AYUV) {
+      /* in AYUV black is not just all zeros:
+       * 0x10 is black for Y,
+       * 0x80 is black for Cr and Cb */
+      for (i = 0; i < width; i++)
+        GST_WRITE_UINT32_BE (out + i * 4, 0xff108080);
+    } else {
+      memset (out, 0, width * gt->pixel_stride);
+    }
+
+    if (gt->interpolation == GST_GT_INTERPOLATION_NEAREST) {
+      gst_geometric_transform_sample_nearest (entry, band->in_data, out,
+          width, gt->pixel_stride);
+    } else if (gt->format == GST_VIDEO_FORMAT_GRAY16_LE
+        || gt->format == GST_VIDEO_FORMAT_GRAY16_BE) {
+      gst_geometric_transform_sample_bilinear_16 (entry, band->in_data, out,
+          width, gt->row_stride, gt->format == GST_VIDEO_FORMAT_GRAY16_BE);
+    } else {
+      gst_geometric_transform_sample_bilinear (entry, band->in_data, out,
+          width, gt->pixel_stride, gt->row_stride);
+    }
+  }
+
+  g_free (row);
+}
+
+/* must be called with the object lock, splits the frame in bands of rows
+ * and samples them on the task pool and the streaming thread. Returns FALSE
+ * if mapping a row failed */
+static gboolean
+gst_geometric_transform_process (GstGeometricTransform * gt,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+{
+  GstGeometricTransformBand *bands;
+  guint n_bands, i;
+
+  n_bands = gst_row_bands_prepare (&gt->row_bands, GST_OBJECT_CAST (gt),
+      gt->n_threads, gt->height);
+  bands = g_newa (GstGeometricTransformBand, n_bands);
+
+  for (i = 0; i < n_bands; i++) {
+    bands[i].gt = gt;
+    bands[i].in_data = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+    bands[i].out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+    bands[i].out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+    bands[i].y_start = gt->height * i / n_bands;
+    bands[i].y_end = gt->height * (i + 1) / n_bands;
+    bands[i].failed = FALSE;
+  }
+
+  gst_row_bands_run (&gt->row_bands,
+      (GstRowBandsFunc) gst_geometric_transform_process_band, bands,
+      sizeof (GstGeometricTransformBand), n_bands);
+
+  for (i = 0; i < n_bands; i++) {
+    if (bands[i].failed)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static void
 gst_geometric_transform_before_transform (GstBaseTransform * trans,
     GstBuffer * outbuf)
@@ -229,64 +478,35 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
 {
   GstGeometricTransform *gt;
   GstGeometricTransformClass *klass;
-  gint x, y, i;
   GstFlowReturn ret = GST_FLOW_OK;
-  gdouble *ptr;
-  guint8 *in_data;
-  guint8 *out_data;
 
   gt = GST_GEOMETRIC_TRANSFORM_CAST (vfilter);
   klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
 
-  in_data = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+  GST_OBJECT_LOCK (gt);
+  if (gt->needs_remap) {
+    if (klass->prepare_func)
+      if (!klass->prepare_func (gt)) {
+        ret = GST_FLOW_ERROR;
+        goto end;
+      }
+    if (gt->precalc_map)
+      gst_geometric_transform_generate_map (gt);
+    else
+      gt->needs_remap = FALSE;
+  }
 
-  if (GST_VIDEO_FRAME_FORMAT (out_frame) == GST_VIDEO_FORMAT_AYUV) {
-    /* in AYUV black is not just all zeros:
-     * 0x10 is black for Y,
-     * 0x80 is black for Cr and Cb */
-    for (i = 0; i < out_frame->map[0].size; i += 4)
-      GST_WRITE_UINT32_BE (out_data + i, 0xff108080);
-  } else {
-    memset (out_data, 0, out_frame->map[0].size);
+  if (gt->precalc_map && gt->map == NULL) {
+    GST_WARNING_OBJECT (gt, "No transform map");
+    ret = GST_FLOW_ERROR;
+    goto end;
   }
 
-  GST_OBJECT_LOCK (gt);
-  if (gt->precalc_map) {
-    if (gt->needs_remap) {
-      if (klass->prepare_func)
-        if (!klass->prepare_func (gt)) {
-          ret = FALSE;
-          goto end;
-        }
-      gst_geometric_transform_generate_map (gt);
-    }
-    g_return_val_if_fail (gt->map, GST_FLOW_ERROR);
-    ptr = gt->map;
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        /* do the mapping */
-        gst_geometric_transform_do_map (gt, in_data, out_data, x, y, ptr[0],
-            ptr[1]);
-        ptr += 2;
-      }
-    }
-  } else {
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        gdouble in_x, in_y;
-
-        if (klass->map_func (gt, x, y, &in_x, &in_y)) {
-          gst_geometric_transform_do_map (gt, in_data, out_data, x, y, in_x,
-              in_y);
-        } else {
-          GST_WARNING_OBJECT (gt, "Failed to do mapping for %d %d", x, y);
-          ret = GST_FLOW_ERROR;
-          goto end;
-        }
-      }
-    }
+  if (!gst_geometric_transform_process (gt, in_frame, out_frame)) {
+    GST_WARNING_OBJECT (gt, "Failed to do the mapping");
+    ret = GST_FLOW_ERROR;
   }
+
 end:
   GST_OBJECT_UNLOCK (gt);
   return ret;
@@ -304,6 +524,18 @@ gst_geometric_transform_set_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       GST_OBJECT_LOCK (gt);
       gt->off_edge_pixels = g_value_get_enum (value);
+      gst_geometric_transform_set_need_remap (gt);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_INTERPOLATION:
+      GST_OBJECT_LOCK (gt);
+      gt->interpolation = g_value_get_enum (value);
+      gst_geometric_transform_set_need_remap (gt);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gt);
+      gt->n_threads = g_value_get_uint (value);
       GST_OBJECT_UNLOCK (gt);
       break;
     default:
@@ -324,6 +556,12 @@ gst_geometric_transform_get_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       g_value_set_enum (value, gt->off_edge_pixels);
       break;
+    case PROP_INTERPOLATION:
+      g_value_set_enum (value, gt->interpolation);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, gt->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -336,7 +574,7 @@ gst_geometric_transform_stop (GstBaseTransform * trans)
 {
   GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (trans);
 
-  GST_INFO_OBJECT (gt, "Deleting transform map");
+  GST_DEBUG_OBJECT (gt, "Deleting transform map");
 
   gt->width = 0;
   gt->height = 0;
@@ -344,6 +582,8 @@ gst_geometric_transform_stop (GstBaseTransform * trans)
   g_free (gt->map);
   gt->map = NULL;
 
+  gst_row_bands_clear (&gt->row_bands);
+
   return TRUE;
 }
 
@@ -389,7 +629,33 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
           GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, DEFAULT_OFF_EDGE_PIXELS,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGeometricTransform:interpolation:
+   *
+   * How the input pixels are sampled. Bilinear interpolation gives
+   * smoother results at a higher cost.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (obj_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "How the input pixels are sampled",
+          GST_GT_INTERPOLATION_METHOD_TYPE, DEFAULT_INTERPOLATION,
+          GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGeometricTransform:n-threads:
+   *
+   * Number of threads the frames are processed with, each one working on
+   * a band of rows.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (obj_class, PROP_N_THREADS,
+      gst_row_bands_param_spec_n_threads (DEFAULT_N_THREADS));
+
   gst_type_mark_as_plugin_api (GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, 0);
+  gst_type_mark_as_plugin_api (GST_GT_INTERPOLATION_METHOD_TYPE, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_GEOMETRIC_TRANSFORM, 0);
 }
 
@@ -399,6 +665,8 @@ gst_geometric_transform_init (GTypeInstance * instance, gpointer g_class)
   GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (instance);
 
   gt->off_edge_pixels = DEFAULT_OFF_EDGE_PIXELS;
+  gt->interpolation = DEFAULT_INTERPOLATION;
+  gt->n_threads = DEFAULT_N_THREADS;
   gt->precalc_map = TRUE;
   gt->needs_remap = TRUE;
 }
@@ -22,6 +22,7 @@
 
 #include <gst/video/gstvideofilter.h>
 #include <gst/video/video.h>
+#include <gst/gst-row-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -46,6 +47,27 @@ enum
   GST_GT_OFF_EDGES_PIXELS_WRAP
 };
 
+enum
+{
+  GST_GT_INTERPOLATION_NEAREST = 0,
+  GST_GT_INTERPOLATION_BILINEAR
+};
+
+/*
+ * One entry of the precalculated map, for one output pixel.
+ *
+ * @offset: byte offset of the (top-left) input pixel, -1 if the output
+ *   pixel is left black
+ * @fx, @fy: weights of the right and bottom neighbours in 1/256th, only
+ *   used with bilinear interpolation. They are 0 when the neighbour is
+ *   outside of the frame.
+ */
+typedef struct
+{
+  gint32 offset;
+  guint8 fx, fy;
+} GstGeometricTransformMapEntry;
+
 typedef struct _GstGeometricTransform GstGeometricTransform;
 typedef struct _GstGeometricTransformClass GstGeometricTransformClass;
 
@@ -99,8 +121,12 @@ struct _GstGeometricTransform {
 
   /* properties */
   gint off_edge_pixels;
+  gint interpolation;
+  guint n_threads;
+
+  GstGeometricTransformMapEntry *map;
 
-  gdouble *map;
+  GstRowBands row_bands;
 };
 
 struct _GstGeometricTransformClass {
@@ -49,6 +49,7 @@ gst_inter_surface_get (const char *name)
   surface->name = g_strdup (name);
   g_mutex_init (&surface->mutex);
   surface->audio_adapter = gst_adapter_new ();
+  surface->video_ring_size = 1;
   surface->audio_buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   surface->audio_latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   surface->audio_period_time = DEFAULT_AUDIO_PERIOD_TIME;
@@ -77,8 +78,8 @@ gst_inter_surface_unref (GstInterSurface * surface)
       }
     }
 
+    gst_inter_surface_clear_video (surface);
     g_mutex_clear (&surface->mutex);
-    gst_buffer_replace (&surface->video_buffer, NULL);
     gst_buffer_replace (&surface->sub_buffer, NULL);
     gst_object_unref (surface->audio_adapter);
     g_free (surface->name);
@@ -86,3 +87,123 @@ gst_inter_surface_unref (GstInterSurface * surface)
   }
   g_mutex_unlock (&mutex);
 }
+
+/* Must be called with the surface lock held. Empties the ring and moves
+ * the references it held to @old, returns their number. */
+static guint
+gst_inter_surface_take_video_locked (GstInterSurface * surface,
+    GstBuffer ** old)
+{
+  guint i, n = 0;
+
+  for (i = 0; i < GST_INTER_SURFACE_MAX_VIDEO_FRAMES; i++) {
+    if (surface->video_frames[i].buffer)
+      old[n++] = surface->video_frames[i].buffer;
+    surface->video_frames[i].buffer = NULL;
+    surface->video_frames[i].time = GST_CLOCK_TIME_NONE;
+  }
+
+  return n;
+}
+
+/* Uses a ring of @size frames from now on. The queued frames are dropped
+ * only if the size changes, their slots would not match the new one. */
+void
+gst_inter_surface_set_video_ring_size (GstInterSurface * surface, guint size)
+{
+  GstBuffer *old[GST_INTER_SURFACE_MAX_VIDEO_FRAMES];
+  guint i, n = 0;
+
+  size = CLAMP (size, 1, GST_INTER_SURFACE_MAX_VIDEO_FRAMES);
+
+  g_mutex_lock (&surface->mutex);
+  if (surface->video_ring_size != size) {
+    n = gst_inter_surface_take_video_locked (surface, old);
+    surface->video_ring_size = size;
+  }
+  g_mutex_unlock (&surface->mutex);
+
+  for (i = 0; i < n; i++)
+    gst_buffer_unref (old[i]);
+}
+
+/* Publishes @buffer as the newest frame, due at clock @time. Only the ring
+ * slot is swapped while holding the surface lock, the evicted frame is
+ * released afterwards so that readers never wait on its destruction. */
+void
+gst_inter_surface_push_video (GstInterSurface * surface, GstBuffer * buffer,
+    GstClockTime time)
+{
+  GstInterSurfaceFrame *frame;
+  GstBuffer *old;
+
+  gst_buffer_ref (buffer);
+
+  g_mutex_lock (&surface->mutex);
+  frame = &surface->video_frames[surface->video_seq %
+      surface->video_ring_size];
+  old = frame->buffer;
+  frame->buffer = buffer;
+  frame->time = time;
+  surface->video_seq++;
+  g_mutex_unlock (&surface->mutex);
+
+  if (old)
+    gst_buffer_unref (old);
+}
+
+void
+gst_inter_surface_clear_video (GstInterSurface * surface)
+{
+  GstBuffer *old[GST_INTER_SURFACE_MAX_VIDEO_FRAMES];
+  guint i, n;
+
+  g_mutex_lock (&surface->mutex);
+  n = gst_inter_surface_take_video_locked (surface, old);
+  g_mutex_unlock (&surface->mutex);
+
+  for (i = 0; i < n; i++)
+    gst_buffer_unref (old[i]);
+}
+
+/* Must be called with the surface lock held.
+ *
+ * Returns the newest queued frame that is due at or before clock @time, or
+ * the oldest queued one if all of them are still in the future. If @time is
+ * GST_CLOCK_TIME_NONE the newest frame is returned. @seq is set to the
+ * sequence number of the returned frame, or to the number of frames ever
+ * published if there is none. */
+GstBuffer *
+gst_inter_surface_get_video_locked (GstInterSurface * surface,
+    GstClockTime time, guint64 * seq)
+{
+  GstInterSurfaceFrame *frame = NULL;
+  guint64 s, oldest;
+
+  *seq = surface->video_seq;
+  if (surface->video_seq == 0)
+    return NULL;
+
+  oldest = surface->video_seq > surface->video_ring_size ?
+      surface->video_seq - surface->video_ring_size : 0;
+
+  for (s = surface->video_seq; s > oldest; s--) {
+    GstInterSurfaceFrame *f =
+        &surface->video_frames[(s - 1) % surface->video_ring_size];
+
+    if (!f->buffer)
+      break;
+
+    frame = f;
+    *seq = s;
+
+    if (!GST_CLOCK_TIME_IS_VALID (time) || !GST_CLOCK_TIME_IS_VALID (f->time)
+        || f->time <= time)
+      break;
+  }
+
+  if (!frame)
+    return NULL;
+
+  return gst_buffer_ref (frame->buffer);
+}
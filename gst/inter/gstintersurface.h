@@ -28,6 +28,15 @@ G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
 
+#define GST_INTER_SURFACE_MAX_VIDEO_FRAMES 64
+
+typedef struct
+{
+  GstBuffer *buffer;
+  /* clock time at which the frame is due, or GST_CLOCK_TIME_NONE */
+  GstClockTime time;
+} GstInterSurfaceFrame;
+
 struct _GstInterSurface
 {
   GMutex mutex;
@@ -37,7 +46,12 @@ struct _GstInterSurface
 
   /* video */
   GstVideoInfo video_info;
-  int video_buffer_count;
+  /* ring of the last video_ring_size frames, the newest one being at
+   * (video_seq - 1) % video_ring_size. video_seq only ever grows so that
+   * readers can tell new frames from repeats. */
+  GstInterSurfaceFrame video_frames[GST_INTER_SURFACE_MAX_VIDEO_FRAMES];
+  guint video_ring_size;
+  guint64 video_seq;
 
   /* audio */
   GstAudioInfo audio_info;
@@ -45,7 +59,6 @@ struct _GstInterSurface
   guint64 audio_latency_time;
   guint64 audio_period_time;
 
-  GstBuffer *video_buffer;
   GstBuffer *sub_buffer;
   GstAdapter *audio_adapter;
 };
@@ -58,6 +71,13 @@ struct _GstInterSurface
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
 
+void gst_inter_surface_set_video_ring_size (GstInterSurface *surface, guint size);
+void gst_inter_surface_push_video (GstInterSurface *surface, GstBuffer *buffer,
+    GstClockTime time);
+void gst_inter_surface_clear_video (GstInterSurface *surface);
+GstBuffer * gst_inter_surface_get_video_locked (GstInterSurface *surface,
+    GstClockTime time, guint64 *seq);
+
 
 G_END_DECLS
 
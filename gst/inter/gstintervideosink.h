@@ -40,6 +40,7 @@ struct _GstInterVideoSink
 
   GstInterSurface *surface;
   char *channel;
+  guint ring_size;
 
   GstVideoInfo info;
 };
@@ -71,11 +71,13 @@ enum
 {
   PROP_0,
   PROP_CHANNEL,
-  PROP_TIMEOUT
+  PROP_TIMEOUT,
+  PROP_TIMESTAMP_SELECTION
 };
 
 #define DEFAULT_CHANNEL ("default")
 #define DEFAULT_TIMEOUT (GST_SECOND)
+#define DEFAULT_TIMESTAMP_SELECTION FALSE
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_src_src_template =
@@ -132,6 +134,22 @@ gst_inter_video_src_class_init (GstInterVideoSrcClass * klass)
           "Timeout after which to start outputting black frames",
           0, G_MAXUINT64, DEFAULT_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSrc:timestamp-selection:
+   *
+   * Instead of always outputting the latest frame, pick the newest frame
+   * from the channel's ring (see #GstInterVideoSink:ring-size) that is due
+   * at or before the clock time of the frame being produced. This requires
+   * the sink and source pipelines to use the same clock.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TIMESTAMP_SELECTION,
+      g_param_spec_boolean ("timestamp-selection", "Timestamp Selection",
+          "Select frames by their timestamp instead of using the latest one",
+          DEFAULT_TIMESTAMP_SELECTION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -142,6 +160,7 @@ gst_inter_video_src_init (GstInterVideoSrc * intervideosrc)
 
   intervideosrc->channel = g_strdup (DEFAULT_CHANNEL);
   intervideosrc->timeout = DEFAULT_TIMEOUT;
+  intervideosrc->timestamp_selection = DEFAULT_TIMESTAMP_SELECTION;
 }
 
 void
@@ -158,6 +177,9 @@ gst_inter_video_src_set_property (GObject * object, guint property_id,
     case PROP_TIMEOUT:
       intervideosrc->timeout = g_value_get_uint64 (value);
       break;
+    case PROP_TIMESTAMP_SELECTION:
+      intervideosrc->timestamp_selection = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -177,6 +199,9 @@ gst_inter_video_src_get_property (GObject * object, guint property_id,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, intervideosrc->timeout);
       break;
+    case PROP_TIMESTAMP_SELECTION:
+      g_value_set_boolean (value, intervideosrc->timestamp_selection);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -278,6 +303,8 @@ gst_inter_video_src_start (GstBaseSrc * src)
   intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
   intervideosrc->timestamp_offset = 0;
   intervideosrc->n_frames = 0;
+  intervideosrc->last_seq = G_MAXUINT64;
+  intervideosrc->repeat_count = 0;
 
   return TRUE;
 }
@@ -328,7 +355,8 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
   GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
   GstCaps *caps;
   GstBuffer *buffer;
-  guint64 frames;
+  guint64 frames, seq;
+  GstClockTime target = GST_CLOCK_TIME_NONE;
   gboolean is_gap = FALSE;
 
   GST_DEBUG_OBJECT (intervideosrc, "create");
@@ -362,26 +390,38 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  if (intervideosrc->surface->video_buffer) {
-    /* We have a buffer to push */
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
+  if (intervideosrc->timestamp_selection) {
+    /* Clock time at which the frame we are producing will be pushed */
+    target = gst_element_get_base_time (GST_ELEMENT (src)) +
+        intervideosrc->timestamp_offset +
+        gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
+        GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
+        GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
+  }
 
-    /* Can only be true if timeout > 0 */
-    if (intervideosrc->surface->video_buffer_count == frames) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
-    }
+  buffer = gst_inter_surface_get_video_locked (intervideosrc->surface, target,
+      &seq);
+  g_mutex_unlock (&intervideosrc->surface->mutex);
+
+  /* Repeats are tracked per source so that several sources can read the
+   * same channel without stealing each other's frames */
+  if (seq != intervideosrc->last_seq) {
+    intervideosrc->last_seq = seq;
+    intervideosrc->repeat_count = 0;
+  } else {
+    intervideosrc->repeat_count++;
   }
 
-  if (intervideosrc->surface->video_buffer_count != 0 &&
-      intervideosrc->surface->video_buffer_count != (frames + 1)) {
+  /* Can only happen for repeats if timeout > 0 */
+  if (buffer && intervideosrc->repeat_count > frames)
+    gst_buffer_replace (&buffer, NULL);
+
+  if (intervideosrc->repeat_count != 0 &&
+      intervideosrc->repeat_count != (frames + 1)) {
     /* This is a repeat of the stored buffer or of a black frame */
     is_gap = TRUE;
   }
 
-  intervideosrc->surface->video_buffer_count++;
-  g_mutex_unlock (&intervideosrc->surface->mutex);
-
   if (caps) {
     gboolean ret;
     GstStructure *s;
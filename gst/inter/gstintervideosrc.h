@@ -43,11 +43,14 @@ struct _GstInterVideoSrc
 
   char *channel;
   guint64 timeout;
+  gboolean timestamp_selection;
 
   GstVideoInfo info;
   GstBuffer *black_frame;
   int n_frames;
   GstClockTime timestamp_offset;
+  guint64 last_seq;
+  guint64 repeat_count;
 };
 
 struct _GstInterVideoSrcClass
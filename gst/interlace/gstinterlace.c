@@ -50,6 +50,12 @@
  * 30000/1001 2:3:2:3... pattern telecined stream suitable for displaying film
  * content on NTSC.
  *
+ * Frames that are output unchanged share the memory of the input frame, and
+ * frames combining fields of two input frames are woven in a single pass
+ * into buffers from the negotiated buffer pool. When downstream supports
+ * #GstVideoMeta, the fields of an "alternate" stream are output without
+ * copying, by pointing at every other line of the input frame.
+ *
  */
 
 
@@ -109,6 +115,10 @@ struct _GstInterlace
   guint pattern_offset;         /* initial offset into the pattern */
   gboolean passthrough;
   gboolean switch_fields;
+
+  /* output allocation */
+  GstBufferPool *pool;
+  gboolean use_video_meta;
 };
 
 struct _GstInterlaceClass
@@ -302,10 +312,22 @@ gst_interlace_class_init (GstInterlaceClass * klass)
   gst_type_mark_as_plugin_api (GST_INTERLACE_PATTERN, 0);
 }
 
+static void
+gst_interlace_clear_pool (GstInterlace * interlace)
+{
+  if (interlace->pool) {
+    gst_buffer_pool_set_active (interlace->pool, FALSE);
+    gst_object_unref (interlace->pool);
+    interlace->pool = NULL;
+  }
+  interlace->use_video_meta = FALSE;
+}
+
 static void
 gst_interlace_finalize (GObject * obj)
 {
   GstInterlace *interlace = GST_INTERLACE (obj);
+  gst_interlace_clear_pool (interlace);
   g_mutex_clear (&interlace->lock);
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -461,6 +483,62 @@ dup_caps_with_alternate (GstCaps * caps)
   return with_alternate;
 }
 
+/* Sets up a buffer pool for the woven frames and checks if downstream can
+ * handle frames with arbitrary strides and offsets */
+static void
+gst_interlace_decide_allocation (GstInterlace * interlace, GstCaps * caps)
+{
+  GstQuery *query;
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  guint size, min = 0, max = 0;
+
+  query = gst_query_new_allocation (caps, TRUE);
+  if (!gst_pad_peer_query (interlace->srcpad, query))
+    GST_DEBUG_OBJECT (interlace, "peer ALLOCATION query failed");
+
+  interlace->use_video_meta =
+      gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  size = GST_VIDEO_INFO_SIZE (&interlace->out_info);
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+  gst_query_unref (query);
+
+  if (!pool)
+    pool = gst_video_buffer_pool_new ();
+  size = MAX (size, GST_VIDEO_INFO_SIZE (&interlace->out_info));
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  if (interlace->use_video_meta)
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (interlace, "failed to set up buffer pool");
+    gst_object_unref (pool);
+    return;
+  }
+
+  interlace->pool = pool;
+}
+
+static GstBuffer *
+gst_interlace_alloc_buffer (GstInterlace * interlace)
+{
+  GstBuffer *buffer = NULL;
+
+  if (interlace->pool &&
+      gst_buffer_pool_acquire_buffer (interlace->pool, &buffer,
+          NULL) == GST_FLOW_OK)
+    return buffer;
+
+  return gst_buffer_new_allocate (NULL,
+      GST_VIDEO_INFO_SIZE (&interlace->out_info), NULL);
+}
+
 static gboolean
 gst_interlace_setcaps (GstInterlace * interlace, GstCaps * caps)
 {
@@ -601,11 +679,15 @@ gst_interlace_setcaps (GstInterlace * interlace, GstCaps * caps)
   GST_DEBUG_OBJECT (interlace->srcpad, "set caps %" GST_PTR_FORMAT, othercaps);
 
   ret = gst_pad_set_caps (interlace->srcpad, othercaps);
-  gst_caps_unref (othercaps);
 
   interlace->info = info;
   interlace->out_info = out_info;
 
+  gst_interlace_clear_pool (interlace);
+  if (ret && !interlace->passthrough)
+    gst_interlace_decide_allocation (interlace, othercaps);
+  gst_caps_unref (othercaps);
+
   return ret;
 
 caps_error:
@@ -1066,66 +1148,115 @@ gst_interlace_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
   return ret;
 }
 
-static void
-copy_fields (GstInterlace * interlace, GstBuffer * dest, GstBuffer * src,
-    int field_index)
+/* Weaves field @field_index of @first and the other field of @second into
+ * @dest in one pass */
+static gboolean
+weave_fields (GstInterlace * interlace, GstBuffer * dest, GstBuffer * first,
+    GstBuffer * second, int field_index)
 {
   GstVideoInfo *in_info = &interlace->info;
   GstVideoInfo *out_info = &interlace->out_info;
+  GstVideoFrame dframe, sframe[2];
   gint i, j, n_planes;
-  guint8 *d, *s;
-  GstVideoFrame dframe, sframe;
 
   if (!gst_video_frame_map (&dframe, out_info, dest, GST_MAP_WRITE))
     goto dest_map_failed;
 
-  if (!gst_video_frame_map (&sframe, in_info, src, GST_MAP_READ))
+  if (!gst_video_frame_map (&sframe[0], in_info, first, GST_MAP_READ))
     goto src_map_failed;
 
+  if (!gst_video_frame_map (&sframe[1], in_info, second, GST_MAP_READ)) {
+    gst_video_frame_unmap (&sframe[0]);
+    goto src_map_failed;
+  }
+
   n_planes = GST_VIDEO_FRAME_N_PLANES (&dframe);
 
   for (i = 0; i < n_planes; i++) {
+    const guint8 *s[2];
+    gint ss[2];
+    guint8 *d;
     gint cheight, cwidth;
-    gint ss, ds;
+    gint ds;
 
     d = GST_VIDEO_FRAME_PLANE_DATA (&dframe, i);
-    s = GST_VIDEO_FRAME_PLANE_DATA (&sframe, i);
-
     ds = GST_VIDEO_FRAME_PLANE_STRIDE (&dframe, i);
-    ss = GST_VIDEO_FRAME_PLANE_STRIDE (&sframe, i);
-
-    d += field_index * ds;
-    if (!interlace->switch_fields) {
-      s += field_index * ss;
-    } else {
-      s += (field_index ^ 1) * ss;
-    }
+    s[0] = GST_VIDEO_FRAME_PLANE_DATA (&sframe[0], i);
+    ss[0] = GST_VIDEO_FRAME_PLANE_STRIDE (&sframe[0], i);
+    s[1] = GST_VIDEO_FRAME_PLANE_DATA (&sframe[1], i);
+    ss[1] = GST_VIDEO_FRAME_PLANE_STRIDE (&sframe[1], i);
 
     cheight = GST_VIDEO_FRAME_COMP_HEIGHT (&dframe, i);
-    cwidth = MIN (ABS (ss), ABS (ds));
+    cwidth = MIN (MIN (ABS (ss[0]), ABS (ss[1])), ABS (ds));
 
-    for (j = field_index; j < cheight; j += 2) {
-      memcpy (d, s, cwidth);
-      d += ds * 2;
-      s += ss * 2;
+    for (j = 0; j < cheight; j++) {
+      gint src = (j & 1) == field_index ? 0 : 1;
+      gint line = j;
+
+      /* take the lines of the field of the opposite parity */
+      if (interlace->switch_fields)
+        line = MIN (j ^ 1, cheight - 1);
+
+      memcpy (d + j * ds, s[src] + line * ss[src], cwidth);
     }
   }
 
   gst_video_frame_unmap (&dframe);
-  gst_video_frame_unmap (&sframe);
-  return;
+  gst_video_frame_unmap (&sframe[0]);
+  gst_video_frame_unmap (&sframe[1]);
+  return TRUE;
 
 dest_map_failed:
   {
-    GST_ERROR_OBJECT (interlace, "failed to map dest");
-    return;
+    GST_ELEMENT_ERROR (interlace, CORE, FAILED, ("Failed to write map buffer"),
+        ("Failed to map output buffer"));
+    return FALSE;
   }
 src_map_failed:
   {
-    GST_ERROR_OBJECT (interlace, "failed to map src");
+    GST_ELEMENT_ERROR (interlace, CORE, FAILED, ("Failed to read map buffer"),
+        ("Failed to map input buffer"));
     gst_video_frame_unmap (&dframe);
-    return;
+    return FALSE;
+  }
+}
+
+/* Output buffer sharing the memory of field @field_index of @src, the lines
+ * of the field are addressed with a doubled stride */
+static GstBuffer *
+wrap_field (GstInterlace * interlace, GstBuffer * src, int field_index)
+{
+  GstVideoInfo *in_info = &interlace->info;
+  GstVideoInfo *out_info = &interlace->out_info;
+  GstVideoMeta *vmeta;
+  gsize offset[GST_VIDEO_MAX_PLANES];
+  gint stride[GST_VIDEO_MAX_PLANES];
+  GstBuffer *dest;
+  guint i;
+
+  vmeta = gst_buffer_get_video_meta (src);
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (in_info); i++) {
+    if (vmeta) {
+      offset[i] = vmeta->offset[i];
+      stride[i] = vmeta->stride[i];
+    } else {
+      offset[i] = GST_VIDEO_INFO_PLANE_OFFSET (in_info, i);
+      stride[i] = GST_VIDEO_INFO_PLANE_STRIDE (in_info, i);
+    }
+
+    offset[i] += field_index * stride[i];
+    stride[i] *= 2;
   }
+
+  dest = gst_buffer_copy_region (src, GST_BUFFER_COPY_MEMORY, 0, -1);
+  gst_buffer_add_video_meta_full (dest,
+      field_index == 0 ? GST_VIDEO_FRAME_FLAG_TOP_FIELD :
+      GST_VIDEO_FRAME_FLAG_BOTTOM_FIELD, GST_VIDEO_INFO_FORMAT (out_info),
+      GST_VIDEO_INFO_WIDTH (out_info), GST_VIDEO_INFO_HEIGHT (out_info),
+      GST_VIDEO_INFO_N_PLANES (in_info), offset, stride);
+
+  return dest;
 }
 
 static GstBuffer *
@@ -1135,9 +1266,10 @@ copy_field (GstInterlace * interlace, GstBuffer * src, int field_index)
   GstVideoFrame dframe, sframe;
   GstBuffer *dest;
 
-  dest =
-      gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&interlace->out_info),
-      NULL);
+  if (interlace->use_video_meta)
+    return wrap_field (interlace, src, field_index);
+
+  dest = gst_interlace_alloc_buffer (interlace);
 
   if (!gst_video_frame_map (&dframe, &interlace->out_info, dest, GST_MAP_WRITE))
     goto dest_map_failed;
@@ -1315,14 +1447,15 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         if (!output_buffer2)
           return GST_FLOW_ERROR;
       } else {
-        output_buffer =
-            gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (out_info));
-        /* take the first field from the stored frame */
-        copy_fields (interlace, output_buffer, interlace->stored_frame,
-            interlace->field_index);
-        /* take the second field from the incoming buffer */
-        copy_fields (interlace, output_buffer, buffer,
-            interlace->field_index ^ 1);
+        output_buffer = gst_interlace_alloc_buffer (interlace);
+        /* take the first field from the stored frame and the second field
+         * from the incoming buffer */
+        if (!weave_fields (interlace, output_buffer, interlace->stored_frame,
+                buffer, interlace->field_index)) {
+          gst_buffer_unref (output_buffer);
+          gst_buffer_unref (buffer);
+          return GST_FLOW_ERROR;
+        }
       }
 
       interlace->stored_fields--;
@@ -1338,11 +1471,15 @@ gst_interlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
             copy_field (interlace, buffer, interlace->field_index ^ 1);
         if (!output_buffer2)
           return GST_FLOW_ERROR;
+      } else if (interlace->use_video_meta
+          || !gst_buffer_get_video_meta (buffer)) {
+        /* both fields come from the same frame, share its memory */
+        output_buffer = gst_buffer_copy_region (buffer,
+            GST_BUFFER_COPY_MEMORY | GST_BUFFER_COPY_META, 0, -1);
       } else {
         GstVideoFrame dframe, sframe;
 
-        output_buffer =
-            gst_buffer_new_and_alloc (GST_VIDEO_INFO_SIZE (out_info));
+        output_buffer = gst_interlace_alloc_buffer (interlace);
 
         if (!gst_video_frame_map (&dframe,
                 out_info, output_buffer, GST_MAP_WRITE)) {
@@ -1521,8 +1658,11 @@ gst_interlace_change_state (GstElement * element, GstStateChange transition)
       interlace->src_fps_n = 0;
       if (interlace->stored_frame) {
         gst_buffer_unref (interlace->stored_frame);
+        interlace->stored_frame = NULL;
+        interlace->stored_fields = 0;
       }
       g_mutex_unlock (&interlace->lock);
+      gst_interlace_clear_pool (interlace);
       /* why? */
       //gst_interlace_reset (interlace);
       break;
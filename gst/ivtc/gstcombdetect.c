@@ -56,12 +56,21 @@ static gboolean gst_comb_detect_set_info (GstVideoFilter * filter,
     GstVideoInfo * out_info);
 static GstFlowReturn gst_comb_detect_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * inframe, GstVideoFrame * outframe);
+static void gst_comb_detect_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_comb_detect_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_comb_detect_finalize (GObject * object);
+static gboolean gst_comb_detect_stop (GstBaseTransform * trans);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_N_THREADS 1
+
 /* pad templates */
 
 /* Yeah, the max width is hard-coded 2048. */
@@ -99,6 +108,7 @@ GST_ELEMENT_REGISTER_DEFINE (combdetect, "combdetect", GST_RANK_NONE,
 static void
 gst_comb_detect_class_init (GstCombDetectClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstBaseTransformClass *base_transform_class =
       GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
@@ -114,17 +124,90 @@ gst_comb_detect_class_init (GstCombDetectClass * klass)
       "Comb Detect", "Video/Filter", "Detect combing artifacts in video stream",
       "David Schleef <ds@schleef.org>");
 
+  gobject_class->set_property = gst_comb_detect_set_property;
+  gobject_class->get_property = gst_comb_detect_get_property;
+  gobject_class->finalize = gst_comb_detect_finalize;
   base_transform_class->transform_caps =
       GST_DEBUG_FUNCPTR (gst_comb_detect_transform_caps);
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_comb_detect_stop);
   video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_comb_detect_set_info);
   video_filter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_comb_detect_transform_frame);
 
+  /**
+   * GstCombDetect:n-threads:
+   *
+   * Number of threads the frames are processed with, each one working on a
+   * band of lines. The output does not depend on the number of threads.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      gst_row_bands_param_spec_n_threads (DEFAULT_N_THREADS));
 }
 
 static void
 gst_comb_detect_init (GstCombDetect * combdetect)
 {
+  combdetect->n_threads = DEFAULT_N_THREADS;
+}
+
+static void
+gst_comb_detect_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstCombDetect *combdetect = GST_COMB_DETECT (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (combdetect);
+      combdetect->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (combdetect);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_comb_detect_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstCombDetect *combdetect = GST_COMB_DETECT (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (combdetect);
+      g_value_set_uint (value, combdetect->n_threads);
+      GST_OBJECT_UNLOCK (combdetect);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_comb_detect_finalize (GObject * object)
+{
+  GstCombDetect *combdetect = GST_COMB_DETECT (object);
+
+  gst_row_bands_clear (&combdetect->row_bands);
+  g_free (combdetect->comb_mask);
+  g_free (combdetect->line_combed);
+
+  G_OBJECT_CLASS (gst_comb_detect_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_comb_detect_stop (GstBaseTransform * trans)
+{
+  GstCombDetect *combdetect = GST_COMB_DETECT (trans);
+
+  gst_row_bands_clear (&combdetect->row_bands);
+
+  return TRUE;
 }
 
 
@@ -186,75 +269,157 @@ gst_comb_detect_set_info (GstVideoFilter * filter,
 
   memcpy (&combdetect->vinfo, in_info, sizeof (GstVideoInfo));
 
+  g_free (combdetect->comb_mask);
+  combdetect->comb_mask =
+      g_malloc (GST_VIDEO_INFO_WIDTH (in_info) *
+      GST_VIDEO_INFO_HEIGHT (in_info));
+  g_free (combdetect->line_combed);
+  combdetect->line_combed =
+      g_new0 (gboolean, GST_VIDEO_INFO_HEIGHT (in_info));
+
   return TRUE;
 }
 
+typedef struct
+{
+  GstCombDetect *combdetect;
+  GstVideoFrame *inframe, *outframe;
+  guint index, n_bands;
+} GstCombDetectBand;
+
+#define GET_LINE(frame,comp,line) (((unsigned char *)(frame)->data[comp]) + \
+      (line) * GST_VIDEO_FRAME_COMP_STRIDE((frame), (comp)))
+
+/* First pass, done in bands of lines: copies the chroma, finds the luma
+ * samples that stick out of their vertical neighbours and outputs the luma
+ * as if nothing was combed */
+static void
+gst_comb_detect_process_band (GstCombDetectBand * band)
+{
+  GstVideoFrame *inframe = band->inframe;
+  GstVideoFrame *outframe = band->outframe;
+  int k;
+  int j;
+  int height;
+  int width;
+
+  for (k = 1; k < 3; k++) {
+    height = GST_VIDEO_FRAME_COMP_HEIGHT (outframe, k);
+    width = GST_VIDEO_FRAME_COMP_WIDTH (outframe, k);
+    for (j = height * band->index / band->n_bands;
+        j < height * (band->index + 1) / band->n_bands; j++) {
+      memcpy (GET_LINE (outframe, k, j), GET_LINE (inframe, k, j), width);
+    }
+  }
+
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (outframe, 0);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (outframe, 0);
+
+  for (j = height * band->index / band->n_bands;
+      j < height * (band->index + 1) / band->n_bands; j++) {
+    int i;
+    if (j < 2 || j >= height - 2) {
+      guint8 *dest = GET_LINE (outframe, 0, j);
+      guint8 *src = GET_LINE (inframe, 0, j);
+      for (i = 0; i < width; i++) {
+        dest[i] = src[i] / 2;
+      }
+    } else {
+      guint8 *dest = GET_LINE (outframe, 0, j);
+      guint8 *src1 = GET_LINE (inframe, 0, j - 1);
+      guint8 *src2 = GET_LINE (inframe, 0, j);
+      guint8 *src3 = GET_LINE (inframe, 0, j + 1);
+      guint8 *mask = band->combdetect->comb_mask + j * width;
+      guint8 combed = 0;
+
+      for (i = 0; i < width; i++) {
+        mask[i] = src2[i] < MIN (src1[i], src3[i]) - 5 ||
+            src2[i] > MAX (src1[i], src3[i]) + 5;
+        combed |= mask[i];
+        dest[i] = src2[i];
+      }
+      band->combdetect->line_combed[j] = combed;
+    }
+  }
+}
+
 static GstFlowReturn
 gst_comb_detect_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * inframe, GstVideoFrame * outframe)
 {
+  GstCombDetect *combdetect = GST_COMB_DETECT (filter);
   static int z;
-  int k;
+  GstCombDetectBand *bands;
+  guint n_threads, n_bands, b;
   int height;
   int width;
 
-#define GET_LINE(frame,comp,line) (((unsigned char *)(frame)->data[k]) + \
-      (line) * GST_VIDEO_FRAME_COMP_STRIDE((frame), (comp)))
-
   z++;
 
-  for (k = 1; k < 3; k++) {
-    int i;
-    height = GST_VIDEO_FRAME_COMP_HEIGHT (outframe, k);
-    width = GST_VIDEO_FRAME_COMP_WIDTH (outframe, k);
-    for (i = 0; i < height; i++) {
-      memcpy (GET_LINE (outframe, k, i), GET_LINE (inframe, k, i), width);
-    }
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (outframe, 0);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (outframe, 0);
+
+  GST_OBJECT_LOCK (combdetect);
+  n_threads = combdetect->n_threads;
+  GST_OBJECT_UNLOCK (combdetect);
+
+  n_bands = gst_row_bands_prepare (&combdetect->row_bands,
+      GST_OBJECT_CAST (combdetect), n_threads, height);
+  bands = g_newa (GstCombDetectBand, n_bands);
+
+  for (b = 0; b < n_bands; b++) {
+    bands[b].combdetect = combdetect;
+    bands[b].inframe = inframe;
+    bands[b].outframe = outframe;
+    bands[b].index = b;
+    bands[b].n_bands = n_bands;
   }
 
+  gst_row_bands_run (&combdetect->row_bands,
+      (GstRowBandsFunc) gst_comb_detect_process_band, bands,
+      sizeof (GstCombDetectBand), n_bands);
+
+  /* Second pass: runs of combed samples carry over from line to line, so
+   * this is done in order, but only on the lines that have combed samples */
   {
     int j;
     int thisline[MAX_WIDTH];
+    gboolean thisline_clear = TRUE;
     int score = 0;
 
-    height = GST_VIDEO_FRAME_COMP_HEIGHT (outframe, 0);
-    width = GST_VIDEO_FRAME_COMP_WIDTH (outframe, 0);
-
     memset (thisline, 0, sizeof (thisline));
 
-    k = 0;
-    for (j = 0; j < height; j++) {
+    for (j = 2; j < height - 2; j++) {
       int i;
-      if (j < 2 || j >= height - 2) {
-        guint8 *dest = GET_LINE (outframe, 0, j);
-        guint8 *src = GET_LINE (inframe, 0, j);
-        for (i = 0; i < width; i++) {
-          dest[i] = src[i] / 2;
+      guint8 *dest;
+      guint8 *mask;
+
+      if (!combdetect->line_combed[j]) {
+        if (!thisline_clear) {
+          memset (thisline, 0, sizeof (thisline));
+          thisline_clear = TRUE;
         }
-      } else {
-        guint8 *dest = GET_LINE (outframe, 0, j);
-        guint8 *src1 = GET_LINE (inframe, 0, j - 1);
-        guint8 *src2 = GET_LINE (inframe, 0, j);
-        guint8 *src3 = GET_LINE (inframe, 0, j + 1);
-
-        for (i = 0; i < width; i++) {
-          if (src2[i] < MIN (src1[i], src3[i]) - 5 ||
-              src2[i] > MAX (src1[i], src3[i]) + 5) {
-            if (i > 0) {
-              thisline[i] += thisline[i - 1];
-            }
-            thisline[i]++;
-            if (thisline[i] > 1000)
-              thisline[i] = 1000;
-          } else {
-            thisline[i] = 0;
-          }
-          if (thisline[i] > 100) {
-            dest[i] = ((i + j + z) & 0x4) ? 235 : 16;
-            score++;
-          } else {
-            dest[i] = src2[i];
+        continue;
+      }
+
+      dest = GET_LINE (outframe, 0, j);
+      mask = combdetect->comb_mask + j * width;
+      thisline_clear = FALSE;
+
+      for (i = 0; i < width; i++) {
+        if (mask[i]) {
+          if (i > 0) {
+            thisline[i] += thisline[i - 1];
           }
+          thisline[i]++;
+          if (thisline[i] > 1000)
+            thisline[i] = 1000;
+        } else {
+          thisline[i] = 0;
+        }
+        if (thisline[i] > 100) {
+          dest[i] = ((i + j + z) & 0x4) ? 235 : 16;
+          score++;
         }
       }
     }
@@ -22,6 +22,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/gst-row-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -39,6 +40,16 @@ struct _GstCombDetect
   GstVideoFilter base_combdetect;
 
   GstVideoInfo vinfo;
+
+  /* properties */
+  guint n_threads;
+
+  GstRowBands row_bands;
+
+  /* one byte per luma sample set when it differs from the samples above and
+   * below, and whether any sample is set on each line */
+  guint8 *comb_mask;
+  gboolean *line_combed;
 };
 
 struct _GstCombDetectClass
@@ -31,6 +31,13 @@
  * image header searching for image properties such as width and height
  * among others. Jpegparse can also extract metadata (e.g. xmp).
  *
+ * When the scans of an image contain restart markers, their byte offsets
+ * from the start of the output buffer are attached in a custom meta named
+ * "GstJpegParseRestartMeta", so that decoders can split the entropy coded
+ * data without scanning it again. The meta structure holds the
+ * "restart-interval" (uint, in MCUs, 0 if no DRI marker was found) and the
+ * "offsets" (array of uint).
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v souphttpsrc location=... ! jpegparse ! matroskamux ! filesink location=...
@@ -120,6 +127,14 @@ gst_jpeg_parse_class_init (GstJpegParseClass * klass)
       "Arnout Vandecappelle (Essensium/Mind) <arnout@mind.be>");
 
   GST_DEBUG_CATEGORY_INIT (jpeg_parse_debug, "jpegparse", 0, "JPEG parser");
+
+  {
+    /* the offsets point into the memory of the buffer */
+    static const gchar *tags[] = { GST_META_TAG_MEMORY_STR, NULL };
+
+    gst_meta_register_custom (GST_JPEG_PARSE_RESTART_META_NAME, tags, NULL,
+        NULL, NULL);
+  }
 }
 
 static void
@@ -189,6 +204,67 @@ gst_jpeg_parse_parse_tag_has_entropy_segment (guint8 tag)
   return FALSE;
 }
 
+static inline void
+gst_jpeg_parse_add_restart (GstJpegParse * parse, guint pos)
+{
+  /* markers are seen again when resuming after more data came in */
+  if (parse->restarts->len > 0 &&
+      g_array_index (parse->restarts, guint, parse->restarts->len - 1) >= pos)
+    return;
+
+  g_array_append_val (parse->restarts, pos);
+}
+
+/*
+ * gst_jpeg_parse_scan_entropy:
+ * @parse: the parser
+ * @data: the frame data
+ * @size: size of @data
+ * @pos: (inout): where to start scanning
+ *
+ * Looks for the end of an entropy coded segment. Stuffed 0xff 0x00 bytes
+ * are skipped and the restart markers are recorded on the way, so an image
+ * with restart intervals is walked in a single pass. The 0xff bytes are
+ * searched with memchr(), which the C library vectorizes.
+ *
+ * Returns: TRUE with @pos set to the 0xff of the marker ending the segment,
+ * or FALSE with @pos set to the first byte still to be examined if more
+ * data is needed.
+ */
+static gboolean
+gst_jpeg_parse_scan_entropy (GstJpegParse * parse, const guint8 * data,
+    guint size, guint * pos)
+{
+  guint i = *pos;
+
+  while (i + 1 < size) {
+    const guint8 *p;
+    guint8 value;
+
+    /* the marker byte following the 0xff must be available */
+    p = memchr (data + i, 0xff, size - 1 - i);
+    if (p == NULL) {
+      i = size - 1;
+      break;
+    }
+
+    i = p - data;
+    value = data[i + 1];
+    if (value == 0x00) {
+      i += 2;
+    } else if (value >= RST0 && value <= RST7) {
+      gst_jpeg_parse_add_restart (parse, i);
+      i += 2;
+    } else {
+      *pos = i;
+      return TRUE;
+    }
+  }
+
+  *pos = i;
+  return FALSE;
+}
+
 /* returns image length in bytes if parsed successfully,
  * otherwise 0 if more data needed,
  * if < 0 the absolute value needs to be flushed */
@@ -222,6 +298,11 @@ gst_jpeg_parse_get_image_length (GstJpegParse * parse, GstMapInfo * mapinfo)
   /* resume from state offset */
   offset = parse->last_offset;
 
+  if (offset == 0 && parse->last_entropy_len == 0) {
+    g_array_set_size (parse->restarts, 0);
+    parse->restart_interval = 0;
+  }
+
   while (1) {
     guint frame_len;
     guint32 value;
@@ -263,12 +344,14 @@ gst_jpeg_parse_get_image_length (GstJpegParse * parse, GstMapInfo * mapinfo)
       /* clear parse state */
       parse->last_resync = FALSE;
       parse->last_offset = 0;
+      g_array_set_size (parse->restarts, 0);
       return -(offset + 2);
     }
 
-    if (value >= 0xd0 && value <= 0xd7)
+    if (value >= 0xd0 && value <= 0xd7) {
+      gst_jpeg_parse_add_restart (parse, offset + 2);
       frame_len = 0;
-    else {
+    } else {
       /* peek tag and subsequent length */
       if (offset + 2 + 4 > size)
         goto need_more_data;
@@ -284,25 +367,20 @@ gst_jpeg_parse_get_image_length (GstJpegParse * parse, GstMapInfo * mapinfo)
       goto need_more_data;
     }
 
+    if (value == DRI && frame_len >= 4)
+      parse->restart_interval = GST_READ_UINT16_BE (mapinfo->data + offset + 6);
+
     if (gst_jpeg_parse_parse_tag_has_entropy_segment (value)) {
-      guint eseglen = parse->last_entropy_len;
+      guint start = offset + 4 + frame_len;
+      guint epos = start + parse->last_entropy_len;
+      guint eseglen;
 
       GST_DEBUG ("0x%08x: finding entropy segment length", offset + 2);
-      noffset = offset + 2 + frame_len + eseglen;
-      while (1) {
-        noffset = gst_byte_reader_masked_scan_uint32_peek (&reader, 0x0000ff00,
-            0x0000ff00, noffset, size - noffset, &value);
-        if (noffset < 0) {
-          /* need more data */
-          parse->last_entropy_len = size - offset - 4 - frame_len - 2;
-          goto need_more_data;
-        }
-        if ((value & 0xff) != 0x00) {
-          eseglen = noffset - offset - frame_len - 2;
-          break;
-        }
-        noffset++;
+      if (!gst_jpeg_parse_scan_entropy (parse, mapinfo->data, size, &epos)) {
+        parse->last_entropy_len = epos - start;
+        goto need_more_data;
       }
+      eseglen = epos - start;
       parse->last_entropy_len = 0;
       frame_len += eseglen;
       GST_DEBUG ("entropy segment length=%u => frame_len=%u", eseglen,
@@ -318,6 +396,10 @@ gst_jpeg_parse_get_image_length (GstJpegParse * parse, GstMapInfo * mapinfo)
       if (noffset < 0) {
         /* ignore and continue resyncing until we hit the end
          * of our data or find a sync point that looks okay */
+        while (parse->restarts->len > 0 &&
+            g_array_index (parse->restarts, guint,
+                parse->restarts->len - 1) >= offset + 2)
+          g_array_set_size (parse->restarts, parse->restarts->len - 1);
         offset++;
         continue;
       }
@@ -737,6 +819,34 @@ gst_jpeg_parse_pre_push_frame (GstBaseParse * bparse, GstBaseParseFrame * frame)
 
   GST_BUFFER_DURATION (outbuf) = parse->duration;
 
+  if (parse->restarts->len > 0) {
+    GstCustomMeta *meta;
+    GstStructure *s;
+    GValue offsets = G_VALUE_INIT;
+    GValue v = G_VALUE_INIT;
+    guint i;
+
+    meta = gst_buffer_add_custom_meta (outbuf,
+        GST_JPEG_PARSE_RESTART_META_NAME);
+    s = gst_custom_meta_get_structure (meta);
+
+    gst_value_array_init (&offsets, parse->restarts->len);
+    g_value_init (&v, G_TYPE_UINT);
+    for (i = 0; i < parse->restarts->len; i++) {
+      g_value_set_uint (&v, g_array_index (parse->restarts, guint, i));
+      gst_value_array_append_value (&offsets, &v);
+    }
+    g_value_unset (&v);
+
+    gst_structure_set (s, "restart-interval", G_TYPE_UINT,
+        (guint) parse->restart_interval, NULL);
+    gst_structure_take_value (s, "offsets", &offsets);
+
+    GST_LOG_OBJECT (parse, "%u restart markers in frame",
+        parse->restarts->len);
+    g_array_set_size (parse->restarts, 0);
+  }
+
   return GST_FLOW_OK;
 }
 
@@ -832,6 +942,7 @@ gst_jpeg_parse_sink_event (GstBaseParse * bparse, GstEvent * event)
       parse->last_offset = 0;
       parse->last_entropy_len = 0;
       parse->last_resync = FALSE;
+      g_array_set_size (parse->restarts, 0);
       res = GST_BASE_PARSE_CLASS (parent_class)->sink_event (bparse, event);
       break;
     case GST_EVENT_TAG:{
@@ -880,6 +991,9 @@ gst_jpeg_parse_start (GstBaseParse * bparse)
   parse->last_entropy_len = 0;
   parse->last_resync = FALSE;
 
+  parse->restarts = g_array_new (FALSE, FALSE, sizeof (guint));
+  parse->restart_interval = 0;
+
   parse->tags = NULL;
 
   return TRUE;
@@ -897,5 +1011,10 @@ gst_jpeg_parse_stop (GstBaseParse * bparse)
     parse->tags = NULL;
   }
 
+  if (parse->restarts) {
+    g_array_free (parse->restarts, TRUE);
+    parse->restarts = NULL;
+  }
+
   return TRUE;
 }
@@ -43,6 +43,9 @@ G_BEGIN_DECLS
   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_JPEG_PARSE))
 #define GST_JPEG_PARSE_CAST(obj) ((GstJpegParse *)obj)
 
+/* name of the custom meta carrying the restart marker offsets */
+#define GST_JPEG_PARSE_RESTART_META_NAME "GstJpegParseRestartMeta"
+
 typedef struct _GstJpegParse           GstJpegParse;
 typedef struct _GstJpegParseClass      GstJpegParseClass;
 
@@ -53,6 +56,10 @@ struct _GstJpegParse {
   guint last_entropy_len;
   gboolean last_resync;
 
+  /* offsets of the RSTn markers found in the current frame */
+  GArray *restarts;
+  guint16 restart_interval;
+
   /* negotiated state */
   gint caps_width, caps_height;
   gint caps_framerate_numerator;
@@ -64,6 +64,10 @@
 
 #define DURATION_SCAN_LIMIT         4 * 1024 * 1024
 
+/* Keep at most one index entry per half second of SCR */
+#define INDEX_MIN_SCR_DISTANCE      (CLOCK_FREQ / 2)
+#define INDEX_STRUCTURE_NAME        "GstPsDemuxIndex"
+
 typedef enum
 {
   SCAN_SCR,
@@ -71,6 +75,17 @@ typedef enum
   SCAN_PTS
 } SCAN_MODE;
 
+/* The index is only fed by the packs the streaming task parses and by the
+ * SCR scans of seeks. There is no background pass seeding it: that would
+ * pull from upstream in parallel to the streaming task, and to the seek
+ * handler that takes over the stream lock. Applications that open the same
+ * file again can hand back the index they queried instead. */
+typedef struct
+{
+  guint64 scr;
+  guint64 offset;               /* of the pack start code */
+} GstPsDemuxIndexEntry;
+
 /* We clamp scr delta with 0 so negative bytes won't be possible */
 #define GSTTIME_TO_BYTES(time) \
   ((time != -1) ? gst_util_uint64_scale (MAX(0,(gint64) (GSTTIME_TO_MPEGTIME(time))), demux->scr_rate_n, demux->scr_rate_d) : -1)
@@ -307,6 +322,7 @@ gst_ps_demux_init (GstPsDemux * demux)
   demux->adapter = gst_adapter_new ();
   demux->rev_adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
+  demux->index = g_array_new (FALSE, FALSE, sizeof (GstPsDemuxIndexEntry));
 
   gst_ps_demux_reset (demux);
 
@@ -323,6 +339,7 @@ gst_ps_demux_finalize (GstPsDemux * demux)
   gst_flow_combiner_free (demux->flowcombiner);
   g_object_unref (demux->adapter);
   g_object_unref (demux->rev_adapter);
+  g_array_free (demux->index, TRUE);
 
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (demux));
 }
@@ -400,6 +417,9 @@ gst_ps_demux_reset (GstPsDemux * demux)
   demux->next_pts = G_MAXUINT64;
   demux->next_dts = G_MAXUINT64;
   demux->need_no_more_pads = TRUE;
+  GST_OBJECT_LOCK (demux);
+  g_array_set_size (demux->index, 0);
+  GST_OBJECT_UNLOCK (demux);
   gst_ps_demux_reset_psm (demux);
   gst_segment_init (&demux->sink_segment, GST_FORMAT_UNDEFINED);
   gst_segment_init (&demux->src_segment, GST_FORMAT_TIME);
@@ -1122,6 +1142,169 @@ gst_ps_demux_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return res;
 }
 
+/* Returns the position of the first index entry at or after @offset */
+static guint
+gst_ps_demux_index_search (GArray * index, guint64 offset)
+{
+  guint lo = 0, hi = index->len;
+
+  while (lo < hi) {
+    guint mid = (lo + hi) / 2;
+
+    if (g_array_index (index, GstPsDemuxIndexEntry, mid).offset < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+static void
+gst_ps_demux_index_add_unlocked (GstPsDemux * demux, guint64 scr,
+    guint64 offset)
+{
+  GArray *index = demux->index;
+  GstPsDemuxIndexEntry entry = { scr, offset };
+  GstPsDemuxIndexEntry *e;
+  guint pos;
+
+  pos = gst_ps_demux_index_search (index, offset);
+
+  /* Only keep entries that are monotonic with their neighbours, packs after
+   * an SCR discontinuity are simply not indexed. */
+  if (pos > 0) {
+    e = &g_array_index (index, GstPsDemuxIndexEntry, pos - 1);
+    if (scr < e->scr + INDEX_MIN_SCR_DISTANCE)
+      return;
+  }
+  if (pos < index->len) {
+    e = &g_array_index (index, GstPsDemuxIndexEntry, pos);
+    if (e->offset == offset || scr + INDEX_MIN_SCR_DISTANCE > e->scr)
+      return;
+  }
+
+  g_array_insert_val (index, pos, entry);
+}
+
+static void
+gst_ps_demux_index_add (GstPsDemux * demux, guint64 scr, guint64 offset)
+{
+  GST_OBJECT_LOCK (demux);
+  gst_ps_demux_index_add_unlocked (demux, scr, offset);
+  GST_OBJECT_UNLOCK (demux);
+}
+
+/* Narrows the [min, max] range around @scr to the closest indexed packs,
+ * returns TRUE if the index has entries on both sides of @scr */
+static gboolean
+gst_ps_demux_index_lookup (GstPsDemux * demux, guint64 scr,
+    guint64 * min_scr, guint64 * min_offset,
+    guint64 * max_scr, guint64 * max_offset)
+{
+  GArray *index;
+  GstPsDemuxIndexEntry *e;
+  gboolean have_min = FALSE, have_max = FALSE;
+  guint lo, hi;
+
+  GST_OBJECT_LOCK (demux);
+  index = demux->index;
+
+  /* first entry with an SCR after the requested one */
+  lo = 0;
+  hi = index->len;
+  while (lo < hi) {
+    guint mid = (lo + hi) / 2;
+
+    if (g_array_index (index, GstPsDemuxIndexEntry, mid).scr <= scr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo > 0) {
+    e = &g_array_index (index, GstPsDemuxIndexEntry, lo - 1);
+    if (e->scr >= *min_scr && e->offset >= *min_offset
+        && e->offset < *max_offset) {
+      *min_scr = e->scr;
+      *min_offset = e->offset;
+      have_min = TRUE;
+    }
+  }
+  if (lo < index->len) {
+    e = &g_array_index (index, GstPsDemuxIndexEntry, lo);
+    if (e->scr <= *max_scr && e->offset <= *max_offset
+        && e->offset > *min_offset) {
+      *max_scr = e->scr;
+      *max_offset = e->offset;
+      have_max = TRUE;
+    }
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  return have_min && have_max;
+}
+
+static void
+gst_ps_demux_index_fill_structure (GstPsDemux * demux, GstStructure * s)
+{
+  GValue scrs = G_VALUE_INIT, offsets = G_VALUE_INIT, v = G_VALUE_INIT;
+  guint i;
+
+  g_value_init (&scrs, GST_TYPE_ARRAY);
+  g_value_init (&offsets, GST_TYPE_ARRAY);
+  g_value_init (&v, G_TYPE_UINT64);
+
+  GST_OBJECT_LOCK (demux);
+  for (i = 0; i < demux->index->len; i++) {
+    GstPsDemuxIndexEntry *e =
+        &g_array_index (demux->index, GstPsDemuxIndexEntry, i);
+
+    g_value_set_uint64 (&v, e->scr);
+    gst_value_array_append_value (&scrs, &v);
+    g_value_set_uint64 (&v, e->offset);
+    gst_value_array_append_value (&offsets, &v);
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  gst_structure_take_value (s, "scr", &scrs);
+  gst_structure_take_value (s, "offset", &offsets);
+  g_value_unset (&v);
+}
+
+static gboolean
+gst_ps_demux_index_merge_structure (GstPsDemux * demux,
+    const GstStructure * s)
+{
+  const GValue *scrs, *offsets;
+  guint i, n;
+
+  scrs = gst_structure_get_value (s, "scr");
+  offsets = gst_structure_get_value (s, "offset");
+  if (!scrs || !offsets || !GST_VALUE_HOLDS_ARRAY (scrs)
+      || !GST_VALUE_HOLDS_ARRAY (offsets))
+    return FALSE;
+
+  n = MIN (gst_value_array_get_size (scrs), gst_value_array_get_size (offsets));
+
+  GST_OBJECT_LOCK (demux);
+  for (i = 0; i < n; i++) {
+    const GValue *scr = gst_value_array_get_value (scrs, i);
+    const GValue *offset = gst_value_array_get_value (offsets, i);
+
+    if (!G_VALUE_HOLDS_UINT64 (scr) || !G_VALUE_HOLDS_UINT64 (offset))
+      continue;
+
+    gst_ps_demux_index_add_unlocked (demux, g_value_get_uint64 (scr),
+        g_value_get_uint64 (offset));
+  }
+  GST_DEBUG_OBJECT (demux, "merged %u entries, index has %u", n,
+      demux->index->len);
+  GST_OBJECT_UNLOCK (demux);
+
+  return TRUE;
+}
+
 static gboolean
 gst_ps_demux_handle_seek_push (GstPsDemux * demux, GstEvent * event)
 {
@@ -1170,6 +1353,21 @@ gst_ps_demux_handle_seek_push (GstPsDemux * demux, GstEvent * event)
   bstart = GSTTIME_TO_BYTES ((guint64) start);
   bstop = GSTTIME_TO_BYTES ((guint64) stop);
 
+  /* Interpolate between the closest indexed packs if we have them */
+  if (start != -1 && demux->base_time != G_MAXUINT64) {
+    guint64 scr = GSTTIME_TO_MPEGTIME (start + demux->base_time);
+    guint64 min_scr = 0, min_offset = 0;
+    guint64 max_scr = G_MAXUINT64, max_offset = G_MAXUINT64;
+
+    if (gst_ps_demux_index_lookup (demux, scr, &min_scr, &min_offset,
+            &max_scr, &max_offset)) {
+      bstart = min_offset + gst_util_uint64_scale (scr - min_scr,
+          max_offset - min_offset, max_scr - min_scr);
+      GST_DEBUG_OBJECT (demux, "index lookup gives bstart %" G_GINT64_FORMAT,
+          bstart);
+    }
+  }
+
   GST_DEBUG_OBJECT (demux, "in bytes bstart %" G_GINT64_FORMAT " bstop %"
       G_GINT64_FORMAT, bstart, bstop);
   bevent = gst_event_new_seek (rate, GST_FORMAT_BYTES, flags, start_type,
@@ -1232,6 +1430,7 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
 {
   gboolean found;
   guint64 fscr, offset;
+  guint64 min_scr, min_offset, max_scr, max_offset;
   guint64 scr = GSTTIME_TO_MPEGTIME (seeksegment->position + demux->base_time);
 
   /* In some clips the PTS values are completely unaligned with SCR values.
@@ -1247,9 +1446,18 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
   GST_INFO_OBJECT (demux, "sink segment configured %" GST_SEGMENT_FORMAT
       ", trying to go at SCR: %" G_GUINT64_FORMAT, &demux->sink_segment, scr);
 
-  offset =
-      find_offset (demux, scr, demux->first_scr, demux->first_scr_offset,
-      demux->last_scr, demux->last_scr_offset, 0);
+  min_scr = demux->first_scr;
+  min_offset = demux->first_scr_offset;
+  max_scr = demux->last_scr;
+  max_offset = demux->last_scr_offset;
+  gst_ps_demux_index_lookup (demux, scr, &min_scr, &min_offset, &max_scr,
+      &max_offset);
+
+  GST_DEBUG_OBJECT (demux, "searching between offsets %" G_GUINT64_FORMAT
+      " and %" G_GUINT64_FORMAT, min_offset, max_offset);
+
+  offset = find_offset (demux, scr, min_scr, min_offset, max_scr, max_offset,
+      0);
 
   if (offset == (guint64) - 1) {
     return FALSE;
@@ -1448,6 +1656,16 @@ gst_ps_demux_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       res = TRUE;
       break;
     }
+    case GST_EVENT_CUSTOM_UPSTREAM:
+      /* Applications can hand back an index they saved from a previous run */
+      if (gst_event_has_name (event, INDEX_STRUCTURE_NAME)) {
+        res = gst_ps_demux_index_merge_structure (demux,
+            gst_event_get_structure (event));
+        gst_event_unref (event);
+        break;
+      }
+      res = gst_pad_push_event (demux->sinkpad, event);
+      break;
     default:
       res = gst_pad_push_event (demux->sinkpad, event);
       break;
@@ -1632,6 +1850,19 @@ gst_ps_demux_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
       res = TRUE;
       break;
     }
+    case GST_QUERY_CUSTOM:{
+      const GstStructure *s = gst_query_get_structure (query);
+
+      /* Hand out the SCR index so applications can persist it */
+      if (s && gst_structure_has_name (s, INDEX_STRUCTURE_NAME)) {
+        gst_ps_demux_index_fill_structure (demux,
+            gst_query_writable_structure (query));
+        res = TRUE;
+        break;
+      }
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+    }
     default:
       res = gst_pad_query_default (pad, parent, query);
       break;
@@ -1803,6 +2034,9 @@ gst_ps_demux_parse_pack_start (GstPsDemux * demux)
     data += 8;
   }
 
+  if (demux->adapter_offset != G_MAXUINT64)
+    gst_ps_demux_index_add (demux, scr, demux->adapter_offset);
+
   if (demux->ignore_scr) {
     /* update only first/current_scr with raw scr value to start streaming
      * after parsing 2 seconds long data with no-more-pad */
@@ -2765,6 +2999,8 @@ gst_ps_demux_scan_forward_ts (GstPsDemux * demux, guint64 * pos,
       offset += cursor;
     }
   } while (!found && offset < demux->sink_segment.stop);
+  if (found && mode == SCAN_SCR)
+    gst_ps_demux_index_add (demux, *rts, *pos);
   return found;
 }
 
@@ -2825,6 +3061,8 @@ gst_ps_demux_scan_backward_ts (GstPsDemux * demux, guint64 * pos,
     }
 
   } while (!found && offset > 0);
+  if (found && mode == SCAN_SCR)
+    gst_ps_demux_index_add (demux, *rts, *pos);
   return found;
 }
 
@@ -2909,6 +3147,14 @@ gst_ps_sink_get_duration (GstPsDemux * demux)
         break;
       }
     }
+    /* Don't keep the bogus first SCR around in the index */
+    GST_OBJECT_LOCK (demux);
+    g_array_set_size (demux->index, 0);
+    gst_ps_demux_index_add_unlocked (demux, demux->first_scr,
+        demux->first_scr_offset);
+    gst_ps_demux_index_add_unlocked (demux, demux->last_scr,
+        demux->last_scr_offset);
+    GST_OBJECT_UNLOCK (demux);
   }
   /* Set the base_time and avg rate */
   demux->base_time = MPEGTIME_TO_GSTTIME (demux->first_scr);
@@ -134,6 +134,10 @@ struct _GstPsDemux
   guint64 last_scr_offset;
   guint64 cur_scr_offset;
 
+  /* sparse SCR -> byte offset index, GstPsDemuxIndexEntry sorted on both,
+   * protected by the object lock */
+  GArray *index;
+
   guint64 first_pts;
   guint64 last_pts;
 
@@ -54,6 +54,9 @@
 #include "mxfdemux.h"
 #include "mxfessence.h"
 
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
 static GstStaticPadTemplate mxf_sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -124,13 +127,18 @@ gst_mxf_demux_pad_init (GstMXFDemuxPad * pad)
 }
 
 #define DEFAULT_MAX_DRIFT 100 * GST_MSECOND
+#define DEFAULT_INDEX_CACHE_DIR NULL
+#define DEFAULT_READ_AHEAD (1024 * 1024)
+#define READ_AHEAD_ALIGN 4096
 
 enum
 {
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_INDEX_CACHE_DIR,
+  PROP_READ_AHEAD
 };
 
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstObject * parent,
@@ -253,6 +261,14 @@ gst_mxf_demux_reset_metadata (GstMXFDemux * demux)
   g_rw_lock_writer_unlock (&demux->metadata_lock);
 }
 
+static void
+index_table_free (GstMXFDemuxIndexTable * t)
+{
+  g_array_free (t->segments, TRUE);
+  g_array_free (t->reverse_temporal_offsets, TRUE);
+  g_free (t);
+}
+
 static void
 gst_mxf_demux_reset (GstMXFDemux * demux)
 {
@@ -299,20 +315,14 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
     demux->pending_index_table_segments = NULL;
   }
 
-  if (demux->index_tables) {
-    GList *l;
+  g_ptr_array_set_size (demux->index_tables, 0);
 
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *t = l->data;
-      g_array_free (t->segments, TRUE);
-      g_array_free (t->reverse_temporal_offsets, TRUE);
-      g_free (t);
-    }
-    g_list_free (demux->index_tables);
-    demux->index_tables = NULL;
-  }
+  gst_buffer_replace (&demux->pull_cache, NULL);
+  demux->pull_cache_offset = 0;
+  demux->pull_filesize = -1;
 
   demux->index_table_segments_collected = FALSE;
+  demux->random_index_pack_walked = FALSE;
 
   gst_mxf_demux_reset_mxf_state (demux);
   gst_mxf_demux_reset_metadata (demux);
@@ -326,6 +336,56 @@ gst_mxf_demux_pull_range (GstMXFDemux * demux, guint64 offset,
     guint size, GstBuffer ** buffer)
 {
   GstFlowReturn ret;
+  guint64 start;
+
+  /* Serve the range from the read-ahead window if possible. The returned
+   * buffer shares the memory of the window, nothing is copied */
+  if (demux->pull_cache && offset >= demux->pull_cache_offset
+      && offset + size <= demux->pull_cache_offset +
+      gst_buffer_get_size (demux->pull_cache)) {
+    *buffer = gst_buffer_copy_region (demux->pull_cache,
+        GST_BUFFER_COPY_MEMORY, offset - demux->pull_cache_offset, size);
+    return GST_FLOW_OK;
+  }
+
+  /* Small ranges (KLV headers, metadata, index segments, system items and
+   * most essence) are grouped into one large aligned pull */
+  start = offset - offset % READ_AHEAD_ALIGN;
+  if (demux->read_ahead && size + (offset - start) <= demux->read_ahead) {
+    GstBuffer *window = NULL;
+    guint window_size = demux->read_ahead;
+    gint64 filesize;
+
+    /* Not all sources return short buffers at the end of the file. The size
+     * is only queried again after a seek or EOS */
+    if (demux->pull_filesize == -1) {
+      if (!gst_pad_peer_query_duration (demux->sinkpad, GST_FORMAT_BYTES,
+              &demux->pull_filesize) || demux->pull_filesize < 0)
+        demux->pull_filesize = 0;
+    }
+    filesize = demux->pull_filesize;
+    if (filesize > 0 && filesize >= offset + size
+        && filesize - start < window_size)
+      window_size = filesize - start;
+
+    ret = gst_pad_pull_range (demux->sinkpad, start, window_size, &window);
+    if (ret == GST_FLOW_OK) {
+      GST_LOG_OBJECT (demux, "Pulled %" G_GSIZE_FORMAT " bytes read-ahead "
+          "window at offset %" G_GUINT64_FORMAT, gst_buffer_get_size (window),
+          start);
+      gst_buffer_replace (&demux->pull_cache, NULL);
+      demux->pull_cache = window;
+      demux->pull_cache_offset = start;
+
+      if (offset + size <= start + gst_buffer_get_size (window)) {
+        *buffer = gst_buffer_copy_region (window, GST_BUFFER_COPY_MEMORY,
+            offset - start, size);
+        return GST_FLOW_OK;
+      }
+    }
+    /* Else we're at the end of the file, or upstream doesn't like the
+     * window. Do the exact pull to get the same result as without it */
+  }
 
   ret = gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
@@ -2072,22 +2132,65 @@ get_partition_for_stream_offset (GstMXFDemux * demux,
   return offset_partition;
 }
 
+/* Binary search in the (sorted) index tables. Returns TRUE if the table for
+ * @body_sid / @index_sid exists, and sets @idx to its position or to the
+ * position at which it should be inserted */
+static gboolean
+find_index_table (GstMXFDemux * demux, guint32 body_sid, guint32 index_sid,
+    guint * idx)
+{
+  GstMXFDemuxIndexTable *t;
+  guint lo = 0, hi = demux->index_tables->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    t = g_ptr_array_index (demux->index_tables, mid);
+    if (t->body_sid < body_sid || (t->body_sid == body_sid
+            && t->index_sid < index_sid))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  *idx = lo;
+  if (lo == demux->index_tables->len)
+    return FALSE;
+
+  t = g_ptr_array_index (demux->index_tables, lo);
+  return t->body_sid == body_sid && t->index_sid == index_sid;
+}
+
 static GstMXFDemuxIndexTable *
 get_track_index_table (GstMXFDemux * demux, GstMXFDemuxEssenceTrack * etrack)
 {
-  GList *l;
+  guint idx;
 
-  /* Look in the indextables */
-  for (l = demux->index_tables; l; l = l->next) {
-    GstMXFDemuxIndexTable *tmp = l->data;
+  if (!find_index_table (demux, etrack->body_sid, etrack->index_sid, &idx))
+    return NULL;
 
-    if (tmp->body_sid == etrack->body_sid
-        && tmp->index_sid == etrack->index_sid) {
-      return tmp;
-    }
+  return g_ptr_array_index (demux->index_tables, idx);
+}
+
+/* Returns the position of the last segment of @segments starting at or
+ * before @position, or -1 if there is none */
+static gint
+find_index_table_segment (GArray * segments, gint64 position)
+{
+  guint lo = 0, hi = segments->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    MXFIndexTableSegment *s =
+        &g_array_index (segments, MXFIndexTableSegment, mid);
+
+    if (s->index_start_position <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
 
-  return NULL;
+  return (gint) lo - 1;
 }
 
 static guint32
@@ -2174,7 +2277,7 @@ find_edit_entry (GstMXFDemux * demux, GstMXFDemuxEssenceTrack * etrack,
     gint64 position, gboolean keyframe, GstMXFDemuxIndex * entry)
 {
   GstMXFDemuxIndexTable *index_table = NULL;
-  guint i;
+  gint i;
   MXFIndexTableSegment *segment = NULL;
   GstMXFDemuxPartition *offset_partition = NULL;
   guint64 stream_offset = G_MAXUINT64, absolute_offset;
@@ -2224,15 +2327,18 @@ find_edit_entry (GstMXFDemux * demux, GstMXFDemuxEssenceTrack * etrack,
 
 search_in_segment:
 
-  /* Find matching index segment */
+  /* Find matching index segment. Segments are sorted by start position, so
+   * the candidate is the last one starting at or before the position. Only
+   * if it doesn't cover it, go back to earlier open-ended segments */
   GST_DEBUG_OBJECT (demux, "Look for entry in %d segments",
       index_table->segments->len);
-  for (i = 0; i < index_table->segments->len; i++) {
+  segment = NULL;
+  for (i = find_index_table_segment (index_table->segments, position); i >= 0;
+      i--) {
     MXFIndexTableSegment *cand =
         &g_array_index (index_table->segments, MXFIndexTableSegment, i);
-    if (position >= cand->index_start_position && (cand->index_duration == 0
-            || position <
-            (cand->index_start_position + cand->index_duration))) {
+    if (cand->index_duration == 0
+        || position < (cand->index_start_position + cand->index_duration)) {
       GST_DEBUG_OBJECT (demux,
           "Entry is in Segment #%d , start: %" G_GINT64_FORMAT " , duration: %"
           G_GINT64_FORMAT, i, cand->index_start_position, cand->index_duration);
@@ -3347,13 +3453,50 @@ has_table_segment (GArray * segments, MXFIndexTableSegment * target)
 }
 #endif
 
+/* Queues @segment for collection, unless it was already seen. Takes ownership
+ * of @segment */
+static void
+gst_mxf_demux_add_index_table_segment (GstMXFDemux * demux,
+    MXFIndexTableSegment * segment)
+{
+  guint idx;
+
+  /* Drop it if we already saw it. Ideally we should be able to do this before
+     parsing (by checking instance UID) */
+  if (g_list_find_custom (demux->pending_index_table_segments, segment,
+          (GCompareFunc) compare_index_table_segment)) {
+    GST_DEBUG_OBJECT (demux, "Already in pending list");
+    goto drop;
+  }
+  if (find_index_table (demux, segment->body_sid, segment->index_sid, &idx)) {
+    GstMXFDemuxIndexTable *table = g_ptr_array_index (demux->index_tables, idx);
+#if !GLIB_CHECK_VERSION (2, 62, 0)
+    if (has_table_segment (table->segments, segment)) {
+#else
+    if (g_array_binary_search (table->segments, segment,
+            (GCompareFunc) compare_index_table_segment, NULL)) {
+#endif
+      GST_DEBUG_OBJECT (demux, "Already handled");
+      goto drop;
+    }
+  }
+
+  demux->pending_index_table_segments =
+      g_list_insert_sorted (demux->pending_index_table_segments, segment,
+      (GCompareFunc) compare_index_table_segment);
+  return;
+
+drop:
+  mxf_index_table_segment_reset (segment);
+  g_free (segment);
+}
+
 static GstFlowReturn
 gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux, GstMXFKLV * klv)
 {
   MXFIndexTableSegment *segment;
   GstMapInfo map;
   gboolean ret;
-  GList *tmp;
   GstFlowReturn flowret;
 
   flowret = gst_mxf_demux_fill_klv (demux, klv);
@@ -3376,31 +3519,7 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux, GstMXFKLV * klv)
     return GST_FLOW_ERROR;
   }
 
-  /* Drop it if we already saw it. Ideally we should be able to do this before
-     parsing (by checking instance UID) */
-  if (g_list_find_custom (demux->pending_index_table_segments, segment,
-          (GCompareFunc) compare_index_table_segment)) {
-    GST_DEBUG_OBJECT (demux, "Already in pending list");
-    g_free (segment);
-    return GST_FLOW_OK;
-  }
-  for (tmp = demux->index_tables; tmp; tmp = tmp->next) {
-    GstMXFDemuxIndexTable *table = (GstMXFDemuxIndexTable *) tmp->data;
-#if !GLIB_CHECK_VERSION (2, 62, 0)
-    if (has_table_segment (table->segments, segment)) {
-#else
-    if (g_array_binary_search (table->segments, segment,
-            (GCompareFunc) compare_index_table_segment, NULL)) {
-#endif
-      GST_DEBUG_OBJECT (demux, "Already handled");
-      g_free (segment);
-      return GST_FLOW_OK;
-    }
-  }
-
-  demux->pending_index_table_segments =
-      g_list_insert_sorted (demux->pending_index_table_segments, segment,
-      (GCompareFunc) compare_index_table_segment);
+  gst_mxf_demux_add_index_table_segment (demux, segment);
 
   return GST_FLOW_OK;
 }
@@ -4379,6 +4498,9 @@ pause:
     gst_pad_pause_task (pad);
 
     if (flow == GST_FLOW_EOS) {
+      /* the file might have grown when playing it again */
+      demux->pull_filesize = -1;
+
       /* perform EOS logic */
       if (demux->src->len == 0) {
         GST_ELEMENT_ERROR (demux, STREAM, WRONG_TYPE,
@@ -4945,6 +5067,338 @@ no_new_offset:
   }
 }
 
+/* Index cache file layout, all integers big-endian as in MXF itself:
+ *   guint32 magic, guint32 version
+ *   guint32 number of partitions, then for each:
+ *     guint64 essence container offset, guint32 size, partition pack KLV
+ *   guint32 number of index table segments, then for each:
+ *     guint32 size, index table segment KLV
+ */
+#define INDEX_CACHE_MAGIC 0x474d5849    /* "GMXI" */
+#define INDEX_CACHE_VERSION 1
+
+/* Returns the cache file for the current file, or NULL if caching is disabled
+ * or the file can't be identified */
+static gchar *
+gst_mxf_demux_get_index_cache_path (GstMXFDemux * demux)
+{
+  GChecksum *checksum;
+  GstQuery *query;
+  gchar *cache_dir, *uri = NULL, *filename = NULL, *name, *path;
+  gint64 filesize = -1;
+  GStatBuf st;
+  guint8 data[12];
+  guint i;
+
+  GST_OBJECT_LOCK (demux);
+  cache_dir = g_strdup (demux->index_cache_dir);
+  GST_OBJECT_UNLOCK (demux);
+
+  if (!cache_dir || !demux->random_index_pack)
+    goto no_path;
+
+  if (!gst_pad_peer_query_duration (demux->sinkpad, GST_FORMAT_BYTES,
+          &filesize) || filesize <= 0)
+    goto no_path;
+
+  query = gst_query_new_uri ();
+  if (gst_pad_peer_query (demux->sinkpad, query))
+    gst_query_parse_uri (query, &uri);
+  gst_query_unref (query);
+
+  /* Only local files have a modification time telling whether they were
+   * rewritten since the cache entry was stored */
+  if (uri)
+    filename = g_filename_from_uri (uri, NULL, NULL);
+  if (!filename || g_stat (filename, &st) != 0) {
+    GST_DEBUG_OBJECT (demux, "Can't get the modification time of %s",
+        GST_STR_NULL (uri));
+    g_free (filename);
+    g_free (uri);
+    goto no_path;
+  }
+  g_free (filename);
+
+  /* The file is identified by its size, its modification time, its RIP
+   * (which lists the offsets of all partitions) and its URI */
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+  GST_WRITE_UINT64_BE (data, filesize);
+  g_checksum_update (checksum, data, 8);
+  GST_WRITE_UINT64_BE (data, (gint64) st.st_mtime);
+  g_checksum_update (checksum, data, 8);
+  GST_WRITE_UINT64_BE (data, demux->run_in);
+  g_checksum_update (checksum, data, 8);
+  for (i = 0; i < demux->random_index_pack->len; i++) {
+    MXFRandomIndexPackEntry *e =
+        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+
+    GST_WRITE_UINT32_BE (data, e->body_sid);
+    GST_WRITE_UINT64_BE (data + 4, e->offset);
+    g_checksum_update (checksum, data, 12);
+  }
+  g_checksum_update (checksum, (const guchar *) uri, -1);
+
+  name = g_strconcat (g_checksum_get_string (checksum), ".mxfidx", NULL);
+  path = g_build_filename (cache_dir, name, NULL);
+
+  g_checksum_free (checksum);
+  g_free (name);
+  g_free (uri);
+  g_free (cache_dir);
+
+  return path;
+
+no_path:
+  g_free (cache_dir);
+  return NULL;
+}
+
+static void
+index_cache_put_klv (GstByteWriter * bw, GstBuffer * buffer)
+{
+  GstMapInfo map;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  gst_byte_writer_put_uint32_be (bw, map.size);
+  gst_byte_writer_put_data (bw, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+}
+
+static gboolean
+index_cache_get_klv (GstByteReader * br, MXFUL * key, const guint8 ** data,
+    guint * size)
+{
+  const guint8 *klv;
+  guint32 klv_size;
+  guint offset;
+
+  if (!gst_byte_reader_get_uint32_be (br, &klv_size) ||
+      !gst_byte_reader_get_data (br, klv_size, &klv) || klv_size < 17)
+    return FALSE;
+
+  memcpy (key, klv, 16);
+  offset = 17 + ((klv[16] & 0x80) ? (klv[16] & 0x7f) : 0);
+  if (offset > klv_size)
+    return FALSE;
+
+  *data = klv + offset;
+  *size = klv_size - offset;
+
+  return TRUE;
+}
+
+/* Stores the partitions and index table segments found by walking the RIP */
+static void
+gst_mxf_demux_store_index_cache (GstMXFDemux * demux)
+{
+  GstByteWriter bw;
+  GError *err = NULL;
+  gchar *path, *dir;
+  guint8 *data;
+  guint i, j, n_segments = 0;
+  gsize size;
+  GList *l;
+
+  path = gst_mxf_demux_get_index_cache_path (demux);
+  if (!path)
+    return;
+
+  gst_byte_writer_init (&bw);
+  gst_byte_writer_put_uint32_be (&bw, INDEX_CACHE_MAGIC);
+  gst_byte_writer_put_uint32_be (&bw, INDEX_CACHE_VERSION);
+
+  gst_byte_writer_put_uint32_be (&bw, g_list_length (demux->partitions));
+  for (l = demux->partitions; l; l = l->next) {
+    GstMXFDemuxPartition *p = l->data;
+
+    gst_byte_writer_put_uint64_be (&bw, p->essence_container_offset);
+    index_cache_put_klv (&bw, mxf_partition_pack_to_buffer (&p->partition));
+  }
+
+  for (i = 0; i < demux->index_tables->len; i++) {
+    GstMXFDemuxIndexTable *t = g_ptr_array_index (demux->index_tables, i);
+
+    for (j = 0; j < t->segments->len; j++) {
+      MXFIndexTableSegment *s =
+          &g_array_index (t->segments, MXFIndexTableSegment, j);
+
+      /* Segments are written back with 2 byte local set lengths */
+      if (s->n_delta_entries * 6 >= G_MAXUINT16 ||
+          s->n_index_entries * (11 + 4 * s->slice_count +
+              8 * s->pos_table_count) >= G_MAXUINT16) {
+        GST_DEBUG_OBJECT (demux, "Index table segment too large to be cached");
+        gst_byte_writer_reset (&bw);
+        g_free (path);
+        return;
+      }
+      n_segments++;
+    }
+  }
+
+  gst_byte_writer_put_uint32_be (&bw, n_segments);
+  for (i = 0; i < demux->index_tables->len; i++) {
+    GstMXFDemuxIndexTable *t = g_ptr_array_index (demux->index_tables, i);
+
+    for (j = 0; j < t->segments->len; j++) {
+      MXFIndexTableSegment *s =
+          &g_array_index (t->segments, MXFIndexTableSegment, j);
+
+      index_cache_put_klv (&bw, mxf_index_table_segment_to_buffer (s));
+    }
+  }
+
+  size = gst_byte_writer_get_size (&bw);
+  data = gst_byte_writer_reset_and_get_data (&bw);
+
+  dir = g_path_get_dirname (path);
+  g_mkdir_with_parents (dir, 0755);
+  g_free (dir);
+
+  /* Written to a temporary file and renamed, so concurrent readers never see
+   * a partial cache */
+  if (!g_file_set_contents (path, (const gchar *) data, size, &err)) {
+    GST_WARNING_OBJECT (demux, "Failed to store index cache %s: %s", path,
+        err->message);
+    g_clear_error (&err);
+  } else {
+    GST_DEBUG_OBJECT (demux, "Stored index cache %s (%u partitions, %u "
+        "segments)", path, g_list_length (demux->partitions), n_segments);
+  }
+
+  g_free (data);
+  g_free (path);
+}
+
+/* Adds a partition from the index cache, the same way walking the RIP would
+ * have. Takes ownership of @pack */
+static void
+gst_mxf_demux_restore_partition (GstMXFDemux * demux, MXFPartitionPack * pack,
+    guint64 essence_container_offset)
+{
+  GstMXFDemuxPartition *p = NULL;
+  GList *l;
+
+  for (l = demux->partitions; l; l = l->next) {
+    GstMXFDemuxPartition *tmp = l->data;
+
+    if (tmp->partition.this_partition == pack->this_partition) {
+      p = tmp;
+      break;
+    }
+  }
+
+  if (p) {
+    mxf_partition_pack_reset (pack);
+  } else {
+    p = g_new0 (GstMXFDemuxPartition, 1);
+    memcpy (&p->partition, pack, sizeof (MXFPartitionPack));
+    demux->partitions =
+        g_list_insert_sorted (demux->partitions, p,
+        (GCompareFunc) gst_mxf_demux_partition_compare);
+
+    if (p->partition.type == MXF_PARTITION_PACK_HEADER)
+      demux->footer_partition_pack_offset = p->partition.footer_partition;
+
+    gst_mxf_demux_partition_postcheck (demux, p);
+  }
+
+  if (p->essence_container_offset == 0)
+    p->essence_container_offset = essence_container_offset;
+}
+
+/* Restores the partitions and index table segments of the current file from
+ * the index cache. Returns FALSE if there is no (valid) cache entry */
+static gboolean
+gst_mxf_demux_load_index_cache (GstMXFDemux * demux)
+{
+  GstByteReader br;
+  gchar *path, *contents = NULL;
+  gsize length;
+  guint32 magic, version, n;
+  guint i;
+  GList *l;
+
+  path = gst_mxf_demux_get_index_cache_path (demux);
+  if (!path)
+    return FALSE;
+
+  if (!g_file_get_contents (path, &contents, &length, NULL)) {
+    GST_DEBUG_OBJECT (demux, "No index cache %s", path);
+    g_free (path);
+    return FALSE;
+  }
+
+  gst_byte_reader_init (&br, (const guint8 *) contents, length);
+  if (!gst_byte_reader_get_uint32_be (&br, &magic) ||
+      !gst_byte_reader_get_uint32_be (&br, &version) ||
+      magic != INDEX_CACHE_MAGIC || version != INDEX_CACHE_VERSION)
+    goto invalid;
+
+  if (!gst_byte_reader_get_uint32_be (&br, &n))
+    goto invalid;
+
+  for (i = 0; i < n; i++) {
+    MXFPartitionPack pack;
+    guint64 essence_container_offset;
+    const guint8 *data;
+    guint size;
+    MXFUL key;
+
+    if (!gst_byte_reader_get_uint64_be (&br, &essence_container_offset) ||
+        !index_cache_get_klv (&br, &key, &data, &size) ||
+        !mxf_is_partition_pack (&key) ||
+        !mxf_partition_pack_parse (&key, &pack, data, size))
+      goto invalid;
+
+    gst_mxf_demux_restore_partition (demux, &pack, essence_container_offset);
+  }
+
+  for (l = demux->partitions; l && l->next; l = l->next) {
+    GstMXFDemuxPartition *a = l->data, *b = l->next->data;
+
+    b->partition.prev_partition = a->partition.this_partition;
+  }
+
+  if (!gst_byte_reader_get_uint32_be (&br, &n))
+    goto invalid;
+
+  for (i = 0; i < n; i++) {
+    MXFIndexTableSegment *segment;
+    const guint8 *data;
+    guint size;
+    MXFUL key;
+
+    if (!index_cache_get_klv (&br, &key, &data, &size) ||
+        !mxf_is_index_table_segment (&key))
+      goto invalid;
+
+    segment = g_new0 (MXFIndexTableSegment, 1);
+    if (!mxf_index_table_segment_parse (&key, segment, data, size)) {
+      g_free (segment);
+      goto invalid;
+    }
+
+    gst_mxf_demux_add_index_table_segment (demux, segment);
+  }
+
+  GST_DEBUG_OBJECT (demux, "Restored %u index table segments from %s", n,
+      path);
+
+  g_free (contents);
+  g_free (path);
+
+  return TRUE;
+
+invalid:
+  /* Anything restored so far is also what walking the RIP would find */
+  GST_WARNING_OBJECT (demux, "Invalid index cache %s", path);
+  g_free (contents);
+  g_free (path);
+
+  return FALSE;
+}
+
 static void
 collect_index_table_segments (GstMXFDemux * demux)
 {
@@ -4952,29 +5406,39 @@ collect_index_table_segments (GstMXFDemux * demux)
   guint i;
   guint64 old_offset = demux->offset;
   GstMXFDemuxPartition *old_partition = demux->current_partition;
+  gboolean store_index_cache = FALSE;
 
   /* This function can also be called when a RIP is not present. This can happen
    * if index table segments were discovered while scanning the file */
-  if (demux->random_index_pack) {
-    for (i = 0; i < demux->random_index_pack->len; i++) {
-      MXFRandomIndexPackEntry *e =
-          &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+  if (demux->random_index_pack && !demux->random_index_pack_walked) {
+    if (gst_mxf_demux_load_index_cache (demux)) {
+      demux->random_index_pack_walked = TRUE;
+    } else {
+      for (i = 0; i < demux->random_index_pack->len; i++) {
+        MXFRandomIndexPackEntry *e =
+            &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry,
+            i);
 
-      if (e->offset < demux->run_in) {
-        GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
-        return;
+        if (e->offset < demux->run_in) {
+          GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
+          return;
+        }
+
+        demux->offset = e->offset;
+        read_partition_header (demux);
       }
 
-      demux->offset = e->offset;
-      read_partition_header (demux);
+      demux->offset = old_offset;
+      demux->current_partition = old_partition;
+      demux->random_index_pack_walked = TRUE;
+      store_index_cache = TRUE;
     }
-
-    demux->offset = old_offset;
-    demux->current_partition = old_partition;
   }
 
   if (demux->pending_index_table_segments == NULL) {
     GST_DEBUG_OBJECT (demux, "No pending index table segments to collect");
+    if (store_index_cache)
+      gst_mxf_demux_store_index_cache (demux);
     return;
   }
 
@@ -4983,8 +5447,7 @@ collect_index_table_segments (GstMXFDemux * demux)
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *segment = l->data;
     GstMXFDemuxIndexTable *t = NULL;
-    GList *k;
-    guint didx;
+    guint didx, idx;
 #ifndef GST_DISABLE_GST_DEBUG
     gchar str[48];
 #endif
@@ -4994,17 +5457,9 @@ collect_index_table_segments (GstMXFDemux * demux)
         segment->body_sid, segment->index_sid,
         mxf_uuid_to_string (&segment->instance_id, str));
 
-    for (k = demux->index_tables; k; k = k->next) {
-      GstMXFDemuxIndexTable *tmp = k->data;
-
-      if (tmp->body_sid == segment->body_sid
-          && tmp->index_sid == segment->index_sid) {
-        t = tmp;
-        break;
-      }
-    }
-
-    if (!t) {
+    if (find_index_table (demux, segment->body_sid, segment->index_sid, &idx)) {
+      t = g_ptr_array_index (demux->index_tables, idx);
+    } else {
       t = g_new0 (GstMXFDemuxIndexTable, 1);
       t->body_sid = segment->body_sid;
       t->index_sid = segment->index_sid;
@@ -5014,11 +5469,13 @@ collect_index_table_segments (GstMXFDemux * demux)
           (GDestroyNotify) mxf_index_table_segment_reset);
       t->reordered_delta_entry = -1;
       t->reverse_temporal_offsets = g_array_new (FALSE, TRUE, 1);
-      demux->index_tables = g_list_prepend (demux->index_tables, t);
+      g_ptr_array_insert (demux->index_tables, idx, t);
     }
 
-    /* Store index segment */
-    g_array_append_val (t->segments, *segment);
+    /* Store index segment, keeping them sorted by start position */
+    idx = find_index_table_segment (t->segments,
+        segment->index_start_position) + 1;
+    g_array_insert_val (t->segments, idx, *segment);
 
     /* Check if temporal reordering tables should be pre-calculated */
     for (didx = 0; didx < segment->n_delta_entries; didx++) {
@@ -5038,8 +5495,8 @@ collect_index_table_segments (GstMXFDemux * demux)
   }
 
   /* Handle temporal offset if present and needed */
-  for (l = demux->index_tables; l; l = l->next) {
-    GstMXFDemuxIndexTable *table = l->data;
+  for (i = 0; i < demux->index_tables->len; i++) {
+    GstMXFDemuxIndexTable *table = g_ptr_array_index (demux->index_tables, i);
     guint segidx;
 
     /* No reordered entries, skip */
@@ -5093,6 +5550,9 @@ collect_index_table_segments (GstMXFDemux * demux)
   g_list_free_full (demux->pending_index_table_segments, g_free);
   demux->pending_index_table_segments = NULL;
 
+  if (store_index_cache)
+    gst_mxf_demux_store_index_cache (demux);
+
   GST_DEBUG_OBJECT (demux, "Done collecting segments");
 }
 
@@ -5153,6 +5613,8 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
   /* Take the stream lock */
   GST_PAD_STREAM_LOCK (demux->sinkpad);
 
+  demux->pull_filesize = -1;
+
   if (flush) {
     GstEvent *e;
 
@@ -5913,6 +6375,15 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_INDEX_CACHE_DIR:
+      GST_OBJECT_LOCK (demux);
+      g_free (demux->index_cache_dir);
+      demux->index_cache_dir = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_READ_AHEAD:
+      demux->read_ahead = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5932,6 +6403,14 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       g_value_set_uint64 (value, demux->max_drift);
       break;
+    case PROP_INDEX_CACHE_DIR:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_string (value, demux->index_cache_dir);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_READ_AHEAD:
+      g_value_set_uint (value, demux->read_ahead);
+      break;
     case PROP_STRUCTURE:{
       GstStructure *s;
 
@@ -5983,9 +6462,13 @@ gst_mxf_demux_finalize (GObject * object)
   demux->current_package_string = NULL;
   g_free (demux->requested_package_string);
   demux->requested_package_string = NULL;
+  g_free (demux->index_cache_dir);
+  demux->index_cache_dir = NULL;
 
   g_ptr_array_free (demux->src, TRUE);
   demux->src = NULL;
+  g_ptr_array_free (demux->index_tables, TRUE);
+  demux->index_tables = NULL;
   g_array_free (demux->essence_tracks, TRUE);
   demux->essence_tracks = NULL;
 
@@ -6026,6 +6509,37 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMXFDemux:index-cache-dir:
+   *
+   * Directory in which the partitions and index table segments of files
+   * with a random index pack are cached. Opening the same file again then
+   * skips walking all its partitions. The cache entries are keyed on the
+   * URI, size and modification time of the file and on the random index
+   * pack, so only local files are cached.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_CACHE_DIR,
+      g_param_spec_string ("index-cache-dir", "Index cache directory",
+          "Directory in which to cache the index of files (NULL = disabled)",
+          DEFAULT_INDEX_CACHE_DIR, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMXFDemux:read-ahead:
+   *
+   * In pull mode, reads of up to this many bytes are grouped into a single
+   * pull from upstream. The KLV packets inside of it are then parsed and
+   * pushed downstream as sub-buffers of that window, without copying.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD,
+      g_param_spec_uint ("read-ahead", "Read ahead",
+          "Size of the read-ahead window in pull mode in bytes (0 = disabled)",
+          0, G_MAXINT, DEFAULT_READ_AHEAD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
@@ -6057,6 +6571,8 @@ gst_mxf_demux_init (GstMXFDemux * demux)
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 
   demux->max_drift = DEFAULT_MAX_DRIFT;
+  demux->index_cache_dir = g_strdup (DEFAULT_INDEX_CACHE_DIR);
+  demux->read_ahead = DEFAULT_READ_AHEAD;
 
   demux->adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
@@ -6065,6 +6581,8 @@ gst_mxf_demux_init (GstMXFDemux * demux)
   demux->src = g_ptr_array_new ();
   demux->essence_tracks =
       g_array_new (FALSE, FALSE, sizeof (GstMXFDemuxEssenceTrack));
+  demux->index_tables =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) index_table_free);
 
   gst_segment_init (&demux->segment, GST_FORMAT_TIME);
 
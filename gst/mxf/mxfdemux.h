@@ -170,7 +170,7 @@ typedef struct
   guint32 body_sid;
   guint32 index_sid;
 
-  /* Array of MXFIndexTableSegment, sorted by DTS
+  /* Array of MXFIndexTableSegment, sorted by index start position (DTS)
    * Note: Can be empty and can be sparse (i.e. not cover every edit unit) */
   GArray *segments;
 
@@ -254,6 +254,13 @@ struct _GstMXFDemux
 
   guint64 offset;
 
+  /* Pull mode read-ahead window, small pulls are served from sub-buffers of
+   * it */
+  GstBuffer *pull_cache;
+  guint64 pull_cache_offset;
+  /* upstream size in bytes, -1 if not queried yet, 0 if unknown */
+  gint64 pull_filesize;
+
   gboolean random_access;
   gboolean flushing;
 
@@ -269,9 +276,14 @@ struct _GstMXFDemux
   GArray *essence_tracks;
 
   GList *pending_index_table_segments;
-  GList *index_tables; /* one per BodySID / IndexSID */
+  /* GstMXFDemuxIndexTable, one per BodySID / IndexSID, sorted by both */
+  GPtrArray *index_tables;
   gboolean index_table_segments_collected;
 
+  /* TRUE once all partitions listed in the RIP were visited (or restored from
+   * the index cache) */
+  gboolean random_index_pack_walked;
+
   GArray *random_index_pack;
 
   /* Metadata */
@@ -293,6 +305,8 @@ struct _GstMXFDemux
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  gchar *index_cache_dir;
+  guint read_ahead;
 
   /* Quirks */
   gboolean temporal_order_misuse;
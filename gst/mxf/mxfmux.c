@@ -114,9 +114,16 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
     GST_STATIC_CAPS ("application/mxf")
     );
 
+#define DEFAULT_PARTITION_INTERVAL 0
+#define DEFAULT_HEADER_PADDING 0
+#define DEFAULT_WRITE_BATCH_SIZE 0
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_PARTITION_INTERVAL,
+  PROP_HEADER_PADDING,
+  PROP_WRITE_BATCH_SIZE
 };
 
 #define gst_mxf_mux_parent_class parent_class
@@ -125,6 +132,10 @@ GST_ELEMENT_REGISTER_DEFINE_WITH_CODE (mxfmux, "mxfmux", GST_RANK_PRIMARY,
     GST_TYPE_MXF_MUX, mxf_element_init (plugin));
 
 static void gst_mxf_mux_finalize (GObject * object);
+static void gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_mxf_mux_aggregate (GstAggregator * aggregator,
     gboolean timeout);
@@ -139,15 +150,41 @@ static GstAggregatorPad *gst_mxf_mux_create_new_pad (GstAggregator * aggregator,
 
 static void gst_mxf_mux_reset (GstMXFMux * mux);
 
+static GstFlowReturn
+gst_mxf_mux_flush_pending (GstMXFMux * mux)
+{
+  GstBufferList *list = mux->pending_buffers;
+
+  if (!list)
+    return GST_FLOW_OK;
+
+  mux->pending_buffers = NULL;
+  mux->pending_size = 0;
+
+  return gst_aggregator_finish_buffer_list (GST_AGGREGATOR (mux), list);
+}
+
 static GstFlowReturn
 gst_mxf_mux_push (GstMXFMux * mux, GstBuffer * buf)
 {
   guint size = gst_buffer_get_size (buf);
-  GstFlowReturn ret;
+  GstFlowReturn ret = GST_FLOW_OK;
 
-  ret = gst_aggregator_finish_buffer (GST_AGGREGATOR (mux), buf);
   mux->offset += size;
 
+  if (mux->write_batch_size == 0)
+    return gst_aggregator_finish_buffer (GST_AGGREGATOR (mux), buf);
+
+  /* Batch the small KLVs into buffer lists so that downstream gets fewer and
+   * larger writes */
+  if (!mux->pending_buffers)
+    mux->pending_buffers = gst_buffer_list_new ();
+  gst_buffer_list_add (mux->pending_buffers, buf);
+  mux->pending_size += size;
+
+  if (mux->pending_size >= mux->write_batch_size)
+    ret = gst_mxf_mux_flush_pending (mux);
+
   return ret;
 }
 
@@ -166,6 +203,54 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gstaggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_mxf_mux_finalize;
+  gobject_class->set_property = gst_mxf_mux_set_property;
+  gobject_class->get_property = gst_mxf_mux_get_property;
+
+  /**
+   * GstMXFMux:partition-interval:
+   *
+   * Minimum duration of a body partition. New body partitions are started
+   * on keyframes of the first stream, and contain the index table segments
+   * of the essence written before. The file can then be read while it is
+   * growing, and is usable up to the last complete partition if writing
+   * is interrupted.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PARTITION_INTERVAL,
+      g_param_spec_uint64 ("partition-interval", "Partition interval",
+          "Minimum duration of a body partition in nanoseconds "
+          "(0 = a single body partition)", 0, G_MAXUINT64,
+          DEFAULT_PARTITION_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMXFMux:header-padding:
+   *
+   * Number of bytes of fill to reserve after the header metadata, so that
+   * it can be rewritten in place even if it grows. A fill KLV is always
+   * reserved, so a header metadata that shrinks can always be rewritten.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_HEADER_PADDING,
+      g_param_spec_uint ("header-padding", "Header padding",
+          "Number of bytes reserved after the header metadata", 0, G_MAXINT,
+          DEFAULT_HEADER_PADDING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMXFMux:write-batch-size:
+   *
+   * If not 0, the output is collected into buffer lists of at least this
+   * many bytes before being pushed downstream.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_WRITE_BATCH_SIZE,
+      g_param_spec_uint ("write-batch-size", "Write batch size",
+          "Minimum number of bytes to push downstream at once (0 = disabled)",
+          0, G_MAXINT, DEFAULT_WRITE_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstaggregator_class->create_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_create_new_pad);
@@ -196,9 +281,72 @@ static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
   mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->random_index_pack =
+      g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+
+  mux->partition_interval = DEFAULT_PARTITION_INTERVAL;
+  mux->header_padding = DEFAULT_HEADER_PADDING;
+  mux->write_batch_size = DEFAULT_WRITE_BATCH_SIZE;
+
   gst_mxf_mux_reset (mux);
 }
 
+static void
+gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      GST_OBJECT_LOCK (mux);
+      mux->partition_interval = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_HEADER_PADDING:
+      GST_OBJECT_LOCK (mux);
+      mux->header_padding = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_WRITE_BATCH_SIZE:
+      GST_OBJECT_LOCK (mux);
+      mux->write_batch_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      GST_OBJECT_LOCK (mux);
+      g_value_set_uint64 (value, mux->partition_interval);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_HEADER_PADDING:
+      GST_OBJECT_LOCK (mux);
+      g_value_set_uint (value, mux->header_padding);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    case PROP_WRITE_BATCH_SIZE:
+      GST_OBJECT_LOCK (mux);
+      g_value_set_uint (value, mux->write_batch_size);
+      GST_OBJECT_UNLOCK (mux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_mxf_mux_finalize (GObject * object)
 {
@@ -222,6 +370,9 @@ gst_mxf_mux_finalize (GObject * object)
     mux->index_table = NULL;
   }
 
+  g_array_free (mux->random_index_pack, TRUE);
+  mux->random_index_pack = NULL;
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -271,8 +422,21 @@ gst_mxf_mux_reset (GstMXFMux * mux)
       g_free (g_array_index (mux->index_table, MXFIndexTableSegment,
               n).index_entries);
   g_array_set_size (mux->index_table, 0);
-  mux->current_index_pos = 0;
+  mux->n_written_index_segments = 0;
   mux->last_keyframe_pos = 0;
+  mux->max_reorder_delay = 0;
+  memset (mux->pending_temporal_offsets, 0,
+      sizeof (mux->pending_temporal_offsets));
+
+  g_array_set_size (mux->random_index_pack, 0);
+  mux->partition_start_pos = 0;
+  mux->header_metadata_size = 0;
+
+  if (mux->pending_buffers) {
+    gst_buffer_list_unref (mux->pending_buffers);
+    mux->pending_buffers = NULL;
+  }
+  mux->pending_size = 0;
 }
 
 static gboolean
@@ -1156,8 +1320,35 @@ gst_mxf_mux_init_partition_pack (GstMXFMux * mux)
   return GST_FLOW_OK;
 }
 
+/* Smallest fill KLV, with a 4 byte BER length */
+#define MIN_FILL_SIZE (16 + 1 + 4)
+
+/* Creates a fill KLV of exactly @size bytes */
+static GstBuffer *
+gst_mxf_mux_create_fill (guint64 size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  g_assert (size >= MIN_FILL_SIZE && size - MIN_FILL_SIZE <= G_MAXUINT32);
+
+  buf = gst_buffer_new_and_alloc (size);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memcpy (map.data, MXF_UL (FILL), 16);
+  map.data[16] = 0x84;
+  GST_WRITE_UINT32_BE (map.data + 17, size - MIN_FILL_SIZE);
+  memset (map.data + MIN_FILL_SIZE, 0, size - MIN_FILL_SIZE);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+/* Writes the partition pack and the header metadata. In the header partition
+ * the metadata is padded to the size it had when it was first written, so
+ * that it can be rewritten in place. Returns GST_FLOW_CUSTOM_SUCCESS without
+ * writing anything if the rewritten metadata doesn't fit */
 static GstFlowReturn
-gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
+gst_mxf_mux_write_header_metadata (GstMXFMux * mux, gboolean header)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   GstBuffer *buf;
@@ -1173,9 +1364,34 @@ gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
     buffers = g_list_prepend (buffers, buf);
   }
 
-  buffers = g_list_reverse (buffers);
   buf = mxf_primer_pack_to_buffer (&mux->primer);
   header_byte_count += gst_buffer_get_size (buf);
+
+  if (header) {
+    guint64 fill = 0;
+
+    if (mux->header_metadata_size == 0) {
+      fill = MAX (mux->header_padding, MIN_FILL_SIZE);
+      mux->header_metadata_size = header_byte_count + fill;
+    } else if (mux->header_metadata_size != header_byte_count) {
+      if (mux->header_metadata_size < header_byte_count + MIN_FILL_SIZE) {
+        GST_WARNING_OBJECT (mux, "Header metadata of %" G_GUINT64_FORMAT
+            " bytes doesn't fit into the %" G_GUINT64_FORMAT " bytes reserved",
+            header_byte_count, mux->header_metadata_size);
+        gst_buffer_unref (buf);
+        g_list_free_full (buffers, (GDestroyNotify) gst_mini_object_unref);
+        return GST_FLOW_CUSTOM_SUCCESS;
+      }
+      fill = mux->header_metadata_size - header_byte_count;
+    }
+
+    if (fill > 0) {
+      buffers = g_list_prepend (buffers, gst_mxf_mux_create_fill (fill));
+      header_byte_count += fill;
+    }
+  }
+
+  buffers = g_list_reverse (buffers);
   buffers = g_list_prepend (buffers, buf);
 
   mux->partition.header_byte_count = header_byte_count;
@@ -1205,6 +1421,121 @@ gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
   return ret;
 }
 
+#define MAX_INDEX_SEGMENT_SIZE (G_MAXUINT16 / 11)
+#define MIN_INDEX_SEGMENT_ALLOC 16
+
+/* Number of entries allocated for an index table segment that is not written
+ * yet and has @n_entries entries. It grows by doubling */
+static guint
+index_segment_alloc_size (guint n_entries)
+{
+  guint size = MIN_INDEX_SEGMENT_ALLOC;
+
+  while (size < n_entries)
+    size *= 2;
+
+  return MIN (size, MAX_INDEX_SEGMENT_SIZE);
+}
+
+/* Returns the index table segment to add the next entry to, creating a new one
+ * if the last one is full or was already written to a body partition */
+static MXFIndexTableSegment *
+gst_mxf_mux_get_index_segment (GstMXFMux * mux, GstMXFMuxPad * pad)
+{
+  MXFMetadataEssenceContainerData *cdata =
+      mux->preface->content_storage->essence_container_data[0];
+  MXFIndexTableSegment *last = NULL, s;
+
+  if (mux->index_table->len > 0)
+    last = &g_array_index (mux->index_table, MXFIndexTableSegment,
+        mux->index_table->len - 1);
+
+  if (last && last->n_index_entries < MAX_INDEX_SEGMENT_SIZE
+      && mux->n_written_index_segments < mux->index_table->len)
+    return last;
+
+  memset (&s, 0, sizeof (s));
+  mxf_uuid_init (&s.instance_id, mux->metadata);
+  memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
+      sizeof (s.index_edit_rate));
+  s.index_start_position =
+      last ? last->index_start_position + last->n_index_entries : 0;
+  s.index_sid = cdata->index_sid;
+  s.body_sid = cdata->body_sid;
+  s.index_entries = g_new0 (MXFIndexEntry, MIN_INDEX_SEGMENT_ALLOC);
+  g_array_append_val (mux->index_table, s);
+
+  return &g_array_index (mux->index_table, MXFIndexTableSegment,
+      mux->index_table->len - 1);
+}
+
+/* Returns the index entry of the edit unit at @position, or NULL if there is
+ * none yet. @written is set if it is already written to a body partition */
+static MXFIndexEntry *
+gst_mxf_mux_get_index_entry (GstMXFMux * mux, guint64 position,
+    gboolean * written)
+{
+  gint i;
+
+  for (i = mux->index_table->len - 1; i >= 0; i--) {
+    MXFIndexTableSegment *s =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, i);
+
+    if (position < s->index_start_position)
+      continue;
+    if (position >= s->index_start_position + s->n_index_entries)
+      return NULL;
+
+    *written = i < mux->n_written_index_segments;
+    return &s->index_entries[position - s->index_start_position];
+  }
+
+  return NULL;
+}
+
+/* Splits the index table segment that is not written yet and contains
+ * @position, so that the entries before @position can be written while the
+ * ones after it can still be changed */
+static void
+gst_mxf_mux_split_index_segment (GstMXFMux * mux, guint64 position)
+{
+  guint i;
+
+  for (i = mux->n_written_index_segments; i < mux->index_table->len; i++) {
+    MXFIndexTableSegment *s =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, i);
+    MXFIndexTableSegment tail;
+    guint n_head;
+
+    if (position <= s->index_start_position
+        || position >= s->index_start_position + s->n_index_entries)
+      continue;
+
+    n_head = position - s->index_start_position;
+
+    tail = *s;
+    mxf_uuid_init (&tail.instance_id, mux->metadata);
+    tail.index_start_position = position;
+    tail.n_index_entries = s->n_index_entries - n_head;
+    tail.index_duration = tail.n_index_entries;
+    tail.index_entries = g_new0 (MXFIndexEntry,
+        index_segment_alloc_size (tail.n_index_entries));
+    memcpy (tail.index_entries, s->index_entries + n_head,
+        tail.n_index_entries * sizeof (MXFIndexEntry));
+
+    /* The head is complete now */
+    s->n_index_entries = n_head;
+    s->index_duration = n_head;
+    s->index_entries = g_renew (MXFIndexEntry, s->index_entries, n_head);
+
+    g_array_insert_val (mux->index_table, i + 1, tail);
+    return;
+  }
+}
+
+static GstFlowReturn gst_mxf_mux_write_body_partition (GstMXFMux * mux,
+    guint64 index_end);
+
 static const guint8 _gc_essence_element_ul[] = {
   0x06, 0x0e, 0x2b, 0x34, 0x01, 0x02, 0x01, 0x01,
   0x0d, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00
@@ -1273,53 +1604,32 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   /* We currently only index the first essence stream */
   if (pad == (GstMXFMuxPad *) GST_ELEMENT_CAST (mux)->sinkpads->data) {
     MXFIndexTableSegment *segment;
-    const gint max_segment_size = G_MAXUINT16 / 11;
-
-    if (mux->index_table->len == 0 ||
-        g_array_index (mux->index_table, MXFIndexTableSegment,
-            mux->current_index_pos).index_duration >= max_segment_size) {
-
-      if (mux->index_table->len > 0)
-        mux->current_index_pos++;
-
-      if (mux->index_table->len <= mux->current_index_pos) {
-        MXFIndexTableSegment s;
-
-        memset (&segment, 0, sizeof (segment));
-
-        mxf_uuid_init (&s.instance_id, mux->metadata);
-        memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-            sizeof (s.index_edit_rate));
-        if (mux->index_table->len > 0)
-          s.index_start_position =
-              g_array_index (mux->index_table, MXFIndexTableSegment,
-              mux->index_table->len - 1).index_start_position;
-        else
-          s.index_start_position = 0;
-        s.index_duration = 0;
-        s.edit_unit_byte_count = 0;
-        s.index_sid =
-            mux->preface->content_storage->essence_container_data[0]->index_sid;
-        s.body_sid =
-            mux->preface->content_storage->essence_container_data[0]->body_sid;
-        s.slice_count = 0;
-        s.pos_table_count = 0;
-        s.n_delta_entries = 0;
-        s.delta_entries = NULL;
-        s.n_index_entries = 0;
-        s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-        g_array_append_val (mux->index_table, s);
+    MXFIndexEntry *entry;
+
+    /* Start a new body partition on a keyframe once the interval is over */
+    if (mux->partition_interval > 0 && is_keyframe
+        && pad->pos > mux->partition_start_pos
+        && gst_util_uint64_scale (pad->pos - mux->partition_start_pos,
+            pad->source_track->edit_rate.d * GST_SECOND,
+            pad->source_track->edit_rate.n) >= mux->partition_interval) {
+      /* The entries of the last edit units can still get temporal offsets
+       * from frames that are displayed before them but come later. They
+       * are written in the next partition */
+      guint64 index_end = pad->pos - MIN (pad->pos, mux->max_reorder_delay);
+
+      if ((ret = gst_mxf_mux_write_body_partition (mux,
+                  index_end)) != GST_FLOW_OK) {
+        gst_buffer_unref (buf);
+        return ret;
       }
+      mux->partition_start_pos = pad->pos;
     }
-    segment =
-        &g_array_index (mux->index_table, MXFIndexTableSegment,
-        mux->current_index_pos);
+
+    segment = gst_mxf_mux_get_index_segment (mux, pad);
 
     if (dts != GST_CLOCK_TIME_NONE && pts != GST_CLOCK_TIME_NONE) {
       guint64 pts_pos;
-      guint64 pts_index_pos, pts_segment_pos;
       gint64 index_pos_diff;
-      MXFIndexTableSegment *pts_segment;
 
       pts =
           gst_segment_to_running_time (&pad->parent.segment, GST_FORMAT_TIME,
@@ -1328,76 +1638,45 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
           gst_util_uint64_scale_round (pts, pad->source_track->edit_rate.n,
           pad->source_track->edit_rate.d * GST_SECOND);
 
+      /* The entry of the edit unit displayed at pts_pos points to us */
       index_pos_diff = pts_pos - pad->pos;
-      pts_index_pos = mux->current_index_pos;
-      pts_segment_pos = segment->n_index_entries;
-      if (index_pos_diff >= 0) {
-        while (pts_segment_pos + index_pos_diff >= max_segment_size) {
-          index_pos_diff -= max_segment_size - pts_segment_pos;
-          pts_segment_pos = 0;
-          pts_index_pos++;
-
-          if (pts_index_pos >= mux->index_table->len) {
-            MXFIndexTableSegment s;
-
-            memset (&segment, 0, sizeof (segment));
-
-            mxf_uuid_init (&s.instance_id, mux->metadata);
-            memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-                sizeof (s.index_edit_rate));
-            if (mux->index_table->len > 0)
-              s.index_start_position =
-                  g_array_index (mux->index_table, MXFIndexTableSegment,
-                  mux->index_table->len - 1).index_start_position;
-            else
-              s.index_start_position = 0;
-            s.index_duration = 0;
-            s.edit_unit_byte_count = 0;
-            s.index_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->index_sid;
-            s.body_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->body_sid;
-            s.slice_count = 0;
-            s.pos_table_count = 0;
-            s.n_delta_entries = 0;
-            s.delta_entries = NULL;
-            s.n_index_entries = 0;
-            s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-            g_array_append_val (mux->index_table, s);
-          }
-        }
-      } else {
-        while (pts_segment_pos + index_pos_diff <= 0) {
-          if (pts_index_pos == 0) {
-            pts_index_pos = G_MAXUINT64;
-            break;
-          }
-          index_pos_diff += pts_segment_pos;
-          pts_segment_pos = max_segment_size;
-          pts_index_pos--;
+      mux->max_reorder_delay = MAX (mux->max_reorder_delay,
+          (guint64) ABS (index_pos_diff));
+      if (index_pos_diff > 0) {
+        g_assert (index_pos_diff < 127);
+        mux->pending_temporal_offsets[pts_pos % 256] = -index_pos_diff;
+      } else if (index_pos_diff < 0) {
+        gboolean written = FALSE;
+
+        entry = gst_mxf_mux_get_index_entry (mux, pts_pos, &written);
+        if (entry) {
+          g_assert (index_pos_diff >= -127);
+          if (written)
+            GST_WARNING_OBJECT (pad, "Index entry %" G_GUINT64_FORMAT
+                " was already written, temporal offset is lost", pts_pos);
+          entry->temporal_offset = -index_pos_diff;
         }
       }
-      if (pts_index_pos != G_MAXUINT64) {
-        g_assert (index_pos_diff < 127 && index_pos_diff >= -127);
-        pts_segment =
-            &g_array_index (mux->index_table, MXFIndexTableSegment,
-            pts_index_pos);
-        pts_segment->index_entries[pts_segment_pos +
-            index_pos_diff].temporal_offset = -index_pos_diff;
-      }
     }
 
-    /* Leave temporal offset initialized at 0, above code will set it as necessary */
-    ;
+    if (segment->n_index_entries ==
+        index_segment_alloc_size (segment->n_index_entries)) {
+      guint n = index_segment_alloc_size (segment->n_index_entries + 1);
+
+      segment->index_entries = g_renew (MXFIndexEntry, segment->index_entries,
+          n);
+      memset (segment->index_entries + segment->n_index_entries, 0,
+          (n - segment->n_index_entries) * sizeof (MXFIndexEntry));
+    }
+
+    entry = &segment->index_entries[segment->n_index_entries];
+    entry->temporal_offset = mux->pending_temporal_offsets[pad->pos % 256];
+    mux->pending_temporal_offsets[pad->pos % 256] = 0;
     if (is_keyframe)
       mux->last_keyframe_pos = pad->pos;
-    segment->index_entries[segment->n_index_entries].key_frame_offset =
-        MIN (pad->pos - mux->last_keyframe_pos, 127);
-    segment->index_entries[segment->n_index_entries].flags = is_keyframe ? 0x80 : 0x20; /* FIXME: Need to distinguish all the cases */
-    segment->index_entries[segment->n_index_entries].stream_offset =
-        mux->partition.body_offset;
+    entry->key_frame_offset = MIN (pad->pos - mux->last_keyframe_pos, 127);
+    entry->flags = is_keyframe ? 0x80 : 0x20;   /* FIXME: Need to distinguish all the cases */
+    entry->stream_offset = mux->partition.body_offset;
 
     segment->n_index_entries++;
     segment->index_duration++;
@@ -1433,26 +1712,71 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   return ret;
 }
 
+/* Starts a new body partition. The index entries before @index_end that were
+ * not written yet are written into it, so that they are available before the
+ * footer */
 static GstFlowReturn
-gst_mxf_mux_write_body_partition (GstMXFMux * mux)
+gst_mxf_mux_write_body_partition (GstMXFMux * mux, guint64 index_end)
 {
-  GstBuffer *buf;
+  MXFMetadataEssenceContainerData *cdata =
+      mux->preface->content_storage->essence_container_data[0];
+  MXFRandomIndexPackEntry entry;
+  GstFlowReturn ret;
+  GstBuffer *buf, *index;
+  gsize index_byte_count;
+  guint i;
+
+  /* Previous partitions are complete downstream before the next one starts */
+  if ((ret = gst_mxf_mux_flush_pending (mux)) != GST_FLOW_OK)
+    return ret;
+
+  gst_mxf_mux_split_index_segment (mux, index_end);
+
+  index = gst_buffer_new ();
+  for (i = mux->n_written_index_segments; i < mux->index_table->len; i++) {
+    MXFIndexTableSegment *segment =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, i);
+
+    if (segment->index_start_position + segment->n_index_entries > index_end)
+      break;
+
+    index = gst_buffer_append (index,
+        mxf_index_table_segment_to_buffer (segment));
+  }
+  mux->n_written_index_segments = i;
+  index_byte_count = gst_buffer_get_size (index);
 
   mux->partition.type = MXF_PARTITION_PACK_BODY;
   mux->partition.closed = TRUE;
   mux->partition.complete = TRUE;
   mux->partition.this_partition = mux->offset;
-  mux->partition.prev_partition = 0;
+  mux->partition.prev_partition = mux->random_index_pack->len > 0 ?
+      g_array_index (mux->random_index_pack, MXFRandomIndexPackEntry,
+      mux->random_index_pack->len - 1).offset : 0;
   mux->partition.footer_partition = 0;
   mux->partition.header_byte_count = 0;
-  mux->partition.index_byte_count = 0;
-  mux->partition.index_sid = 0;
-  mux->partition.body_offset = 0;
-  mux->partition.body_sid =
-      mux->preface->content_storage->essence_container_data[0]->body_sid;
+  mux->partition.index_byte_count = index_byte_count;
+  mux->partition.index_sid = index_byte_count ? cdata->index_sid : 0;
+  /* body_offset is left as is, it's the essence stream offset at which
+   * this partition starts */
+  mux->partition.body_sid = cdata->body_sid;
+
+  entry.offset = mux->offset;
+  entry.body_sid = cdata->body_sid;
+  g_array_append_val (mux->random_index_pack, entry);
 
   buf = mxf_partition_pack_to_buffer (&mux->partition);
-  return gst_mxf_mux_push (mux, buf);
+  if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+    gst_buffer_unref (index);
+    return ret;
+  }
+
+  if (index_byte_count > 0)
+    ret = gst_mxf_mux_push (mux, index);
+  else
+    gst_buffer_unref (index);
+
+  return ret;
 }
 
 static GstFlowReturn
@@ -1569,9 +1893,8 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
   }
 
   {
-    guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
-    guint64 footer_partition = mux->offset;
+    guint64 body_partition;
+    guint64 footer_partition;
     GArray *rip;
     GstFlowReturn ret;
     GstSegment segment;
@@ -1581,6 +1904,17 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     guint i;
     GstBuffer *buf;
 
+    /* Everything written so far must be downstream before seeking back */
+    if ((ret = gst_mxf_mux_flush_pending (mux)) != GST_FLOW_OK)
+      return ret;
+
+    g_assert (mux->random_index_pack->len >= 2);
+    body_partition = g_array_index (mux->random_index_pack,
+        MXFRandomIndexPackEntry, 1).offset;
+    footer_partition = mux->offset;
+
+    /* The footer carries the complete index, also the segments that were
+     * already written to body partitions */
     for (i = 0; i < mux->index_table->len; i++) {
       MXFIndexTableSegment *segment =
           &g_array_index (mux->index_table, MXFIndexTableSegment, i);
@@ -1594,7 +1928,8 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     mux->partition.closed = TRUE;
     mux->partition.complete = TRUE;
     mux->partition.this_partition = mux->offset;
-    mux->partition.prev_partition = body_partition;
+    mux->partition.prev_partition = g_array_index (mux->random_index_pack,
+        MXFRandomIndexPackEntry, mux->random_index_pack->len - 1).offset;
     mux->partition.footer_partition = mux->offset;
     mux->partition.header_byte_count = 0;
     mux->partition.index_byte_count = index_byte_count;
@@ -1603,7 +1938,7 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     mux->partition.body_offset = 0;
     mux->partition.body_sid = 0;
 
-    gst_mxf_mux_write_header_metadata (mux);
+    gst_mxf_mux_write_header_metadata (mux, FALSE);
 
     index_entries = g_list_reverse (index_entries);
     for (l = index_entries; l; l = l->next) {
@@ -1613,13 +1948,10 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     }
     g_list_free (index_entries);
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
-    entry.offset = 0;
-    entry.body_sid = 0;
-    g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
+    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry),
+        mux->random_index_pack->len + 1);
+    g_array_append_vals (rip, mux->random_index_pack->data,
+        mux->random_index_pack->len);
     entry.offset = footer_partition;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
@@ -1630,6 +1962,9 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     }
     g_array_free (rip, TRUE);
 
+    if ((ret = gst_mxf_mux_flush_pending (mux)) != GST_FLOW_OK)
+      return ret;
+
     /* Rewrite header partition with updated values */
     gst_segment_init (&segment, GST_FORMAT_BYTES);
     if (gst_pad_push_event (GST_AGGREGATOR_SRC_PAD (mux),
@@ -1647,8 +1982,14 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
       mux->partition.body_offset = 0;
       mux->partition.body_sid = 0;
 
-      ret = gst_mxf_mux_write_header_metadata (mux);
-      if (ret != GST_FLOW_OK) {
+      ret = gst_mxf_mux_write_header_metadata (mux, TRUE);
+      if (ret == GST_FLOW_CUSTOM_SUCCESS) {
+        /* the footer has the complete metadata, keep the open header
+         * partition that was written first */
+        GST_WARNING_OBJECT (mux, "Can't rewrite header partition, increase "
+            "header-padding");
+        return GST_FLOW_OK;
+      } else if (ret != GST_FLOW_OK) {
         GST_ERROR_OBJECT (mux, "Rewriting header partition failed");
         return ret;
       }
@@ -1670,6 +2011,8 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
 
       buf = mxf_partition_pack_to_buffer (&mux->partition);
       ret = gst_mxf_mux_push (mux, buf);
+      if (ret == GST_FLOW_OK)
+        ret = gst_mxf_mux_flush_pending (mux);
       if (ret != GST_FLOW_OK) {
         GST_ERROR_OBJECT (mux, "Rewriting body partition failed");
         return ret;
@@ -1753,9 +2096,15 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     if ((ret = gst_mxf_mux_init_partition_pack (mux)) != GST_FLOW_OK)
       goto error;
 
-    if ((ret = gst_mxf_mux_write_header_metadata (mux)) != GST_FLOW_OK)
+    if ((ret = gst_mxf_mux_write_header_metadata (mux, TRUE)) != GST_FLOW_OK)
       goto error;
 
+    {
+      MXFRandomIndexPackEntry entry = { 0, 0 };
+
+      g_array_append_val (mux->random_index_pack, entry);
+    }
+
     /* Sort pads, we will always write in that order */
     GST_OBJECT_LOCK (mux);
     GST_ELEMENT_CAST (mux)->sinkpads =
@@ -1763,7 +2112,7 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     GST_OBJECT_UNLOCK (mux);
 
     /* Write body partition */
-    ret = gst_mxf_mux_write_body_partition (mux);
+    ret = gst_mxf_mux_write_body_partition (mux, 0);
     if (ret != GST_FLOW_OK)
       goto error;
     mux->state = GST_MXF_MUX_STATE_DATA;
@@ -70,8 +70,30 @@ typedef struct _GstMXFMux {
   gchar *application;
 
   GArray *index_table;
-  guint current_index_pos;
+  /* Number of index table segments already written to body partitions */
+  guint n_written_index_segments;
   guint64 last_keyframe_pos;
+  /* Temporal offsets of edit units that are not indexed yet, indexed by
+   * position modulo 256 */
+  gint8 pending_temporal_offsets[256];
+  /* Largest distance between the stored and displayed position of an edit
+   * unit seen so far */
+  guint64 max_reorder_delay;
+
+  /* MXFRandomIndexPackEntry of all partitions written so far */
+  GArray *random_index_pack;
+  /* Position of the first edit unit of the current body partition */
+  guint64 partition_start_pos;
+  /* Size of the header metadata, including padding */
+  guint64 header_metadata_size;
+
+  GstBufferList *pending_buffers;
+  gsize pending_size;
+
+  /* Properties */
+  GstClockTime partition_interval;
+  guint header_padding;
+  guint write_batch_size;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
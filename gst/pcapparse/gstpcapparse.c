@@ -29,6 +29,10 @@
  * The supported data format is the classical
  * [libpcap file format](https://wiki.wireshark.org/Development/LibpcapFileFormat)
  *
+ * When upstream supports it, the file is read in pull mode in large blocks
+ * and the payloads are pushed as sub-buffers of those blocks, one buffer list
+ * per block, without copying.
+ *
  * ## Example pipelines
  * |[
  * gst-launch-1.0 filesrc location=h264crasher.pcap ! pcapparse ! rtph264depay
@@ -64,6 +68,8 @@ const guint GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN = 0xa1b23c4d;
 const guint GST_PCAPPARSE_MAGIC_MILLISECOND_SWAP_ENDIAN = 0xd4c3b2a1;
 const guint GST_PCAPPARSE_MAGIC_NANOSECOND_SWAP_ENDIAN = 0x4d3cb2a1;
 
+/* size of the blocks read in pull mode, each one becomes a buffer list */
+#define PULL_BLOCK_SIZE (1024 * 1024)
 
 enum
 {
@@ -101,6 +107,11 @@ static void gst_pcap_parse_reset (GstPcapParse * self);
 
 static GstFlowReturn gst_pcap_parse_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buffer);
+static void gst_pcap_parse_loop (GstPad * pad);
+static gboolean gst_pcap_parse_sink_activate (GstPad * sinkpad,
+    GstObject * parent);
+static gboolean gst_pcap_parse_sink_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
 static gboolean gst_pcap_sink_event (GstPad * pad,
     GstObject * parent, GstEvent * event);
 
@@ -169,6 +180,10 @@ gst_pcap_parse_init (GstPcapParse * self)
   self->sink_pad = gst_pad_new_from_static_template (&sink_template, "sink");
   gst_pad_set_chain_function (self->sink_pad,
       GST_DEBUG_FUNCPTR (gst_pcap_parse_chain));
+  gst_pad_set_activate_function (self->sink_pad,
+      GST_DEBUG_FUNCPTR (gst_pcap_parse_sink_activate));
+  gst_pad_set_activatemode_function (self->sink_pad,
+      GST_DEBUG_FUNCPTR (gst_pcap_parse_sink_activate_mode));
   gst_pad_use_fixed_caps (self->sink_pad);
   gst_pad_set_event_function (self->sink_pad,
       GST_DEBUG_FUNCPTR (gst_pcap_sink_event));
@@ -493,6 +508,150 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
   return TRUE;
 }
 
+static GstFlowReturn
+gst_pcap_parse_read_global_header (GstPcapParse * self, const guint8 * data)
+{
+  guint32 magic;
+  guint32 linktype;
+  guint16 major_version;
+
+  magic = *((guint32 *) data);
+  major_version = *((guint16 *) (data + 4));
+  linktype = *((guint32 *) (data + 20));
+
+  if (magic == GST_PCAPPARSE_MAGIC_MILLISECOND_NO_SWAP_ENDIAN ||
+      magic == GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN) {
+    self->swap_endian = FALSE;
+    if (magic == GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN)
+      self->nanosecond_timestamp = TRUE;
+  } else if (magic == GST_PCAPPARSE_MAGIC_MILLISECOND_SWAP_ENDIAN ||
+      magic == GST_PCAPPARSE_MAGIC_NANOSECOND_SWAP_ENDIAN) {
+    self->swap_endian = TRUE;
+    if (magic == GST_PCAPPARSE_MAGIC_NANOSECOND_SWAP_ENDIAN)
+      self->nanosecond_timestamp = TRUE;
+    major_version = GUINT16_SWAP_LE_BE (major_version);
+    linktype = GUINT32_SWAP_LE_BE (linktype);
+  } else {
+    GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+        ("File is not a libpcap file, magic is %X", magic));
+    return GST_FLOW_ERROR;
+  }
+
+  if (major_version != 2) {
+    GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+        ("File is not a libpcap major version 2, but %u", major_version));
+    return GST_FLOW_ERROR;
+  }
+
+  if (linktype != LINKTYPE_ETHER && linktype != LINKTYPE_SLL &&
+      linktype != LINKTYPE_RAW) {
+    GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+        ("Only dumps of type Ethernet, raw IP or Linux Cooked (SLL) "
+            "understood; type %d unknown", linktype));
+    return GST_FLOW_ERROR;
+  }
+
+  GST_DEBUG_OBJECT (self, "linktype %u", linktype);
+  self->linktype = linktype;
+  self->initialized = TRUE;
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_pcap_parse_read_record_header (GstPcapParse * self, const guint8 * data)
+{
+  guint32 ts_sec;
+  guint32 ts_usec;
+  guint32 incl_len;
+
+  ts_sec = gst_pcap_parse_read_uint32 (self, data + 0);
+  ts_usec = gst_pcap_parse_read_uint32 (self, data + 4);
+  incl_len = gst_pcap_parse_read_uint32 (self, data + 8);
+  /* orig_len = gst_pcap_parse_read_uint32 (self, data + 12); */
+
+  self->cur_ts =
+      ts_sec * GST_SECOND +
+      ts_usec * (self->nanosecond_timestamp ? 1 : GST_USECOND);
+  self->cur_packet_size = incl_len;
+}
+
+/* Rebases the timestamp of the current packet, called once the packet passed
+ * the filters and before a buffer is created for it */
+static void
+gst_pcap_parse_rebase_ts (GstPcapParse * self)
+{
+  if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
+    if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
+      self->base_ts = self->cur_ts;
+    if (self->offset >= 0) {
+      self->cur_ts -= self->base_ts;
+      self->cur_ts += self->offset;
+    }
+  }
+}
+
+static void
+gst_pcap_parse_add_buffer (GstPcapParse * self, GstBufferList ** list,
+    GstBuffer * out_buf)
+{
+  /* only first packet should have DISCONT flag */
+  if (G_LIKELY (!self->first_packet)) {
+    GST_BUFFER_FLAG_UNSET (out_buf, GST_BUFFER_FLAG_DISCONT);
+  } else {
+    GST_BUFFER_FLAG_SET (out_buf, GST_BUFFER_FLAG_DISCONT);
+    self->first_packet = FALSE;
+  }
+
+  GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
+
+  if (*list == NULL)
+    *list = gst_buffer_list_new ();
+  gst_buffer_list_add (*list, out_buf);
+}
+
+/* In pull mode there is no stream-start from upstream to forward, so we
+ * create our own */
+static void
+gst_pcap_parse_send_stream_start (GstPcapParse * self)
+{
+  GstEvent *event;
+  gchar *stream_id;
+
+  event = gst_pad_get_sticky_event (self->src_pad, GST_EVENT_STREAM_START, 0);
+  if (event) {
+    gst_event_unref (event);
+    return;
+  }
+
+  stream_id = gst_pad_create_stream_id (self->src_pad, GST_ELEMENT_CAST (self),
+      NULL);
+  GST_DEBUG_OBJECT (self, "creating stream-start %s", stream_id);
+  event = gst_event_new_stream_start (stream_id);
+  gst_event_set_group_id (event, gst_util_group_id_next ());
+  gst_pad_push_event (self->src_pad, event);
+  g_free (stream_id);
+}
+
+static GstFlowReturn
+gst_pcap_parse_push_list (GstPcapParse * self, GstBufferList * list)
+{
+  if (!self->newsegment_sent && GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
+    GstSegment segment;
+
+    if (GST_PAD_MODE (self->sink_pad) == GST_PAD_MODE_PULL)
+      gst_pcap_parse_send_stream_start (self);
+    if (self->caps)
+      gst_pad_set_caps (self->src_pad, self->caps);
+    gst_segment_init (&segment, GST_FORMAT_TIME);
+    segment.start = self->base_ts;
+    gst_pad_push_event (self->src_pad, gst_event_new_segment (&segment));
+    self->newsegment_sent = TRUE;
+  }
+
+  return gst_pad_push_list (self->src_pad, list);
+}
+
 static GstFlowReturn
 gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
@@ -528,6 +687,8 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
             GstBuffer *out_buf;
             guintptr offset = payload_data - data;
 
+            gst_pcap_parse_rebase_ts (self);
+
             gst_adapter_unmap (self->adapter);
             gst_adapter_flush (self->adapter, offset);
             /* we don't use _take_buffer_fast() on purpose here, we need a
@@ -540,31 +701,10 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
               out_buf = gst_buffer_new ();
             }
 
-            /* only first packet should have DISCONT flag */
-            if (G_LIKELY (!self->first_packet)) {
-              GST_BUFFER_FLAG_UNSET (out_buf, GST_BUFFER_FLAG_DISCONT);
-            } else {
-              GST_BUFFER_FLAG_SET (out_buf, GST_BUFFER_FLAG_DISCONT);
-              self->first_packet = FALSE;
-            }
-
             gst_adapter_flush (self->adapter,
                 self->cur_packet_size - offset - payload_size);
 
-            if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
-              if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
-                self->base_ts = self->cur_ts;
-              if (self->offset >= 0) {
-                self->cur_ts -= self->base_ts;
-                self->cur_ts += self->offset;
-              }
-            }
-            GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
-
-
-            if (list == NULL)
-              list = gst_buffer_list_new ();
-            gst_buffer_list_add (list, out_buf);
+            gst_pcap_parse_add_buffer (self, &list, out_buf);
           } else {
             gst_adapter_unmap (self->adapter);
             gst_adapter_flush (self->adapter, self->cur_packet_size);
@@ -574,102 +714,36 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         self->cur_packet_size = -1;
       } else {
         /* Parse the Record (Packet) Header */
-        guint32 ts_sec;
-        guint32 ts_usec;
-        guint32 incl_len;
 
         /* sizeof(pcaprec_hdr_t) == 16 */
         if (avail < 16)
           break;
 
         data = gst_adapter_map (self->adapter, 16);
-
-        ts_sec = gst_pcap_parse_read_uint32 (self, data + 0);
-        ts_usec = gst_pcap_parse_read_uint32 (self, data + 4);
-        incl_len = gst_pcap_parse_read_uint32 (self, data + 8);
-        /* orig_len = gst_pcap_parse_read_uint32 (self, data + 12); */
-
+        gst_pcap_parse_read_record_header (self, data);
         gst_adapter_unmap (self->adapter);
         gst_adapter_flush (self->adapter, 16);
-
-        self->cur_ts =
-            ts_sec * GST_SECOND +
-            ts_usec * (self->nanosecond_timestamp ? 1 : GST_USECOND);
-        self->cur_packet_size = incl_len;
       }
     } else {
       /* Parse the Global Header */
-      guint32 magic;
-      guint32 linktype;
-      guint16 major_version;
 
       /* sizeof(pcap_hdr_t) == 24 */
       if (avail < 24)
         break;
 
       data = gst_adapter_map (self->adapter, 24);
-
-      magic = *((guint32 *) data);
-      major_version = *((guint16 *) (data + 4));
-      linktype = *((guint32 *) (data + 20));
+      ret = gst_pcap_parse_read_global_header (self, data);
       gst_adapter_unmap (self->adapter);
 
-      if (magic == GST_PCAPPARSE_MAGIC_MILLISECOND_NO_SWAP_ENDIAN ||
-          magic == GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN) {
-        self->swap_endian = FALSE;
-        if (magic == GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN)
-          self->nanosecond_timestamp = TRUE;
-      } else if (magic == GST_PCAPPARSE_MAGIC_MILLISECOND_SWAP_ENDIAN ||
-          magic == GST_PCAPPARSE_MAGIC_NANOSECOND_SWAP_ENDIAN) {
-        self->swap_endian = TRUE;
-        if (magic == GST_PCAPPARSE_MAGIC_NANOSECOND_SWAP_ENDIAN)
-          self->nanosecond_timestamp = TRUE;
-        major_version = GUINT16_SWAP_LE_BE (major_version);
-        linktype = GUINT32_SWAP_LE_BE (linktype);
-      } else {
-        GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
-            ("File is not a libpcap file, magic is %X", magic));
-        ret = GST_FLOW_ERROR;
-        goto out;
-      }
-
-      if (major_version != 2) {
-        GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
-            ("File is not a libpcap major version 2, but %u", major_version));
-        ret = GST_FLOW_ERROR;
-        goto out;
-      }
-
-      if (linktype != LINKTYPE_ETHER && linktype != LINKTYPE_SLL &&
-          linktype != LINKTYPE_RAW) {
-        GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
-            ("Only dumps of type Ethernet, raw IP or Linux Cooked (SLL) "
-                "understood; type %d unknown", linktype));
-        ret = GST_FLOW_ERROR;
+      if (ret != GST_FLOW_OK)
         goto out;
-      }
-
-      GST_DEBUG_OBJECT (self, "linktype %u", linktype);
-      self->linktype = linktype;
 
       gst_adapter_flush (self->adapter, 24);
-      self->initialized = TRUE;
     }
   }
 
   if (list) {
-    if (!self->newsegment_sent && GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
-      GstSegment segment;
-
-      if (self->caps)
-        gst_pad_set_caps (self->src_pad, self->caps);
-      gst_segment_init (&segment, GST_FORMAT_TIME);
-      segment.start = self->base_ts;
-      gst_pad_push_event (self->src_pad, gst_event_new_segment (&segment));
-      self->newsegment_sent = TRUE;
-    }
-
-    ret = gst_pad_push_list (self->src_pad, list);
+    ret = gst_pcap_parse_push_list (self, list);
     list = NULL;
   }
 
@@ -681,6 +755,169 @@ out:
   return ret;
 }
 
+static void
+gst_pcap_parse_loop (GstPad * pad)
+{
+  GstPcapParse *self = GST_PCAP_PARSE (GST_PAD_PARENT (pad));
+  GstFlowReturn ret;
+  GstBuffer *block = NULL;
+  GstBufferList *list = NULL;
+  GstMapInfo map;
+  gsize size, pos = 0, needed = 0;
+
+  ret = gst_pad_pull_range (pad, self->read_offset, self->pull_size, &block);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  gst_buffer_map (block, &map, GST_MAP_READ);
+  size = map.size;
+
+  if (!self->initialized) {
+    /* sizeof(pcap_hdr_t) == 24 */
+    if (map.size < 24) {
+      gst_buffer_unmap (block, &map);
+      gst_buffer_unref (block);
+      ret = GST_FLOW_EOS;
+      goto pause;
+    }
+
+    ret = gst_pcap_parse_read_global_header (self, map.data);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unmap (block, &map);
+      gst_buffer_unref (block);
+      goto pause;
+    }
+    pos = 24;
+  }
+
+  /* Only complete records are handled, the payloads are pushed as sub-buffers
+   * of the block we pulled so nothing gets copied */
+  while (pos + 16 <= size) {
+    const guint8 *payload_data;
+    gint payload_size;
+
+    gst_pcap_parse_read_record_header (self, map.data + pos);
+    if (G_UNLIKELY (self->cur_packet_size > G_MAXINT32)) {
+      GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+          ("Invalid record size %" G_GINT64_FORMAT, self->cur_packet_size));
+      ret = GST_FLOW_ERROR;
+      break;
+    }
+
+    needed = 16 + self->cur_packet_size;
+    if (pos + needed > size)
+      break;
+
+    GST_LOG_OBJECT (self, "examining packet size %" G_GINT64_FORMAT,
+        self->cur_packet_size);
+
+    if (self->cur_packet_size > 0 &&
+        gst_pcap_parse_scan_frame (self, map.data + pos + 16,
+            self->cur_packet_size, &payload_data, &payload_size)) {
+      GstBuffer *out_buf;
+
+      gst_pcap_parse_rebase_ts (self);
+
+      if (payload_size > 0) {
+        out_buf = gst_buffer_copy_region (block, GST_BUFFER_COPY_MEMORY,
+            payload_data - map.data, payload_size);
+      } else {
+        out_buf = gst_buffer_new ();
+      }
+
+      gst_pcap_parse_add_buffer (self, &list, out_buf);
+    }
+
+    pos += needed;
+    needed = 0;
+  }
+  self->cur_packet_size = -1;
+
+  gst_buffer_unmap (block, &map);
+  gst_buffer_unref (block);
+
+  /* a short read means we are at the end of the file, anything left is a
+   * truncated record */
+  if (ret == GST_FLOW_OK && size < self->pull_size) {
+    if (pos < size)
+      GST_DEBUG_OBJECT (self, "ignoring %" G_GSIZE_FORMAT " trailing bytes",
+          size - pos);
+    ret = GST_FLOW_EOS;
+  }
+
+  self->read_offset += pos;
+  /* make sure the next block can hold a record larger than usual */
+  self->pull_size = MAX (PULL_BLOCK_SIZE, needed);
+
+  if (list) {
+    GstFlowReturn push_ret = gst_pcap_parse_push_list (self, list);
+
+    if (ret == GST_FLOW_OK || push_ret != GST_FLOW_OK)
+      ret = push_ret;
+  }
+
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  {
+    GST_LOG_OBJECT (self, "pausing task, reason %s", gst_flow_get_name (ret));
+    gst_pad_pause_task (pad);
+    if (ret == GST_FLOW_EOS) {
+      gst_pcap_parse_send_stream_start (self);
+      gst_pad_push_event (self->src_pad, gst_event_new_eos ());
+    } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+      /* parse errors have been posted already */
+      if (ret != GST_FLOW_ERROR)
+        GST_ELEMENT_FLOW_ERROR (self, ret);
+      gst_pcap_parse_send_stream_start (self);
+      gst_pad_push_event (self->src_pad, gst_event_new_eos ());
+    }
+  }
+}
+
+static gboolean
+gst_pcap_parse_sink_activate (GstPad * sinkpad, GstObject * parent)
+{
+  gboolean res = FALSE;
+  GstQuery *query = gst_query_new_scheduling ();
+
+  if (gst_pad_peer_query (sinkpad, query) &&
+      gst_query_has_scheduling_mode_with_flags (query, GST_PAD_MODE_PULL,
+          GST_SCHEDULING_FLAG_SEEKABLE)) {
+    res = gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PULL, TRUE);
+  } else {
+    res = gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PUSH, TRUE);
+  }
+
+  gst_query_unref (query);
+  return res;
+}
+
+static gboolean
+gst_pcap_parse_sink_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstPcapParse *self = GST_PCAP_PARSE (parent);
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      return TRUE;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        self->read_offset = 0;
+        self->pull_size = PULL_BLOCK_SIZE;
+        return gst_pad_start_task (pad, (GstTaskFunction) gst_pcap_parse_loop,
+            pad, NULL);
+      }
+      return gst_pad_stop_task (pad);
+    default:
+      return FALSE;
+  }
+}
+
 static gboolean
 gst_pcap_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
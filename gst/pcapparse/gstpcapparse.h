@@ -86,6 +86,10 @@ struct _GstPcapParse
 
   gboolean newsegment_sent;
   gboolean first_packet;
+
+  /* pull mode */
+  guint64 read_offset;
+  guint pull_size;
 };
 
 struct _GstPcapParseClass
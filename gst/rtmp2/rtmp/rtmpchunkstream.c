@@ -244,63 +244,59 @@ select_chunk_type (GstRtmpChunkStream * cstream, GstBuffer * buffer)
   return CHUNK_TYPE_3;
 }
 
-static GstBuffer *
-serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
-    ChunkType type)
+static gsize
+chunk_header_size (GstRtmpChunkStream * cstream, ChunkType type)
 {
-  GstRtmpMeta *meta = cstream->meta;
-  guint8 small_stream_id;
-  gsize header_size = chunk_header_sizes[type], offset;
-  gboolean ext_ts;
-  GstBuffer *ret;
-  GstMapInfo map;
-
-  GST_TRACE ("Serializing a chunk of type %d, offset %" G_GUINT32_FORMAT,
-      type, cstream->offset);
+  gsize header_size = chunk_header_sizes[type];
 
   if (cstream->id < CHUNK_STREAM_MIN_TWOBYTE) {
-    small_stream_id = cstream->id;
     header_size += 1;
   } else if (cstream->id < CHUNK_STREAM_MIN_THREEBYTE) {
-    small_stream_id = CHUNK_BYTE_TWOBYTE;
     header_size += 2;
   } else {
-    small_stream_id = CHUNK_BYTE_THREEBYTE;
     header_size += 3;
   }
 
-  ext_ts = needs_ext_ts (meta);
-  if (ext_ts) {
+  if (needs_ext_ts (cstream->meta)) {
     header_size += 4;
   }
 
-  GST_TRACE ("Allocating buffer, header size %" G_GSIZE_FORMAT, header_size);
+  return header_size;
+}
 
-  ret = gst_buffer_new_allocate (NULL, header_size, NULL);
-  if (!ret) {
-    GST_ERROR ("Failed to allocate chunk buffer");
-    return NULL;
-  }
+/* Writes the header of the next chunk into @data, which must have room for
+ * chunk_header_size() bytes. Returns the number of bytes written. */
+static gsize
+write_chunk_header (GstRtmpChunkStream * cstream, ChunkType type,
+    guint8 * data)
+{
+  GstRtmpMeta *meta = cstream->meta;
+  guint8 small_stream_id;
+  gsize offset;
+  gboolean ext_ts;
 
-  if (!gst_buffer_map (ret, &map, GST_MAP_WRITE)) {
-    GST_ERROR ("Failed to map %" GST_PTR_FORMAT, ret);
-    gst_buffer_unref (ret);
-    return NULL;
+  if (cstream->id < CHUNK_STREAM_MIN_TWOBYTE) {
+    small_stream_id = cstream->id;
+  } else if (cstream->id < CHUNK_STREAM_MIN_THREEBYTE) {
+    small_stream_id = CHUNK_BYTE_TWOBYTE;
+  } else {
+    small_stream_id = CHUNK_BYTE_THREEBYTE;
   }
 
+  ext_ts = needs_ext_ts (meta);
+
   /* Chunk Basic Header */
-  GST_WRITE_UINT8 (map.data, (type << 6) | small_stream_id);
+  GST_WRITE_UINT8 (data, (type << 6) | small_stream_id);
   offset = 1;
 
   switch (small_stream_id) {
     case CHUNK_BYTE_TWOBYTE:
-      GST_WRITE_UINT8 (map.data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
+      GST_WRITE_UINT8 (data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
       offset += 1;
       break;
 
     case CHUNK_BYTE_THREEBYTE:
-      GST_WRITE_UINT16_LE (map.data + 1,
-          cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
+      GST_WRITE_UINT16_LE (data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
       offset += 2;
       break;
   }
@@ -308,50 +304,93 @@ serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
   switch (type) {
     case CHUNK_TYPE_0:
       /* SRSLY:  "Message stream ID is stored in little-endian format." */
-      GST_WRITE_UINT32_LE (map.data + offset + 7, meta->mstream);
+      GST_WRITE_UINT32_LE (data + offset + 7, meta->mstream);
       /* no break */
     case CHUNK_TYPE_1:
-      GST_WRITE_UINT24_BE (map.data + offset + 3, meta->size);
-      GST_WRITE_UINT8 (map.data + offset + 6, meta->type);
+      GST_WRITE_UINT24_BE (data + offset + 3, meta->size);
+      GST_WRITE_UINT8 (data + offset + 6, meta->type);
       /* no break */
     case CHUNK_TYPE_2:
-      GST_WRITE_UINT24_BE (map.data + offset,
+      GST_WRITE_UINT24_BE (data + offset,
           ext_ts ? 0xffffff : meta->ts_delta);
       /* no break */
     case CHUNK_TYPE_3:
       offset += chunk_header_sizes[type];
 
       if (ext_ts) {
-        GST_WRITE_UINT32_BE (map.data + offset, meta->ts_delta);
+        GST_WRITE_UINT32_BE (data + offset, meta->ts_delta);
         offset += 4;
       }
   }
 
-  g_assert (offset == header_size);
-  GST_MEMDUMP (">>> chunk header", map.data, offset);
+  g_assert (offset == chunk_header_size (cstream, type));
+  GST_MEMDUMP (">>> chunk header", data, offset);
 
-  gst_buffer_unmap (ret, &map);
+  return offset;
+}
 
-  GST_BUFFER_OFFSET (ret) = GST_BUFFER_OFFSET_IS_VALID (cstream->buffer) ?
-      GST_BUFFER_OFFSET (cstream->buffer) + cstream->offset : cstream->bytes;
-  GST_BUFFER_OFFSET_END (ret) = GST_BUFFER_OFFSET (ret);
+/* Appends the payload of the next chunk to @outbuf, sharing the memory of
+ * the message instead of copying it */
+static void
+append_chunk_payload (GstRtmpChunkStream * cstream, guint32 chunk_size,
+    GstBuffer * outbuf)
+{
+  guint32 payload_size;
 
-  if (meta->size > 0) {
-    guint32 payload_size = chunk_stream_next_size (cstream, chunk_size);
+  if (cstream->meta->size == 0) {
+    GST_TRACE ("Chunk has no payload");
+    return;
+  }
 
-    GST_TRACE ("Appending %" G_GUINT32_FORMAT " bytes of payload",
-        payload_size);
+  payload_size = chunk_stream_next_size (cstream, chunk_size);
 
-    gst_buffer_copy_into (ret, cstream->buffer, GST_BUFFER_COPY_MEMORY,
-        cstream->offset, payload_size);
+  GST_TRACE ("Appending %" G_GUINT32_FORMAT " bytes of payload", payload_size);
 
-    GST_BUFFER_OFFSET_END (ret) += payload_size;
-    cstream->offset += payload_size;
-    cstream->bytes += payload_size;
-  } else {
-    GST_TRACE ("Chunk has no payload");
+  gst_buffer_copy_into (outbuf, cstream->buffer, GST_BUFFER_COPY_MEMORY,
+      cstream->offset, payload_size);
+
+  GST_BUFFER_OFFSET_END (outbuf) += payload_size;
+  cstream->offset += payload_size;
+  cstream->bytes += payload_size;
+}
+
+static GstBuffer *
+serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
+    ChunkType type)
+{
+  gsize header_size;
+  GstBuffer *ret;
+  GstMapInfo map;
+
+  GST_TRACE ("Serializing a chunk of type %d, offset %" G_GUINT32_FORMAT,
+      type, cstream->offset);
+
+  header_size = chunk_header_size (cstream, type);
+
+  GST_TRACE ("Allocating buffer, header size %" G_GSIZE_FORMAT, header_size);
+
+  ret = gst_buffer_new_allocate (NULL, header_size, NULL);
+  if (!ret) {
+    GST_ERROR ("Failed to allocate chunk buffer");
+    return NULL;
   }
 
+  if (!gst_buffer_map (ret, &map, GST_MAP_WRITE)) {
+    GST_ERROR ("Failed to map %" GST_PTR_FORMAT, ret);
+    gst_buffer_unref (ret);
+    return NULL;
+  }
+
+  write_chunk_header (cstream, type, map.data);
+
+  gst_buffer_unmap (ret, &map);
+
+  GST_BUFFER_OFFSET (ret) = GST_BUFFER_OFFSET_IS_VALID (cstream->buffer) ?
+      GST_BUFFER_OFFSET (cstream->buffer) + cstream->offset : cstream->bytes;
+  GST_BUFFER_OFFSET_END (ret) = GST_BUFFER_OFFSET (ret);
+
+  append_chunk_payload (cstream, chunk_size, ret);
+
   gst_rtmp_buffer_dump (ret, ">>> chunk");
 
   return ret;
@@ -666,21 +705,88 @@ gst_rtmp_chunk_stream_serialize_next (GstRtmpChunkStream * cstream,
   return serialize_next (cstream, chunk_size, CHUNK_TYPE_3);
 }
 
-GstBuffer *
+/* Serializes a whole message at once, appending one buffer per chunk to
+ * @chunks. All chunk headers are written into a single small memory that the
+ * chunks share slices of, while the payload stays in the memory of @buffer,
+ * so the list can be written out with a vectored write without copying. */
+gboolean
 gst_rtmp_chunk_stream_serialize_all (GstRtmpChunkStream * cstream,
-    GstBuffer * buffer, guint32 chunk_size)
+    GstBuffer * buffer, guint32 chunk_size, GstBufferList * chunks)
 {
-  GstBuffer *outbuf, *nextbuf;
+  GstMemory *headers;
+  GstMapInfo map;
+  ChunkType type;
+  gsize first_size, next_size, headers_size, offset;
+  guint32 n_chunks;
+
+  g_return_val_if_fail (cstream, FALSE);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (chunk_size, FALSE);
+  g_return_val_if_fail (GST_IS_BUFFER_LIST (chunks), FALSE);
+
+  type = select_chunk_type (cstream, buffer);
+  g_return_val_if_fail (type >= 0, FALSE);
+
+  GST_TRACE ("Serializing message %" GST_PTR_FORMAT " into stream %"
+      G_GUINT32_FORMAT, buffer, cstream->id);
+
+  gst_rtmp_buffer_dump (buffer, ">>> message");
+
+  chunk_stream_clear (cstream);
+  chunk_stream_take_buffer (cstream, gst_buffer_ref (buffer));
+
+  n_chunks = MAX (1, (cstream->meta->size + chunk_size - 1) / chunk_size);
+  first_size = chunk_header_size (cstream, type);
+  next_size = chunk_header_size (cstream, CHUNK_TYPE_3);
+  headers_size = first_size + (n_chunks - 1) * next_size;
+
+  GST_TRACE ("Allocating %" G_GUINT32_FORMAT " chunk headers, %"
+      G_GSIZE_FORMAT " bytes", n_chunks, headers_size);
 
-  outbuf = gst_rtmp_chunk_stream_serialize_start (cstream, buffer, chunk_size);
-  nextbuf = gst_rtmp_chunk_stream_serialize_next (cstream, chunk_size);
+  headers = gst_allocator_alloc (NULL, headers_size, NULL);
+  if (!headers) {
+    GST_ERROR ("Failed to allocate chunk headers");
+    return FALSE;
+  }
 
-  while (nextbuf) {
-    outbuf = gst_buffer_append (outbuf, nextbuf);
-    nextbuf = gst_rtmp_chunk_stream_serialize_next (cstream, chunk_size);
+  if (!gst_memory_map (headers, &map, GST_MAP_WRITE)) {
+    GST_ERROR ("Failed to map chunk headers");
+    gst_memory_unref (headers);
+    return FALSE;
   }
 
-  return outbuf;
+  /* Chunk headers only depend on the message, not on the chunk's offset */
+  offset = write_chunk_header (cstream, type, map.data);
+  while (offset < headers_size) {
+    offset += write_chunk_header (cstream, CHUNK_TYPE_3, map.data + offset);
+  }
+
+  g_assert (offset == headers_size);
+
+  /* Must not be mapped writable while sharing it */
+  gst_memory_unmap (headers, &map);
+
+  offset = 0;
+  do {
+    gsize size = offset == 0 ? first_size : next_size;
+    GstBuffer *chunk = gst_buffer_new ();
+
+    GST_BUFFER_OFFSET (chunk) = GST_BUFFER_OFFSET_IS_VALID (buffer) ?
+        GST_BUFFER_OFFSET (buffer) + cstream->offset : cstream->bytes;
+    GST_BUFFER_OFFSET_END (chunk) = GST_BUFFER_OFFSET (chunk);
+
+    gst_buffer_append_memory (chunk, gst_memory_share (headers, offset, size));
+    offset += size;
+
+    append_chunk_payload (cstream, chunk_size, chunk);
+
+    gst_rtmp_buffer_dump (chunk, ">>> chunk");
+    gst_buffer_list_add (chunks, chunk);
+  } while (chunk_stream_next_size (cstream, chunk_size) > 0);
+
+  gst_memory_unref (headers);
+
+  return TRUE;
 }
 
 GstRtmpChunkStreams *
@@ -36,6 +36,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_rtmp_connection_debug_category);
 #define GST_CAT_DEFAULT gst_rtmp_connection_debug_category
 
 #define READ_SIZE 8192
+#define MAX_WRITE_MESSAGES 16
 
 typedef void (*GstRtmpConnectionCallback) (GstRtmpConnection * connection);
 
@@ -92,6 +93,7 @@ struct _GstRtmpConnection
   guint64 out_bytes_total;
   guint64 in_bytes_acked;
   guint64 out_bytes_acked;
+  guint64 out_writes_total;
 };
 
 
@@ -513,34 +515,26 @@ gst_rtmp_connection_input_ready (GInputStream * is, gpointer user_data)
   return G_SOURCE_CONTINUE;
 }
 
-static void
-gst_rtmp_connection_start_write (GstRtmpConnection * self)
+/* Serializes @message into @chunks. Returns FALSE if the message had to be
+ * dropped. */
+static gboolean
+gst_rtmp_connection_serialize_message (GstRtmpConnection * self,
+    GstBuffer * message, GstBufferList * chunks)
 {
-  GOutputStream *os;
-  GstBuffer *message, *chunks;
   GstRtmpMeta *meta;
   GstRtmpChunkStream *cstream;
 
-  if (self->writing) {
-    return;
-  }
-
-  message = g_async_queue_try_pop (self->output_queue);
-  if (!message) {
-    return;
-  }
-
   meta = gst_buffer_get_rtmp_meta (message);
   if (!meta) {
     GST_ERROR_OBJECT (self, "No RTMP meta on %" GST_PTR_FORMAT, message);
-    goto out;
+    return FALSE;
   }
 
   if (gst_rtmp_message_is_protocol_control (message)) {
     if (!gst_rtmp_connection_prepare_protocol_control (self, message)) {
       GST_ERROR_OBJECT (self,
           "Failed to prepare protocol control %" GST_PTR_FORMAT, message);
-      goto out;
+      return FALSE;
     }
   }
 
@@ -548,30 +542,71 @@ gst_rtmp_connection_start_write (GstRtmpConnection * self)
   if (!cstream) {
     GST_ERROR_OBJECT (self, "Failed to get chunk stream for %" GST_PTR_FORMAT,
         message);
-    goto out;
+    return FALSE;
   }
 
-  chunks = gst_rtmp_chunk_stream_serialize_all (cstream, message,
-      self->out_chunk_size);
-  if (!chunks) {
+  if (!gst_rtmp_chunk_stream_serialize_all (cstream, message,
+          self->out_chunk_size, chunks)) {
     GST_ERROR_OBJECT (self, "Failed to serialize %" GST_PTR_FORMAT, message);
-    goto out;
+    return FALSE;
   }
 
+  return TRUE;
+}
+
+static void
+gst_rtmp_connection_start_write (GstRtmpConnection * self)
+{
+  GOutputStream *os;
+  GstBuffer *message;
+  GstBufferList *chunks;
+  guint n_messages = 0;
+
+  if (self->writing) {
+    return;
+  }
+
+  chunks = gst_buffer_list_new ();
+
+  /* Write whatever is queued in one go, up to a limit so that we get around
+   * to reading in between. A protocol control message ends the batch, as its
+   * settings may only be applied once it has been written. */
+  while (n_messages < MAX_WRITE_MESSAGES &&
+      (message = g_async_queue_try_pop (self->output_queue))) {
+    gboolean is_protocol_control;
+
+    is_protocol_control = gst_rtmp_message_is_protocol_control (message);
+
+    if (gst_rtmp_connection_serialize_message (self, message, chunks)) {
+      n_messages++;
+    }
+
+    gst_buffer_unref (message);
+
+    if (is_protocol_control) {
+      break;
+    }
+  }
+
+  if (gst_buffer_list_length (chunks) == 0) {
+    gst_buffer_list_unref (chunks);
+    return;
+  }
+
+  GST_TRACE_OBJECT (self, "writing %u messages in %u chunks", n_messages,
+      gst_buffer_list_length (chunks));
+
   self->writing = TRUE;
   if (self->output_handler) {
     self->output_handler (self, self->output_handler_user_data);
   }
 
   os = g_io_stream_get_output_stream (G_IO_STREAM (self->connection));
-  gst_rtmp_output_stream_write_all_buffer_async (os, chunks, G_PRIORITY_DEFAULT,
-      self->cancellable, gst_rtmp_connection_write_buffer_done,
-      g_object_ref (self));
-
-  gst_buffer_unref (chunks);
+  gst_rtmp_output_stream_write_all_buffer_list_async (os, chunks,
+      G_PRIORITY_DEFAULT, self->cancellable,
+      gst_rtmp_connection_write_buffer_done, g_object_ref (self));
 
-out:
-  gst_buffer_unref (message);
+  gst_buffer_list_unref (chunks);
 }
 
 static void
@@ -596,16 +631,18 @@ gst_rtmp_connection_write_buffer_done (GObject * obj,
   GOutputStream *os = G_OUTPUT_STREAM (obj);
   GstRtmpConnection *self = GST_RTMP_CONNECTION (user_data);
   gsize bytes_written = 0;
+  guint n_writes = 0;
   GError *error = NULL;
   gboolean res;
 
   self->writing = FALSE;
 
-  res = gst_rtmp_output_stream_write_all_buffer_finish (os, result,
-      &bytes_written, &error);
+  res = gst_rtmp_output_stream_write_all_buffer_list_finish (os, result,
+      &bytes_written, &n_writes, &error);
 
   g_mutex_lock (&self->stats_lock);
   self->out_bytes_total += bytes_written;
+  self->out_writes_total += n_writes;
   g_mutex_unlock (&self->stats_lock);
 
   if (!res) {
@@ -623,8 +660,8 @@ gst_rtmp_connection_write_buffer_done (GObject * obj,
     return;
   }
 
-  GST_LOG_OBJECT (self, "write completed; wrote %" G_GSIZE_FORMAT " bytes",
-      bytes_written);
+  GST_LOG_OBJECT (self, "write completed; wrote %" G_GSIZE_FORMAT
+      " bytes in %u writes", bytes_written, n_writes);
 
   gst_rtmp_connection_apply_protocol_control (self);
   gst_rtmp_connection_start_write (self);
@@ -1379,7 +1416,9 @@ get_stats (GstRtmpConnection * self)
       "in-bytes-total", G_TYPE_UINT64, self ? self->in_bytes_total : 0,
       "out-bytes-total", G_TYPE_UINT64, self ? self->out_bytes_total : 0,
       "in-bytes-acked", G_TYPE_UINT64, self ? self->in_bytes_acked : 0,
-      "out-bytes-acked", G_TYPE_UINT64, self ? self->out_bytes_acked : 0, NULL);
+      "out-bytes-acked", G_TYPE_UINT64, self ? self->out_bytes_acked : 0,
+      "out-writes-total", G_TYPE_UINT64, self ? self->out_writes_total : 0,
+      NULL);
 }
 
 GstStructure *
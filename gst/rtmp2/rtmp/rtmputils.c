@@ -30,7 +30,8 @@ static void read_all_bytes_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
 static void write_all_bytes_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
-static void write_all_buffer_done (GObject * source, GAsyncResult * result,
+static void write_buffer_list_next (GTask * task);
+static void write_buffer_list_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
 
 void
@@ -158,75 +159,145 @@ gst_rtmp_output_stream_write_all_bytes_finish (GOutputStream * stream,
 
 typedef struct
 {
-  GstBuffer *buffer;
-  GstMapInfo map;
-  gboolean mapped;
+  GstBufferList *list;
+  GArray *maps;
+  GOutputVector *vectors;
+  guint n_vectors, vector;
+  int io_priority;
   gsize bytes_written;
-} WriteAllBufferData;
+  guint n_writes;
+} WriteBufferListData;
 
-static WriteAllBufferData *
-write_all_buffer_data_new (GstBuffer * buffer)
+static void
+write_buffer_list_data_free (gpointer ptr)
 {
-  WriteAllBufferData *data = g_slice_new0 (WriteAllBufferData);
-  data->buffer = gst_buffer_ref (buffer);
-  return data;
+  WriteBufferListData *data = ptr;
+  guint i;
+
+  for (i = 0; i < data->maps->len; i++) {
+    GstMapInfo *map = &g_array_index (data->maps, GstMapInfo, i);
+    gst_memory_unmap (map->memory, map);
+  }
+
+  g_array_free (data->maps, TRUE);
+  g_free (data->vectors);
+  g_clear_pointer (&data->list, gst_buffer_list_unref);
+  g_slice_free (WriteBufferListData, data);
 }
 
-static void
-write_all_buffer_data_free (gpointer ptr)
+static gboolean
+write_buffer_list_data_map (WriteBufferListData * data)
 {
-  WriteAllBufferData *data = ptr;
-  if (data->mapped) {
-    gst_buffer_unmap (data->buffer, &data->map);
+  guint i, j, len = gst_buffer_list_length (data->list), n_memories = 0;
+
+  for (i = 0; i < len; i++) {
+    n_memories += gst_buffer_n_memory (gst_buffer_list_get (data->list, i));
+  }
+
+  data->maps = g_array_sized_new (FALSE, FALSE, sizeof (GstMapInfo),
+      n_memories);
+  data->vectors = g_new (GOutputVector, n_memories);
+
+  for (i = 0; i < len; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (data->list, i);
+    guint n = gst_buffer_n_memory (buffer);
+
+    for (j = 0; j < n; j++) {
+      GstMemory *mem = gst_buffer_peek_memory (buffer, j);
+      GstMapInfo map;
+
+      if (!gst_memory_map (mem, &map, GST_MAP_READ)) {
+        return FALSE;
+      }
+
+      g_array_append_val (data->maps, map);
+
+      if (map.size > 0) {
+        data->vectors[data->n_vectors].buffer = map.data;
+        data->vectors[data->n_vectors].size = map.size;
+        data->n_vectors++;
+      }
+    }
   }
-  g_clear_pointer (&data->buffer, gst_buffer_unref);
-  g_slice_free (WriteAllBufferData, data);
+
+  return TRUE;
 }
 
+/* Writes all buffers of @list, mapping each of their memories separately
+ * and handing them to the stream as one vectored write. Short writes are
+ * continued from where they stopped. */
 void
-gst_rtmp_output_stream_write_all_buffer_async (GOutputStream * stream,
-    GstBuffer * buffer, int io_priority, GCancellable * cancellable,
+gst_rtmp_output_stream_write_all_buffer_list_async (GOutputStream * stream,
+    GstBufferList * list, int io_priority, GCancellable * cancellable,
     GAsyncReadyCallback callback, gpointer user_data)
 {
   GTask *task;
-  WriteAllBufferData *data;
+  WriteBufferListData *data;
 
   g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
-  g_return_if_fail (GST_IS_BUFFER (buffer));
+  g_return_if_fail (GST_IS_BUFFER_LIST (list));
 
   task = g_task_new (stream, cancellable, callback, user_data);
 
-  data = write_all_buffer_data_new (buffer);
-  g_task_set_task_data (task, data, write_all_buffer_data_free);
+  data = g_slice_new0 (WriteBufferListData);
+  data->list = gst_buffer_list_ref (list);
+  data->io_priority = io_priority;
+  g_task_set_task_data (task, data, write_buffer_list_data_free);
 
-  if (!gst_buffer_map (buffer, &data->map, GST_MAP_READ)) {
+  if (!write_buffer_list_data_map (data)) {
     g_task_return_new_error (task, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
         "Failed to map buffer for reading");
     g_object_unref (task);
     return;
   }
 
-  data->mapped = TRUE;
+  write_buffer_list_next (task);
+}
+
+static void
+write_buffer_list_next (GTask * task)
+{
+  GOutputStream *os = g_task_get_source_object (task);
+  WriteBufferListData *data = g_task_get_task_data (task);
+
+  if (data->vector == data->n_vectors) {
+    g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+    return;
+  }
 
-  g_output_stream_write_all_async (stream, data->map.data, data->map.size,
-      io_priority, cancellable, write_all_buffer_done, task);
+#if GLIB_CHECK_VERSION(2, 60, 0)
+  g_output_stream_writev_async (os, data->vectors + data->vector,
+      data->n_vectors - data->vector, data->io_priority,
+      g_task_get_cancellable (task), write_buffer_list_done, task);
+#else
+  g_output_stream_write_async (os, data->vectors[data->vector].buffer,
+      data->vectors[data->vector].size, data->io_priority,
+      g_task_get_cancellable (task), write_buffer_list_done, task);
+#endif
 }
 
 static void
-write_all_buffer_done (GObject * source, GAsyncResult * result,
+write_buffer_list_done (GObject * source, GAsyncResult * result,
     gpointer user_data)
 {
   GOutputStream *os = G_OUTPUT_STREAM (source);
   GTask *task = user_data;
-  WriteAllBufferData *data = g_task_get_task_data (task);
+  WriteBufferListData *data = g_task_get_task_data (task);
   GError *error = NULL;
+  gsize written = 0;
   gboolean res;
 
-  res = g_output_stream_write_all_finish (os, result, &data->bytes_written,
-      &error);
-
-  gst_buffer_unmap (data->buffer, &data->map);
-  data->mapped = FALSE;
+#if GLIB_CHECK_VERSION(2, 60, 0)
+  res = g_output_stream_writev_finish (os, result, &written, &error);
+#else
+  {
+    gssize ret = g_output_stream_write_finish (os, result, &error);
+    res = ret >= 0;
+    if (res)
+      written = ret;
+  }
+#endif
 
   if (!res) {
     g_task_return_error (task, error);
@@ -234,16 +305,32 @@ write_all_buffer_done (GObject * source, GAsyncResult * result,
     return;
   }
 
-  g_task_return_boolean (task, TRUE);
-  g_object_unref (task);
-}
+  data->n_writes++;
+  data->bytes_written += written;
+
+  /* Skip what was written, the last vector may have been written partially */
+  while (written > 0) {
+    GOutputVector *vector = &data->vectors[data->vector];
+
+    if (written < vector->size) {
+      vector->buffer = (const guint8 *) vector->buffer + written;
+      vector->size -= written;
+      break;
+    }
 
+    written -= vector->size;
+    data->vector++;
+  }
+
+  write_buffer_list_next (task);
+}
 
 gboolean
-gst_rtmp_output_stream_write_all_buffer_finish (GOutputStream * stream,
-    GAsyncResult * result, gsize * bytes_written, GError ** error)
+gst_rtmp_output_stream_write_all_buffer_list_finish (GOutputStream * stream,
+    GAsyncResult * result, gsize * bytes_written, guint * n_writes,
+    GError ** error)
 {
-  WriteAllBufferData *data;
+  WriteBufferListData *data;
   GTask *task;
 
   g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
@@ -253,6 +340,9 @@ gst_rtmp_output_stream_write_all_buffer_finish (GOutputStream * stream,
   if (bytes_written) {
     *bytes_written = data->bytes_written;
   }
+  if (n_writes) {
+    *n_writes = data->n_writes;
+  }
 
   return g_task_propagate_boolean (task, error);
 }
@@ -71,7 +71,8 @@ enum
   PROP_LTC_TIMEOUT,
   PROP_RTC_MAX_DRIFT,
   PROP_RTC_AUTO_RESYNC,
-  PROP_TIMECODE_OFFSET
+  PROP_TIMECODE_OFFSET,
+  PROP_LTC_CHANNEL
 };
 
 #define DEFAULT_SOURCE GST_TIME_CODE_STAMPER_SOURCE_INTERNAL
@@ -88,6 +89,7 @@ enum
 #define DEFAULT_RTC_MAX_DRIFT 250000000
 #define DEFAULT_RTC_AUTO_RESYNC TRUE
 #define DEFAULT_TIMECODE_OFFSET 0
+#define DEFAULT_LTC_CHANNEL -1
 
 #define DEFAULT_LTC_QUEUE 100
 
@@ -113,7 +115,9 @@ static GstStaticPadTemplate gst_timecodestamper_ltc_template =
 GST_STATIC_PAD_TEMPLATE ("ltc_sink",
     GST_PAD_SINK,
     GST_PAD_REQUEST,
-    GST_STATIC_CAPS ("audio/x-raw,format=U8,rate=[1,max],channels=1")
+    GST_STATIC_CAPS ("audio/x-raw,format={ U8, " GST_AUDIO_NE (S16) ", "
+        GST_AUDIO_NE (F32) " },rate=[1,max],channels=[1,max],"
+        "layout=interleaved")
     );
 
 static void gst_timecodestamper_set_property (GObject * object, guint prop_id,
@@ -141,6 +145,9 @@ typedef struct
   GstVideoTimeCode timecode;
 } TimestampedTimecode;
 
+static void gst_timecodestamper_reset_ltc_decoders (GstTimeCodeStamper *
+    timecodestamper);
+
 static gboolean gst_timecodestamper_query (GstBaseTransform * trans,
     GstPadDirection direction, GstQuery * query);
 
@@ -315,6 +322,21 @@ gst_timecodestamper_class_init (GstTimeCodeStamperClass * klass)
           "useful if there is an offset between the timecode source and video",
           G_MININT, G_MAXINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstTimeCodeStamper:ltc-channel:
+   *
+   * Channel of the LTC audio to decode LTC from. With -1 all channels that
+   * look like they could carry LTC are decoded until LTC is found on one.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LTC_CHANNEL,
+      g_param_spec_int ("ltc-channel",
+          "LTC Channel",
+          "Audio channel to decode LTC from (-1 = autodetect)",
+          -1, G_MAXINT, DEFAULT_LTC_CHANNEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&gst_timecodestamper_sink_template));
   gst_element_class_add_pad_template (element_class,
@@ -361,6 +383,7 @@ gst_timecodestamper_init (GstTimeCodeStamper * timecodestamper)
   timecodestamper->rtc_max_drift = DEFAULT_RTC_MAX_DRIFT;
   timecodestamper->rtc_auto_resync = DEFAULT_RTC_AUTO_RESYNC;
   timecodestamper->timecode_offset = 0;
+  timecodestamper->ltc_channel = DEFAULT_LTC_CHANNEL;
 
   timecodestamper->internal_tc = NULL;
   timecodestamper->last_tc = NULL;
@@ -381,8 +404,15 @@ gst_timecodestamper_init (GstTimeCodeStamper * timecodestamper)
   g_queue_init (&timecodestamper->ltc_current_tcs);
   timecodestamper->ltc_internal_tc = NULL;
   timecodestamper->ltc_internal_running_time = GST_CLOCK_TIME_NONE;
-  timecodestamper->ltc_dec = NULL;
+  g_mutex_init (&timecodestamper->ltc_dec_lock);
+  timecodestamper->stream_align = NULL;
+  timecodestamper->ltc_decs = NULL;
+  timecodestamper->n_ltc_decs = 0;
   timecodestamper->ltc_total = 0;
+  timecodestamper->ltc_found_channel = -1;
+  timecodestamper->ltc_found_total = 0;
+  timecodestamper->ltc_samples = NULL;
+  timecodestamper->ltc_samples_size = 0;
 
   timecodestamper->ltc_eos = TRUE;
   timecodestamper->ltc_flushing = TRUE;
@@ -449,15 +479,8 @@ gst_timecodestamper_dispose (GObject * object)
   }
   timecodestamper->ltc_internal_running_time = GST_CLOCK_TIME_NONE;
 
-  if (timecodestamper->ltc_dec) {
-    ltc_decoder_free (timecodestamper->ltc_dec);
-    timecodestamper->ltc_dec = NULL;
-  }
-
-  if (timecodestamper->stream_align) {
-    gst_audio_stream_align_free (timecodestamper->stream_align);
-    timecodestamper->stream_align = NULL;
-  }
+  gst_timecodestamper_reset_ltc_decoders (timecodestamper);
+  g_mutex_clear (&timecodestamper->ltc_dec_lock);
 #endif
 
   G_OBJECT_CLASS (gst_timecodestamper_parent_class)->dispose (object);
@@ -554,6 +577,9 @@ gst_timecodestamper_set_property (GObject * object, guint prop_id,
     case PROP_TIMECODE_OFFSET:
       timecodestamper->timecode_offset = g_value_get_int (value);
       break;
+    case PROP_LTC_CHANNEL:
+      timecodestamper->ltc_channel = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -612,6 +638,9 @@ gst_timecodestamper_get_property (GObject * object, guint prop_id,
     case PROP_TIMECODE_OFFSET:
       g_value_set_int (value, timecodestamper->timecode_offset);
       break;
+    case PROP_LTC_CHANNEL:
+      g_value_set_int (value, timecodestamper->ltc_channel);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -677,17 +706,7 @@ gst_timecodestamper_stop (GstBaseTransform * trans)
     }
   }
 
-  if (timecodestamper->ltc_dec) {
-    ltc_decoder_free (timecodestamper->ltc_dec);
-    timecodestamper->ltc_dec = NULL;
-  }
-
-  if (timecodestamper->stream_align) {
-    gst_audio_stream_align_free (timecodestamper->stream_align);
-    timecodestamper->stream_align = NULL;
-  }
-
-  timecodestamper->ltc_total = 0;
+  gst_timecodestamper_reset_ltc_decoders (timecodestamper);
   g_mutex_unlock (&timecodestamper->mutex);
 #endif
 
@@ -1735,17 +1754,7 @@ gst_timecodestamper_release_pad (GstElement * element, GstPad * pad)
   timecodestamper->ltc_first_running_time = GST_CLOCK_TIME_NONE;
   timecodestamper->ltc_current_running_time = GST_CLOCK_TIME_NONE;
 
-  if (timecodestamper->ltc_dec) {
-    ltc_decoder_free (timecodestamper->ltc_dec);
-    timecodestamper->ltc_dec = NULL;
-  }
-
-  if (timecodestamper->stream_align) {
-    gst_audio_stream_align_free (timecodestamper->stream_align);
-    timecodestamper->stream_align = NULL;
-  }
-
-  timecodestamper->ltc_total = 0;
+  gst_timecodestamper_reset_ltc_decoders (timecodestamper);
 
   timecodestamper->audio_live = FALSE;
   timecodestamper->audio_latency = GST_CLOCK_TIME_NONE;
@@ -1759,6 +1768,104 @@ gst_timecodestamper_release_pad (GstElement * element, GstPad * pad)
 }
 
 #if HAVE_LTC
+/* Minimum distance from the center for a zero crossing, in 8 bit samples */
+#define LTC_CROSSING_THRESHOLD 4
+/* LTC is biphase mark coded with 80 bits per frame, at 24 to 30 fps this
+ * gives between 1920 and 4800 zero crossings per second. Leave some room
+ * for varispeed */
+#define LTC_MIN_CROSSINGS_PER_SECOND 1000
+#define LTC_MAX_CROSSINGS_PER_SECOND 6000
+/* Look at all channels again if no LTC was decoded for this long */
+#define LTC_CHANNEL_TIMEOUT 2
+
+static void
+gst_timecodestamper_reset_ltc_decoders (GstTimeCodeStamper * timecodestamper)
+{
+  guint i;
+
+  g_mutex_lock (&timecodestamper->ltc_dec_lock);
+  for (i = 0; i < timecodestamper->n_ltc_decs; i++)
+    ltc_decoder_free (timecodestamper->ltc_decs[i]);
+  g_free (timecodestamper->ltc_decs);
+  timecodestamper->ltc_decs = NULL;
+  timecodestamper->n_ltc_decs = 0;
+
+  g_free (timecodestamper->ltc_samples);
+  timecodestamper->ltc_samples = NULL;
+  timecodestamper->ltc_samples_size = 0;
+
+  if (timecodestamper->stream_align) {
+    gst_audio_stream_align_free (timecodestamper->stream_align);
+    timecodestamper->stream_align = NULL;
+  }
+
+  timecodestamper->ltc_total = 0;
+  timecodestamper->ltc_found_channel = -1;
+  timecodestamper->ltc_found_total = 0;
+  g_mutex_unlock (&timecodestamper->ltc_dec_lock);
+}
+
+/* Extracts one channel as the unsigned 8 bit samples the LTC decoder works
+ * with internally */
+static void
+ltc_extract_channel (const GstAudioInfo * info, const guint8 * data,
+    guint nsamples, guint channel, guint8 * out)
+{
+  guint channels = GST_AUDIO_INFO_CHANNELS (info);
+  guint i;
+
+  switch (GST_AUDIO_INFO_FORMAT (info)) {
+    case GST_AUDIO_FORMAT_U8:
+      for (i = 0; i < nsamples; i++)
+        out[i] = data[i * channels + channel];
+      break;
+    case GST_AUDIO_FORMAT_S16:{
+      const gint16 *s16 = (const gint16 *) data;
+
+      for (i = 0; i < nsamples; i++)
+        out[i] = (s16[i * channels + channel] >> 8) + 128;
+      break;
+    }
+    case GST_AUDIO_FORMAT_F32:{
+      const gfloat *f32 = (const gfloat *) data;
+
+      for (i = 0; i < nsamples; i++) {
+        gfloat v = f32[i * channels + channel] * 127.0f + 128.0f;
+
+        out[i] = CLAMP (v, 0.0f, 255.0f);
+      }
+      break;
+    }
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+}
+
+/* Whether the zero crossing rate of @samples is in the range of LTC */
+static gboolean
+ltc_samples_look_like_ltc (const guint8 * samples, guint nsamples, gint rate)
+{
+  gboolean high = samples[0] >= 128;
+  guint i, crossings = 0;
+  guint64 per_second;
+
+  for (i = 1; i < nsamples; i++) {
+    if (high && samples[i] < 128 - LTC_CROSSING_THRESHOLD) {
+      high = FALSE;
+      crossings++;
+    } else if (!high && samples[i] > 128 + LTC_CROSSING_THRESHOLD) {
+      high = TRUE;
+      crossings++;
+    }
+  }
+
+  per_second = gst_util_uint64_scale_int (crossings, rate, nsamples);
+
+  return per_second >= LTC_MIN_CROSSINGS_PER_SECOND
+      && per_second <= LTC_MAX_CROSSINGS_PER_SECOND;
+}
+
 static GstFlowReturn
 gst_timecodestamper_ltcpad_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buffer)
@@ -1767,7 +1874,11 @@ gst_timecodestamper_ltcpad_chain (GstPad * pad,
   GstTimeCodeStamper *timecodestamper = GST_TIME_CODE_STAMPER (parent);
   GstMapInfo map;
   GstClockTime timestamp, running_time, duration;
-  guint nsamples;
+  GQueue new_tcs = G_QUEUE_INIT;
+  TimestampedTimecode *ltc_tc;
+  GDateTime *daily_jam;
+  gint ltc_channel;
+  guint nsamples, channels, c;
   gboolean discont;
 
   if (timecodestamper->audio_latency == -1 || gst_pad_check_reconfigure (pad)) {
@@ -1781,7 +1892,19 @@ gst_timecodestamper_ltcpad_chain (GstPad * pad,
     gst_buffer_unref (buffer);
     return GST_FLOW_FLUSHING;
   }
+  g_mutex_unlock (&timecodestamper->mutex);
+
+  GST_OBJECT_LOCK (timecodestamper);
+  ltc_channel = timecodestamper->ltc_channel;
+  daily_jam = timecodestamper->ltc_daily_jam ?
+      g_date_time_ref (timecodestamper->ltc_daily_jam) : NULL;
+  GST_OBJECT_UNLOCK (timecodestamper);
+
+  /* Decode without holding the mutex so the video streaming thread is never
+   * waiting for this */
+  g_mutex_lock (&timecodestamper->ltc_dec_lock);
 
+  channels = GST_AUDIO_INFO_CHANNELS (&timecodestamper->ainfo);
   nsamples = gst_buffer_get_size (buffer) /
       GST_AUDIO_INFO_BPF (&timecodestamper->ainfo);
 
@@ -1797,17 +1920,23 @@ gst_timecodestamper_ltcpad_chain (GstPad * pad,
       &timestamp, &duration, NULL);
 
   if (discont) {
-    if (timecodestamper->ltc_dec) {
+    if (timecodestamper->ltc_decs) {
       GST_WARNING_OBJECT (timecodestamper, "Got discont at %" GST_TIME_FORMAT,
           GST_TIME_ARGS (timestamp));
-      ltc_decoder_queue_flush (timecodestamper->ltc_dec);
+      for (c = 0; c < timecodestamper->n_ltc_decs; c++)
+        ltc_decoder_queue_flush (timecodestamper->ltc_decs[c]);
     }
     timecodestamper->ltc_total = 0;
+    timecodestamper->ltc_found_total = 0;
   }
 
-  if (!timecodestamper->ltc_dec) {
+  if (timecodestamper->n_ltc_decs != channels) {
     gint samples_per_frame = 1920;
 
+    for (c = 0; c < timecodestamper->n_ltc_decs; c++)
+      ltc_decoder_free (timecodestamper->ltc_decs[c]);
+    g_free (timecodestamper->ltc_decs);
+
     GST_OBJECT_LOCK (timecodestamper);
     /* This is only for initialization and needs to be somewhat close to the
      * real value. It will be tracked automatically afterwards */
@@ -1817,9 +1946,20 @@ gst_timecodestamper_ltcpad_chain (GstPad * pad,
     }
     GST_OBJECT_UNLOCK (timecodestamper);
 
-    timecodestamper->ltc_dec =
-        ltc_decoder_create (samples_per_frame, DEFAULT_LTC_QUEUE);
+    timecodestamper->ltc_decs = g_new (LTCDecoder *, channels);
+    for (c = 0; c < channels; c++)
+      timecodestamper->ltc_decs[c] =
+          ltc_decoder_create (samples_per_frame, DEFAULT_LTC_QUEUE);
+    timecodestamper->n_ltc_decs = channels;
     timecodestamper->ltc_total = 0;
+    timecodestamper->ltc_found_channel = -1;
+    timecodestamper->ltc_found_total = 0;
+  }
+
+  if (timecodestamper->ltc_samples_size < nsamples) {
+    timecodestamper->ltc_samples =
+        g_realloc (timecodestamper->ltc_samples, nsamples);
+    timecodestamper->ltc_samples_size = nsamples;
   }
 
   running_time = gst_segment_to_running_time (&timecodestamper->ltc_segment,
@@ -1837,22 +1977,50 @@ gst_timecodestamper_ltcpad_chain (GstPad * pad,
   }
 
   gst_buffer_map (buffer, &map, GST_MAP_READ);
-  ltc_decoder_write (timecodestamper->ltc_dec, map.data, map.size,
-      timecodestamper->ltc_total);
-  timecodestamper->ltc_total += map.size;
-  gst_buffer_unmap (buffer, &map);
-
-  /* Now read all the timecodes from the decoder that are currently available
-   * and store them in our own queue, which gives us more control over how
-   * things are working. */
-  {
+  for (c = 0; c < channels && nsamples > 0; c++) {
+    LTCDecoder *ltc_dec = timecodestamper->ltc_decs[c];
     LTCFrameExt ltc_frame;
 
-    while (ltc_decoder_read (timecodestamper->ltc_dec, &ltc_frame) == 1) {
+    /* Once LTC was found only decode that channel */
+    if (ltc_channel >= 0 && (gint) c != ltc_channel)
+      continue;
+    if (ltc_channel < 0 && timecodestamper->ltc_found_channel >= 0
+        && (gint) c != timecodestamper->ltc_found_channel)
+      continue;
+
+    ltc_extract_channel (&timecodestamper->ainfo, map.data, nsamples, c,
+        timecodestamper->ltc_samples);
+
+    /* While looking for the LTC channel, skip silence and anything else that
+     * doesn't look like LTC at all */
+    if (ltc_channel < 0 && timecodestamper->ltc_found_channel < 0
+        && channels > 1
+        && !ltc_samples_look_like_ltc (timecodestamper->ltc_samples, nsamples,
+            timecodestamper->ainfo.rate))
+      continue;
+
+    ltc_decoder_write (ltc_dec, timecodestamper->ltc_samples, nsamples,
+        timecodestamper->ltc_total);
+
+    /* Now read all the timecodes from the decoder that are currently
+     * available and store them in our own queue, which gives us more control
+     * over how things are working. */
+    while (ltc_decoder_read (ltc_dec, &ltc_frame) == 1) {
       SMPTETimecode stc;
-      TimestampedTimecode *ltc_tc;
       GstClockTime ltc_running_time;
 
+      if (timecodestamper->ltc_found_channel != (gint) c) {
+        /* Another channel already had LTC in this buffer */
+        if (timecodestamper->ltc_found_channel >= 0
+            && timecodestamper->ltc_found_total == timecodestamper->ltc_total
+            + nsamples)
+          continue;
+
+        GST_INFO_OBJECT (timecodestamper, "Found LTC on channel %u", c);
+        timecodestamper->ltc_found_channel = c;
+      }
+      timecodestamper->ltc_found_total = timecodestamper->ltc_total + nsamples;
+
       if (ltc_frame.off_start < 0) {
         GstClockTime offset =
             gst_util_uint64_scale (GST_SECOND, -ltc_frame.off_start,
@@ -1878,31 +2046,53 @@ gst_timecodestamper_ltcpad_chain (GstPad * pad,
       ltc_tc->running_time = ltc_running_time;
       /* We fill in the framerate and other metadata later */
       gst_video_time_code_init (&ltc_tc->timecode,
-          0, 0, timecodestamper->ltc_daily_jam, 0,
-          stc.hours, stc.mins, stc.secs, stc.frame, 0);
-
-      /* If we have a discontinuity it might happen that we're getting
-       * timecodes that are in the past relative to timecodes we already have
-       * in our queue. We have to get rid of all the timecodes that are in the
-       * future now. */
-      if (discont) {
-        TimestampedTimecode *tmp;
-
-        while ((tmp = g_queue_peek_tail (&timecodestamper->ltc_current_tcs)) &&
-            tmp->running_time >= ltc_running_time) {
-          gst_video_time_code_clear (&tmp->timecode);
-          g_free (tmp);
-          g_queue_pop_tail (&timecodestamper->ltc_current_tcs);
-        }
+          0, 0, daily_jam, 0, stc.hours, stc.mins, stc.secs, stc.frame, 0);
 
-        g_queue_push_tail (&timecodestamper->ltc_current_tcs,
-            g_steal_pointer (&ltc_tc));
-      } else {
-        g_queue_push_tail (&timecodestamper->ltc_current_tcs,
-            g_steal_pointer (&ltc_tc));
+      g_queue_push_tail (&new_tcs, ltc_tc);
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  timecodestamper->ltc_total += nsamples;
+
+  if (ltc_channel < 0 && timecodestamper->ltc_found_channel >= 0
+      && timecodestamper->ltc_total - timecodestamper->ltc_found_total >
+      LTC_CHANNEL_TIMEOUT * timecodestamper->ainfo.rate) {
+    GST_INFO_OBJECT (timecodestamper, "Lost LTC on channel %d",
+        timecodestamper->ltc_found_channel);
+    timecodestamper->ltc_found_channel = -1;
+  }
+
+  g_mutex_unlock (&timecodestamper->ltc_dec_lock);
+
+  if (daily_jam)
+    g_date_time_unref (daily_jam);
+
+  g_mutex_lock (&timecodestamper->mutex);
+
+  GST_OBJECT_LOCK (timecodestamper);
+  while ((ltc_tc = g_queue_pop_head (&new_tcs))) {
+    /* If we have a discontinuity it might happen that we're getting
+     * timecodes that are in the past relative to timecodes we already have
+     * in our queue. We have to get rid of all the timecodes that are in the
+     * future now. */
+    if (discont) {
+      TimestampedTimecode *tmp;
+
+      while ((tmp = g_queue_peek_tail (&timecodestamper->ltc_current_tcs)) &&
+          tmp->running_time >= ltc_tc->running_time) {
+        gst_video_time_code_clear (&tmp->timecode);
+        g_free (tmp);
+        g_queue_pop_tail (&timecodestamper->ltc_current_tcs);
       }
     }
+
+    g_queue_push_tail (&timecodestamper->ltc_current_tcs, ltc_tc);
   }
+  GST_OBJECT_UNLOCK (timecodestamper);
+
+  if (GST_CLOCK_TIME_IS_VALID (running_time))
+    timecodestamper->ltc_current_running_time = running_time + duration;
 
   /* Notify the video streaming thread that new data is available */
   g_cond_signal (&timecodestamper->ltc_cond_video);
@@ -1917,7 +2107,6 @@ gst_timecodestamper_ltcpad_chain (GstPad * pad,
     while ((timecodestamper->video_current_running_time == GST_CLOCK_TIME_NONE
             || running_time + duration >=
             timecodestamper->video_current_running_time)
-        && timecodestamper->ltc_dec
         && g_queue_get_length (&timecodestamper->ltc_current_tcs) >
         DEFAULT_LTC_QUEUE / 2 && !timecodestamper->video_eos
         && !timecodestamper->ltc_flushing) {
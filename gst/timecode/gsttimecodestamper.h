@@ -89,6 +89,7 @@ struct _GstTimeCodeStamper
   GstClockTime rtc_max_drift;
   gboolean rtc_auto_resync;
   gint timecode_offset;
+  gint ltc_channel;
 
   /* Timecode tracking, protected by object lock */
   GstVideoTimeCode *internal_tc;
@@ -114,7 +115,6 @@ struct _GstTimeCodeStamper
 
   /* Only accessed from audio streaming thread */
   GstAudioInfo ainfo;
-  GstAudioStreamAlign *stream_align;
   GstSegment ltc_segment;
   /* Running time of the first audio buffer passed to the LTC decoder */
   GstClockTime ltc_first_running_time;
@@ -134,9 +134,21 @@ struct _GstTimeCodeStamper
   /* Running time of last video frame we received */
   GstClockTime video_current_running_time;
 
-  /* Protected by mutex above */
-  LTCDecoder *ltc_dec;
+  /* Protected by ltc_dec_lock. This is only taken by the audio streaming
+   * thread and when cleaning up, so that decoding LTC never blocks the video
+   * streaming thread */
+  GMutex ltc_dec_lock;
+  GstAudioStreamAlign *stream_align;
+  /* One decoder per audio channel */
+  LTCDecoder **ltc_decs;
+  guint n_ltc_decs;
   ltc_off_t ltc_total;
+  /* Channel LTC was last decoded from or -1, and ltc_total at that time */
+  gint ltc_found_channel;
+  ltc_off_t ltc_found_total;
+  /* One channel of the current buffer as unsigned 8 bit samples */
+  guint8 *ltc_samples;
+  guint ltc_samples_size;
 
   /* Protected by mutex above */
   gboolean video_flushing;
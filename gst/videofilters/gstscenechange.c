@@ -33,6 +33,14 @@
  *
  * The scenechange element does not work with compressed video.
  *
+ * For high resolution input, the #GstSceneChange:downsample property makes
+ * the detection run on a box-filtered, lower resolution copy of the luma
+ * plane, and #GstSceneChange:n-threads spreads the work over several
+ * threads. #GstSceneChange:roi-type restricts the detection to the regions
+ * of interest of that type found on the buffers, and with
+ * #GstSceneChange:score-meta every buffer gets a
+ * #GstVideoRegionOfInterestMeta of type "scene-change" carrying the score.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v filesrc location=some_file.ogv ! decodebin !
@@ -92,6 +100,15 @@ GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
 
 static GstFlowReturn gst_scene_change_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
+static gboolean gst_scene_change_set_info (GstVideoFilter * filter,
+    GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
+    GstVideoInfo * out_info);
+static gboolean gst_scene_change_stop (GstBaseTransform * trans);
+static void gst_scene_change_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_scene_change_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_scene_change_finalize (GObject * object);
 
 #undef TESTING
 #ifdef TESTING
@@ -100,9 +117,18 @@ static gboolean is_shot_change (int frame_number);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_DOWNSAMPLE,
+  PROP_ROI_TYPE,
+  PROP_N_THREADS,
+  PROP_SCORE_META
 };
 
+#define DEFAULT_DOWNSAMPLE 1
+#define DEFAULT_ROI_TYPE NULL
+#define DEFAULT_N_THREADS 1
+#define DEFAULT_SCORE_META FALSE
+
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, Y42B, Y41B, Y444 }")
 
@@ -118,6 +144,9 @@ GST_ELEMENT_REGISTER_DEFINE (scenechange, "scenechange",
 static void
 gst_scene_change_class_init (GstSceneChangeClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
@@ -132,30 +161,415 @@ gst_scene_change_class_init (GstSceneChangeClass * klass)
       "Video/Filter", "Detects scene changes in video",
       "David Schleef <ds@entropywave.com>");
 
+  gobject_class->set_property = gst_scene_change_set_property;
+  gobject_class->get_property = gst_scene_change_get_property;
+  gobject_class->finalize = gst_scene_change_finalize;
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_scene_change_stop);
+  video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_scene_change_set_info);
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_scene_change_transform_frame_ip);
 
+  /**
+   * GstSceneChange:downsample:
+   *
+   * Factor by which the luma plane is box-filtered in both directions
+   * before comparing frames. 1 compares the frames at full resolution.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DOWNSAMPLE,
+      g_param_spec_uint ("downsample", "Downsample",
+          "Downsampling factor of the analysed picture (1 = full resolution)",
+          1, 64, DEFAULT_DOWNSAMPLE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSceneChange:roi-type:
+   *
+   * If set, only the regions described by the #GstVideoRegionOfInterestMeta
+   * of this type on the incoming buffers are compared. Buffers without any
+   * such meta are compared as a whole.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ROI_TYPE,
+      g_param_spec_string ("roi-type", "ROI type",
+          "Type of the regions of interest to restrict the detection to "
+          "(NULL = whole picture)", DEFAULT_ROI_TYPE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSceneChange:n-threads:
+   *
+   * Number of threads the frames are compared with, each one working on a
+   * band of rows.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      gst_row_bands_param_spec_n_threads (DEFAULT_N_THREADS));
+
+  /**
+   * GstSceneChange:score-meta:
+   *
+   * Add a #GstVideoRegionOfInterestMeta of type "scene-change" covering the
+   * whole picture to every compared buffer. Its "GstSceneChange" parameter
+   * holds the "score" and "threshold" as doubles and whether a
+   * "scene-change" was detected.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SCORE_META,
+      g_param_spec_boolean ("score-meta", "Score meta",
+          "Attach the score to the buffers as a region of interest meta",
+          DEFAULT_SCORE_META, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_scene_change_init (GstSceneChange * scenechange)
 {
+  scenechange->downsample = DEFAULT_DOWNSAMPLE;
+  scenechange->roi_type = g_strdup (DEFAULT_ROI_TYPE);
+  scenechange->n_threads = DEFAULT_N_THREADS;
+  scenechange->score_meta = DEFAULT_SCORE_META;
+}
+
+static void
+gst_scene_change_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_DOWNSAMPLE:
+      scenechange->downsample = g_value_get_uint (value);
+      break;
+    case PROP_ROI_TYPE:
+      g_free (scenechange->roi_type);
+      scenechange->roi_type = g_value_dup_string (value);
+      break;
+    case PROP_N_THREADS:
+      scenechange->n_threads = g_value_get_uint (value);
+      break;
+    case PROP_SCORE_META:
+      scenechange->score_meta = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
+}
+
+static void
+gst_scene_change_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_DOWNSAMPLE:
+      g_value_set_uint (value, scenechange->downsample);
+      break;
+    case PROP_ROI_TYPE:
+      g_value_set_string (value, scenechange->roi_type);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, scenechange->n_threads);
+      break;
+    case PROP_SCORE_META:
+      g_value_set_boolean (value, scenechange->score_meta);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
+}
+
+/* forget about the previous frames */
+static void
+gst_scene_change_reset (GstSceneChange * scenechange)
+{
+  gst_clear_buffer (&scenechange->oldbuf);
+  scenechange->have_prev_plane = FALSE;
+  scenechange->n_diffs = 0;
+  memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+}
+
+static void
+gst_scene_change_free_planes (GstSceneChange * scenechange)
+{
+  g_clear_pointer (&scenechange->planes[0], g_free);
+  g_clear_pointer (&scenechange->planes[1], g_free);
+  scenechange->plane_width = 0;
+  scenechange->plane_height = 0;
+  scenechange->plane_downsample = 0;
+  scenechange->have_prev_plane = FALSE;
+}
+
+static void
+gst_scene_change_finalize (GObject * object)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  gst_scene_change_reset (scenechange);
+  gst_scene_change_free_planes (scenechange);
+  gst_row_bands_clear (&scenechange->row_bands);
+  g_free (scenechange->roi_type);
+
+  G_OBJECT_CLASS (gst_scene_change_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_scene_change_set_info (GstVideoFilter * filter, GstCaps * incaps,
+    GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (filter);
+
+  /* frames of different sizes can't be compared */
+  if (scenechange->oldbuf &&
+      (GST_VIDEO_INFO_WIDTH (in_info) !=
+          GST_VIDEO_INFO_WIDTH (&scenechange->oldinfo)
+          || GST_VIDEO_INFO_HEIGHT (in_info) !=
+          GST_VIDEO_INFO_HEIGHT (&scenechange->oldinfo)))
+    gst_scene_change_reset (scenechange);
+
+  return TRUE;
+}
+
+static gboolean
+gst_scene_change_stop (GstBaseTransform * trans)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (trans);
+
+  gst_scene_change_reset (scenechange);
+  gst_scene_change_free_planes (scenechange);
+  gst_row_bands_clear (&scenechange->row_bands);
+
+  return TRUE;
 }
 
 
+typedef struct
+{
+  /* full resolution luma of the current frame, when downsampling */
+  const guint8 *src;
+  int src_stride;
+  guint factor;
+  int width;
+
+  /* previous and current pictures to compare */
+  const guint8 *p1;
+  int stride1;
+  guint8 *p2;
+  int stride2;
+
+  const GstVideoRectangle *rects;
+  guint n_rects;
+
+  int start, end;               /* rows of the compared pictures */
+  guint64 sad;
+} GstSceneChangeBand;
+
+/* box filter of rows [start, end) of the downsampled picture */
+static void
+downsample_rows (GstSceneChangeBand * band)
+{
+  const guint factor = band->factor;
+  const guint area = factor * factor;
+  const int width = band->width;
+  guint32 *acc = g_new (guint32, width);
+  int x, y;
+  guint i, j;
+
+  for (y = band->start; y < band->end; y++) {
+    const guint8 *src = band->src + (gsize) y * factor * band->src_stride;
+    guint8 *dest = band->p2 + (gsize) y * band->stride2;
+
+    memset (acc, 0, width * sizeof (guint32));
+    for (j = 0; j < factor; j++, src += band->src_stride) {
+      for (x = 0; x < width; x++) {
+        const guint8 *s = src + x * factor;
+        guint32 sum = 0;
+
+        for (i = 0; i < factor; i++)
+          sum += s[i];
+        acc[x] += sum;
+      }
+    }
+
+    for (x = 0; x < width; x++)
+      dest[x] = (acc[x] + area / 2) / area;
+  }
+
+  g_free (acc);
+}
+
+static void
+gst_scene_change_process_band (GstSceneChangeBand * band)
+{
+  guint i;
+
+  if (band->src)
+    downsample_rows (band);
+
+  band->sad = 0;
+  if (!band->p1)
+    return;
+
+  for (i = 0; i < band->n_rects; i++) {
+    const GstVideoRectangle *rect = &band->rects[i];
+    int y0 = MAX (rect->y, band->start);
+    int y1 = MIN (rect->y + rect->h, band->end);
+    guint32 sad = 0;
+
+    if (y0 >= y1)
+      continue;
+
+    orc_sad_nxm_u8 (&sad, band->p1 + (gsize) y0 * band->stride1 + rect->x,
+        band->stride1, band->p2 + (gsize) y0 * band->stride2 + rect->x,
+        band->stride2, rect->w, y1 - y0);
+    band->sad += sad;
+  }
+}
+
+/* Regions of the picture to compare, in coordinates of the compared
+ * pictures */
+static GArray *
+get_regions (GstBuffer * buffer, GQuark roi_type, guint factor, int width,
+    int height)
+{
+  GArray *rects = g_array_new (FALSE, FALSE, sizeof (GstVideoRectangle));
+  GstVideoRectangle rect;
+
+  if (roi_type) {
+    GstMeta *meta;
+    gpointer state = NULL;
+
+    while ((meta = gst_buffer_iterate_meta_filtered (buffer, &state,
+                GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE))) {
+      GstVideoRegionOfInterestMeta *roi =
+          (GstVideoRegionOfInterestMeta *) meta;
+      int x0, y0, x1, y1;
+
+      if (roi->roi_type != roi_type)
+        continue;
+
+      x0 = MIN (roi->x / factor, width);
+      y0 = MIN (roi->y / factor, height);
+      x1 = MIN ((roi->x + roi->w) / factor, width);
+      y1 = MIN ((roi->y + roi->h) / factor, height);
+      if (x0 >= x1 || y0 >= y1)
+        continue;
+
+      rect.x = x0;
+      rect.y = y0;
+      rect.w = x1 - x0;
+      rect.h = y1 - y0;
+      g_array_append_val (rects, rect);
+    }
+  }
+
+  if (rects->len == 0) {
+    rect.x = 0;
+    rect.y = 0;
+    rect.w = width;
+    rect.h = height;
+    g_array_append_val (rects, rect);
+  }
+
+  return rects;
+}
+
+/* Compares @frame to the previous frame, or the downsampled previous frame
+ * to the downsampled @frame when @factor is > 1. Returns the mean absolute
+ * difference per pixel, or a negative value if there is no previous frame */
 static double
-get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
+get_frame_score (GstSceneChange * scenechange, GstVideoFrame * oldframe,
+    GstVideoFrame * frame, guint factor, GQuark roi_type, guint n_threads)
 {
-  guint32 score = 0;
+  GstSceneChangeBand *bands;
+  GArray *rects;
+  guint64 sad = 0, area = 0;
+  gboolean have_prev;
   int width, height;
+  guint n_bands, i;
 
-  width = f1->info.width;
-  height = f1->info.height;
+  width = frame->info.width;
+  height = frame->info.height;
 
-  orc_sad_nxm_u8 (&score, f1->data[0], f1->info.stride[0],
-      f2->data[0], f2->info.stride[0], width, height);
+  if (factor > 1) {
+    width /= factor;
+    height /= factor;
+    have_prev = scenechange->have_prev_plane;
+  } else {
+    have_prev = oldframe != NULL;
+  }
 
-  return ((double) score) / (width * height);
+  rects = get_regions (frame->buffer, roi_type, factor, width, height);
+  for (i = 0; i < rects->len; i++) {
+    GstVideoRectangle *rect = &g_array_index (rects, GstVideoRectangle, i);
+    area += (guint64) rect->w * rect->h;
+  }
+
+  n_bands = gst_row_bands_prepare (&scenechange->row_bands,
+      GST_OBJECT_CAST (scenechange), n_threads, height);
+  bands = g_newa (GstSceneChangeBand, n_bands);
+
+  for (i = 0; i < n_bands; i++) {
+    GstSceneChangeBand *band = &bands[i];
+
+    if (factor > 1) {
+      guint cur = scenechange->have_prev_plane ? 1 : 0;
+
+      band->src = frame->data[0];
+      band->src_stride = frame->info.stride[0];
+      band->p1 = have_prev ? scenechange->planes[1 - cur] : NULL;
+      band->stride1 = width;
+      band->p2 = scenechange->planes[cur];
+      band->stride2 = width;
+    } else {
+      band->src = NULL;
+      band->src_stride = 0;
+      band->p1 = have_prev ? oldframe->data[0] : NULL;
+      band->stride1 = have_prev ? oldframe->info.stride[0] : 0;
+      band->p2 = frame->data[0];
+      band->stride2 = frame->info.stride[0];
+    }
+    band->factor = factor;
+    band->width = width;
+    band->rects = (const GstVideoRectangle *) rects->data;
+    band->n_rects = rects->len;
+    band->start = height * i / n_bands;
+    band->end = height * (i + 1) / n_bands;
+  }
+
+  gst_row_bands_run (&scenechange->row_bands,
+      (GstRowBandsFunc) gst_scene_change_process_band, bands,
+      sizeof (GstSceneChangeBand), n_bands);
+
+  for (i = 0; i < n_bands; i++)
+    sad += bands[i].sad;
+
+  g_array_unref (rects);
+
+  if (factor > 1) {
+    /* the current plane becomes the previous one */
+    if (scenechange->have_prev_plane) {
+      guint8 *tmp = scenechange->planes[0];
+      scenechange->planes[0] = scenechange->planes[1];
+      scenechange->planes[1] = tmp;
+    }
+    scenechange->have_prev_plane = TRUE;
+  }
+
+  if (!have_prev || area == 0)
+    return -1.0;
+
+  return ((double) sad) / area;
 }
 
 static GstFlowReturn
@@ -170,33 +584,79 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
   double score;
   gboolean change;
   gboolean ret;
+  guint factor, n_threads;
+  GQuark roi_type;
+  gboolean score_meta;
   int i;
 
   GST_DEBUG_OBJECT (scenechange, "transform_frame_ip");
 
-  if (!scenechange->oldbuf) {
-    scenechange->n_diffs = 0;
-    memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
-    scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-    memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
-    return GST_FLOW_OK;
-  }
+  GST_OBJECT_LOCK (scenechange);
+  factor = scenechange->downsample;
+  roi_type = scenechange->roi_type ?
+      g_quark_from_string (scenechange->roi_type) : 0;
+  n_threads = scenechange->n_threads;
+  score_meta = scenechange->score_meta;
+  GST_OBJECT_UNLOCK (scenechange);
+
+  factor = MIN (factor, (guint) MAX (MIN (frame->info.width,
+              frame->info.height), 1));
+
+  if (factor > 1) {
+    int plane_width = frame->info.width / factor;
+    int plane_height = frame->info.height / factor;
+
+    if (scenechange->plane_downsample != factor
+        || scenechange->plane_width != plane_width
+        || scenechange->plane_height != plane_height) {
+      gst_scene_change_reset (scenechange);
+      gst_scene_change_free_planes (scenechange);
+      scenechange->planes[0] = g_malloc (plane_width * plane_height);
+      scenechange->planes[1] = g_malloc (plane_width * plane_height);
+      scenechange->plane_width = plane_width;
+      scenechange->plane_height = plane_height;
+      scenechange->plane_downsample = factor;
+    }
 
-  ret =
-      gst_video_frame_map (&oldframe, &scenechange->oldinfo,
-      scenechange->oldbuf, GST_MAP_READ);
-  if (!ret) {
-    GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
-    return GST_FLOW_ERROR;
-  }
+    if (!scenechange->have_prev_plane) {
+      scenechange->n_diffs = 0;
+      memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+    }
+
+    score = get_frame_score (scenechange, NULL, frame, factor, roi_type,
+        n_threads);
+    if (score < 0)
+      return GST_FLOW_OK;
+  } else {
+    if (scenechange->plane_downsample) {
+      gst_scene_change_reset (scenechange);
+      gst_scene_change_free_planes (scenechange);
+    }
+
+    if (!scenechange->oldbuf) {
+      scenechange->n_diffs = 0;
+      memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+      scenechange->oldbuf = gst_buffer_ref (frame->buffer);
+      memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+      return GST_FLOW_OK;
+    }
 
-  score = get_frame_score (&oldframe, frame);
+    ret =
+        gst_video_frame_map (&oldframe, &scenechange->oldinfo,
+        scenechange->oldbuf, GST_MAP_READ);
+    if (!ret) {
+      GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
+      return GST_FLOW_ERROR;
+    }
 
-  gst_video_frame_unmap (&oldframe);
+    score = get_frame_score (scenechange, &oldframe, frame, 1, roi_type,
+        n_threads);
 
-  gst_buffer_unref (scenechange->oldbuf);
-  scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-  memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+    gst_video_frame_unmap (&oldframe);
+
+    /* the new reference is taken once done with the buffer's meta */
+    gst_clear_buffer (&scenechange->oldbuf);
+  }
 
   memmove (scenechange->diffs, scenechange->diffs + 1,
       sizeof (double) * (SC_N_DIFFS - 1));
@@ -256,6 +716,22 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
     gst_pad_push_event (GST_BASE_TRANSFORM_SRC_PAD (scenechange), event);
   }
 
+  if (score_meta && gst_buffer_is_writable (frame->buffer)) {
+    GstVideoRegionOfInterestMeta *meta;
+
+    meta = gst_buffer_add_video_region_of_interest_meta (frame->buffer,
+        "scene-change", 0, 0, frame->info.width, frame->info.height);
+    gst_video_region_of_interest_meta_add_param (meta,
+        gst_structure_new ("GstSceneChange", "score", G_TYPE_DOUBLE, score,
+            "threshold", G_TYPE_DOUBLE, threshold, "scene-change",
+            G_TYPE_BOOLEAN, change, NULL));
+  }
+
+  if (factor == 1) {
+    scenechange->oldbuf = gst_buffer_ref (frame->buffer);
+    memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+  }
+
   return GST_FLOW_OK;
 }
 
@@ -22,6 +22,7 @@
 
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/gst-row-bands-private.h>
 
 G_BEGIN_DECLS
 
@@ -45,6 +46,21 @@ struct _GstSceneChange
   GstBuffer *oldbuf;
   GstVideoInfo oldinfo;
   int count;
+
+  /* properties */
+  guint downsample;
+  gchar *roi_type;
+  guint n_threads;
+  gboolean score_meta;
+
+  /* downsampled luma of the current and previous frames, used instead of
+   * oldbuf when downsampling */
+  guint8 *planes[2];
+  int plane_width, plane_height;
+  guint plane_downsample;
+  gboolean have_prev_plane;
+
+  GstRowBands row_bands;
 };
 
 struct _GstSceneChangeClass
@@ -22,6 +22,9 @@
  *
  * The gsty4mdec element decodes uncompressed video in YUV4MPEG format.
  *
+ * When upstream supports pull mode, several frames are read at once and
+ * pushed without copying if downstream supports #GstVideoMeta.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v filesrc location=file.y4m ! y4mdec ! xvimagesink
@@ -41,6 +44,9 @@
 #include <string.h>
 
 #define MAX_SIZE 32768
+#define MAX_HEADER_LENGTH 80
+/* amount of data read at once in pull mode, rounded to whole frames */
+#define PULL_BLOCK_SIZE (8 * 1024 * 1024)
 
 GST_DEBUG_CATEGORY (y4mdec_debug);
 #define GST_CAT_DEFAULT y4mdec_debug
@@ -57,6 +63,11 @@ static void gst_y4m_dec_finalize (GObject * object);
 
 static GstFlowReturn gst_y4m_dec_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static void gst_y4m_dec_loop (GstPad * pad);
+static gboolean gst_y4m_dec_sink_activate (GstPad * sinkpad,
+    GstObject * parent);
+static gboolean gst_y4m_dec_sink_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
 static gboolean gst_y4m_dec_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 
@@ -129,6 +140,10 @@ gst_y4m_dec_init (GstY4mDec * y4mdec)
       GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_event));
   gst_pad_set_chain_function (y4mdec->sinkpad,
       GST_DEBUG_FUNCPTR (gst_y4m_dec_chain));
+  gst_pad_set_activate_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate));
+  gst_pad_set_activatemode_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate_mode));
   gst_element_add_pad (GST_ELEMENT (y4mdec), y4mdec->sinkpad);
 
   y4mdec->srcpad = gst_pad_new_from_static_template (&gst_y4m_dec_src_template,
@@ -483,163 +498,252 @@ error:
   return FALSE;
 }
 
+/* Parses the stream header at the start of @data, which holds at least
+ * MAX_HEADER_LENGTH bytes, and configures the source pad for it */
 static GstFlowReturn
-gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_y4m_dec_handle_header (GstY4mDec * y4mdec, const guint8 * data)
 {
-  GstY4mDec *y4mdec;
-  int n_avail;
-  GstFlowReturn flow_ret = GST_FLOW_OK;
-#define MAX_HEADER_LENGTH 80
+  gboolean ret;
+  GstCaps *caps;
+  GstQuery *query;
   char header[MAX_HEADER_LENGTH];
   int i;
-  int len;
 
-  y4mdec = GST_Y4M_DEC (parent);
+  memcpy (header, data, MAX_HEADER_LENGTH);
 
-  GST_DEBUG_OBJECT (y4mdec, "chain");
+  header[MAX_HEADER_LENGTH - 1] = 0;
+  for (i = 0; i < MAX_HEADER_LENGTH; i++) {
+    if (header[i] == 0x0a)
+      header[i] = 0;
+  }
 
-  if (GST_BUFFER_IS_DISCONT (buffer)) {
-    GST_DEBUG ("got discont");
-    gst_adapter_clear (y4mdec->adapter);
+  ret = gst_y4m_dec_parse_header (y4mdec, header);
+  if (!ret) {
+    GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+        ("Failed to parse YUV4MPEG header"), (NULL));
+    return GST_FLOW_ERROR;
   }
 
-  gst_adapter_push (y4mdec->adapter, buffer);
-  n_avail = gst_adapter_available (y4mdec->adapter);
+  y4mdec->header_size = strlen (header) + 1;
 
-  if (!y4mdec->have_header) {
-    gboolean ret;
-    GstCaps *caps;
-    GstQuery *query;
+  caps = gst_video_info_to_caps (&y4mdec->info);
+  ret = gst_pad_set_caps (y4mdec->srcpad, caps);
 
-    if (n_avail < MAX_HEADER_LENGTH)
-      return GST_FLOW_OK;
+  query = gst_query_new_allocation (caps, FALSE);
+  y4mdec->video_meta = FALSE;
 
-    gst_adapter_copy (y4mdec->adapter, (guint8 *) header, 0, MAX_HEADER_LENGTH);
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, FALSE);
+    gst_object_unref (y4mdec->pool);
+  }
+  y4mdec->pool = NULL;
 
-    header[MAX_HEADER_LENGTH - 1] = 0;
-    for (i = 0; i < MAX_HEADER_LENGTH; i++) {
-      if (header[i] == 0x0a)
-        header[i] = 0;
-    }
+  if (gst_pad_peer_query (y4mdec->srcpad, query)) {
+    y4mdec->video_meta =
+        gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
 
-    ret = gst_y4m_dec_parse_header (y4mdec, header);
-    if (!ret) {
-      GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
-          ("Failed to parse YUV4MPEG header"), (NULL));
-      return GST_FLOW_ERROR;
-    }
+    /* We only need a pool if we need to do stride conversion for downstream */
+    if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
+            sizeof (y4mdec->info)) != 0) {
+      GstBufferPool *pool = NULL;
+      GstAllocator *allocator = NULL;
+      GstAllocationParams params;
+      GstStructure *config;
+      guint size, min, max;
 
-    y4mdec->header_size = strlen (header) + 1;
-    gst_adapter_flush (y4mdec->adapter, y4mdec->header_size);
+      if (gst_query_get_n_allocation_params (query) > 0) {
+        gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+      } else {
+        allocator = NULL;
+        gst_allocation_params_init (&params);
+      }
 
-    caps = gst_video_info_to_caps (&y4mdec->info);
-    ret = gst_pad_set_caps (y4mdec->srcpad, caps);
+      if (gst_query_get_n_allocation_pools (query) > 0) {
+        gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
+            &max);
+        size = MAX (size, y4mdec->out_info.size);
+      } else {
+        pool = NULL;
+        size = y4mdec->out_info.size;
+        min = max = 0;
+      }
 
-    query = gst_query_new_allocation (caps, FALSE);
-    y4mdec->video_meta = FALSE;
+      if (pool == NULL) {
+        pool = gst_video_buffer_pool_new ();
+      }
 
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, FALSE);
-      gst_object_unref (y4mdec->pool);
+      config = gst_buffer_pool_get_config (pool);
+      gst_buffer_pool_config_set_params (config, caps, size, min, max);
+      gst_buffer_pool_config_set_allocator (config, allocator, &params);
+      gst_buffer_pool_set_config (pool, config);
+
+      if (allocator)
+        gst_object_unref (allocator);
+
+      y4mdec->pool = pool;
     }
-    y4mdec->pool = NULL;
-
-    if (gst_pad_peer_query (y4mdec->srcpad, query)) {
-      y4mdec->video_meta =
-          gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
-
-      /* We only need a pool if we need to do stride conversion for downstream */
-      if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
-              sizeof (y4mdec->info)) != 0) {
-        GstBufferPool *pool = NULL;
-        GstAllocator *allocator = NULL;
-        GstAllocationParams params;
-        GstStructure *config;
-        guint size, min, max;
-
-        if (gst_query_get_n_allocation_params (query) > 0) {
-          gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
-        } else {
-          allocator = NULL;
-          gst_allocation_params_init (&params);
-        }
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBufferPool *pool;
+    GstStructure *config;
+
+    /* No pool, create our own if we need to do stride conversion */
+    pool = gst_video_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
+        0);
+    gst_buffer_pool_set_config (pool, config);
+    y4mdec->pool = pool;
+  }
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, TRUE);
+  }
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+  if (!ret) {
+    GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
+    return GST_FLOW_ERROR;
+  }
 
-        if (gst_query_get_n_allocation_pools (query) > 0) {
-          gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
-              &max);
-          size = MAX (size, y4mdec->out_info.size);
-        } else {
-          pool = NULL;
-          size = y4mdec->out_info.size;
-          min = max = 0;
-        }
+  y4mdec->have_header = TRUE;
 
-        if (pool == NULL) {
-          pool = gst_video_buffer_pool_new ();
-        }
+  return GST_FLOW_OK;
+}
 
-        config = gst_buffer_pool_get_config (pool);
-        gst_buffer_pool_config_set_params (config, caps, size, min, max);
-        gst_buffer_pool_config_set_allocator (config, allocator, &params);
-        gst_buffer_pool_set_config (pool, config);
+/* Converts our byte segment to the time segment we output */
+static void
+gst_y4m_dec_get_time_segment (GstY4mDec * y4mdec, GstSegment * seg)
+{
+  gst_segment_init (seg, GST_FORMAT_TIME);
+  seg->start = gst_y4m_dec_bytes_to_timestamp (y4mdec, y4mdec->segment.start);
+  seg->stop = gst_y4m_dec_bytes_to_timestamp (y4mdec, y4mdec->segment.stop);
+  seg->time = gst_y4m_dec_bytes_to_timestamp (y4mdec, y4mdec->segment.time);
+  seg->base = y4mdec->segment_base;
+}
 
-        if (allocator)
-          gst_object_unref (allocator);
+static void
+gst_y4m_dec_send_segment (GstY4mDec * y4mdec)
+{
+  GstEvent *event;
+  GstSegment seg;
 
-        y4mdec->pool = pool;
-      }
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBufferPool *pool;
-      GstStructure *config;
+  gst_y4m_dec_get_time_segment (y4mdec, &seg);
+  event = gst_event_new_segment (&seg);
+  if (y4mdec->segment_seqnum != GST_SEQNUM_INVALID)
+    gst_event_set_seqnum (event, y4mdec->segment_seqnum);
 
-      /* No pool, create our own if we need to do stride conversion */
-      pool = gst_video_buffer_pool_new ();
-      config = gst_buffer_pool_get_config (pool);
-      gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
-          0);
-      gst_buffer_pool_set_config (pool, config);
-      y4mdec->pool = pool;
-    }
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, TRUE);
+  gst_pad_push_event (y4mdec->srcpad, event);
+  //gst_event_unref (event);
+
+  y4mdec->have_new_segment = FALSE;
+  y4mdec->frame_index = gst_y4m_dec_bytes_to_frames (y4mdec,
+      y4mdec->segment.time);
+  GST_DEBUG ("new frame_index %d", y4mdec->frame_index);
+}
+
+/* Timestamps and pushes the packed frame in @buffer. If downstream supports
+ * GstVideoMeta the buffer is pushed as is with the packed layout described
+ * in the meta, otherwise it is copied into the downstream layout. */
+static GstFlowReturn
+gst_y4m_dec_push_frame (GstY4mDec * y4mdec, GstBuffer * buffer)
+{
+  GST_BUFFER_TIMESTAMP (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+  GST_BUFFER_DURATION (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
+      GST_BUFFER_TIMESTAMP (buffer);
+
+  y4mdec->frame_index++;
+
+  if (y4mdec->video_meta) {
+    gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
+        y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
+        y4mdec->info.offset, y4mdec->info.stride);
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstFlowReturn flow_ret;
+    GstBuffer *outbuf;
+    GstVideoFrame iframe, oframe;
+    gint i, j;
+    gint w, h, istride, ostride;
+    guint8 *src, *dest;
+
+    /* Allocate a new buffer and do stride conversion */
+    g_assert (y4mdec->pool != NULL);
+
+    flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
+    if (flow_ret != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      return flow_ret;
     }
-    gst_query_unref (query);
-    gst_caps_unref (caps);
-    if (!ret) {
-      GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
-      return GST_FLOW_ERROR;
+
+    gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
+    gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+
+    for (i = 0; i < 3; i++) {
+      w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
+      h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
+      istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
+      ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
+      src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
+      dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+
+      for (j = 0; j < h; j++) {
+        memcpy (dest, src, w);
+
+        dest += ostride;
+        src += istride;
+      }
     }
 
-    y4mdec->have_header = TRUE;
+    gst_video_frame_unmap (&iframe);
+    gst_video_frame_unmap (&oframe);
+    gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    gst_buffer_unref (buffer);
+    buffer = outbuf;
   }
 
-  if (y4mdec->have_new_segment) {
-    GstEvent *event;
-    GstClockTime start = gst_y4m_dec_bytes_to_timestamp (y4mdec,
-        y4mdec->segment.start);
-    GstClockTime stop = gst_y4m_dec_bytes_to_timestamp (y4mdec,
-        y4mdec->segment.stop);
-    GstClockTime time = gst_y4m_dec_bytes_to_timestamp (y4mdec,
-        y4mdec->segment.time);
-    GstSegment seg;
+  return gst_pad_push (y4mdec->srcpad, buffer);
+}
+
+static GstFlowReturn
+gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstY4mDec *y4mdec;
+  int n_avail;
+  GstFlowReturn flow_ret = GST_FLOW_OK;
+  char header[MAX_HEADER_LENGTH];
+  int i;
+  int len;
+
+  y4mdec = GST_Y4M_DEC (parent);
+
+  GST_DEBUG_OBJECT (y4mdec, "chain");
+
+  if (GST_BUFFER_IS_DISCONT (buffer)) {
+    GST_DEBUG ("got discont");
+    gst_adapter_clear (y4mdec->adapter);
+  }
+
+  gst_adapter_push (y4mdec->adapter, buffer);
+  n_avail = gst_adapter_available (y4mdec->adapter);
 
-    gst_segment_init (&seg, GST_FORMAT_TIME);
-    seg.start = start;
-    seg.stop = stop;
-    seg.time = time;
-    event = gst_event_new_segment (&seg);
+  if (!y4mdec->have_header) {
+    if (n_avail < MAX_HEADER_LENGTH)
+      return GST_FLOW_OK;
 
-    gst_pad_push_event (y4mdec->srcpad, event);
-    //gst_event_unref (event);
+    gst_adapter_copy (y4mdec->adapter, (guint8 *) header, 0, MAX_HEADER_LENGTH);
 
-    y4mdec->have_new_segment = FALSE;
-    y4mdec->frame_index = gst_y4m_dec_bytes_to_frames (y4mdec,
-        y4mdec->segment.time);
-    GST_DEBUG ("new frame_index %d", y4mdec->frame_index);
+    flow_ret = gst_y4m_dec_handle_header (y4mdec, (const guint8 *) header);
+    if (flow_ret != GST_FLOW_OK)
+      return flow_ret;
 
+    gst_adapter_flush (y4mdec->adapter, y4mdec->header_size);
   }
 
+  if (y4mdec->have_new_segment)
+    gst_y4m_dec_send_segment (y4mdec);
+
   while (1) {
     n_avail = gst_adapter_available (y4mdec->adapter);
     if (n_avail < MAX_HEADER_LENGTH)
@@ -670,69 +774,310 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
     buffer = gst_adapter_take_buffer (y4mdec->adapter, y4mdec->info.size);
 
-    GST_BUFFER_TIMESTAMP (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
-    GST_BUFFER_DURATION (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
-        GST_BUFFER_TIMESTAMP (buffer);
+    flow_ret = gst_y4m_dec_push_frame (y4mdec, buffer);
+    if (flow_ret != GST_FLOW_OK)
+      break;
+  }
 
-    y4mdec->frame_index++;
+  GST_DEBUG ("returning %d", flow_ret);
 
-    if (y4mdec->video_meta) {
-      gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
-          y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
-          y4mdec->info.offset, y4mdec->info.stride);
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBuffer *outbuf;
-      GstVideoFrame iframe, oframe;
-      gint i, j;
-      gint w, h, istride, ostride;
-      guint8 *src, *dest;
-
-      /* Allocate a new buffer and do stride conversion */
-      g_assert (y4mdec->pool != NULL);
-
-      flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
-      if (flow_ret != GST_FLOW_OK) {
-        gst_buffer_unref (buffer);
-        break;
-      }
+  return flow_ret;
+}
 
-      gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
-      gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+/* In pull mode there is no stream-start from upstream to forward, so we
+ * create our own */
+static void
+gst_y4m_dec_send_stream_start (GstY4mDec * y4mdec)
+{
+  GstEvent *event;
+  gchar *stream_id;
 
-      for (i = 0; i < 3; i++) {
-        w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
-        h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
-        istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
-        ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
-        src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
-        dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+  event = gst_pad_get_sticky_event (y4mdec->srcpad, GST_EVENT_STREAM_START, 0);
+  if (event) {
+    gst_event_unref (event);
+    return;
+  }
 
-        for (j = 0; j < h; j++) {
-          memcpy (dest, src, w);
+  stream_id = gst_pad_create_stream_id (y4mdec->srcpad,
+      GST_ELEMENT_CAST (y4mdec), NULL);
+  GST_DEBUG_OBJECT (y4mdec, "creating stream-start %s", stream_id);
+  event = gst_event_new_stream_start (stream_id);
+  gst_event_set_group_id (event, gst_util_group_id_next ());
+  gst_pad_push_event (y4mdec->srcpad, event);
+  g_free (stream_id);
+}
 
-          dest += ostride;
-          src += istride;
-        }
-      }
+static void
+gst_y4m_dec_send_eos (GstY4mDec * y4mdec)
+{
+  GstEvent *event = gst_event_new_eos ();
 
-      gst_video_frame_unmap (&iframe);
-      gst_video_frame_unmap (&oframe);
-      gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
-      gst_buffer_unref (buffer);
-      buffer = outbuf;
+  if (y4mdec->segment_seqnum != GST_SEQNUM_INVALID)
+    gst_event_set_seqnum (event, y4mdec->segment_seqnum);
+
+  gst_y4m_dec_send_stream_start (y4mdec);
+  gst_pad_push_event (y4mdec->srcpad, event);
+}
+
+static void
+gst_y4m_dec_loop (GstPad * pad)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (GST_PAD_PARENT (pad));
+  GstFlowReturn flow_ret;
+  GstBuffer *block = NULL;
+  GstMapInfo map;
+  gsize pos = 0, frame_size, to_read;
+
+  if (!y4mdec->have_header) {
+    gst_y4m_dec_send_stream_start (y4mdec);
+
+    flow_ret = gst_pad_pull_range (pad, 0, MAX_HEADER_LENGTH, &block);
+    if (flow_ret != GST_FLOW_OK)
+      goto pause;
+
+    gst_buffer_map (block, &map, GST_MAP_READ);
+    if (map.size < MAX_HEADER_LENGTH)
+      flow_ret = GST_FLOW_EOS;
+    else
+      flow_ret = gst_y4m_dec_handle_header (y4mdec, map.data);
+    gst_buffer_unmap (block, &map);
+    gst_buffer_unref (block);
+    block = NULL;
+
+    if (flow_ret != GST_FLOW_OK)
+      goto pause;
+
+    if (y4mdec->offset < y4mdec->header_size)
+      y4mdec->offset = y4mdec->header_size;
+  }
+
+  if (y4mdec->have_new_segment)
+    gst_y4m_dec_send_segment (y4mdec);
+
+  /* Read as many frames as fit in a block at once, plus some room for frame
+   * headers with parameters */
+  frame_size = y4mdec->info.size + 6;
+  to_read = MAX (1, PULL_BLOCK_SIZE / frame_size) * frame_size +
+      MAX_HEADER_LENGTH;
+
+  flow_ret = gst_pad_pull_range (pad, y4mdec->offset, to_read, &block);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  gst_buffer_map (block, &map, GST_MAP_READ);
+
+  while (pos < map.size) {
+    const guint8 *nl;
+    gsize len;
+
+    if (y4mdec->segment.stop != -1
+        && y4mdec->offset + pos >= y4mdec->segment.stop) {
+      GST_DEBUG_OBJECT (y4mdec, "reached the segment stop");
+      flow_ret = GST_FLOW_EOS;
+      break;
+    }
+
+    nl = memchr (map.data + pos, 0x0a, MIN (map.size - pos,
+            MAX_HEADER_LENGTH));
+    if (nl == NULL && map.size - pos < MAX_HEADER_LENGTH)
+      break;
+
+    if (nl == NULL || map.size - pos < 5
+        || memcmp (map.data + pos, "FRAME", 5) != 0) {
+      GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+          ("Failed to parse YUV4MPEG frame"), (NULL));
+      flow_ret = GST_FLOW_ERROR;
+      break;
     }
 
-    flow_ret = gst_pad_push (y4mdec->srcpad, buffer);
+    len = nl - (map.data + pos) + 1;
+    if (pos + len + y4mdec->info.size > map.size)
+      break;
+
+    /* the frame shares the memory of the block, nothing is copied when
+     * downstream can handle our layout */
+    flow_ret = gst_y4m_dec_push_frame (y4mdec,
+        gst_buffer_copy_region (block, GST_BUFFER_COPY_MEMORY, pos + len,
+            y4mdec->info.size));
+    pos += len + y4mdec->info.size;
+
     if (flow_ret != GST_FLOW_OK)
       break;
   }
 
-  GST_DEBUG ("returning %d", flow_ret);
+  /* a short read means we reached the end of the file */
+  if (flow_ret == GST_FLOW_OK && map.size < to_read)
+    flow_ret = GST_FLOW_EOS;
 
-  return flow_ret;
+  gst_buffer_unmap (block, &map);
+  gst_buffer_unref (block);
+
+  y4mdec->offset += pos;
+
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  {
+    GST_DEBUG_OBJECT (y4mdec, "pausing task, reason %s",
+        gst_flow_get_name (flow_ret));
+    gst_pad_pause_task (pad);
+    if (flow_ret == GST_FLOW_EOS) {
+      gst_y4m_dec_send_eos (y4mdec);
+    } else if (flow_ret == GST_FLOW_NOT_LINKED || flow_ret < GST_FLOW_EOS) {
+      /* parse errors have been posted already */
+      if (flow_ret != GST_FLOW_ERROR)
+        GST_ELEMENT_FLOW_ERROR (y4mdec, flow_ret);
+      gst_y4m_dec_send_eos (y4mdec);
+    }
+  }
+}
+
+static gboolean
+gst_y4m_dec_sink_activate (GstPad * sinkpad, GstObject * parent)
+{
+  gboolean res = FALSE;
+  GstQuery *query = gst_query_new_scheduling ();
+
+  if (gst_pad_peer_query (sinkpad, query) &&
+      gst_query_has_scheduling_mode_with_flags (query, GST_PAD_MODE_PULL,
+          GST_SCHEDULING_FLAG_SEEKABLE)) {
+    res = gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PULL, TRUE);
+  } else {
+    res = gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PUSH, TRUE);
+  }
+
+  gst_query_unref (query);
+  return res;
+}
+
+static gboolean
+gst_y4m_dec_sink_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (parent);
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      y4mdec->pull_mode = FALSE;
+      y4mdec->segment_base = 0;
+      y4mdec->segment_seqnum = GST_SEQNUM_INVALID;
+      return TRUE;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        y4mdec->pull_mode = TRUE;
+        y4mdec->have_header = FALSE;
+        y4mdec->offset = 0;
+        gst_segment_init (&y4mdec->segment, GST_FORMAT_BYTES);
+        y4mdec->segment_base = 0;
+        y4mdec->segment_seqnum = GST_SEQNUM_INVALID;
+        y4mdec->have_new_segment = TRUE;
+        return gst_pad_start_task (pad, (GstTaskFunction) gst_y4m_dec_loop,
+            pad, NULL);
+      }
+      return gst_pad_stop_task (pad);
+    default:
+      return FALSE;
+  }
+}
+
+static gboolean
+gst_y4m_dec_do_seek_pull (GstY4mDec * y4mdec, GstEvent * event)
+{
+  gdouble rate;
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  gint64 start, stop;
+  gint64 framenum, stop_framenum;
+  guint64 stop_offset;
+  guint32 seqnum = gst_event_get_seqnum (event);
+  gboolean flush;
+
+  gst_event_parse_seek (event, &rate, &format, &flags, &start_type,
+      &start, &stop_type, &stop);
+
+  if (format != GST_FORMAT_TIME || rate <= 0.0 || !y4mdec->have_header)
+    return FALSE;
+
+  framenum = gst_y4m_dec_timestamp_to_frames (y4mdec, start);
+  GST_DEBUG ("seeking to frame %" G_GINT64_FORMAT, framenum);
+  if (framenum == -1)
+    return FALSE;
+
+  switch (stop_type) {
+    case GST_SEEK_TYPE_NONE:
+      stop_offset = y4mdec->segment.stop;
+      break;
+    case GST_SEEK_TYPE_SET:
+      /* include the frame the stop position falls in */
+      stop_framenum = gst_y4m_dec_timestamp_to_frames (y4mdec, stop);
+      if (stop_framenum != -1
+          && gst_y4m_dec_frames_to_timestamp (y4mdec, stop_framenum) < stop)
+        stop_framenum++;
+      stop_offset = gst_y4m_dec_frames_to_bytes (y4mdec, stop_framenum);
+      break;
+    default:
+      stop_offset = -1;
+      break;
+  }
+
+  flush = flags & GST_SEEK_FLAG_FLUSH;
+
+  if (flush) {
+    GstEvent *e = gst_event_new_flush_start ();
+
+    gst_event_set_seqnum (e, seqnum);
+    gst_pad_push_event (y4mdec->srcpad, e);
+  } else {
+    gst_pad_pause_task (y4mdec->sinkpad);
+  }
+
+  GST_PAD_STREAM_LOCK (y4mdec->sinkpad);
+
+  if (flush) {
+    GstEvent *e = gst_event_new_flush_stop (TRUE);
+
+    gst_event_set_seqnum (e, seqnum);
+    gst_pad_push_event (y4mdec->srcpad, e);
+
+    y4mdec->segment_base = 0;
+  } else {
+    GstSegment seg;
+    GstClockTime position;
+
+    /* the running time continues from where the current segment got to */
+    gst_y4m_dec_get_time_segment (y4mdec, &seg);
+    position = gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+    if (GST_CLOCK_TIME_IS_VALID (seg.stop))
+      position = MIN (position, seg.stop);
+    position = MAX (position, seg.start);
+    y4mdec->segment_base = gst_segment_to_running_time (&seg,
+        GST_FORMAT_TIME, position);
+  }
+
+  y4mdec->offset = gst_y4m_dec_frames_to_bytes (y4mdec, framenum);
+  gst_segment_init (&y4mdec->segment, GST_FORMAT_BYTES);
+  y4mdec->segment.start = y4mdec->offset;
+  y4mdec->segment.stop = stop_offset;
+  y4mdec->segment.time = y4mdec->offset;
+  y4mdec->segment_seqnum = seqnum;
+
+  /* downstream keeps its data on a non-flushing seek, tell it right away
+   * where the new segment starts */
+  if (flush)
+    y4mdec->have_new_segment = TRUE;
+  else
+    gst_y4m_dec_send_segment (y4mdec);
+
+  gst_pad_start_task (y4mdec->sinkpad, (GstTaskFunction) gst_y4m_dec_loop,
+      y4mdec->sinkpad, NULL);
+
+  GST_PAD_STREAM_UNLOCK (y4mdec->sinkpad);
+
+  return TRUE;
 }
 
 static gboolean
@@ -805,6 +1150,12 @@ gst_y4m_dec_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       gst_event_parse_seek (event, &rate, &format, &flags, &start_type,
           &start, &stop_type, &stop);
 
+      if (y4mdec->pull_mode) {
+        res = gst_y4m_dec_do_seek_pull (y4mdec, event);
+        gst_event_unref (event);
+        break;
+      }
+
       if (format != GST_FORMAT_TIME) {
         res = FALSE;
         break;
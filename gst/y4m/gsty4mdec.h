@@ -43,12 +43,16 @@ struct _GstY4mDec
   GstAdapter *adapter;
 
   /* state */
+  gboolean pull_mode;
+  guint64 offset;               /* next read position in pull mode */
   gboolean have_header;
   int frame_index;
   int header_size;
 
   gboolean have_new_segment;
   GstSegment segment;
+  GstClockTime segment_base;    /* running time of the segment start */
+  guint32 segment_seqnum;       /* seqnum of the seek, in pull mode */
 
   GstVideoInfo info;
   GstVideoInfo out_info;
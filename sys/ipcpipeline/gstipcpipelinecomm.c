@@ -24,9 +24,21 @@
 #  include "config.h"
 #endif
 
+/* for memfd_create () */
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
+#if defined (HAVE_MEMFD_CREATE) && defined (HAVE_SYS_SOCKET_H) && defined (HAVE_MMAP)
+#  define HAVE_SHM_PAYLOAD 1
+#  include <poll.h>
+#  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <gst/allocators/gstfdmemory.h>
+#endif
 #ifdef _MSC_VER
 /* ssize_t is not available, so match return value of read()/write() on MSVC */
 #define ssize_t int
@@ -42,6 +54,11 @@ GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
 
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
 
+/* Maximum number of shm segments a sender keeps around */
+#define SHM_MAX_SEGMENTS 16
+/* Maximum number of fds accepted in one read from fdin */
+#define SHM_MAX_FDS_PER_READ 8
+
 GQuark QUARK_ID;
 
 typedef enum
@@ -192,6 +209,10 @@ gst_ipc_pipeline_comm_data_type_get_name (GstIpcPipelineCommDataType type)
       return "MESSAGE";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
       return "GERROR_MESSAGE";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_BUFFER:
+      return "SHM_BUFFER";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_RELEASE:
+      return "SHM_RELEASE";
     default:
       return "UNKNOWN";
   }
@@ -262,6 +283,654 @@ write_byte_writer_to_fd (GstIpcPipelineComm * comm, GstByteWriter * bw)
   return ret;
 }
 
+/*
+ * Shared memory payloads
+ *
+ * The sender keeps a small pool of memfd segments. Each buffer is copied
+ * into a free segment and only a reference to it goes through fdout. The
+ * first time a segment is used, its fd is attached to the chunk with
+ * SCM_RIGHTS; the receiver maps it once and keeps it for later buffers.
+ * When the receiver is done with a buffer it sends a SHM_RELEASE chunk so
+ * the sender can reuse the segment. The sender sends the same chunk when
+ * it drops a segment, so the receiver can unmap it.
+ */
+
+typedef struct
+{
+  guint32 id;
+  int fd;
+  guint8 *data;
+  gsize size;
+  gboolean busy;
+  gboolean sent;
+} ShmOutSegment;
+
+typedef struct
+{
+  gint refcount;
+  guint32 id;
+  int fd;
+  guint8 *data;
+  gsize size;
+} ShmInSegment;
+
+typedef struct
+{
+  GstIpcPipelineComm *comm;
+  GstElement *element;
+  ShmInSegment *segment;
+} ShmInBufferData;
+
+#ifdef HAVE_SHM_PAYLOAD
+
+/*
+ * The sink proposes an allocator of memfd backed memory upstream. A buffer
+ * made of a single memory from it is sent by passing that memfd as its
+ * segment, so its data is not copied. While the receiver uses it, the
+ * memory is kept locked so that it is not writable and no upstream pool
+ * recycles it. When the memory is freed, the receiver is told to unmap it.
+ */
+
+typedef struct
+{
+  GstFdAllocator parent;
+
+  /* protected by the object lock, NULL once the comm is gone */
+  GstIpcPipelineComm *comm;
+} GstIpcPipelineShmAllocator;
+
+typedef struct
+{
+  GstFdAllocatorClass parent_class;
+} GstIpcPipelineShmAllocatorClass;
+
+/* Attached to each memory of the allocator, protected by comm->mutex */
+typedef struct
+{
+  GstIpcPipelineShmAllocator *allocator;
+  guint32 id;
+  /* comm->shm_generation when the fd was passed to the peer */
+  guint generation;
+  /* number of buffers the receiver holds on the memory */
+  guint busy;
+} ShmOutMemoryInfo;
+
+static GType gst_ipc_pipeline_shm_allocator_get_type (void);
+G_DEFINE_TYPE (GstIpcPipelineShmAllocator, gst_ipc_pipeline_shm_allocator,
+    GST_TYPE_FD_ALLOCATOR);
+
+static gboolean write_shm_release_to_fd (GstIpcPipelineComm * comm,
+    guint32 segment_id);
+
+static GQuark
+shm_out_memory_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("GstIpcPipelineShmMemory");
+  return quark;
+}
+
+/* Called when the memory is freed */
+static void
+shm_out_memory_info_free (ShmOutMemoryInfo * info)
+{
+  GstIpcPipelineComm *comm;
+
+  GST_OBJECT_LOCK (info->allocator);
+  comm = info->allocator->comm;
+  if (comm) {
+    g_mutex_lock (&comm->mutex);
+    if (info->generation == comm->shm_generation)
+      write_shm_release_to_fd (comm, info->id);
+    g_mutex_unlock (&comm->mutex);
+  }
+  GST_OBJECT_UNLOCK (info->allocator);
+
+  g_free (info);
+}
+
+static GstMemory *
+gst_ipc_pipeline_shm_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  GstIpcPipelineShmAllocator *self = (GstIpcPipelineShmAllocator *) allocator;
+  gsize page_size = sysconf (_SC_PAGESIZE);
+  gsize maxsize = params->prefix + size + params->padding;
+  ShmOutMemoryInfo *info;
+  GstMemory *mem;
+  int fd;
+
+  maxsize = (maxsize + page_size - 1) & ~(page_size - 1);
+
+  fd = memfd_create ("gst-ipcpipeline", MFD_CLOEXEC);
+  if (fd < 0) {
+    GST_WARNING_OBJECT (self, "memfd_create failed: %s", strerror (errno));
+    return NULL;
+  }
+
+  if (ftruncate (fd, maxsize) < 0) {
+    GST_WARNING_OBJECT (self, "ftruncate failed: %s", strerror (errno));
+    close (fd);
+    return NULL;
+  }
+
+  mem = gst_fd_allocator_alloc (allocator, fd, maxsize,
+      GST_FD_MEMORY_FLAG_KEEP_MAPPED);
+  if (!mem) {
+    close (fd);
+    return NULL;
+  }
+  gst_memory_resize (mem, params->prefix, size);
+
+  info = g_new0 (ShmOutMemoryInfo, 1);
+  info->allocator = self;
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem),
+      shm_out_memory_quark (), info, (GDestroyNotify) shm_out_memory_info_free);
+
+  return mem;
+}
+
+static void
+gst_ipc_pipeline_shm_allocator_class_init (GstIpcPipelineShmAllocatorClass *
+    klass)
+{
+  GstAllocatorClass *alloc_class = (GstAllocatorClass *) klass;
+
+  alloc_class->alloc = gst_ipc_pipeline_shm_allocator_alloc;
+}
+
+static void
+gst_ipc_pipeline_shm_allocator_init (GstIpcPipelineShmAllocator * self)
+{
+  GST_OBJECT_FLAG_UNSET (self, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+
+/* Called with comm->mutex held. Returns the memory of @buffer if it can be
+ * sent without copying. */
+static GstMemory *
+shm_out_memory_from_buffer (GstIpcPipelineComm * comm, GstBuffer * buffer)
+{
+  GstMemory *mem;
+
+  if (!comm->shm_allocator || gst_buffer_n_memory (buffer) != 1)
+    return NULL;
+
+  mem = gst_buffer_peek_memory (buffer, 0);
+  if (mem->allocator != comm->shm_allocator)
+    return NULL;
+
+  return mem;
+}
+
+/* Called with comm->mutex held, once @mem was sent */
+static void
+shm_out_memory_hold (GstIpcPipelineComm * comm, GstMemory * mem)
+{
+  ShmOutMemoryInfo *info = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST
+      (mem), shm_out_memory_quark ());
+
+  info->generation = comm->shm_generation;
+  if (info->busy++ == 0) {
+    if (!comm->shm_out_memories)
+      comm->shm_out_memories = g_hash_table_new (NULL, NULL);
+    gst_memory_ref (mem);
+    gst_memory_lock (mem, GST_LOCK_FLAG_EXCLUSIVE);
+    g_hash_table_insert (comm->shm_out_memories, GUINT_TO_POINTER (info->id),
+        mem);
+  }
+}
+
+/* Called with comm->mutex held. Returns the memory to unref once the
+ * mutex is released, if the receiver does not use it anymore. */
+static GstMemory *
+shm_out_memory_release (GstIpcPipelineComm * comm, guint32 segment_id)
+{
+  ShmOutMemoryInfo *info;
+  GstMemory *mem;
+
+  if (!comm->shm_out_memories)
+    return NULL;
+
+  mem = g_hash_table_lookup (comm->shm_out_memories,
+      GUINT_TO_POINTER (segment_id));
+  if (!mem)
+    return NULL;
+
+  info = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (mem),
+      shm_out_memory_quark ());
+  if (--info->busy > 0)
+    return NULL;
+
+  GST_TRACE_OBJECT (comm->element, "shm memory %u released", segment_id);
+  g_hash_table_remove (comm->shm_out_memories, GUINT_TO_POINTER (segment_id));
+  return mem;
+}
+
+static void
+shm_out_memory_unref (GstMemory * mem)
+{
+  gst_memory_unlock (mem, GST_LOCK_FLAG_EXCLUSIVE);
+  gst_memory_unref (mem);
+}
+
+/* Called with comm->mutex held. Returns the memories to unref once the
+ * mutex is released. */
+static GList *
+shm_out_memory_release_all (GstIpcPipelineComm * comm)
+{
+  GList *memories, *l;
+
+  if (!comm->shm_out_memories)
+    return NULL;
+
+  memories = g_hash_table_get_values (comm->shm_out_memories);
+  for (l = memories; l; l = l->next) {
+    ShmOutMemoryInfo *info = gst_mini_object_get_qdata (l->data,
+        shm_out_memory_quark ());
+    info->busy = 0;
+  }
+  g_hash_table_remove_all (comm->shm_out_memories);
+
+  return memories;
+}
+
+static void
+shm_out_segment_free (ShmOutSegment * segment)
+{
+  munmap (segment->data, segment->size);
+  close (segment->fd);
+  g_free (segment);
+}
+
+static ShmOutSegment *
+shm_out_segment_new (GstIpcPipelineComm * comm, gsize size)
+{
+  ShmOutSegment *segment;
+  gsize page_size = sysconf (_SC_PAGESIZE);
+  int fd;
+  void *data;
+
+  size = (size + page_size - 1) & ~(page_size - 1);
+
+  fd = memfd_create ("gst-ipcpipeline", MFD_CLOEXEC);
+  if (fd < 0) {
+    GST_WARNING_OBJECT (comm->element, "memfd_create failed: %s",
+        strerror (errno));
+    return NULL;
+  }
+
+  if (ftruncate (fd, size) < 0) {
+    GST_WARNING_OBJECT (comm->element, "ftruncate failed: %s",
+        strerror (errno));
+    close (fd);
+    return NULL;
+  }
+
+  data = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    GST_WARNING_OBJECT (comm->element, "mmap failed: %s", strerror (errno));
+    close (fd);
+    return NULL;
+  }
+
+  segment = g_new0 (ShmOutSegment, 1);
+  segment->id = ++comm->shm_next_id;
+  segment->fd = fd;
+  segment->data = data;
+  segment->size = size;
+
+  GST_DEBUG_OBJECT (comm->element, "Created shm segment %u of %"
+      G_GSIZE_FORMAT " bytes", segment->id, size);
+
+  return segment;
+}
+
+/* Called with comm->mutex held */
+static gboolean
+write_shm_release_to_fd (GstIpcPipelineComm * comm, guint32 segment_id)
+{
+  const unsigned char payload_type =
+      GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_RELEASE;
+  GstByteWriter bw;
+  gboolean ret = FALSE;
+
+  GST_TRACE_OBJECT (comm->element, "Writing shm release for segment %u",
+      segment_id);
+
+  gst_byte_writer_init (&bw);
+  if (!gst_byte_writer_put_uint8 (&bw, payload_type))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&bw, 0))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&bw, sizeof (guint32)))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&bw, segment_id))
+    goto done;
+
+  ret = write_byte_writer_to_fd (comm, &bw);
+
+done:
+  gst_byte_writer_reset (&bw);
+  if (!ret)
+    GST_WARNING_OBJECT (comm->element, "Failed to write shm release");
+  return ret;
+}
+
+/* Called with comm->mutex held. Returns a segment of at least @size bytes,
+ * or NULL if none became available in time, in which case the caller
+ * falls back to sending the data inline. */
+static ShmOutSegment *
+shm_out_segment_acquire (GstIpcPipelineComm * comm, gsize size)
+{
+  guint64 end_time = g_get_monotonic_time () + comm->ack_time;
+
+  while (TRUE) {
+    ShmOutSegment *best = NULL, *smaller = NULL, *segment;
+    guint i;
+
+    /* may have been dropped by a reset while we were waiting */
+    if (!comm->shm_out_segments)
+      comm->shm_out_segments =
+          g_ptr_array_new_with_free_func ((GDestroyNotify)
+          shm_out_segment_free);
+
+    for (i = 0; i < comm->shm_out_segments->len; i++) {
+      segment = g_ptr_array_index (comm->shm_out_segments, i);
+      if (segment->busy)
+        continue;
+      if (segment->size >= size) {
+        if (!best || segment->size < best->size)
+          best = segment;
+      } else {
+        smaller = segment;
+      }
+    }
+
+    if (best)
+      return best;
+
+    if (comm->shm_out_segments->len >= SHM_MAX_SEGMENTS && smaller) {
+      /* make room for a bigger one */
+      write_shm_release_to_fd (comm, smaller->id);
+      g_ptr_array_remove_fast (comm->shm_out_segments, smaller);
+    }
+
+    if (comm->shm_out_segments->len < SHM_MAX_SEGMENTS) {
+      segment = shm_out_segment_new (comm, size);
+      if (segment)
+        g_ptr_array_add (comm->shm_out_segments, segment);
+      return segment;
+    }
+
+    GST_LOG_OBJECT (comm->element, "Waiting for a free shm segment");
+    if (!g_cond_wait_until (&comm->shm_cond, &comm->mutex, end_time)) {
+      GST_WARNING_OBJECT (comm->element,
+          "No shm segment released in time, sending data inline");
+      return NULL;
+    }
+  }
+}
+
+static void
+shm_out_segment_release (GstIpcPipelineComm * comm, guint32 segment_id)
+{
+  guint i;
+
+  if (!comm->shm_out_segments)
+    return;
+
+  for (i = 0; i < comm->shm_out_segments->len; i++) {
+    ShmOutSegment *segment = g_ptr_array_index (comm->shm_out_segments, i);
+    if (segment->id == segment_id) {
+      GST_TRACE_OBJECT (comm->element, "shm segment %u released", segment_id);
+      segment->busy = FALSE;
+      g_cond_broadcast (&comm->shm_cond);
+      return;
+    }
+  }
+}
+
+static gboolean
+write_byte_writer_with_fd_to_fd (GstIpcPipelineComm * comm,
+    GstByteWriter * bw, int fd)
+{
+  char control[CMSG_SPACE (sizeof (int))];
+  struct msghdr msg = { 0, };
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  guint8 *data;
+  guint size;
+  ssize_t written;
+  gboolean ret;
+
+  size = gst_byte_writer_get_size (bw);
+  data = gst_byte_writer_reset_and_get_data (bw);
+  if (!data)
+    return FALSE;
+
+  iov.iov_base = data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  memset (control, 0, sizeof (control));
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof (control);
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+  do {
+    written = sendmsg (comm->fdout, &msg, MSG_NOSIGNAL);
+    if (written < 0 && errno == EAGAIN) {
+      struct pollfd pfd = { comm->fdout, POLLOUT, 0 };
+
+      /* non-blocking fdout is full, wait until the peer reads from it */
+      if (poll (&pfd, 1, -1) < 0 && errno != EINTR)
+        break;
+    }
+  } while (written < 0 && (errno == EAGAIN || errno == EINTR));
+
+  if (written < 0) {
+    GST_ERROR_OBJECT (comm->element, "Failed to send fd: %s",
+        strerror (errno));
+    g_free (data);
+    return FALSE;
+  }
+
+  /* the fd went with the first byte, the rest can be written normally */
+  ret = write_to_fd_raw (comm, data + written, size - written);
+  g_free (data);
+  return ret;
+}
+
+static void
+shm_in_segment_unref (ShmInSegment * segment)
+{
+  if (!g_atomic_int_dec_and_test (&segment->refcount))
+    return;
+
+  munmap (segment->data, segment->size);
+  close (segment->fd);
+  g_free (segment);
+}
+
+static void
+shm_in_buffer_data_free (ShmInBufferData * data)
+{
+  GstIpcPipelineComm *comm = data->comm;
+
+  /* must not be called with comm->mutex held */
+  g_mutex_lock (&comm->mutex);
+  if (comm->shm_in_segments &&
+      g_hash_table_lookup (comm->shm_in_segments,
+          GUINT_TO_POINTER (data->segment->id)) == data->segment)
+    write_shm_release_to_fd (comm, data->segment->id);
+  g_mutex_unlock (&comm->mutex);
+
+  shm_in_segment_unref (data->segment);
+  gst_object_unref (data->element);
+  g_free (data);
+}
+
+/* Called from the reader thread */
+static GstBuffer *
+shm_in_segment_wrap (GstIpcPipelineComm * comm, guint32 segment_id,
+    guint64 segment_size, guint64 data_offset, guint32 data_size,
+    gboolean has_fd)
+{
+  ShmInSegment *segment;
+  ShmInBufferData *data;
+
+  g_mutex_lock (&comm->mutex);
+
+  if (!comm->shm_in_segments)
+    comm->shm_in_segments = g_hash_table_new_full (NULL, NULL, NULL,
+        (GDestroyNotify) shm_in_segment_unref);
+
+  if (has_fd) {
+    int fd = GPOINTER_TO_INT (g_queue_pop_head (&comm->shm_fds)) - 1;
+    void *map;
+
+    if (fd < 0) {
+      GST_ERROR_OBJECT (comm->element, "No fd received for shm segment %u",
+          segment_id);
+      goto error;
+    }
+
+    map = mmap (NULL, segment_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+      GST_ERROR_OBJECT (comm->element, "Failed to map shm segment %u: %s",
+          segment_id, strerror (errno));
+      close (fd);
+      goto error;
+    }
+
+    segment = g_new0 (ShmInSegment, 1);
+    segment->refcount = 1;
+    segment->id = segment_id;
+    segment->fd = fd;
+    segment->data = map;
+    segment->size = segment_size;
+    g_hash_table_replace (comm->shm_in_segments, GUINT_TO_POINTER (segment_id),
+        segment);
+    GST_DEBUG_OBJECT (comm->element, "Mapped shm segment %u of %"
+        G_GUINT64_FORMAT " bytes", segment_id, segment_size);
+  } else {
+    segment = g_hash_table_lookup (comm->shm_in_segments,
+        GUINT_TO_POINTER (segment_id));
+    if (!segment) {
+      GST_ERROR_OBJECT (comm->element, "Unknown shm segment %u", segment_id);
+      goto error;
+    }
+  }
+
+  if (data_offset > segment->size || data_size > segment->size - data_offset)
+    goto error;
+
+  data = g_new (ShmInBufferData, 1);
+  data->comm = comm;
+  data->element = gst_object_ref (comm->element);
+  data->segment = segment;
+  g_atomic_int_inc (&segment->refcount);
+
+  g_mutex_unlock (&comm->mutex);
+
+  return gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      segment->data, segment->size, data_offset, data_size, data,
+      (GDestroyNotify) shm_in_buffer_data_free);
+
+error:
+  g_mutex_unlock (&comm->mutex);
+  return NULL;
+}
+
+/* Called from the reader thread when a SHM_RELEASE chunk is received */
+static void
+shm_segment_released (GstIpcPipelineComm * comm, guint32 segment_id)
+{
+  GstMemory *mem;
+
+  g_mutex_lock (&comm->mutex);
+  shm_out_segment_release (comm, segment_id);
+  mem = shm_out_memory_release (comm, segment_id);
+  if (comm->shm_in_segments &&
+      g_hash_table_remove (comm->shm_in_segments,
+          GUINT_TO_POINTER (segment_id)))
+    GST_DEBUG_OBJECT (comm->element, "Dropped shm segment %u", segment_id);
+  g_mutex_unlock (&comm->mutex);
+
+  /* freeing it may need the mutex to tell the peer */
+  if (mem)
+    shm_out_memory_unref (mem);
+}
+
+#endif /* HAVE_SHM_PAYLOAD */
+
+/* Forgets all shm segments on both the sending and the receiving side.
+ * Must be called whenever the peer goes away: its segment ids are
+ * meaningless to the next peer, and segments it still held must not make
+ * the sender wait for releases that will never come. Buffers that still
+ * wrap a received segment keep it mapped until they are freed. */
+void
+gst_ipc_pipeline_comm_reset_shm (GstIpcPipelineComm * comm)
+{
+  GList *memories = NULL;
+  int fd;
+
+  g_mutex_lock (&comm->mutex);
+#ifdef HAVE_SHM_PAYLOAD
+  memories = shm_out_memory_release_all (comm);
+#endif
+  comm->shm_generation++;
+  if (comm->shm_out_segments) {
+    g_ptr_array_unref (comm->shm_out_segments);
+    comm->shm_out_segments = NULL;
+  }
+  if (comm->shm_in_segments) {
+    g_hash_table_destroy (comm->shm_in_segments);
+    comm->shm_in_segments = NULL;
+  }
+  while ((fd = GPOINTER_TO_INT (g_queue_pop_head (&comm->shm_fds)) - 1) >= 0)
+    close (fd);
+  comm->fdin_not_socket = FALSE;
+  g_cond_broadcast (&comm->shm_cond);
+  g_mutex_unlock (&comm->mutex);
+
+#ifdef HAVE_SHM_PAYLOAD
+  g_list_free_full (memories, (GDestroyNotify) shm_out_memory_unref);
+#else
+  g_assert (memories == NULL);
+#endif
+}
+
+/* Returns the allocator to propose upstream, if buffers allocated from it
+ * can be sent without copying their data */
+GstAllocator *
+gst_ipc_pipeline_comm_get_shm_allocator (GstIpcPipelineComm * comm)
+{
+  GstAllocator *allocator = NULL;
+
+#ifdef HAVE_SHM_PAYLOAD
+  g_mutex_lock (&comm->mutex);
+  if (comm->shm_payload) {
+    if (!comm->shm_allocator) {
+      comm->shm_allocator =
+          g_object_new (gst_ipc_pipeline_shm_allocator_get_type (), NULL);
+      gst_object_ref_sink (comm->shm_allocator);
+      ((GstIpcPipelineShmAllocator *) comm->shm_allocator)->comm = comm;
+    }
+    allocator = gst_object_ref (comm->shm_allocator);
+  }
+  g_mutex_unlock (&comm->mutex);
+#endif
+
+  return allocator;
+}
+
 static void
 gst_ipc_pipeline_comm_write_ack_to_fd (GstIpcPipelineComm * comm, guint32 id,
     guint32 ret, CommRequestType type)
@@ -503,11 +1172,16 @@ typedef struct
   guint64 flags;
 } CommBufferMetadata;
 
+/* segment id, segment size, data offset, data size, has fd */
+#define SHM_BUFFER_REF_SIZE (4 + 8 + 8 + 4 + 1)
+
 GstFlowReturn
 gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
     GstBuffer * buffer)
 {
-  const unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
+  unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
+  gpointer shm_segment = NULL;
+  GstMemory *shm_memory = NULL;
   GstMapInfo map;
   guint32 ret32 = GST_FLOW_OK;
   guint32 size, n;
@@ -534,29 +1208,105 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   /* work out meta size */
   gst_buffer_foreach_meta (buffer, build_meta, &repr);
 
+#ifdef HAVE_SHM_PAYLOAD
+  if (comm->shm_payload && gst_buffer_get_size (buffer) > 0) {
+    /* buffers from the allocator we proposed are sent as they are, others
+     * are copied into one of our segments */
+    shm_memory = shm_out_memory_from_buffer (comm, buffer);
+    if (!shm_memory)
+      shm_segment = shm_out_segment_acquire (comm,
+          gst_buffer_get_size (buffer));
+    if (shm_memory || shm_segment)
+      payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_BUFFER;
+  }
+#endif
+
   if (!gst_byte_writer_put_uint8 (&bw, payload_type))
     goto write_failed;
   if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
     goto write_failed;
   size =
-      gst_buffer_get_size (buffer) + sizeof (guint32) +
+      (payload_type == GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_BUFFER ?
+      SHM_BUFFER_REF_SIZE : gst_buffer_get_size (buffer) + sizeof (guint32)) +
       sizeof (CommBufferMetadata) + repr.total_bytes;
   if (!gst_byte_writer_put_uint32_le (&bw, size))
     goto write_failed;
   if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
     goto write_failed;
   size = gst_buffer_get_size (buffer);
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!write_byte_writer_to_fd (comm, &bw))
-    goto write_failed;
 
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
-    goto map_failed;
-  ret = write_to_fd_raw (comm, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
-  if (!ret)
-    goto write_failed;
+#ifdef HAVE_SHM_PAYLOAD
+  if (payload_type == GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_BUFFER) {
+    guint32 segment_id;
+    guint64 segment_size, offset;
+    gboolean sent;
+    int fd;
+
+    if (shm_memory) {
+      ShmOutMemoryInfo *info =
+          gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (shm_memory),
+          shm_out_memory_quark ());
+
+      if (info->id == 0)
+        info->id = ++comm->shm_next_id;
+      segment_id = info->id;
+      segment_size = shm_memory->maxsize;
+      offset = shm_memory->offset;
+      sent = info->generation == comm->shm_generation;
+      fd = gst_fd_memory_get_fd (shm_memory);
+    } else {
+      ShmOutSegment *segment = shm_segment;
+
+      /* fallback: the buffer was not allocated from our allocator */
+      gst_buffer_extract (buffer, 0, segment->data, size);
+
+      segment_id = segment->id;
+      segment_size = segment->size;
+      offset = 0;
+      sent = segment->sent;
+      fd = segment->fd;
+    }
+
+    if (!gst_byte_writer_put_uint32_le (&bw, segment_id))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint64_le (&bw, segment_size))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint64_le (&bw, offset))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint8 (&bw, !sent))
+      goto write_failed;
+
+    if (sent) {
+      if (!write_byte_writer_to_fd (comm, &bw))
+        goto write_failed;
+    } else {
+      if (!write_byte_writer_with_fd_to_fd (comm, &bw, fd))
+        goto write_failed;
+    }
+
+    if (shm_memory) {
+      shm_out_memory_hold (comm, shm_memory);
+    } else {
+      ((ShmOutSegment *) shm_segment)->sent = TRUE;
+      ((ShmOutSegment *) shm_segment)->busy = TRUE;
+    }
+  } else
+#endif
+  {
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!write_byte_writer_to_fd (comm, &bw))
+      goto write_failed;
+
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+      goto map_failed;
+    ret = write_to_fd_raw (comm, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+    if (!ret)
+      goto write_failed;
+  }
 
   /* meta */
   gst_byte_writer_init (&bw);
@@ -627,12 +1377,14 @@ map_failed:
   goto done;
 }
 
+static GstBuffer *gst_ipc_pipeline_comm_read_buffer_metas (GstIpcPipelineComm *
+    comm, GstBuffer * buffer, const CommBufferMetadata * bmeta, guint32 size);
+
 static GstBuffer *
 gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
 {
   GstBuffer *buffer;
   CommBufferMetadata meta;
-  guint32 n_meta, n;
   const guint8 *payload = NULL;
   guint32 mapped_size, buffer_data_size;
 
@@ -659,12 +1411,65 @@ gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
   }
   size -= buffer_data_size;
 
-  GST_BUFFER_PTS (buffer) = meta.pts;
-  GST_BUFFER_DTS (buffer) = meta.dts;
-  GST_BUFFER_DURATION (buffer) = meta.duration;
-  GST_BUFFER_OFFSET (buffer) = meta.offset;
-  GST_BUFFER_OFFSET_END (buffer) = meta.offset_end;
-  GST_BUFFER_FLAGS (buffer) = meta.flags;
+  return gst_ipc_pipeline_comm_read_buffer_metas (comm, buffer, &meta, size);
+}
+
+#ifdef HAVE_SHM_PAYLOAD
+static GstBuffer *
+gst_ipc_pipeline_comm_read_shm_buffer (GstIpcPipelineComm * comm, guint32 size)
+{
+  GstBuffer *buffer;
+  CommBufferMetadata meta;
+  const guint8 *payload = NULL;
+  guint32 mapped_size, segment_id, buffer_data_size;
+  guint64 segment_size, data_offset;
+  guint8 has_fd;
+
+  /* this should not be called if we don't have enough yet */
+  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
+  g_return_val_if_fail (size >= sizeof (CommBufferMetadata) +
+      SHM_BUFFER_REF_SIZE, NULL);
+
+  mapped_size = sizeof (CommBufferMetadata) + SHM_BUFFER_REF_SIZE;
+  payload = gst_adapter_map (comm->adapter, mapped_size);
+  if (!payload)
+    return NULL;
+  memcpy (&meta, payload, sizeof (CommBufferMetadata));
+  payload += sizeof (CommBufferMetadata);
+  segment_id = GST_READ_UINT32_LE (payload);
+  segment_size = GST_READ_UINT64_LE (payload + 4);
+  data_offset = GST_READ_UINT64_LE (payload + 12);
+  buffer_data_size = GST_READ_UINT32_LE (payload + 20);
+  has_fd = payload[24];
+  size -= mapped_size;
+  gst_adapter_unmap (comm->adapter);
+  gst_adapter_flush (comm->adapter, mapped_size);
+
+  buffer = shm_in_segment_wrap (comm, segment_id, segment_size, data_offset,
+      buffer_data_size, has_fd);
+  if (!buffer) {
+    gst_adapter_flush (comm->adapter, size);
+    return NULL;
+  }
+
+  return gst_ipc_pipeline_comm_read_buffer_metas (comm, buffer, &meta, size);
+}
+#endif
+
+static GstBuffer *
+gst_ipc_pipeline_comm_read_buffer_metas (GstIpcPipelineComm * comm,
+    GstBuffer * buffer, const CommBufferMetadata * bmeta, guint32 size)
+{
+  guint32 n_meta, n;
+  const guint8 *payload = NULL;
+  guint32 mapped_size;
+
+  GST_BUFFER_PTS (buffer) = bmeta->pts;
+  GST_BUFFER_DTS (buffer) = bmeta->dts;
+  GST_BUFFER_DURATION (buffer) = bmeta->duration;
+  GST_BUFFER_OFFSET (buffer) = bmeta->offset;
+  GST_BUFFER_OFFSET_END (buffer) = bmeta->offset_end;
+  GST_BUFFER_FLAGS (buffer) = bmeta->flags;
 
   /* If you don't call that, the GType isn't yet known at the
      g_type_from_name below */
@@ -1614,14 +2419,41 @@ gst_ipc_pipeline_comm_init (GstIpcPipelineComm * comm, GstElement * element)
   comm->adapter = gst_adapter_new ();
   comm->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&comm->pollFDin);
+  g_cond_init (&comm->shm_cond);
+  g_queue_init (&comm->shm_fds);
+  /* memories start at generation 0, which means their fd was never sent */
+  comm->shm_generation = 1;
 }
 
 void
 gst_ipc_pipeline_comm_clear (GstIpcPipelineComm * comm)
 {
+  int fd;
+
   g_hash_table_destroy (comm->waiting_ids);
   gst_object_unref (comm->adapter);
   gst_poll_free (comm->poll);
+  if (comm->shm_out_segments)
+    g_ptr_array_unref (comm->shm_out_segments);
+  if (comm->shm_in_segments)
+    g_hash_table_destroy (comm->shm_in_segments);
+  while ((fd = GPOINTER_TO_INT (g_queue_pop_head (&comm->shm_fds)) - 1) >= 0)
+    close (fd);
+#ifdef HAVE_SHM_PAYLOAD
+  if (comm->shm_allocator) {
+    /* memories allocated upstream may outlive us */
+    GST_OBJECT_LOCK (comm->shm_allocator);
+    ((GstIpcPipelineShmAllocator *) comm->shm_allocator)->comm = NULL;
+    GST_OBJECT_UNLOCK (comm->shm_allocator);
+    gst_object_unref (comm->shm_allocator);
+  }
+  if (comm->shm_out_memories) {
+    g_list_free_full (shm_out_memory_release_all (comm),
+        (GDestroyNotify) shm_out_memory_unref);
+    g_hash_table_destroy (comm->shm_out_memories);
+  }
+#endif
+  g_cond_clear (&comm->shm_cond);
   g_mutex_clear (&comm->mutex);
 }
 
@@ -1654,6 +2486,7 @@ gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm, gboolean cleanup)
 {
   g_mutex_lock (&comm->mutex);
   g_hash_table_foreach (comm->waiting_ids, cancel_request_error, comm);
+  g_cond_broadcast (&comm->shm_cond);
   if (cleanup) {
     g_hash_table_unref (comm->waiting_ids);
     comm->waiting_ids =
@@ -1706,6 +2539,59 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
   return TRUE;
 }
 
+/* Reads from fdin, collecting any fds passed along with the data */
+static ssize_t
+read_from_fd (GstIpcPipelineComm * comm, void *data, size_t size)
+{
+#ifdef HAVE_SHM_PAYLOAD
+  char control[CMSG_SPACE (sizeof (int) * SHM_MAX_FDS_PER_READ)];
+  struct msghdr msg = { 0, };
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  ssize_t sz;
+
+  if (comm->fdin_not_socket)
+    return read (comm->pollFDin.fd, data, size);
+
+  iov.iov_base = data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof (control);
+
+  sz = recvmsg (comm->pollFDin.fd, &msg, MSG_CMSG_CLOEXEC);
+  if (sz < 0 && errno == ENOTSOCK) {
+    comm->fdin_not_socket = TRUE;
+    return read (comm->pollFDin.fd, data, size);
+  }
+
+  if (msg.msg_flags & MSG_CTRUNC)
+    GST_WARNING_OBJECT (comm->element, "Some fds were dropped");
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); sz >= 0 && cmsg;
+      cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    int *fds, n_fds, i;
+
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+
+    fds = (int *) CMSG_DATA (cmsg);
+    n_fds = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+    g_mutex_lock (&comm->mutex);
+    for (i = 0; i < n_fds; i++) {
+      GST_TRACE_OBJECT (comm->element, "Received fd %d", fds[i]);
+      g_queue_push_tail (&comm->shm_fds, GINT_TO_POINTER (fds[i] + 1));
+    }
+    g_mutex_unlock (&comm->mutex);
+  }
+
+  return sz;
+#else
+  return read (comm->pollFDin.fd, data, size);
+#endif
+}
+
 static gint
 update_adapter (GstIpcPipelineComm * comm)
 {
@@ -1752,7 +2638,7 @@ again:
       mem = gst_allocator_alloc (NULL, comm->read_chunk_size, NULL);
 
     gst_memory_map (mem, &map, GST_MAP_WRITE);
-    sz = read (comm->pollFDin.fd, map.data, map.size);
+    sz = read_from_fd (comm, map.data, map.size);
     gst_memory_unmap (mem, &map);
 
     if (sz <= 0) {
@@ -1817,6 +2703,10 @@ read_many (GstIpcPipelineComm * comm)
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
+#ifdef HAVE_SHM_PAYLOAD
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_BUFFER:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_RELEASE:
+#endif
             GST_TRACE_OBJECT (comm->element, "switching to state %s",
                 gst_ipc_pipeline_comm_data_type_get_name (type));
             comm->state = type;
@@ -1881,6 +2771,9 @@ read_many (GstIpcPipelineComm * comm)
         break;
       }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER:
+#ifdef HAVE_SHM_PAYLOAD
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_BUFFER:
+#endif
       {
         GstBuffer *buf;
 
@@ -1888,7 +2781,13 @@ read_many (GstIpcPipelineComm * comm)
         if (available < comm->payload_length)
           goto done;
 
-        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
+#ifdef HAVE_SHM_PAYLOAD
+        if (comm->state == GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_BUFFER)
+          buf = gst_ipc_pipeline_comm_read_shm_buffer (comm,
+              comm->payload_length);
+        else
+#endif
+          buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
         if (!buf)
           goto buffer_failed;
 
@@ -1912,6 +2811,31 @@ read_many (GstIpcPipelineComm * comm)
         comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
         break;
       }
+#ifdef HAVE_SHM_PAYLOAD
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_RELEASE:
+      {
+        const guint8 *data;
+        guint32 segment_id;
+
+        available = gst_adapter_available (comm->adapter);
+        if (available < comm->payload_length)
+          goto done;
+
+        if (comm->payload_length < sizeof (guint32))
+          goto out_of_sync;
+
+        data = gst_adapter_map (comm->adapter, sizeof (guint32));
+        segment_id = GST_READ_UINT32_LE (data);
+        gst_adapter_unmap (comm->adapter);
+        gst_adapter_flush (comm->adapter, comm->payload_length);
+
+        shm_segment_released (comm, segment_id);
+
+        GST_TRACE_OBJECT (comm->element, "switching to state TYPE");
+        comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
+        break;
+      }
+#endif
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_EVENT:
       {
         GstEvent *event;
@@ -51,6 +51,8 @@ typedef enum {
   GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_BUFFER,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_SHM_RELEASE,
 } GstIpcPipelineCommDataType;
 
 typedef struct
@@ -76,6 +78,26 @@ typedef struct
   guint read_chunk_size;
   GstClockTime ack_time;
 
+  /* sender side: buffer payloads go through memfd segments passed
+   * with SCM_RIGHTS instead of being written to fdout */
+  gboolean shm_payload;
+  GPtrArray *shm_out_segments;
+  guint32 shm_next_id;
+  GCond shm_cond;
+
+  /* sender side: allocator proposed upstream, buffers allocated from it
+   * are sent without copying. The memories the receiver still uses are
+   * kept by segment id. The generation changes with the peer. */
+  GstAllocator *shm_allocator;
+  GHashTable *shm_out_memories;
+  guint shm_generation;
+
+  /* receiver side: segments mapped so far, and fds received
+   * on fdin that were not claimed by a buffer yet */
+  GHashTable *shm_in_segments;
+  GQueue shm_fds;
+  gboolean fdin_not_socket;
+
   void (*on_buffer) (guint32, GstBuffer *, gpointer);
   void (*on_event) (guint32, GstEvent *, gboolean, gpointer);
   void (*on_query) (guint32, GstQuery *, gboolean, gpointer);
@@ -92,6 +114,9 @@ void gst_ipc_pipeline_comm_init (GstIpcPipelineComm *comm, GstElement *e);
 void gst_ipc_pipeline_comm_clear (GstIpcPipelineComm *comm);
 void gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm,
     gboolean flushing);
+void gst_ipc_pipeline_comm_reset_shm (GstIpcPipelineComm * comm);
+GstAllocator * gst_ipc_pipeline_comm_get_shm_allocator (
+    GstIpcPipelineComm * comm);
 
 void gst_ipc_pipeline_comm_write_flow_ack_to_fd (GstIpcPipelineComm * comm,
     guint32 id, GstFlowReturn ret);
@@ -66,7 +66,12 @@
  * GError are serialized differently).
  *
  * Buffers are transported by writing their content directly on the socket.
- * More efficient ways for memory sharing could be implemented in the future.
+ * If #GstIpcPipelineSink:shm-payload is enabled and fdout is a unix socket,
+ * buffer contents are instead copied once into a pool of memfd segments that
+ * are passed to the other process with SCM_RIGHTS and mapped there, so the
+ * data itself never goes through the socket. A memfd backed allocator is
+ * also proposed upstream, and buffers allocated from it are passed without
+ * any copy. Events, queries, messages and state changes are not affected.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -99,11 +104,13 @@ enum
   PROP_FDOUT,
   PROP_READ_CHUNK_SIZE,
   PROP_ACK_TIME,
+  PROP_SHM_PAYLOAD,
 };
 
 
 #define DEFAULT_READ_CHUNK_SIZE 4096
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
+#define DEFAULT_SHM_PAYLOAD FALSE
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_sink_debug, "ipcpipelinesink", 0, "ipcpipelinesink element");
@@ -179,6 +186,22 @@ gst_ipc_pipeline_sink_class_init (GstIpcPipelineSinkClass * klass)
           0, G_MAXUINT64, DEFAULT_ACK_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstIpcPipelineSink:shm-payload:
+   *
+   * Pass buffer contents through shared memory instead of writing them to
+   * fdout. Requires fdout to be a unix domain socket. If no shared memory
+   * segment becomes free within #GstIpcPipelineSink:ack-time, the buffer is
+   * sent inline as usual.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SHM_PAYLOAD,
+      g_param_spec_boolean ("shm-payload", "Shared memory payload",
+          "Pass buffer contents through shared memory (fdout must be "
+          "a unix socket)", DEFAULT_SHM_PAYLOAD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_ipc_pipeline_sink_signals[SIGNAL_DISCONNECT] =
       g_signal_new ("disconnect",
       G_TYPE_FROM_CLASS (klass),
@@ -214,6 +237,7 @@ gst_ipc_pipeline_sink_init (GstIpcPipelineSink * sink)
   gst_ipc_pipeline_comm_init (&sink->comm, GST_ELEMENT (sink));
   sink->comm.read_chunk_size = DEFAULT_READ_CHUNK_SIZE;
   sink->comm.ack_time = DEFAULT_ACK_TIME;
+  sink->comm.shm_payload = DEFAULT_SHM_PAYLOAD;
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
   sink->threads = g_thread_pool_new (pusher, sink, -1, FALSE, NULL);
@@ -265,9 +289,11 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_FDIN:
       sink->comm.fdin = g_value_get_int (value);
+      gst_ipc_pipeline_comm_reset_shm (&sink->comm);
       break;
     case PROP_FDOUT:
       sink->comm.fdout = g_value_get_int (value);
+      gst_ipc_pipeline_comm_reset_shm (&sink->comm);
       break;
     case PROP_READ_CHUNK_SIZE:
       sink->comm.read_chunk_size = g_value_get_uint (value);
@@ -275,6 +301,11 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       sink->comm.ack_time = g_value_get_uint64 (value);
       break;
+    case PROP_SHM_PAYLOAD:
+      g_mutex_lock (&sink->comm.mutex);
+      sink->comm.shm_payload = g_value_get_boolean (value);
+      g_mutex_unlock (&sink->comm.mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -300,6 +331,9 @@ gst_ipc_pipeline_sink_get_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       g_value_set_uint64 (value, sink->comm.ack_time);
       break;
+    case PROP_SHM_PAYLOAD:
+      g_value_set_boolean (value, sink->comm.shm_payload);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -348,8 +382,21 @@ gst_ipc_pipeline_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 
   switch (GST_QUERY_TYPE (query)) {
     case GST_QUERY_ALLOCATION:
-      GST_DEBUG_OBJECT (sink, "Rejecting ALLOCATION query");
-      return FALSE;
+    {
+      GstAllocator *allocator;
+
+      allocator = gst_ipc_pipeline_comm_get_shm_allocator (&sink->comm);
+      if (!allocator) {
+        GST_DEBUG_OBJECT (sink, "Rejecting ALLOCATION query");
+        return FALSE;
+      }
+
+      /* buffers allocated from it are sent without copying */
+      GST_DEBUG_OBJECT (sink, "Proposing shared memory allocator");
+      gst_query_add_allocation_param (query, allocator, NULL);
+      gst_object_unref (allocator);
+      return TRUE;
+    }
     case GST_QUERY_CAPS:
     {
       /* caps queries occur even while linking the pipeline.
@@ -581,6 +628,7 @@ gst_ipc_pipeline_sink_disconnect (GstIpcPipelineSink * sink)
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
   gst_ipc_pipeline_comm_cancel (&sink->comm, FALSE);
+  gst_ipc_pipeline_comm_reset_shm (&sink->comm);
   gst_ipc_pipeline_sink_start_reader_thread (sink);
 }
 
@@ -717,6 +765,9 @@ gst_ipc_pipeline_sink_change_state (GstElement * element,
     return GST_STATE_CHANGE_FAILURE;
   }
 
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    gst_ipc_pipeline_comm_reset_shm (&sink->comm);
+
   /* the parent's (GstElement) state change func won't return ASYNC or
    * NO_PREROLL, so unless it has returned FAILURE, which we have caught above,
    * we are not interested in its return code... just return the peer's */
@@ -239,9 +239,11 @@ gst_ipc_pipeline_src_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_FDIN:
       src->comm.fdin = g_value_get_int (value);
+      gst_ipc_pipeline_comm_reset_shm (&src->comm);
       break;
     case PROP_FDOUT:
       src->comm.fdout = g_value_get_int (value);
+      gst_ipc_pipeline_comm_reset_shm (&src->comm);
       break;
     case PROP_READ_CHUNK_SIZE:
       src->comm.read_chunk_size = g_value_get_uint (value);
@@ -923,6 +925,7 @@ gst_ipc_pipeline_src_disconnect (GstIpcPipelineSrc * src)
   src->comm.fdin = -1;
   src->comm.fdout = -1;
   gst_ipc_pipeline_comm_cancel (&src->comm, FALSE);
+  gst_ipc_pipeline_comm_reset_shm (&src->comm);
   gst_ipc_pipeline_src_start_reader_thread (src);
 }
 
@@ -931,6 +934,7 @@ gst_ipc_pipeline_src_change_state (GstElement * element,
     GstStateChange transition)
 {
   GstIpcPipelineSrc *src = GST_IPC_PIPELINE_SRC (element);
+  GstStateChangeReturn ret;
 
   switch (transition) {
     case GST_STATE_CHANGE_NULL_TO_READY:
@@ -950,5 +954,16 @@ gst_ipc_pipeline_src_change_state (GstElement * element,
     default:
       break;
   }
-  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_ipc_pipeline_comm_reset_shm (&src->comm);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
 }
@@ -0,0 +1,309 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstshmmeta.h"
+
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
+#include <gst/video/video.h>
+
+#include <string.h>
+
+enum
+{
+  SHM_META_VIDEO = 1,
+  SHM_META_TIME_CODE = 2,
+  SHM_META_CAPTION = 3,
+  SHM_META_REFERENCE_TIMESTAMP = 4
+};
+
+static gboolean
+serialize_meta (GstMeta * meta, GstByteWriter * bw)
+{
+  GstByteWriter mw;
+  guint8 *data;
+  guint size;
+  guint32 type;
+
+  gst_byte_writer_init (&mw);
+
+  if (meta->info->api == GST_VIDEO_META_API_TYPE) {
+    GstVideoMeta *vmeta = (GstVideoMeta *) meta;
+    guint i;
+
+    type = SHM_META_VIDEO;
+    gst_byte_writer_put_uint32_ne (&mw, vmeta->flags);
+    gst_byte_writer_put_uint32_ne (&mw, vmeta->format);
+    gst_byte_writer_put_uint32_ne (&mw, vmeta->width);
+    gst_byte_writer_put_uint32_ne (&mw, vmeta->height);
+    gst_byte_writer_put_uint32_ne (&mw, vmeta->n_planes);
+    for (i = 0; i < GST_VIDEO_MAX_PLANES; i++) {
+      gst_byte_writer_put_uint64_ne (&mw, vmeta->offset[i]);
+      gst_byte_writer_put_int32_ne (&mw, vmeta->stride[i]);
+    }
+  } else if (meta->info->api == GST_VIDEO_TIME_CODE_META_API_TYPE) {
+    GstVideoTimeCode *tc = &((GstVideoTimeCodeMeta *) meta)->tc;
+
+    type = SHM_META_TIME_CODE;
+    gst_byte_writer_put_uint32_ne (&mw, tc->config.fps_n);
+    gst_byte_writer_put_uint32_ne (&mw, tc->config.fps_d);
+    gst_byte_writer_put_uint32_ne (&mw, tc->config.flags);
+    gst_byte_writer_put_uint32_ne (&mw, tc->hours);
+    gst_byte_writer_put_uint32_ne (&mw, tc->minutes);
+    gst_byte_writer_put_uint32_ne (&mw, tc->seconds);
+    gst_byte_writer_put_uint32_ne (&mw, tc->frames);
+    gst_byte_writer_put_uint32_ne (&mw, tc->field_count);
+  } else if (meta->info->api == GST_VIDEO_CAPTION_META_API_TYPE) {
+    GstVideoCaptionMeta *cmeta = (GstVideoCaptionMeta *) meta;
+
+    type = SHM_META_CAPTION;
+    gst_byte_writer_put_uint32_ne (&mw, cmeta->caption_type);
+    gst_byte_writer_put_data (&mw, cmeta->data, cmeta->size);
+  } else if (meta->info->api == GST_REFERENCE_TIMESTAMP_META_API_TYPE) {
+    GstReferenceTimestampMeta *rmeta = (GstReferenceTimestampMeta *) meta;
+    gchar *caps_str = gst_caps_to_string (rmeta->reference);
+
+    type = SHM_META_REFERENCE_TIMESTAMP;
+    gst_byte_writer_put_uint64_ne (&mw, rmeta->timestamp);
+    gst_byte_writer_put_uint64_ne (&mw, rmeta->duration);
+    gst_byte_writer_put_string (&mw, caps_str);
+    g_free (caps_str);
+  } else {
+    GST_LOG ("Not transmitting %s", g_type_name (meta->info->api));
+    gst_byte_writer_reset (&mw);
+    return FALSE;
+  }
+
+  size = gst_byte_writer_get_size (&mw);
+  data = gst_byte_writer_reset_and_get_data (&mw);
+
+  gst_byte_writer_put_uint32_ne (bw, type);
+  gst_byte_writer_put_uint32_ne (bw, size);
+  gst_byte_writer_put_data (bw, data, size);
+  g_free (data);
+
+  return TRUE;
+}
+
+/* gst_shm_meta_serialize:
+ * @buffer: the buffer whose metadata should be serialised
+ * @caps_str: (nullable): the current caps as a string
+ * @size: (out): the size of the returned data
+ *
+ * Returns: (transfer full): the serialised metadata, free with g_free()
+ */
+guint8 *
+gst_shm_meta_serialize (GstBuffer * buffer, const gchar * caps_str,
+    gsize * size)
+{
+  GstShmMetaHeader header = { 0, };
+  GstByteWriter bw, metas;
+  gpointer state = NULL;
+  GstMeta *meta;
+  guint metas_size;
+  guint8 *metas_data;
+
+  gst_byte_writer_init (&metas);
+  while ((meta = gst_buffer_iterate_meta (buffer, &state))) {
+    if (serialize_meta (meta, &metas))
+      header.n_metas++;
+  }
+
+  header.magic = GST_SHM_META_MAGIC;
+  header.version = GST_SHM_META_VERSION;
+  header.pts = GST_BUFFER_PTS (buffer);
+  header.dts = GST_BUFFER_DTS (buffer);
+  header.duration = GST_BUFFER_DURATION (buffer);
+  header.offset = GST_BUFFER_OFFSET (buffer);
+  header.offset_end = GST_BUFFER_OFFSET_END (buffer);
+  header.flags = GST_BUFFER_FLAGS (buffer);
+  header.caps_size = caps_str ? strlen (caps_str) + 1 : 0;
+
+  metas_size = gst_byte_writer_get_size (&metas);
+  metas_data = gst_byte_writer_reset_and_get_data (&metas);
+  header.metas_size = metas_size;
+
+  gst_byte_writer_init_with_size (&bw,
+      sizeof (header) + header.caps_size + metas_size, FALSE);
+  gst_byte_writer_put_data (&bw, (const guint8 *) &header, sizeof (header));
+  if (caps_str)
+    gst_byte_writer_put_string (&bw, caps_str);
+  if (metas_data)
+    gst_byte_writer_put_data (&bw, metas_data, metas_size);
+  g_free (metas_data);
+
+  *size = gst_byte_writer_get_size (&bw);
+
+  return gst_byte_writer_reset_and_get_data (&bw);
+}
+
+static gboolean
+deserialize_meta (guint32 type, GstByteReader * br, GstBuffer * buffer)
+{
+  switch (type) {
+    case SHM_META_VIDEO:{
+      guint32 flags, format, width, height, n_planes;
+      gsize offset[GST_VIDEO_MAX_PLANES];
+      gint stride[GST_VIDEO_MAX_PLANES];
+      guint i;
+
+      if (!gst_byte_reader_get_uint32_ne (br, &flags) ||
+          !gst_byte_reader_get_uint32_ne (br, &format) ||
+          !gst_byte_reader_get_uint32_ne (br, &width) ||
+          !gst_byte_reader_get_uint32_ne (br, &height) ||
+          !gst_byte_reader_get_uint32_ne (br, &n_planes) ||
+          n_planes > GST_VIDEO_MAX_PLANES)
+        return FALSE;
+
+      for (i = 0; i < GST_VIDEO_MAX_PLANES; i++) {
+        guint64 o;
+        gint32 s;
+
+        if (!gst_byte_reader_get_uint64_ne (br, &o) ||
+            !gst_byte_reader_get_int32_ne (br, &s))
+          return FALSE;
+        offset[i] = o;
+        stride[i] = s;
+      }
+
+      gst_buffer_add_video_meta_full (buffer, flags, format, width, height,
+          n_planes, offset, stride);
+      break;
+    }
+    case SHM_META_TIME_CODE:{
+      guint32 v[8];
+      guint i;
+
+      for (i = 0; i < G_N_ELEMENTS (v); i++) {
+        if (!gst_byte_reader_get_uint32_ne (br, &v[i]))
+          return FALSE;
+      }
+
+      gst_buffer_add_video_time_code_meta_full (buffer, v[0], v[1], NULL,
+          v[2], v[3], v[4], v[5], v[6], v[7]);
+      break;
+    }
+    case SHM_META_CAPTION:{
+      guint32 caption_type;
+      const guint8 *data;
+      guint size;
+
+      if (!gst_byte_reader_get_uint32_ne (br, &caption_type))
+        return FALSE;
+
+      size = gst_byte_reader_get_remaining (br);
+      if (!gst_byte_reader_get_data (br, size, &data))
+        return FALSE;
+
+      gst_buffer_add_video_caption_meta (buffer, caption_type, data, size);
+      break;
+    }
+    case SHM_META_REFERENCE_TIMESTAMP:{
+      guint64 timestamp, duration;
+      const gchar *caps_str;
+      GstCaps *reference;
+
+      if (!gst_byte_reader_get_uint64_ne (br, &timestamp) ||
+          !gst_byte_reader_get_uint64_ne (br, &duration) ||
+          !gst_byte_reader_get_string (br, &caps_str))
+        return FALSE;
+
+      reference = gst_caps_from_string (caps_str);
+      if (!reference)
+        return FALSE;
+
+      gst_buffer_add_reference_timestamp_meta (buffer, reference, timestamp,
+          duration);
+      gst_caps_unref (reference);
+      break;
+    }
+    default:
+      /* Unknown meta from a newer writer, skip it */
+      GST_LOG ("Skipping unknown meta type %u", type);
+      break;
+  }
+
+  return TRUE;
+}
+
+/* gst_shm_meta_deserialize:
+ * @data: serialised metadata as produced by gst_shm_meta_serialize()
+ * @size: size of @data
+ * @buffer: a writable buffer on which to set the timestamps, flags and metas
+ * @caps_str: (out) (transfer none): the caps string inside @data, or %NULL
+ *
+ * Returns: %TRUE if @data could be parsed
+ */
+gboolean
+gst_shm_meta_deserialize (const guint8 * data, gsize size,
+    GstBuffer * buffer, const gchar ** caps_str)
+{
+  GstShmMetaHeader header;
+  GstByteReader br;
+  guint i;
+
+  *caps_str = NULL;
+
+  if (size < sizeof (header))
+    return FALSE;
+
+  memcpy (&header, data, sizeof (header));
+  if (header.magic != GST_SHM_META_MAGIC ||
+      header.version != GST_SHM_META_VERSION)
+    return FALSE;
+
+  if (sizeof (header) + (gsize) header.caps_size +
+      (gsize) header.metas_size > size)
+    return FALSE;
+
+  GST_BUFFER_PTS (buffer) = header.pts;
+  GST_BUFFER_DTS (buffer) = header.dts;
+  GST_BUFFER_DURATION (buffer) = header.duration;
+  GST_BUFFER_OFFSET (buffer) = header.offset;
+  GST_BUFFER_OFFSET_END (buffer) = header.offset_end;
+  GST_BUFFER_FLAGS (buffer) = header.flags;
+
+  data += sizeof (header);
+  if (header.caps_size > 0) {
+    if (data[header.caps_size - 1] != '\0')
+      return FALSE;
+    *caps_str = (const gchar *) data;
+  }
+
+  gst_byte_reader_init (&br, data + header.caps_size, header.metas_size);
+  for (i = 0; i < header.n_metas; i++) {
+    GstByteReader mr;
+    guint32 type, msize;
+    const guint8 *mdata;
+
+    if (!gst_byte_reader_get_uint32_ne (&br, &type) ||
+        !gst_byte_reader_get_uint32_ne (&br, &msize) ||
+        !gst_byte_reader_get_data (&br, msize, &mdata))
+      return FALSE;
+
+    gst_byte_reader_init (&mr, mdata, msize);
+    if (!deserialize_meta (type, &mr, buffer))
+      return FALSE;
+  }
+
+  return TRUE;
+}
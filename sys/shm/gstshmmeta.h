@@ -0,0 +1,65 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_SHM_META_H__
+#define __GST_SHM_META_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Side channel used by shmsink/shmsrc to carry what the raw shm protocol
+ * can't: timestamps, flags, caps and a few well-known metas. Both ends run
+ * on the same host, so everything is stored in native byte order.
+ *
+ * Layout:
+ *   GstShmMetaHeader
+ *   caps string (caps_size bytes, NUL terminated, may be empty)
+ *   n_metas records of { guint32 type; guint32 size; guint8 data[size]; }
+ */
+
+#define GST_SHM_META_MAGIC   0x4d485347       /* "GSHM" */
+#define GST_SHM_META_VERSION 1
+
+typedef struct
+{
+  guint32 magic;
+  guint32 version;
+
+  guint64 pts;
+  guint64 dts;
+  guint64 duration;
+  guint64 offset;
+  guint64 offset_end;
+  guint32 flags;
+
+  guint32 caps_size;
+  guint32 n_metas;
+  guint32 metas_size;
+} GstShmMetaHeader;
+
+guint8 * gst_shm_meta_serialize (GstBuffer * buffer, const gchar * caps_str,
+    gsize * size);
+
+gboolean gst_shm_meta_deserialize (const guint8 * data, gsize size,
+    GstBuffer * buffer, const gchar ** caps_str);
+
+G_END_DECLS
+
+#endif /* __GST_SHM_META_H__ */
@@ -31,12 +31,18 @@
  * ! shmsink socket-path=/tmp/blah shm-size=2000000
  * ]| Send video to shm buffers.
  *
+ * When #GstShmSink:send-meta is enabled, the timestamps, flags, caps and
+ * supported metas (video, timecode, closed caption and reference timestamp
+ * metas) of each buffer are written into the shared memory area next to the
+ * payload and restored by shmsrc, so no gdppay/gdpdepay is needed.
+ *
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
 #include "gstshmsink.h"
+#include "gstshmmeta.h"
 
 #include <gst/gst.h>
 
@@ -58,7 +64,8 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_SEND_META
 };
 
 struct GstShmClient
@@ -69,6 +76,7 @@ struct GstShmClient
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_SEND_META (FALSE)
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -97,6 +105,7 @@ static gboolean gst_shm_sink_stop (GstBaseSink * bsink);
 static GstFlowReturn gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf);
 
 static gboolean gst_shm_sink_event (GstBaseSink * bsink, GstEvent * event);
+static gboolean gst_shm_sink_set_caps (GstBaseSink * bsink, GstCaps * caps);
 static gboolean gst_shm_sink_unlock (GstBaseSink * bsink);
 static gboolean gst_shm_sink_unlock_stop (GstBaseSink * bsink);
 static gboolean gst_shm_sink_propose_allocation (GstBaseSink * sink,
@@ -106,6 +115,8 @@ static gpointer pollthread_func (gpointer data);
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+static GQuark meta_memory_quark;
+
 
 
 /********************
@@ -357,6 +368,7 @@ gst_shm_sink_init (GstShmSink * self)
   self->unlock = FALSE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
   self->perms = DEFAULT_PERMS;
+  self->send_meta = DEFAULT_SEND_META;
 
   gst_allocation_params_init (&self->params);
 }
@@ -380,6 +392,7 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_shm_sink_stop);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_shm_sink_render);
   gstbasesink_class->event = GST_DEBUG_FUNCPTR (gst_shm_sink_event);
+  gstbasesink_class->set_caps = GST_DEBUG_FUNCPTR (gst_shm_sink_set_caps);
   gstbasesink_class->unlock = GST_DEBUG_FUNCPTR (gst_shm_sink_unlock);
   gstbasesink_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_shm_sink_unlock_stop);
   gstbasesink_class->propose_allocation =
@@ -419,6 +432,22 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSink:send-meta:
+   *
+   * Transmit the timestamps, flags, caps and supported metas of each buffer
+   * through the shared memory area. The receiving shmsrc restores them
+   * automatically. Readers that predate this mode can't parse the stream,
+   * so it is disabled by default.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SEND_META,
+      g_param_spec_boolean ("send-meta",
+          "Send metadata",
+          "Send timestamps, flags, caps and metas along with the buffers",
+          DEFAULT_SEND_META, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
       G_TYPE_NONE, 1, G_TYPE_INT);
@@ -436,6 +465,8 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
       "Olivier Crete <olivier.crete@collabora.co.uk>");
 
   GST_DEBUG_CATEGORY_INIT (shmsink_debug, "shmsink", 0, "Shared Memory Sink");
+
+  meta_memory_quark = g_quark_from_static_string ("GstShmSinkMetaMemory");
 }
 
 static void
@@ -445,6 +476,7 @@ gst_shm_sink_finalize (GObject * object)
 
   g_cond_clear (&self->cond);
   g_free (self->socket_path);
+  g_free (self->caps_str);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -507,6 +539,11 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_SEND_META:
+      GST_OBJECT_LOCK (object);
+      self->send_meta = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       break;
   }
@@ -536,6 +573,9 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_SEND_META:
+      g_value_set_boolean (value, self->send_meta);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -642,6 +682,72 @@ gst_shm_sink_stop (GstBaseSink * bsink)
   return TRUE;
 }
 
+/* Serialises the metadata of *sendbuf into its own block of the shm area.
+ * The block is kept alive by the buffer that is sent, so it is released
+ * together with the payload once all clients acked it. If *sendbuf is
+ * shared with upstream it is replaced by a new buffer referencing the same
+ * memory, so the block can be attached to it.
+ *
+ * Called with the object lock held, returns with it held unless flushing.
+ */
+static GstFlowReturn
+gst_shm_sink_prepare_meta_locked (GstShmSink * self, GstBuffer ** sendbuf,
+    gchar ** meta, gsize * meta_size)
+{
+  GstBaseSink *bsink = GST_BASE_SINK (self);
+  GstMemory *memory;
+  GstFlowReturn ret;
+  guint8 *data;
+  gsize size;
+
+  data = gst_shm_meta_serialize (*sendbuf, self->caps_str, &size);
+
+  if (size > sp_writer_get_max_buf_size (self->pipe)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, NO_SPACE_LEFT, (NULL),
+        ("Shared memory area too small for %" G_GSIZE_FORMAT
+            " bytes of metadata", size));
+    g_free (data);
+    return GST_FLOW_ERROR;
+  }
+
+  while ((memory = gst_shm_sink_allocator_alloc_locked (self->allocator,
+              size, &self->params)) == NULL) {
+    g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+    if (self->unlock) {
+      GST_OBJECT_UNLOCK (self);
+      ret = gst_base_sink_wait_preroll (bsink);
+      if (ret == GST_FLOW_OK) {
+        GST_OBJECT_LOCK (self);
+      } else {
+        gst_buffer_unref (*sendbuf);
+        *sendbuf = NULL;
+        g_free (data);
+        return ret;
+      }
+    }
+  }
+
+  /* Our memory is a plain pointer into the shm area, no need to map it */
+  *meta = ((GstShmSinkMemory *) memory)->data + memory->offset;
+  *meta_size = size;
+  memcpy (*meta, data, size);
+  g_free (data);
+
+  if (!gst_buffer_is_writable (*sendbuf)) {
+    GstBuffer *buf = gst_buffer_new ();
+
+    gst_buffer_copy_into (buf, *sendbuf, GST_BUFFER_COPY_METADATA |
+        GST_BUFFER_COPY_MEMORY, 0, -1);
+    gst_buffer_unref (*sendbuf);
+    *sendbuf = buf;
+  }
+
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (*sendbuf),
+      meta_memory_quark, memory, (GDestroyNotify) gst_memory_unref);
+
+  return GST_FLOW_OK;
+}
+
 static gboolean
 gst_shm_sink_can_render (GstShmSink * self, GstClockTime time)
 {
@@ -670,6 +776,8 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   GstFlowReturn ret = GST_FLOW_OK;
   GstMemory *memory = NULL;
   GstBuffer *sendbuf = NULL;
+  gchar *meta = NULL;
+  gsize meta_size = 0;
   gsize written_bytes;
 
   GST_OBJECT_LOCK (self);
@@ -780,6 +888,17 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     sendbuf = gst_buffer_ref (buf);
   }
 
+  if (self->send_meta) {
+    ret = gst_shm_sink_prepare_meta_locked (self, &sendbuf, &meta,
+        &meta_size);
+    if (ret != GST_FLOW_OK) {
+      if (ret == GST_FLOW_ERROR)
+        goto error;
+      /* Flushing, the lock was released */
+      return ret;
+    }
+  }
+
   if (!gst_buffer_map (sendbuf, &map, GST_MAP_READ)) {
     GST_ELEMENT_ERROR (self, STREAM, FAILED,
         (NULL), ("Failed to map data into send buffer"));
@@ -790,7 +909,8 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
    * We know it's not mapped for writing anywhere as we just mapped it for
    * reading
    */
-  rv = sp_writer_send_buf (self->pipe, (char *) map.data, map.size, sendbuf);
+  rv = sp_writer_send_buf_with_meta (self->pipe, (char *) map.data, map.size,
+      meta, meta_size, sendbuf);
   if (rv == -1) {
     GST_ELEMENT_ERROR (self, STREAM, FAILED,
         (NULL), ("Failed to send data over SHM"));
@@ -975,6 +1095,20 @@ gst_shm_sink_event (GstBaseSink * bsink, GstEvent * event)
 }
 
 
+static gboolean
+gst_shm_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
+{
+  GstShmSink *self = GST_SHM_SINK (bsink);
+  gchar *caps_str = gst_caps_to_string (caps);
+
+  GST_OBJECT_LOCK (self);
+  g_free (self->caps_str);
+  self->caps_str = caps_str;
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
 static gboolean
 gst_shm_sink_unlock (GstBaseSink * bsink)
 {
@@ -63,6 +63,8 @@ struct _GstShmSink
   gboolean stop;
   gboolean unlock;
   GstClockTimeDiff buffer_time;
+  gboolean send_meta;
+  gchar *caps_str;
 
   GCond cond;
 
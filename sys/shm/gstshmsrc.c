@@ -32,6 +32,10 @@
  * ! queue ! videoconvert ! autovideosink
  * ]| Render video from shm buffers.
  *
+ * If the matching shmsink has #GstShmSink:send-meta enabled, the buffer
+ * timestamps, flags, caps and supported metas are restored from the shared
+ * memory area and no caps filter is needed.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -39,6 +43,7 @@
 #endif
 
 #include "gstshmsrc.h"
+#include "gstshmmeta.h"
 
 #include <gst/gst.h>
 
@@ -162,6 +167,7 @@ gst_shm_src_finalize (GObject * object)
 
   gst_poll_free (self->poll);
   g_free (self->socket_path);
+  g_free (self->caps_str);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -280,6 +286,9 @@ gst_shm_src_stop_reading (GstShmSrc * self)
     gst_shm_pipe_dec (pipe);
   }
   gst_poll_set_flushing (self->poll, TRUE);
+
+  g_free (self->caps_str);
+  self->caps_str = NULL;
 }
 
 static gboolean
@@ -319,12 +328,44 @@ free_buffer (gpointer data)
   g_slice_free (struct GstShmBuffer, gsb);
 }
 
+static gboolean
+gst_shm_src_apply_meta (GstShmSrc * self, const guint8 * meta, gsize size,
+    GstBuffer * buffer)
+{
+  const gchar *caps_str;
+
+  if (!gst_shm_meta_deserialize (meta, size, buffer, &caps_str))
+    return FALSE;
+
+  if (caps_str && g_strcmp0 (caps_str, self->caps_str) != 0) {
+    GstCaps *caps = gst_caps_from_string (caps_str);
+
+    GST_DEBUG_OBJECT (self, "Received new caps %s", caps_str);
+
+    if (!caps)
+      return FALSE;
+
+    g_free (self->caps_str);
+    self->caps_str = g_strdup (caps_str);
+
+    if (!gst_base_src_set_caps (GST_BASE_SRC (self), caps)) {
+      GST_WARNING_OBJECT (self, "Downstream refused caps %" GST_PTR_FORMAT,
+          caps);
+    }
+    gst_caps_unref (caps);
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
   GstShmSrc *self = GST_SHM_SRC (psrc);
   GstShmPipe *pipe;
   gchar *buf = NULL;
+  gchar *meta = NULL;
+  gsize meta_size = 0;
   int rv = 0;
   struct GstShmBuffer *gsb;
 
@@ -369,6 +410,8 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
       GST_LOG_OBJECT (self, "Reading from pipe");
       GST_OBJECT_LOCK (self);
       rv = sp_client_recv (pipe->pipe, &buf);
+      if (buf)
+        meta_size = sp_client_recv_meta (pipe->pipe, &meta);
       GST_OBJECT_UNLOCK (self);
       if (rv < 0) {
         GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
@@ -387,6 +430,15 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   *outbuf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
       buf, rv, 0, rv, gsb, free_buffer);
 
+  /* The metadata block is only valid until the buffer is released */
+  if (meta && !gst_shm_src_apply_meta (self, (const guint8 *) meta,
+          meta_size, *outbuf)) {
+    gst_buffer_replace (outbuf, NULL);
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, ("Failed to read from shmsrc"),
+        ("Invalid buffer metadata received"));
+    return GST_FLOW_ERROR;
+  }
+
   return GST_FLOW_OK;
 
 error:
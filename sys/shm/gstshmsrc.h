@@ -56,6 +56,9 @@ struct _GstShmSrc
 
   GstFlowReturn flow_return;
   gboolean unlocked;
+
+  /* caps last received through the metadata side channel */
+  gchar *caps_str;
 };
 
 struct _GstShmSrcClass
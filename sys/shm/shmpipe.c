@@ -67,6 +67,14 @@
  * type 4: ack buffer
  * offset
  *
+ * type 5: buffer metadata
+ * offset
+ * size
+ *
+ * Type 5 is optional and, when present, immediately precedes the type 3
+ * packet it describes. It points to a block in the shm area holding
+ * serialised buffer metadata; its content is opaque to this layer.
+ *
  * Type 4 goes from the client to the server
  * The rest are from the server to the client
  * The client should never write in the SHM
@@ -80,7 +88,8 @@ enum
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_BUFFER_META = 5
 };
 
 typedef struct _ShmArea ShmArea;
@@ -141,6 +150,10 @@ struct _ShmPipe
   ShmClient *clients;
 
   mode_t perms;
+
+  /* Reader side: metadata announced for the next buffer */
+  char *meta;
+  size_t meta_size;
 };
 
 struct _ShmClient
@@ -572,12 +585,40 @@ sp_writer_free_block (ShmBlock * block)
   spalloc_free (ShmBlock, block);
 }
 
+static ShmArea *
+sp_writer_find_area (ShmPipe * self, char *buf)
+{
+  ShmArea *area;
+
+  for (area = self->shm_area; area; area = area->next) {
+    if (buf >= area->shm_area_buf &&
+        buf < (area->shm_area_buf + area->shm_area_len))
+      return area;
+  }
+
+  return NULL;
+}
+
 /* Returns the number of client this has successfully been sent to */
 
 int
 sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
+{
+  return sp_writer_send_buf_with_meta (self, buf, size, NULL, 0, tag);
+}
+
+/* Same as sp_writer_send_buf() but also announces a block of metadata
+ * located in the shm area. The metadata block is not tracked here, the
+ * caller must keep it alive for as long as the buffer itself (for example
+ * by tying it to @tag).
+ */
+
+int
+sp_writer_send_buf_with_meta (ShmPipe * self, char *buf, size_t size,
+    char *meta, size_t meta_size, void *tag)
 {
   ShmArea *area = NULL;
+  ShmArea *meta_area = NULL;
   unsigned long offset = 0;
   unsigned long bsize = size;
   ShmBuffer *sb;
@@ -602,6 +643,12 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   if (!ablock)
     return -1;
 
+  if (meta) {
+    meta_area = sp_writer_find_area (self, meta);
+    if (!meta_area)
+      return -1;
+  }
+
   sb = spalloc_alloc (sizeof (ShmBuffer) + sizeof (int) * self->num_clients);
   memset (sb, 0, sizeof (ShmBuffer));
   memset (sb->clients, -1, sizeof (int) * self->num_clients);
@@ -614,6 +661,14 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
 
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
+
+    if (meta_area) {
+      cb.payload.buffer.offset = meta - meta_area->shm_area_buf;
+      cb.payload.buffer.size = meta_size;
+      if (!send_command (client->fd, &cb, COMMAND_BUFFER_META, meta_area->id))
+        continue;
+    }
+
     cb.payload.buffer.offset = offset;
     cb.payload.buffer.size = bsize;
     if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, self->shm_area->id))
@@ -708,6 +763,21 @@ sp_client_recv (ShmPipe * self, char **buf)
       }
       return -23;
 
+    case COMMAND_BUFFER_META:
+      self->meta = NULL;
+      self->meta_size = 0;
+      for (area = self->shm_area; area; area = area->next) {
+        if (area->id == cb.area_id) {
+          if (cb.payload.buffer.offset + cb.payload.buffer.size >
+              area->shm_area_len)
+            return -24;
+          self->meta = area->shm_area_buf + cb.payload.buffer.offset;
+          self->meta_size = cb.payload.buffer.size;
+          return 0;
+        }
+      }
+      return -23;
+
     default:
       return -99;
   }
@@ -715,6 +785,22 @@ sp_client_recv (ShmPipe * self, char **buf)
   return 0;
 }
 
+/* Returns the size of the metadata that was announced for the last buffer
+ * returned by sp_client_recv(), or 0 if there was none. The metadata is only
+ * valid until sp_client_recv_finish() is called on that buffer.
+ */
+size_t
+sp_client_recv_meta (ShmPipe * self, char **meta)
+{
+  size_t meta_size = self->meta_size;
+
+  *meta = self->meta;
+  self->meta = NULL;
+  self->meta_size = 0;
+
+  return meta_size;
+}
+
 int
 sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
 {
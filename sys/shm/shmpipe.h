@@ -55,7 +55,9 @@
  * application must close the pipe with sp_close() and assume that all
  * buffers are no longer valid. If was valid buffer was received, the
  * client must release it with sp_client_recv_finish() when it is done
- * reading from it.
+ * reading from it. If the writer sent metadata along with the buffer
+ * (sp_writer_send_buf_with_meta()), it can be retrieved with
+ * sp_client_recv_meta() right after sp_client_recv() returned the buffer.
  */
 
 
@@ -97,6 +99,8 @@ int sp_writer_get_client_fd (ShmClient * client);
 ShmBlock *sp_writer_alloc_block (ShmPipe * self, size_t size);
 void sp_writer_free_block (ShmBlock *block);
 int sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void * tag);
+int sp_writer_send_buf_with_meta (ShmPipe * self, char *buf, size_t size,
+    char *meta, size_t meta_size, void * tag);
 char *sp_writer_block_get_buf (ShmBlock *block);
 ShmPipe *sp_writer_block_get_pipe (ShmBlock *block);
 size_t sp_writer_get_max_buf_size (ShmPipe * self);
@@ -114,6 +118,7 @@ void *sp_writer_buf_get_tag (ShmBuffer * buffer);
 
 ShmPipe *sp_client_open (const char *path);
 long int sp_client_recv (ShmPipe * self, char **buf);
+size_t sp_client_recv_meta (ShmPipe * self, char **meta);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
 void sp_client_close (ShmPipe * self);
 
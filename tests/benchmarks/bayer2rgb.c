@@ -0,0 +1,152 @@
+/* GStreamer
+ *
+ * benchmark for bayer2rgb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of bayer2rgb for each input format, with both
+ * interpolation methods and with one thread and one thread per CPU:
+ *
+ *   GST_PLUGIN_PATH=<build dir> bayer2rgb [width height [n-frames]]
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+static const gchar *formats[] = {
+  "bggr", "grbg", "gbrg", "rggb",
+  "bggr10le", "bggr10be", "bggr12le", "bggr12be",
+  "bggr14le", "bggr14be", "bggr16le", "bggr16be",
+};
+
+static const gchar *methods[] = { "bilinear", "edge-aware" };
+
+static gint
+format_depth (const gchar * format)
+{
+  return strlen (format) > 4 ? atoi (format + 4) : 8;
+}
+
+static GstBuffer *
+create_frame (GstHarness * h, const gchar * format, gint width, gint height)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint depth = format_depth (format);
+  gint bpp = depth > 8 ? 2 : 1;
+  gboolean big_endian = g_str_has_suffix (format, "be");
+  gsize i, n_samples = (gsize) width * height;
+  guint32 seed = 1;
+
+  buffer = gst_harness_create_buffer (h, n_samples * bpp);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i < n_samples; i++) {
+    guint value;
+
+    seed = seed * 1103515245 + 12345;
+    value = (seed >> 16) & ((1 << depth) - 1);
+    if (bpp == 1)
+      map.data[i] = value;
+    else if (big_endian)
+      GST_WRITE_UINT16_BE (map.data + 2 * i, value);
+    else
+      GST_WRITE_UINT16_LE (map.data + 2 * i, value);
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+static void
+run_benchmark (const gchar * format, const gchar * method, guint n_threads,
+    gint width, gint height, guint n_frames)
+{
+  GstHarness *h;
+  GstBuffer *frame;
+  GstClockTime start, elapsed;
+  gchar *caps;
+  guint i;
+
+  h = gst_harness_new ("bayer2rgb");
+  gst_util_set_object_arg (G_OBJECT (h->element), "method", method);
+  g_object_set (h->element, "n-threads", n_threads, NULL);
+
+  caps = g_strdup_printf ("video/x-bayer, format=%s, width=%d, height=%d, "
+      "framerate=30/1", format, width, height);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+  gst_harness_set_sink_caps_str (h, "video/x-raw, format=BGRx");
+
+  frame = create_frame (h, format, width, height);
+
+  /* the first frame negotiates and starts the threads */
+  gst_buffer_unref (gst_harness_push_and_pull (h, gst_buffer_ref (frame)));
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_frames; i++)
+    gst_buffer_unref (gst_harness_push_and_pull (h, gst_buffer_ref (frame)));
+  elapsed = gst_util_get_timestamp () - start;
+
+  g_print ("%-10s %-11s %2u threads: %8.2f frames/s, %8.2f Mpixels/s\n",
+      format, method, n_threads,
+      (gdouble) n_frames * GST_SECOND / elapsed,
+      (gdouble) n_frames * width * height * GST_SECOND / elapsed / 1e6);
+
+  gst_buffer_unref (frame);
+  gst_harness_teardown (h);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gint width = 4000, height = 3000;
+  guint n_frames = 30, n_cpus;
+  guint f, m;
+
+  gst_init (&argc, &argv);
+
+  if (argc >= 3) {
+    width = atoi (argv[1]);
+    height = atoi (argv[2]);
+  }
+  if (argc >= 4)
+    n_frames = atoi (argv[3]);
+  if (width < 2 || height < 2 || n_frames < 1) {
+    g_printerr ("usage: %s [width height [n-frames]]\n", argv[0]);
+    return 1;
+  }
+
+  n_cpus = g_get_num_processors ();
+
+  g_print ("%dx%d, %u frames\n", width, height, n_frames);
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    for (m = 0; m < G_N_ELEMENTS (methods); m++) {
+      run_benchmark (formats[f], methods[m], 1, width, height, n_frames);
+      if (n_cpus > 1)
+        run_benchmark (formats[f], methods[m], n_cpus, width, height,
+            n_frames);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,295 @@
+/* GStreamer
+ *
+ * unit test for audiomixmatrix
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/audio/audio.h>
+
+/* more than one block of the sparse kernels, and not a multiple of it */
+#define N_SAMPLES 300
+#define IN_CHANNELS 4
+
+static const GstAudioFormat formats[] = {
+  GST_AUDIO_FORMAT_F32, GST_AUDIO_FORMAT_F64,
+  GST_AUDIO_FORMAT_S16, GST_AUDIO_FORMAT_S32
+};
+
+/* each matrix selects a different kernel in the element */
+static const gdouble identity_matrix[] = {
+  1, 0, 0, 0,
+  0, 1, 0, 0,
+  0, 0, 1, 0,
+  0, 0, 0, 1
+};
+
+static const gdouble copy_matrix[] = {
+  0, 0, 1, 0,
+  1, 0, 0, 0,
+  0, 0, 0, 0
+};
+
+static const gdouble route_matrix[] = {
+  0, 0, 0, 0.5,
+  0, -0.25, 0, 0
+};
+
+static const gdouble sparse_matrix[] = {
+  0.5, 0.25, 0, 0,
+  -0.5, 0, 0.125, 0.25,
+  0.25, 0.25, 0.25, 0.25
+};
+
+static void
+set_matrix (GstElement * element, guint in_channels, guint out_channels,
+    const gdouble * matrix)
+{
+  GValue value = G_VALUE_INIT;
+  guint in, out;
+
+  g_value_init (&value, GST_TYPE_ARRAY);
+  for (out = 0; out < out_channels; out++) {
+    GValue row = G_VALUE_INIT;
+
+    g_value_init (&row, GST_TYPE_ARRAY);
+    for (in = 0; in < in_channels; in++) {
+      GValue coefficient = G_VALUE_INIT;
+
+      g_value_init (&coefficient, G_TYPE_DOUBLE);
+      g_value_set_double (&coefficient, matrix[out * in_channels + in]);
+      gst_value_array_append_and_take_value (&row, &coefficient);
+    }
+    gst_value_array_append_and_take_value (&value, &row);
+  }
+
+  g_object_set (element, "in-channels", in_channels, "out-channels",
+      out_channels, NULL);
+  g_object_set_property (G_OBJECT (element), "matrix", &value);
+  g_value_unset (&value);
+}
+
+static gdouble
+get_sample (GstAudioFormat format, const guint8 * data, guint index)
+{
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32:
+      return ((const gfloat *) data)[index];
+    case GST_AUDIO_FORMAT_F64:
+      return ((const gdouble *) data)[index];
+    case GST_AUDIO_FORMAT_S16:
+      return ((const gint16 *) data)[index];
+    case GST_AUDIO_FORMAT_S32:
+      return ((const gint32 *) data)[index];
+    default:
+      g_assert_not_reached ();
+  }
+
+  return 0;
+}
+
+static void
+set_sample (GstAudioFormat format, guint8 * data, guint index, gdouble value)
+{
+  /* value is in [-0.5, 0.5) */
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32:
+      ((gfloat *) data)[index] = value;
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      ((gdouble *) data)[index] = value;
+      break;
+    case GST_AUDIO_FORMAT_S16:
+      ((gint16 *) data)[index] = value * G_MAXINT16;
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      ((gint32 *) data)[index] = value * G_MAXINT32;
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+/* Pushes a buffer through the element and compares the output with a
+ * straightforward dense matrix multiplication */
+static void
+check_output (GstHarness * h, GstAudioFormat format, guint out_channels,
+    const gdouble * matrix)
+{
+  const GstAudioFormatInfo *finfo = gst_audio_format_get_info (format);
+  guint bps = GST_AUDIO_FORMAT_INFO_WIDTH (finfo) / 8;
+  gdouble tolerance;
+  GstBuffer *inbuf, *outbuf;
+  GstMapInfo inmap, outmap;
+  gchar *incaps, *outcaps;
+  guint sample, in, out;
+
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32:
+      tolerance = 1e-6;
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      tolerance = 1e-12;
+      break;
+    default:
+      /* the fixed point kernels truncate */
+      tolerance = 1.0;
+      break;
+  }
+
+  incaps = g_strdup_printf ("audio/x-raw, format=%s, rate=48000, channels=%u, "
+      "layout=interleaved, channel-mask=(bitmask)0x0",
+      gst_audio_format_to_string (format), IN_CHANNELS);
+  outcaps = g_strdup_printf ("audio/x-raw, format=%s, rate=48000, "
+      "channels=%u, layout=interleaved, channel-mask=(bitmask)0x0",
+      gst_audio_format_to_string (format), out_channels);
+  gst_harness_set_caps_str (h, incaps, outcaps);
+  g_free (incaps);
+  g_free (outcaps);
+
+  inbuf = gst_harness_create_buffer (h, N_SAMPLES * IN_CHANNELS * bps);
+  fail_unless (gst_buffer_map (inbuf, &inmap, GST_MAP_WRITE));
+  for (sample = 0; sample < N_SAMPLES; sample++) {
+    for (in = 0; in < IN_CHANNELS; in++) {
+      guint index = sample * IN_CHANNELS + in;
+
+      set_sample (format, inmap.data, index,
+          ((index * 7919) % 1000) / 1000.0 - 0.5);
+    }
+  }
+  gst_buffer_unmap (inbuf, &inmap);
+
+  outbuf = gst_harness_push_and_pull (h, gst_buffer_ref (inbuf));
+  fail_unless (outbuf != NULL);
+  fail_unless_equals_int (gst_buffer_get_size (outbuf),
+      N_SAMPLES * out_channels * bps);
+
+  fail_unless (gst_buffer_map (inbuf, &inmap, GST_MAP_READ));
+  fail_unless (gst_buffer_map (outbuf, &outmap, GST_MAP_READ));
+  for (sample = 0; sample < N_SAMPLES; sample++) {
+    for (out = 0; out < out_channels; out++) {
+      gdouble expected = 0, actual;
+
+      for (in = 0; in < IN_CHANNELS; in++)
+        expected += get_sample (format, inmap.data,
+            sample * IN_CHANNELS + in) * matrix[out * IN_CHANNELS + in];
+
+      actual = get_sample (format, outmap.data, sample * out_channels + out);
+      fail_unless (ABS (actual - expected) <= tolerance,
+          "%s: sample %u, channel %u is %f instead of %f",
+          gst_audio_format_to_string (format), sample, out, actual, expected);
+    }
+  }
+  gst_buffer_unmap (inbuf, &inmap);
+  gst_buffer_unmap (outbuf, &outmap);
+
+  gst_buffer_unref (inbuf);
+  gst_buffer_unref (outbuf);
+}
+
+static void
+check_matrix (GstAudioFormat format, guint out_channels,
+    const gdouble * matrix)
+{
+  GstHarness *h = gst_harness_new ("audiomixmatrix");
+
+  set_matrix (h->element, IN_CHANNELS, out_channels, matrix);
+  check_output (h, format, out_channels, matrix);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_identity)
+{
+  check_matrix (formats[__i__], 4, identity_matrix);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_copy)
+{
+  check_matrix (formats[__i__], 3, copy_matrix);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_route)
+{
+  check_matrix (formats[__i__], 2, route_matrix);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_sparse)
+{
+  check_matrix (formats[__i__], 3, sparse_matrix);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_change_channels)
+{
+  GstAudioFormat format = formats[__i__];
+  GstHarness *h = gst_harness_new ("audiomixmatrix");
+  GValue value = G_VALUE_INIT;
+
+  set_matrix (h->element, IN_CHANNELS, 3, sparse_matrix);
+  check_output (h, format, 3, sparse_matrix);
+
+  /* the matrix does not fit the new number of channels anymore */
+  g_object_set (h->element, "out-channels", 2, NULL);
+  g_value_init (&value, GST_TYPE_ARRAY);
+  g_object_get_property (G_OBJECT (h->element), "matrix", &value);
+  fail_unless_equals_int (gst_value_array_get_size (&value), 0);
+  g_value_unset (&value);
+
+  /* and the previous one is not used until a new one is set */
+  fail_unless_equals_int (gst_harness_push (h,
+          gst_harness_create_buffer (h, 64)), GST_FLOW_NOT_SUPPORTED);
+
+  set_matrix (h->element, IN_CHANNELS, 2, route_matrix);
+  check_output (h, format, 2, route_matrix);
+
+  set_matrix (h->element, IN_CHANNELS, 2, copy_matrix);
+  check_output (h, format, 2, copy_matrix);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+audiomixmatrix_suite (void)
+{
+  Suite *s = suite_create ("audiomixmatrix");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_loop_test (tc_chain, test_identity, 0, G_N_ELEMENTS (formats));
+  tcase_add_loop_test (tc_chain, test_copy, 0, G_N_ELEMENTS (formats));
+  tcase_add_loop_test (tc_chain, test_route, 0, G_N_ELEMENTS (formats));
+  tcase_add_loop_test (tc_chain, test_sparse, 0, G_N_ELEMENTS (formats));
+  tcase_add_loop_test (tc_chain, test_change_channels, 0,
+      G_N_ELEMENTS (formats));
+
+  return s;
+}
+
+GST_CHECK_MAIN (audiomixmatrix);
@@ -0,0 +1,247 @@
+/* GStreamer
+ *
+ * unit test for bayer2rgb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#define WIDTH 64
+#define HEIGHT 48
+
+static const gchar *methods[] = { "bilinear", "edge-aware" };
+
+static const struct
+{
+  const gchar *format;
+  gint bits;
+  gboolean big_endian;
+} wide_formats[] = {
+  {"bggr16le", 16, FALSE}, {"bggr16be", 16, TRUE},
+  {"bggr12le", 12, FALSE}, {"bggr12be", 12, TRUE},
+};
+
+typedef void (*PictureFunc) (gint x, gint y, guint8 rgb[3]);
+
+static void
+flat_picture (gint x, gint y, guint8 rgb[3])
+{
+  rgb[0] = 180;
+  rgb[1] = 90;
+  rgb[2] = 30;
+}
+
+static void
+vertical_edge_picture (gint x, gint y, guint8 rgb[3])
+{
+  rgb[0] = rgb[1] = rgb[2] = x < WIDTH / 2 + 1 ? 40 : 200;
+}
+
+static void
+horizontal_edge_picture (gint x, gint y, guint8 rgb[3])
+{
+  rgb[0] = rgb[1] = rgb[2] = y < HEIGHT / 2 + 1 ? 40 : 200;
+}
+
+static void
+textured_picture (gint x, gint y, guint8 rgb[3])
+{
+  rgb[0] = (x * 7 + y * 3) & 0xff;
+  rgb[1] = (x * y) & 0xff;
+  rgb[2] = ((x / 4 + y / 4) & 1) ? 220 : 20;
+}
+
+/* The sample of a bggr mosaic of the picture */
+static guint8
+bayer_sample (PictureFunc picture, gint x, gint y)
+{
+  guint8 rgb[3];
+
+  picture (x, y, rgb);
+  if ((y & 1) == 0 && (x & 1) == 0)
+    return rgb[2];
+  if ((y & 1) == 1 && (x & 1) == 1)
+    return rgb[0];
+  return rgb[1];
+}
+
+/* Converts the bggr mosaic of @picture stored in @format, with samples of
+ * @bits significant bits, and returns the RGBA output. The bits below the
+ * 8 most significant ones are filled with garbage. */
+static GstBuffer *
+convert (PictureFunc picture, const gchar * method, const gchar * format,
+    gint bits, gboolean big_endian)
+{
+  gint bpp = bits > 8 ? 2 : 1;
+  gint stride = GST_ROUND_UP_4 (WIDTH * bpp);
+  GstHarness *h;
+  GstBuffer *inbuf, *outbuf;
+  GstMapInfo map;
+  gchar *caps;
+  gint x, y;
+
+  h = gst_harness_new ("bayer2rgb");
+  gst_util_set_object_arg (G_OBJECT (h->element), "method", method);
+
+  caps = g_strdup_printf ("video/x-bayer, format=%s, width=%d, height=%d, "
+      "framerate=30/1", format, WIDTH, HEIGHT);
+  gst_harness_set_caps_str (h, caps, "video/x-raw, format=RGBA, "
+      "width=64, height=48, framerate=30/1");
+  g_free (caps);
+
+  inbuf = gst_harness_create_buffer (h, stride * HEIGHT);
+  fail_unless (gst_buffer_map (inbuf, &map, GST_MAP_WRITE));
+  for (y = 0; y < HEIGHT; y++) {
+    guint8 *line = map.data + y * stride;
+
+    for (x = 0; x < WIDTH; x++) {
+      guint8 v = bayer_sample (picture, x, y);
+
+      if (bits > 8) {
+        guint16 s = (v << (bits - 8)) | ((x * 31 + y * 17) &
+            ((1 << (bits - 8)) - 1));
+
+        if (big_endian)
+          GST_WRITE_UINT16_BE (line + 2 * x, s);
+        else
+          GST_WRITE_UINT16_LE (line + 2 * x, s);
+      } else {
+        line[x] = v;
+      }
+    }
+  }
+  gst_buffer_unmap (inbuf, &map);
+
+  outbuf = gst_harness_push_and_pull (h, inbuf);
+  fail_unless (outbuf != NULL);
+  fail_unless_equals_int (gst_buffer_get_size (outbuf), WIDTH * HEIGHT * 4);
+
+  gst_harness_teardown (h);
+
+  return outbuf;
+}
+
+/* Returns the number of pixels of the RGBA @buffer differing from
+ * @picture */
+static guint
+count_errors (GstBuffer * buffer, PictureFunc picture)
+{
+  GstMapInfo map;
+  guint errors = 0;
+  gint x, y;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      const guint8 *p = map.data + (y * WIDTH + x) * 4;
+      guint8 rgb[3];
+
+      picture (x, y, rgb);
+      if (p[0] != rgb[0] || p[1] != rgb[1] || p[2] != rgb[2]) {
+        GST_LOG ("pixel %d,%d is %u,%u,%u instead of %u,%u,%u", x, y,
+            p[0], p[1], p[2], rgb[0], rgb[1], rgb[2]);
+        errors++;
+      }
+      fail_unless_equals_int (p[3], 0xff);
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  return errors;
+}
+
+GST_START_TEST (test_wide_formats)
+{
+  const gchar *method = methods[__i__ % G_N_ELEMENTS (methods)];
+  guint f = __i__ / G_N_ELEMENTS (methods);
+  GstBuffer *expected, *actual;
+  GstMapInfo emap, amap;
+
+  /* only the 8 most significant bits are used, in either endianness */
+  expected = convert (textured_picture, method, "bggr", 8, FALSE);
+  actual = convert (textured_picture, method, wide_formats[f].format,
+      wide_formats[f].bits, wide_formats[f].big_endian);
+
+  fail_unless (gst_buffer_map (expected, &emap, GST_MAP_READ));
+  fail_unless (gst_buffer_map (actual, &amap, GST_MAP_READ));
+  fail_unless_equals_int (amap.size, emap.size);
+  fail_unless (memcmp (amap.data, emap.data, emap.size) == 0,
+      "%s output differs from 8 bit output with method %s",
+      wide_formats[f].format, method);
+  gst_buffer_unmap (expected, &emap);
+  gst_buffer_unmap (actual, &amap);
+
+  gst_buffer_unref (expected);
+  gst_buffer_unref (actual);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_flat)
+{
+  GstBuffer *outbuf;
+
+  outbuf = convert (flat_picture, methods[__i__], "bggr", 8, FALSE);
+  fail_unless_equals_int (count_errors (outbuf, flat_picture), 0);
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_edges)
+{
+  PictureFunc pictures[] = { vertical_edge_picture, horizontal_edge_picture };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (pictures); i++) {
+    GstBuffer *bilinear, *edge_aware;
+
+    bilinear = convert (pictures[i], "bilinear", "bggr", 8, FALSE);
+    edge_aware = convert (pictures[i], "edge-aware", "bggr", 8, FALSE);
+
+    /* bilinear interpolation blurs the edge, interpolating along it
+     * reconstructs a grey step exactly */
+    fail_unless (count_errors (bilinear, pictures[i]) > 0);
+    fail_unless_equals_int (count_errors (edge_aware, pictures[i]), 0);
+
+    gst_buffer_unref (bilinear);
+    gst_buffer_unref (edge_aware);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+bayer2rgb_suite (void)
+{
+  Suite *s = suite_create ("bayer2rgb");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_loop_test (tc_chain, test_wide_formats, 0,
+      G_N_ELEMENTS (wide_formats) * G_N_ELEMENTS (methods));
+  tcase_add_loop_test (tc_chain, test_flat, 0, G_N_ELEMENTS (methods));
+  tcase_add_test (tc_chain, test_edges);
+
+  return s;
+}
+
+GST_CHECK_MAIN (bayer2rgb);
@@ -962,6 +962,308 @@ GST_START_TEST (convert_cea608_s334_1a_cea708_cdp_double_framerate)
 
 GST_END_TEST;
 
+enum CCFormat
+{
+  CC_FORMAT_CEA608_RAW,
+  CC_FORMAT_CEA608_S334_1A,
+  CC_FORMAT_CEA708_CC_DATA,
+  CC_FORMAT_CEA708_CDP,
+};
+
+static const gchar *cc_format_caps[] = {
+  "closedcaption/x-cea-608,format=(string)raw",
+  "closedcaption/x-cea-608,format=(string)s334-1a",
+  "closedcaption/x-cea-708,format=(string)cc_data",
+  "closedcaption/x-cea-708,format=(string)cdp",
+};
+
+static const struct
+{
+  gint fps_n, fps_d;
+  guint8 fps_idx;
+  /* number of CEA608 byte pairs a frame can carry */
+  guint max_cea608_count;
+} cc_framerates[] = {
+  {24000, 1001, 0x1f, 3},
+  {24, 1, 0x2f, 2},
+  {25, 1, 0x3f, 2},
+  {30000, 1001, 0x4f, 2},
+  {30, 1, 0x5f, 2},
+  {50, 1, 0x6f, 1},
+  {60000, 1001, 0x7f, 1},
+  {60, 1, 0x8f, 1},
+};
+
+#define N_MATRIX_FRAMES 10
+
+static gboolean
+cc_format_has_cea608_field2 (enum CCFormat format)
+{
+  return format != CC_FORMAT_CEA608_RAW;
+}
+
+static gboolean
+cc_format_has_ccp (enum CCFormat format)
+{
+  return format == CC_FORMAT_CEA708_CC_DATA || format == CC_FORMAT_CEA708_CDP;
+}
+
+/* Creates input frame @seq, with a field 1 CEA608 byte pair, and optionally a
+ * field 2 one and a CEA708 ccp triplet */
+static GstBuffer *
+make_cc_buffer (enum CCFormat format, guint8 fps_idx, guint seq,
+    gboolean with_field2, gboolean with_ccp)
+{
+  guint8 data[32];
+  guint i, len = 0;
+
+  switch (format) {
+    case CC_FORMAT_CEA608_RAW:
+      data[len++] = 0x20 + seq;
+      data[len++] = 0x40 + seq;
+      break;
+    case CC_FORMAT_CEA608_S334_1A:
+      data[len++] = 0x80;
+      data[len++] = 0x20 + seq;
+      data[len++] = 0x40 + seq;
+      if (with_field2) {
+        data[len++] = 0x00;
+        data[len++] = 0x60 + seq;
+        data[len++] = 0x70 + seq;
+      }
+      break;
+    case CC_FORMAT_CEA708_CC_DATA:
+    case CC_FORMAT_CEA708_CDP:{
+      guint cc_count_i = 0;
+
+      if (format == CC_FORMAT_CEA708_CDP) {
+        data[len++] = 0x96;
+        data[len++] = 0x69;
+        data[len++] = 0;        /* length, filled in below */
+        data[len++] = fps_idx;
+        data[len++] = 0x43;
+        data[len++] = (seq >> 8) & 0xff;
+        data[len++] = seq & 0xff;
+        data[len++] = 0x72;
+        cc_count_i = len++;
+      }
+
+      data[len++] = 0xfc;
+      data[len++] = 0x20 + seq;
+      data[len++] = 0x40 + seq;
+      if (with_field2) {
+        data[len++] = 0xfd;
+        data[len++] = 0x60 + seq;
+        data[len++] = 0x70 + seq;
+      }
+      if (with_ccp) {
+        data[len++] = 0xfe;
+        data[len++] = 0x10 + seq;
+        data[len++] = 0x30 + seq;
+      }
+
+      if (format == CC_FORMAT_CEA708_CDP) {
+        guint8 checksum = 0;
+
+        data[cc_count_i] = 0xe0 | ((len - cc_count_i - 1) / 3);
+        data[len++] = 0x74;
+        data[len++] = (seq >> 8) & 0xff;
+        data[len++] = seq & 0xff;
+        data[2] = len + 1;
+        for (i = 0; i < len; i++)
+          checksum += data[i];
+        data[len++] = 256 - checksum;
+      }
+      break;
+    }
+  }
+
+  return gst_buffer_new_memdup (data, len);
+}
+
+/* Appends the field 1 and field 2 CEA608 byte pairs and the CEA708 ccp
+ * triplets found in @buffer to @field1, @field2 and @ccp */
+static void
+extract_cc_data (enum CCFormat format, GstBuffer * buffer,
+    GByteArray * field1, GByteArray * field2, GByteArray * ccp)
+{
+  GstMapInfo map;
+  const guint8 *cc_data;
+  guint i, cc_data_len;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+
+  switch (format) {
+    case CC_FORMAT_CEA608_RAW:
+      fail_unless_equals_int (map.size % 2, 0);
+      for (i = 0; i < map.size; i += 2) {
+        /* skip the padding */
+        if (map.data[i] != 0x80 || map.data[i + 1] != 0x80)
+          g_byte_array_append (field1, &map.data[i], 2);
+      }
+      break;
+    case CC_FORMAT_CEA608_S334_1A:
+      fail_unless_equals_int (map.size % 3, 0);
+      for (i = 0; i < map.size; i += 3) {
+        /* the padding loses its field */
+        if (map.data[i + 1] == 0x80 && map.data[i + 2] == 0x80)
+          continue;
+        if (map.data[i] & 0x80)
+          g_byte_array_append (field1, &map.data[i + 1], 2);
+        else
+          g_byte_array_append (field2, &map.data[i + 1], 2);
+      }
+      break;
+    case CC_FORMAT_CEA708_CC_DATA:
+    case CC_FORMAT_CEA708_CDP:
+      if (format == CC_FORMAT_CEA708_CDP) {
+        guint8 checksum = 0;
+
+        fail_unless (map.size >= 11);
+        fail_unless_equals_int (map.data[0], 0x96);
+        fail_unless_equals_int (map.data[1], 0x69);
+        fail_unless_equals_int (map.data[2], map.size);
+        for (i = 0; i < map.size; i++)
+          checksum += map.data[i];
+        fail_unless_equals_int (checksum, 0);
+
+        /* skip the time code section if any */
+        i = (map.data[4] & 0x80) ? 12 : 7;
+        fail_unless_equals_int (map.data[i], 0x72);
+        cc_data_len = (map.data[i + 1] & 0x1f) * 3;
+        cc_data = &map.data[i + 2];
+        fail_unless (i + 2 + cc_data_len <= map.size);
+      } else {
+        cc_data = map.data;
+        cc_data_len = map.size;
+      }
+
+      fail_unless_equals_int (cc_data_len % 3, 0);
+      for (i = 0; i < cc_data_len; i += 3) {
+        /* only valid data, not the padding */
+        if (!(cc_data[i] & 0x04))
+          continue;
+
+        switch (cc_data[i] & 0x03) {
+          case 0x00:
+            g_byte_array_append (field1, &cc_data[i + 1], 2);
+            break;
+          case 0x01:
+            g_byte_array_append (field2, &cc_data[i + 1], 2);
+            break;
+          default:
+            g_byte_array_append (ccp, &cc_data[i], 3);
+            break;
+        }
+      }
+      break;
+  }
+
+  gst_buffer_unmap (buffer, &map);
+}
+
+static void
+check_cc_data_roundtrip (enum CCFormat in_format, guint in_fps,
+    enum CCFormat out_format, guint out_fps)
+{
+  GstHarness *h;
+  GstBuffer *buffer;
+  GByteArray *field1, *field2, *ccp;
+  gchar *in_caps, *out_caps;
+  gboolean with_field2, with_ccp;
+  guint i;
+
+  /* Field 2 is only sent if the input can carry it next to field 1, and ccp
+   * data between the CEA708 formats */
+  with_field2 = cc_format_has_cea608_field2 (in_format)
+      && cc_format_has_cea608_field2 (out_format)
+      && cc_framerates[in_fps].max_cea608_count >= 2;
+  with_ccp = cc_format_has_ccp (in_format) && cc_format_has_ccp (out_format);
+
+  in_caps = g_strdup_printf ("%s,framerate=(fraction)%d/%d",
+      cc_format_caps[in_format], cc_framerates[in_fps].fps_n,
+      cc_framerates[in_fps].fps_d);
+  out_caps = g_strdup_printf ("%s,framerate=(fraction)%d/%d",
+      cc_format_caps[out_format], cc_framerates[out_fps].fps_n,
+      cc_framerates[out_fps].fps_d);
+
+  GST_INFO ("converting from %s to %s, %s field 2, %s ccp", in_caps,
+      out_caps, with_field2 ? "with" : "without", with_ccp ? "with" :
+      "without");
+
+  h = gst_harness_new ("ccconverter");
+  gst_harness_set_src_caps_str (h, in_caps);
+  gst_harness_set_sink_caps_str (h, out_caps);
+
+  for (i = 0; i < N_MATRIX_FRAMES; i++) {
+    buffer = make_cc_buffer (in_format, cc_framerates[in_fps].fps_idx, i,
+        with_field2, with_ccp);
+    fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  }
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  field1 = g_byte_array_new ();
+  field2 = g_byte_array_new ();
+  ccp = g_byte_array_new ();
+  while ((buffer = gst_harness_try_pull (h))) {
+    extract_cc_data (out_format, buffer, field1, field2, ccp);
+    gst_buffer_unref (buffer);
+  }
+
+  /* Everything arrives, in order */
+  fail_unless_equals_int (field1->len, 2 * N_MATRIX_FRAMES);
+  fail_unless_equals_int (field2->len, with_field2 ? 2 * N_MATRIX_FRAMES : 0);
+  fail_unless_equals_int (ccp->len, with_ccp ? 3 * N_MATRIX_FRAMES : 0);
+  for (i = 0; i < N_MATRIX_FRAMES; i++) {
+    fail_unless_equals_int (field1->data[2 * i], 0x20 + i);
+    fail_unless_equals_int (field1->data[2 * i + 1], 0x40 + i);
+    if (with_field2) {
+      fail_unless_equals_int (field2->data[2 * i], 0x60 + i);
+      fail_unless_equals_int (field2->data[2 * i + 1], 0x70 + i);
+    }
+    if (with_ccp) {
+      fail_unless_equals_int (ccp->data[3 * i], 0xfe);
+      fail_unless_equals_int (ccp->data[3 * i + 1], 0x10 + i);
+      fail_unless_equals_int (ccp->data[3 * i + 2], 0x30 + i);
+    }
+  }
+
+  g_byte_array_unref (field1);
+  g_byte_array_unref (field2);
+  g_byte_array_unref (ccp);
+  gst_harness_teardown (h);
+  g_free (in_caps);
+  g_free (out_caps);
+}
+
+GST_START_TEST (convert_cc_data_all_formats)
+{
+  enum CCFormat in_format, out_format;
+  guint in_fps, out_fps;
+
+  for (in_format = CC_FORMAT_CEA608_RAW; in_format <= CC_FORMAT_CEA708_CDP;
+      in_format++) {
+    for (out_format = CC_FORMAT_CEA608_RAW;
+        out_format <= CC_FORMAT_CEA708_CDP; out_format++) {
+      /* only CDP can change the framerate */
+      if (in_format != CC_FORMAT_CEA708_CDP
+          && out_format != CC_FORMAT_CEA708_CDP) {
+        if (in_format != out_format)
+          check_cc_data_roundtrip (in_format, 4, out_format, 4);
+        continue;
+      }
+
+      /* including CDP to CDP framerate conversion */
+      for (in_fps = 0; in_fps < G_N_ELEMENTS (cc_framerates); in_fps++) {
+        for (out_fps = 0; out_fps < G_N_ELEMENTS (cc_framerates); out_fps++)
+          check_cc_data_roundtrip (in_format, in_fps, out_format, out_fps);
+      }
+    }
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 ccextractor_suite (void)
 {
@@ -997,6 +1299,7 @@ ccextractor_suite (void)
   tcase_add_test (tc, convert_cea708_cc_data_cea708_cdp_double_framerate);
   tcase_add_test (tc, convert_cea608_raw_cea708_cdp_double_framerate);
   tcase_add_test (tc, convert_cea608_s334_1a_cea708_cdp_double_framerate);
+  tcase_add_test (tc, convert_cc_data_all_formats);
 
   return s;
 }
@@ -0,0 +1,236 @@
+/* GStreamer
+ *
+ * unit test for combdetect
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+#include <string.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+#define N_FRAMES 4
+
+static const gchar *formats[] = { "I420", "Y42B", "Y444" };
+
+/* Moving vertical bars, with the bottom field of odd frames taken from the
+ * next picture so that they are combed */
+static GstBuffer *
+create_frame (GstHarness * h, GstVideoInfo * info, guint index)
+{
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  guint c;
+  gint x, y;
+
+  buffer = gst_harness_create_buffer (h, GST_VIDEO_INFO_SIZE (info));
+  fail_unless (gst_video_frame_map (&frame, info, buffer, GST_MAP_WRITE));
+
+  for (y = 0; y < HEIGHT; y++) {
+    guint8 *line = GST_VIDEO_FRAME_COMP_DATA (&frame, 0) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
+    gint picture = index;
+
+    if ((index & 1) && (y & 1))
+      picture++;
+    for (x = 0; x < WIDTH; x++)
+      line[x] = (((x + picture * 12) / 8) % 2) ? 200 : 40 + (y % 16);
+  }
+
+  for (c = 1; c < 3; c++) {
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, c); y++) {
+      guint8 *line = GST_VIDEO_FRAME_COMP_DATA (&frame, c) +
+          y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, c);
+
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, c); x++)
+        line[x] = 64 + ((x * c + y + index) & 0x7f);
+    }
+  }
+  gst_video_frame_unmap (&frame);
+
+  GST_BUFFER_PTS (buffer) = index * GST_SECOND / 30;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 30;
+
+  return buffer;
+}
+
+/* Returns the checksums of the frames output by combdetect */
+static gchar *
+run_comb_detect (const gchar * format, guint n_threads)
+{
+  GstHarness *h;
+  GstVideoInfo info;
+  GString *log;
+  gchar *caps;
+  guint i;
+
+  h = gst_harness_new ("combdetect");
+  g_object_set (h->element, "n-threads", n_threads, NULL);
+
+  caps = g_strdup_printf ("video/x-raw, format=%s, width=%d, height=%d, "
+      "framerate=30/1", format, WIDTH, HEIGHT);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+
+  gst_video_info_set_format (&info, gst_video_format_from_string (format),
+      WIDTH, HEIGHT);
+
+  log = g_string_new (NULL);
+
+  for (i = 0; i < N_FRAMES; i++) {
+    GstBuffer *buffer;
+    GstMapInfo map;
+    gchar *checksum;
+
+    buffer = gst_harness_push_and_pull (h, create_frame (h, &info, i));
+    fail_unless (buffer != NULL);
+
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, map.data,
+        map.size);
+    g_string_append_printf (log, "%s\n", checksum);
+    g_free (checksum);
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+  }
+
+  gst_harness_teardown (h);
+
+  return g_string_free (log, FALSE);
+}
+
+GST_START_TEST (test_n_threads)
+{
+  static const guint n_threads[] = { 2, 3, 8 };
+  gchar *expected, *actual;
+  guint i;
+
+  expected = run_comb_detect (formats[__i__], 1);
+
+  /* the output must not depend on how the rows are split */
+  for (i = 0; i < G_N_ELEMENTS (n_threads); i++) {
+    actual = run_comb_detect (formats[__i__], n_threads[i]);
+    fail_unless_equals_string (actual, expected);
+    g_free (actual);
+  }
+
+  g_free (expected);
+}
+
+GST_END_TEST;
+
+/* A 64x16 frame with a combed block in columns 16 to 47: the marked runs
+ * start where the accumulated comb length first goes over 100 and grow to
+ * the left on the following lines */
+#define SCORES_WIDTH 64
+#define SCORES_HEIGHT 16
+
+static const gint first_marked[SCORES_HEIGHT] = {
+  -1, -1, -1, 28, 22, 20, 19, 19, 18, 18, 18, 18, 18, 18, -1, -1
+};
+
+GST_START_TEST (test_scores)
+{
+  GstHarness *h;
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  guint8 *input;
+  gint x, y, n_marked = 0;
+
+  h = gst_harness_new ("combdetect");
+  gst_harness_set_src_caps_str (h, "video/x-raw, format=I420, width=64, "
+      "height=16, framerate=30/1");
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, SCORES_WIDTH,
+      SCORES_HEIGHT);
+
+  input = g_malloc (SCORES_WIDTH * SCORES_HEIGHT);
+  for (y = 0; y < SCORES_HEIGHT; y++) {
+    for (x = 0; x < SCORES_WIDTH; x++) {
+      if (x >= 16 && x < 48)
+        input[y * SCORES_WIDTH + x] = (y & 1) ? 100 : 60;
+      else
+        input[y * SCORES_WIDTH + x] = 80;
+    }
+  }
+
+  buffer = gst_harness_create_buffer (h, GST_VIDEO_INFO_SIZE (&info));
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_WRITE));
+  for (y = 0; y < SCORES_HEIGHT; y++)
+    memcpy (GST_VIDEO_FRAME_COMP_DATA (&frame, 0) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0),
+        input + y * SCORES_WIDTH, SCORES_WIDTH);
+  for (y = 0; y < SCORES_HEIGHT / 2; y++) {
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 1) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 1), 128, SCORES_WIDTH / 2);
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 2) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 2), 128, SCORES_WIDTH / 2);
+  }
+  gst_video_frame_unmap (&frame);
+
+  buffer = gst_harness_push_and_pull (h, buffer);
+  fail_unless (buffer != NULL);
+
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_READ));
+  for (y = 0; y < SCORES_HEIGHT; y++) {
+    const guint8 *line = GST_VIDEO_FRAME_COMP_DATA (&frame, 0) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
+    const guint8 *in = input + y * SCORES_WIDTH;
+
+    for (x = 0; x < SCORES_WIDTH; x++) {
+      if (y < 2 || y >= SCORES_HEIGHT - 2) {
+        /* the edge lines are not checked and are dimmed */
+        fail_unless_equals_int (line[x], in[x] / 2);
+      } else if (first_marked[y] >= 0 && x >= first_marked[y] && x < 48) {
+        fail_unless (line[x] == 16 || line[x] == 235,
+            "sample %d,%d not marked: %d", x, y, line[x]);
+        n_marked++;
+      } else {
+        fail_unless_equals_int (line[x], in[x]);
+      }
+    }
+  }
+  gst_video_frame_unmap (&frame);
+  fail_unless_equals_int (n_marked, 312);
+
+  gst_buffer_unref (buffer);
+  g_free (input);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+combdetect_suite (void)
+{
+  Suite *s = suite_create ("combdetect");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_loop_test (tc_chain, test_n_threads, 0, G_N_ELEMENTS (formats));
+  tcase_add_test (tc_chain, test_scores);
+
+  return s;
+}
+
+GST_CHECK_MAIN (combdetect);
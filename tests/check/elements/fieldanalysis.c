@@ -0,0 +1,325 @@
+/* GStreamer
+ *
+ * unit test for fieldanalysis
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+#include <string.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+#define CAPS_STR "video/x-raw, format=I420, width=320, height=240, " \
+    "framerate=30/1, interlace-mode=progressive"
+
+typedef struct
+{
+  const gchar *field_metric;
+  const gchar *frame_metric;
+  const gchar *comb_method;
+} FieldAnalysisConfig;
+
+static const FieldAnalysisConfig configs[] = {
+  {"sad", "5-tap", "5-tap"},
+  {"ssd", "5-tap", "32-detect"},
+  {"3-tap", "5-tap", "isCombed"},
+  {"ssd", "windowed-comb", "5-tap"},
+  {"sad", "windowed-comb", "32-detect"},
+  {"3-tap", "windowed-comb", "isCombed"},
+};
+
+/* A progressive picture of moving vertical bars is picture n, a combed frame
+ * takes its top field from picture n and its bottom field from picture
+ * n + 1. The sequence has progressive, combed and repeated frames. */
+static const struct
+{
+  gint picture;
+  gboolean combed;
+} sequence[] = {
+  {0, FALSE}, {1, FALSE}, {1, TRUE}, {2, TRUE}, {3, FALSE}, {3, FALSE},
+  {4, FALSE}, {4, TRUE}, {5, FALSE}, {6, FALSE}, {6, FALSE}, {7, FALSE},
+};
+
+static guint8
+picture_sample (gint picture, gint x, gint y)
+{
+  return (((x + picture * 12) / 8) % 2) ? 200 : 40 + (y % 16);
+}
+
+static GstBuffer *
+create_frame (GstHarness * h, guint index)
+{
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  gint x, y;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, WIDTH, HEIGHT);
+  buffer = gst_harness_create_buffer (h, GST_VIDEO_INFO_SIZE (&info));
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_WRITE));
+
+  for (y = 0; y < HEIGHT; y++) {
+    guint8 *line = GST_VIDEO_FRAME_COMP_DATA (&frame, 0) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
+    gint picture = sequence[index].picture;
+
+    if (sequence[index].combed && (y & 1))
+      picture++;
+    for (x = 0; x < WIDTH; x++)
+      line[x] = picture_sample (picture, x, y);
+  }
+  for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, 1); y++) {
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 1) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 1), 128,
+        GST_VIDEO_FRAME_COMP_WIDTH (&frame, 1));
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 2) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 2), 128,
+        GST_VIDEO_FRAME_COMP_WIDTH (&frame, 2));
+  }
+  gst_video_frame_unmap (&frame);
+
+  GST_BUFFER_PTS (buffer) = index * GST_SECOND / 30;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 30;
+
+  return buffer;
+}
+
+/* Runs the sequence through fieldanalysis and returns a description of the
+ * caps and of the flags, timestamps and contents of the buffers it output */
+static gchar *
+run_field_analysis (const FieldAnalysisConfig * config, guint n_threads)
+{
+  GstHarness *h;
+  GstBuffer *buffer;
+  GstEvent *event;
+  GString *log;
+  guint i;
+
+  h = gst_harness_new ("fieldanalysis");
+  gst_util_set_object_arg (G_OBJECT (h->element), "field-metric",
+      config->field_metric);
+  gst_util_set_object_arg (G_OBJECT (h->element), "frame-metric",
+      config->frame_metric);
+  gst_util_set_object_arg (G_OBJECT (h->element), "comb-method",
+      config->comb_method);
+  g_object_set (h->element, "n-threads", n_threads, NULL);
+  gst_harness_set_src_caps_str (h, CAPS_STR);
+
+  for (i = 0; i < G_N_ELEMENTS (sequence); i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (h, i)),
+        GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  log = g_string_new (NULL);
+
+  while ((event = gst_harness_try_pull_event (h))) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      GstCaps *caps;
+      gchar *str;
+
+      gst_event_parse_caps (event, &caps);
+      str = gst_caps_to_string (caps);
+      g_string_append_printf (log, "caps %s\n", str);
+      g_free (str);
+    }
+    gst_event_unref (event);
+  }
+
+  while ((buffer = gst_harness_try_pull (h))) {
+    GstMapInfo map;
+    gchar *checksum;
+
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, map.data,
+        map.size);
+    g_string_append_printf (log, "buffer %" GST_TIME_FORMAT " flags 0x%x %s\n",
+        GST_TIME_ARGS (GST_BUFFER_PTS (buffer)), GST_BUFFER_FLAGS (buffer),
+        checksum);
+    g_free (checksum);
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+  }
+
+  gst_harness_teardown (h);
+
+  return g_string_free (log, FALSE);
+}
+
+GST_START_TEST (test_n_threads)
+{
+  const FieldAnalysisConfig *config = &configs[__i__];
+  static const guint n_threads[] = { 2, 3, 8 };
+  gchar *expected, *actual;
+  guint i;
+
+  expected = run_field_analysis (config, 1);
+  GST_DEBUG ("%s/%s/%s:\n%s", config->field_metric, config->frame_metric,
+      config->comb_method, expected);
+
+  /* the results must not depend on how the rows are split */
+  for (i = 0; i < G_N_ELEMENTS (n_threads); i++) {
+    actual = run_field_analysis (config, n_threads[i]);
+    fail_unless_equals_string (actual, expected);
+    g_free (actual);
+  }
+
+  g_free (expected);
+}
+
+GST_END_TEST;
+
+#ifndef GST_DISABLE_GST_DEBUG
+#define SCORES_WIDTH 16
+#define SCORES_HEIGHT 8
+
+/* A frame whose even lines are all @top and odd lines all @bottom */
+static GstBuffer *
+create_field_frame (GstHarness * h, guint8 top, guint8 bottom, guint index)
+{
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  gint y;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, SCORES_WIDTH,
+      SCORES_HEIGHT);
+  buffer = gst_harness_create_buffer (h, GST_VIDEO_INFO_SIZE (&info));
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_WRITE));
+  for (y = 0; y < SCORES_HEIGHT; y++)
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 0) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0), (y & 1) ? bottom : top,
+        SCORES_WIDTH);
+  for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, 1); y++) {
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 1) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 1), 128,
+        GST_VIDEO_FRAME_COMP_WIDTH (&frame, 1));
+    memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 2) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 2), 128,
+        GST_VIDEO_FRAME_COMP_WIDTH (&frame, 2));
+  }
+  gst_video_frame_unmap (&frame);
+
+  GST_BUFFER_PTS (buffer) = index * GST_SECOND / 30;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 30;
+
+  return buffer;
+}
+
+/* the scores are only visible in the debug log */
+static void
+collect_scores (GstDebugCategory * category, GstDebugLevel level,
+    const gchar * file, const gchar * function, gint line, GObject * object,
+    GstDebugMessage * message, gpointer user_data)
+{
+  GPtrArray *scores = user_data;
+  const gchar *str = gst_debug_message_get (message);
+
+  if (!g_strcmp0 (gst_debug_category_get_name (category), "fieldanalysis")
+      && g_str_has_prefix (str, "Scores: "))
+    g_ptr_array_add (scores, g_strdup (str));
+}
+
+static const struct
+{
+  const gchar *field_metric;
+  gfloat t, b;
+} field_metrics[] = {
+  /* mean absolute difference */
+  {"sad", 30, 50},
+  /* mean squared difference */
+  {"ssd", 900, 2500},
+  /* [1,4,1] weighted difference, normalised */
+  {"3-tap", 30, 50},
+};
+
+/* Two frames with constant fields: 60/100 then 90/150. With the 5-tap frame
+ * metric the comb score of two fields is their difference, unless six
+ * times that is below the noise floor (16 * 6). The field scores compare
+ * the same field of both frames. */
+GST_START_TEST (test_scores)
+{
+  GPtrArray *scores = g_ptr_array_new_with_free_func (g_free);
+  GstHarness *h;
+  gchar *expected;
+
+  gst_debug_set_threshold_for_name ("fieldanalysis", GST_LEVEL_DEBUG);
+  gst_debug_add_log_function (collect_scores, scores, NULL);
+
+  h = gst_harness_new ("fieldanalysis");
+  gst_util_set_object_arg (G_OBJECT (h->element), "field-metric",
+      field_metrics[__i__].field_metric);
+  gst_util_set_object_arg (G_OBJECT (h->element), "frame-metric", "5-tap");
+  gst_harness_set_src_caps_str (h, "video/x-raw, format=I420, width=16, "
+      "height=8, framerate=30/1, interlace-mode=progressive");
+
+  fail_unless_equals_int (gst_harness_push (h, create_field_frame (h, 60, 100,
+              0)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_push (h, create_field_frame (h, 90, 150,
+              1)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  gst_debug_remove_log_function (collect_scores);
+
+  fail_unless_equals_int (scores->len, 2);
+  /* only the fields of the first frame can be compared */
+  fail_unless_equals_string (g_ptr_array_index (scores, 0),
+      "Scores: f 40.000000, t , b , t_b , b_t ");
+  /* the top field of the second frame and the bottom field of the first one
+   * only differ by 10, which is below the noise floor */
+  expected = g_strdup_printf ("Scores: f 60.000000, t %f, b %f, "
+      "t_b 0.000000, b_t 90.000000", field_metrics[__i__].t,
+      field_metrics[__i__].b);
+  fail_unless_equals_string (g_ptr_array_index (scores, 1), expected);
+  g_free (expected);
+
+  /* both frames are combed */
+  while (gst_harness_buffers_in_queue (h)) {
+    GstBuffer *buffer = gst_harness_pull (h);
+
+    fail_unless (GST_BUFFER_FLAG_IS_SET (buffer,
+            GST_VIDEO_BUFFER_FLAG_INTERLACED));
+    gst_buffer_unref (buffer);
+  }
+
+  gst_harness_teardown (h);
+  g_ptr_array_unref (scores);
+}
+
+GST_END_TEST;
+#endif
+
+static Suite *
+fieldanalysis_suite (void)
+{
+  Suite *s = suite_create ("fieldanalysis");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_loop_test (tc_chain, test_n_threads, 0, G_N_ELEMENTS (configs));
+#ifndef GST_DISABLE_GST_DEBUG
+  tcase_add_loop_test (tc_chain, test_scores, 0, G_N_ELEMENTS (field_metrics));
+#endif
+
+  return s;
+}
+
+GST_CHECK_MAIN (fieldanalysis);
@@ -0,0 +1,199 @@
+/* GStreamer
+ *
+ * unit test for the geometrictransform elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+/* the perspective matrix is a GValueArray */
+#define GLIB_DISABLE_DEPRECATION_WARNINGS
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+/* the width is not a multiple of 4, so rows are padded */
+#define WIDTH 10
+#define HEIGHT 6
+#define CAPS "video/x-raw, format=GRAY8, width=10, height=6, framerate=25/1"
+
+/* horizontal neighbours differ by 16, vertical ones by 2 */
+#define PIXEL(x, y) ((x) * 16 + (y) * 2)
+
+static GstHarness *
+create_harness (const gchar * element, gint interpolation, guint n_threads)
+{
+  GstHarness *h = gst_harness_new (element);
+
+  g_object_set (h->element, "interpolation", interpolation, "n-threads",
+      n_threads, NULL);
+  gst_harness_set_src_caps_str (h, CAPS);
+
+  return h;
+}
+
+static GstBuffer *
+create_frame (GstHarness * h, gboolean uniform)
+{
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  gint x, y;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_GRAY8, WIDTH, HEIGHT);
+  buffer = gst_harness_create_buffer (h, GST_VIDEO_INFO_SIZE (&info));
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_WRITE));
+  for (y = 0; y < HEIGHT; y++) {
+    guint8 *line = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0) +
+        y * GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+
+    for (x = 0; x < WIDTH; x++)
+      line[x] = uniform ? 100 : PIXEL (x, y);
+  }
+  gst_video_frame_unmap (&frame);
+
+  return buffer;
+}
+
+/* Pushes a frame and compares every output pixel with @expected */
+static void
+check_frame (GstHarness * h, gboolean uniform,
+    guint8 (*expected) (gint x, gint y, gboolean bilinear), gboolean bilinear)
+{
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  gint x, y;
+
+  buffer = gst_harness_push_and_pull (h, create_frame (h, uniform));
+  fail_unless (buffer != NULL);
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_GRAY8, WIDTH, HEIGHT);
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_READ));
+  for (y = 0; y < HEIGHT; y++) {
+    const guint8 *line = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0) +
+        y * GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+
+    for (x = 0; x < WIDTH; x++)
+      fail_unless_equals_int (line[x], expected (x, y, bilinear));
+  }
+  gst_video_frame_unmap (&frame);
+  gst_buffer_unref (buffer);
+}
+
+/* The input is sampled half a pixel right and down of each output pixel.
+ * Nearest neighbour truncates to the same pixel, bilinear interpolation
+ * averages the neighbours that are inside the frame. */
+static guint8
+expected_half_pixel_shift (gint x, gint y, gboolean bilinear)
+{
+  guint8 pixel = PIXEL (x, y);
+
+  if (bilinear) {
+    if (x < WIDTH - 1)
+      pixel += 16 / 2;
+    if (y < HEIGHT - 1)
+      pixel += 2 / 2;
+  }
+
+  return pixel;
+}
+
+static guint8
+expected_uniform (gint x, gint y, gboolean bilinear)
+{
+  return 100;
+}
+
+static void
+set_perspective_matrix (GstElement * element, const gdouble * matrix)
+{
+  GValueArray *array = g_value_array_new (9);
+  GValue value = G_VALUE_INIT;
+  guint i;
+
+  g_value_init (&value, G_TYPE_DOUBLE);
+  for (i = 0; i < 9; i++) {
+    g_value_set_double (&value, matrix[i]);
+    g_value_array_append (array, &value);
+  }
+  g_value_unset (&value);
+
+  g_object_set (element, "matrix", array, NULL);
+  g_value_array_free (array);
+}
+
+GST_START_TEST (test_interpolation)
+{
+  static const gdouble shift[] = {
+    1, 0, 0.5,
+    0, 1, 0.5,
+    0, 0, 1
+  };
+  gboolean bilinear = __i__ & 1;
+  guint n_threads = __i__ & 2 ? 3 : 1;
+  GstHarness *h;
+
+  h = create_harness ("perspective", bilinear, n_threads);
+  set_perspective_matrix (h->element, shift);
+
+  check_frame (h, FALSE, expected_half_pixel_shift, bilinear);
+  /* the precalculated map is reused */
+  check_frame (h, FALSE, expected_half_pixel_shift, bilinear);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* diffuse maps every frame again, on as many threads as configured */
+GST_START_TEST (test_no_precalc_map)
+{
+  gboolean bilinear = __i__ & 1;
+  guint n_threads = __i__ & 2 ? 3 : 1;
+  GstHarness *h;
+
+  h = create_harness ("diffuse", bilinear, n_threads);
+
+  /* whatever the random displacements are, a uniform frame stays the same */
+  check_frame (h, TRUE, expected_uniform, bilinear);
+  g_object_set (h->element, "scale", 2.0, NULL);
+  check_frame (h, TRUE, expected_uniform, bilinear);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+geometrictransform_suite (void)
+{
+  Suite *s = suite_create ("geometrictransform");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  /* nearest and bilinear, with one and several threads */
+  tcase_add_loop_test (tc_chain, test_interpolation, 0, 4);
+  tcase_add_loop_test (tc_chain, test_no_precalc_map, 0, 4);
+
+  return s;
+}
+
+GST_CHECK_MAIN (geometrictransform);
@@ -194,6 +194,101 @@ GST_START_TEST (test_framerate_empty_not_negotiated)
 
 GST_END_TEST;
 
+static GstBuffer *
+create_filled_frame (GstHarness * h, const GstVideoInfo * info, guint16 value)
+{
+  GstBuffer *buffer;
+  GstVideoFrame frame;
+  guint i, x, y;
+
+  buffer = gst_harness_create_buffer (h, GST_VIDEO_INFO_SIZE (info));
+  fail_unless (gst_video_frame_map (&frame, info, buffer, GST_MAP_WRITE));
+
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&frame); i++) {
+    guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (&frame, i);
+    gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, i);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, i); y++) {
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, i); x++)
+        GST_WRITE_UINT16_LE (data + y * stride + 2 * x, value);
+    }
+  }
+
+  gst_video_frame_unmap (&frame);
+
+  return buffer;
+}
+
+static void
+check_frame_fields (GstBuffer * buffer, const GstVideoInfo * info,
+    guint16 top, guint16 bottom)
+{
+  GstVideoFrame frame;
+  guint i, x, y;
+
+  fail_unless (gst_video_frame_map (&frame, info, buffer, GST_MAP_READ));
+
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&frame); i++) {
+    const guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (&frame, i);
+    gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, i);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, i); y++) {
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, i); x++) {
+        fail_unless_equals_int (GST_READ_UINT16_LE (data + y * stride + 2 * x),
+            (y & 1) ? bottom : top);
+      }
+    }
+  }
+
+  gst_video_frame_unmap (&frame);
+}
+
+GST_START_TEST (test_telecine_2_3_10bit)
+{
+  /* top and bottom field values of the 5 frames produced from 4 frames */
+  const guint16 expected[5][2] = {
+    {100, 100}, {200, 200}, {200, 300}, {300, 400}, {400, 400}
+  };
+  GstVideoInfo in_info, out_info;
+  GstBuffer *buffer;
+  GstCaps *caps;
+  GstHarness *h;
+  guint i;
+
+  h = gst_harness_new ("interlace");
+
+  gst_harness_set (h, "interlace", "field-pattern", 2, "top-field-first", TRUE,
+      NULL);
+  gst_harness_set_sink_caps_str (h, "video/x-raw,framerate=30/1");
+  gst_harness_set_src_caps_str (h,
+      "video/x-raw,interlace-mode=progressive,format=I420_10LE,width=4,height=4,framerate=24/1");
+
+  gst_video_info_set_format (&in_info, GST_VIDEO_FORMAT_I420_10LE, 4, 4);
+
+  for (i = 0; i < 4; i++) {
+    buffer = create_filled_frame (h, &in_info, 100 * (i + 1));
+    if (i == 0)
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  }
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (caps != NULL);
+  fail_unless (gst_video_info_from_caps (&out_info, caps));
+  gst_caps_unref (caps);
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 5);
+  for (i = 0; i < 5; i++) {
+    buffer = gst_harness_pull (h);
+    check_frame_fields (buffer, &out_info, expected[i][0], expected[i][1]);
+    gst_buffer_unref (buffer);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 interlace_suite (void)
 {
@@ -209,6 +304,7 @@ interlace_suite (void)
   tcase_add_test (tc_chain, test_framerate_1_1);
   tcase_add_test (tc_chain, test_framerate_3_2);
   tcase_add_test (tc_chain, test_framerate_empty_not_negotiated);
+  tcase_add_test (tc_chain, test_telecine_2_3_10bit);
 
   return s;
 }
@@ -0,0 +1,158 @@
+/* GStreamer
+ *
+ * unit test for intervideosink and intervideosrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define VIDEO_CAPS_STR \
+    "video/x-raw,format=I420,width=16,height=16,framerate=25/1"
+#define FRAME_SIZE (16 * 16 * 3 / 2)
+#define FRAME_TIME(n) gst_util_uint64_scale (n, GST_SECOND, 25)
+#define N_FRAMES 4
+
+/* The sink is not part of a pipeline, so its base time is 0 and every frame
+ * is due at the clock time of its PTS. Frame n starts with the byte n. */
+static GstHarness *
+start_sink (const gchar * channel, guint ring_size)
+{
+  GstHarness *h;
+  gchar *desc;
+  guint i;
+
+  desc = g_strdup_printf ("intervideosink channel=%s ring-size=%u sync=false",
+      channel, ring_size);
+  h = gst_harness_new_parse (desc);
+  g_free (desc);
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS_STR);
+
+  for (i = 0; i < N_FRAMES; i++) {
+    GstBuffer *buffer = gst_harness_create_buffer (h, FRAME_SIZE);
+
+    gst_buffer_memset (buffer, 0, i, FRAME_SIZE);
+    GST_BUFFER_PTS (buffer) = FRAME_TIME (i);
+    GST_BUFFER_DURATION (buffer) = FRAME_TIME (i + 1) - FRAME_TIME (i);
+    fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  }
+
+  return h;
+}
+
+static GstHarness *
+start_src (const gchar * channel, gboolean timestamp_selection)
+{
+  GstHarness *h;
+  gchar *desc;
+
+  desc = g_strdup_printf ("intervideosrc channel=%s timestamp-selection=%d",
+      channel, timestamp_selection);
+  h = gst_harness_new_parse (desc);
+  g_free (desc);
+  gst_harness_set_sink_caps_str (h, VIDEO_CAPS_STR);
+  gst_harness_play (h);
+
+  return h;
+}
+
+/* Pulls the next frame of the live source and returns which sink frame it
+ * carries */
+static guint8
+pull_frame (GstHarness * h, guint n, gboolean * gap)
+{
+  GstBuffer *buffer;
+  guint8 id;
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  buffer = gst_harness_pull (h);
+  fail_unless (buffer != NULL);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), FRAME_TIME (n));
+  fail_unless_equals_int (gst_buffer_extract (buffer, 0, &id, 1), 1);
+  *gap = GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_GAP);
+  gst_buffer_unref (buffer);
+
+  return id;
+}
+
+GST_START_TEST (test_timestamp_selection)
+{
+  guint ring_size = __i__ + 1;
+  GstHarness *sink, *src;
+  guint8 expected, previous = 0;
+  gboolean gap;
+  guint n;
+
+  sink = start_sink ("test-timestamp-selection", ring_size);
+  src = start_src ("test-timestamp-selection", TRUE);
+
+  /* each frame shows the sink frame due at its time, or the oldest one
+   * still in the ring, and repeats are flagged as gaps */
+  for (n = 0; n < N_FRAMES + 2; n++) {
+    expected = CLAMP (n, N_FRAMES - ring_size, N_FRAMES - 1);
+    fail_unless_equals_int (pull_frame (src, n, &gap), expected);
+    fail_unless_equals_int (gap, n > 0 && expected == previous);
+    previous = expected;
+  }
+
+  gst_harness_teardown (src);
+  gst_harness_teardown (sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_latest_frame)
+{
+  GstHarness *sink, *src;
+  gboolean gap;
+  guint n;
+
+  sink = start_sink ("test-latest-frame", N_FRAMES);
+  src = start_src ("test-latest-frame", FALSE);
+
+  /* without timestamp selection the ring size does not matter, the newest
+   * frame is output and then repeated */
+  for (n = 0; n < N_FRAMES; n++) {
+    fail_unless_equals_int (pull_frame (src, n, &gap), N_FRAMES - 1);
+    fail_unless_equals_int (gap, n > 0);
+  }
+
+  gst_harness_teardown (src);
+  gst_harness_teardown (sink);
+}
+
+GST_END_TEST;
+
+static Suite *
+intervideo_suite (void)
+{
+  Suite *s = suite_create ("intervideo");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  /* ring sizes 1 to N_FRAMES */
+  tcase_add_loop_test (tc_chain, test_timestamp_selection, 0, N_FRAMES);
+  tcase_add_test (tc_chain, test_latest_frame);
+
+  return s;
+}
+
+GST_CHECK_MAIN (intervideo);
@@ -23,6 +23,7 @@
 #include <unistd.h>
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 
 /* This test doesn't use actual JPEG data, but some fake data that we know
    will trigger certain paths in jpegparse. */
@@ -150,6 +151,18 @@ guint8 test_data_sof0[] = {
 
 guint8 test_data_eoi[] = { 0xff, 0xd9 };
 
+guint8 test_data_restarts[] = {
+  0xff, 0xd8,
+  0xff, 0xdd, 0x00, 0x04, 0x00, 0x02,   /* DRI, interval of 2 MCUs */
+  0xff, 0xda, 0x00, 0x04, 0x22, 0x33,   /* SOS */
+  0x44, 0xff, 0x00, 0x55,
+  /* 18: */ 0xff, 0xd0,         /* RST0 */
+  0x66, 0x77,
+  /* 22: */ 0xff, 0xd1,         /* RST1 */
+  0x88,
+  0xff, 0xd9
+};
+
 static GList *
 _make_buffers_in (GList * buffer_in, guint8 * test_data, gsize test_data_size)
 {
@@ -367,6 +380,81 @@ GST_START_TEST (test_parse_comment)
 
 GST_END_TEST;
 
+static void
+check_restart_meta (GstBuffer * buffer)
+{
+  GstCustomMeta *meta;
+  GstStructure *s;
+  const GValue *offsets;
+  guint interval = 0;
+
+  fail_unless_equals_int (gst_buffer_get_size (buffer),
+      sizeof (test_data_restarts));
+  fail_unless (gst_buffer_memcmp (buffer, 0, test_data_restarts,
+          sizeof (test_data_restarts)) == 0);
+
+  meta = gst_buffer_get_custom_meta (buffer, "GstJpegParseRestartMeta");
+  fail_unless (meta != NULL);
+  fail_unless (gst_meta_api_type_has_tag (meta->meta.info->api,
+          GST_META_TAG_MEMORY));
+  s = gst_custom_meta_get_structure (meta);
+
+  fail_unless (gst_structure_get_uint (s, "restart-interval", &interval));
+  fail_unless_equals_int (interval, 2);
+
+  offsets = gst_structure_get_value (s, "offsets");
+  fail_unless (offsets != NULL);
+  fail_unless_equals_int (gst_value_array_get_size (offsets), 2);
+  fail_unless_equals_int (g_value_get_uint (gst_value_array_get_value (offsets,
+              0)), 18);
+  fail_unless_equals_int (g_value_get_uint (gst_value_array_get_value (offsets,
+              1)), 22);
+}
+
+GST_START_TEST (test_parse_restart_markers)
+{
+  GstHarness *h;
+  GstBuffer *buffer;
+  gsize i;
+
+  h = gst_harness_new ("jpegparse");
+  gst_harness_set_src_caps_str (h, "image/jpeg, parsed = (boolean) false");
+
+  /* byte by byte first, so the entropy scan has to resume several times */
+  for (i = 0; i < sizeof (test_data_restarts); i++) {
+    buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        test_data_restarts + i, 1, 0, 1, NULL, NULL);
+    fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  }
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      test_data_restarts, sizeof (test_data_restarts), 0,
+      sizeof (test_data_restarts), NULL, NULL);
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+
+  buffer = gst_harness_pull (h);
+  check_restart_meta (buffer);
+  gst_buffer_unref (buffer);
+
+  buffer = gst_harness_pull (h);
+  check_restart_meta (buffer);
+  gst_buffer_unref (buffer);
+
+  /* a frame without restart markers carries no meta */
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      test_data_normal_frame, sizeof (test_data_normal_frame), 0,
+      sizeof (test_data_normal_frame), NULL, NULL);
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+
+  buffer = gst_harness_pull (h);
+  fail_unless (gst_buffer_get_custom_meta (buffer,
+          "GstJpegParseRestartMeta") == NULL);
+  gst_buffer_unref (buffer);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 jpegparse_suite (void)
 {
@@ -378,6 +466,7 @@ jpegparse_suite (void)
   tcase_add_test (tc_chain, test_parse_all_in_one_buf);
   tcase_add_test (tc_chain, test_parse_app1_exif);
   tcase_add_test (tc_chain, test_parse_comment);
+  tcase_add_test (tc_chain, test_parse_restart_markers);
 
   return s;
 }
@@ -26,6 +26,10 @@
 #include <gst/check/gstharness.h>
 #include <gst/video/video.h>
 
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
 GST_START_TEST (basic)
 {
   GstHarness *h;
@@ -127,6 +131,241 @@ GST_START_TEST (remove_caption_meta)
 
 GST_END_TEST;
 
+GST_START_TEST (decode_black_frames)
+{
+  GstHarness *h;
+  GstBuffer *buf, *outbuf;
+  GstVideoInfo info;
+  GstVideoCaptionMeta *out_cc_meta;
+  GstMapInfo map;
+  guint i, j;
+  GstCaps *caps = gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "I420",
+      "width", G_TYPE_INT, 720,
+      "height", G_TYPE_INT, 525,
+      "interlace-mode", G_TYPE_STRING, "interleaved",
+      NULL);
+
+  h = gst_harness_new_parse
+      ("line21encoder remove-caption-meta=true ! line21decoder");
+  gst_harness_set_caps (h, gst_caps_ref (caps), gst_caps_ref (caps));
+
+  gst_video_info_from_caps (&info, caps);
+
+  gst_caps_unref (caps);
+
+  /* All lines but the CC ones are flat, so they're all skipped while
+   * probing, and the following frames are decoded from the same line */
+  for (i = 0; i < 5; i++) {
+    guint8 full_data[] = { 0x8c, 0x42 + i, 0x43 + i, 0x0, 0x44 + i, 0x45 + i };
+
+    buf = gst_buffer_new_and_alloc (info.size);
+    gst_buffer_map (buf, &map, GST_MAP_WRITE);
+    memset (map.data, 16, GST_VIDEO_INFO_PLANE_OFFSET (&info, 1));
+    memset (map.data + GST_VIDEO_INFO_PLANE_OFFSET (&info, 1), 128,
+        info.size - GST_VIDEO_INFO_PLANE_OFFSET (&info, 1));
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_add_video_caption_meta (buf,
+        GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A, full_data, 6);
+
+    outbuf = gst_harness_push_and_pull (h, buf);
+
+    fail_unless (outbuf != NULL);
+    fail_unless_equals_int (gst_buffer_get_n_meta (outbuf,
+            GST_VIDEO_CAPTION_META_API_TYPE), 1);
+
+    out_cc_meta = gst_buffer_get_video_caption_meta (outbuf);
+    fail_unless (out_cc_meta != NULL);
+    fail_unless_equals_int (out_cc_meta->size, 6);
+
+    for (j = 0; j < out_cc_meta->size; j++)
+      fail_unless_equals_int (out_cc_meta->data[j], full_data[j]);
+
+    gst_buffer_unref (outbuf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* Line 21 waveform as specified by EIA-608, sampled at 13.5 MHz from the
+ * start of the BT.601 active line, 122 samples after the horizontal sync */
+#define CC_WIDTH 720
+#define CC_HEIGHT 525
+#define CC_BIT_RATE (32 * 15734.264)
+#define CC_SAMPLE_TIME(x) ((122 + (x)) / 13.5e6)
+/* clock run-in and start bits, from the half amplitude of the first edge */
+#define CC_CRI_START (10.5e-6 - 0.25 / CC_BIT_RATE)
+#define CC_START_BITS (10.5e-6 + 6.5 / CC_BIT_RATE)
+/* 0 and 50 IRE */
+#define CC_LOW 16
+#define CC_HIGH 126
+
+static guint8
+odd_parity (guint8 c)
+{
+  guint8 p = c & 0x7f;
+
+  p ^= p >> 4;
+  p ^= p >> 2;
+  p ^= p >> 1;
+
+  return (c & 0x7f) | ((~p & 1) << 7);
+}
+
+static void
+write_cc_line (guint8 * line, guint8 cc1, guint8 cc2)
+{
+  /* two start bits at 0, one at 1, then both bytes LSB first */
+  guint32 bits = (cc2 << 11) | (cc1 << 3) | 0x4;
+  gint x;
+
+  for (x = 0; x < CC_WIDTH; x++) {
+    gdouble t = CC_SAMPLE_TIME (x);
+    gint bit = floor ((t - CC_START_BITS) * CC_BIT_RATE);
+
+    if (t >= CC_CRI_START && t < CC_CRI_START + 7 / CC_BIT_RATE) {
+      /* 7 cycles of sine wave */
+      line[x] = CC_LOW + (CC_HIGH - CC_LOW) / 2.0 *
+          (1.0 - cos (2 * G_PI * CC_BIT_RATE * (t - CC_CRI_START)));
+    } else if (t >= CC_START_BITS && bit < 19 && (bits & (1 << bit))) {
+      line[x] = CC_HIGH;
+    } else {
+      line[x] = CC_LOW;
+    }
+  }
+}
+
+/* A black frame with the CC of both fields at @cc_line and @cc_line + 1,
+ * unless it is -1. Two lines of wide bars have the range of a CC line but
+ * don't decode, and a line of low amplitude noise doesn't even have the
+ * range */
+static GstBuffer *
+create_cc_frame (GstVideoInfo * info, gint cc_line, const guint8 cc[4])
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  guint stride = GST_VIDEO_INFO_COMP_STRIDE (info, 0);
+  gint x;
+
+  buf = gst_buffer_new_and_alloc (info->size);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, CC_LOW, GST_VIDEO_INFO_PLANE_OFFSET (info, 1));
+  memset (map.data + GST_VIDEO_INFO_PLANE_OFFSET (info, 1), 128,
+      info->size - GST_VIDEO_INFO_PLANE_OFFSET (info, 1));
+
+  for (x = 0; x < CC_WIDTH; x++) {
+    map.data[5 * stride + x] = map.data[6 * stride + x] =
+        ((x / 90) & 1) ? 235 : CC_LOW;
+    map.data[10 * stride + x] = CC_LOW + x % 20;
+  }
+
+  if (cc_line != -1) {
+    write_cc_line (map.data + cc_line * stride, cc[0], cc[1]);
+    write_cc_line (map.data + (cc_line + 1) * stride, cc[2], cc[3]);
+  }
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+#ifndef GST_DISABLE_GST_DEBUG
+/* the lines that went through the bit slicer are only visible in the debug
+ * log */
+static void
+collect_decoded_lines (GstDebugCategory * category, GstDebugLevel level,
+    const gchar * file, const gchar * function, gint line, GObject * object,
+    GstDebugMessage * message, gpointer user_data)
+{
+  GString *lines = user_data;
+  const gchar *str = gst_debug_message_get (message);
+  gint i, n_lines;
+
+  if (!g_strcmp0 (gst_debug_category_get_name (category), "line21decoder")
+      && sscanf (str, "i:%d n_lines:%d", &i, &n_lines) == 2)
+    g_string_append_printf (lines, "%d ", i);
+}
+#endif
+
+GST_START_TEST (decode_waveform)
+{
+  static const struct
+  {
+    gint cc_line;
+    const gchar *decoded_lines;
+  } frames[] = {
+    /* full probe, the bars are tried but not the noise */
+    {15, "5 15 "},
+    /* the line of the previous frame decodes */
+    {15, "15 "},
+    /* the line of the previous frame doesn't decode anymore */
+    {21, "15 5 21 "},
+    /* no CC */
+    {-1, "21 5 "},
+  };
+  GstHarness *h;
+  GstVideoInfo info;
+  GString *lines = g_string_new (NULL);
+  guint i, j;
+
+#ifndef GST_DISABLE_GST_DEBUG
+  gst_debug_set_threshold_for_name ("line21decoder", GST_LEVEL_DEBUG);
+  gst_debug_add_log_function (collect_decoded_lines, lines, NULL);
+#endif
+
+  h = gst_harness_new ("line21decoder");
+  gst_harness_set_src_caps_str (h, "video/x-raw, format=I420, width=720, "
+      "height=525, interlace-mode=interleaved, framerate=30000/1001");
+  gst_video_info_set_interlaced_format (&info, GST_VIDEO_FORMAT_I420,
+      GST_VIDEO_INTERLACE_MODE_INTERLEAVED, CC_WIDTH, CC_HEIGHT);
+
+  for (i = 0; i < G_N_ELEMENTS (frames); i++) {
+    guint8 cc[4];
+    GstBuffer *outbuf;
+    GstVideoCaptionMeta *cc_meta;
+
+    cc[0] = odd_parity ('A' + i);
+    cc[1] = odd_parity ('a' + i);
+    cc[2] = odd_parity ('0' + i);
+    cc[3] = odd_parity (' ' + i);
+
+    g_string_truncate (lines, 0);
+    outbuf = gst_harness_push_and_pull (h,
+        create_cc_frame (&info, frames[i].cc_line, cc));
+    fail_unless (outbuf != NULL);
+
+    cc_meta = gst_buffer_get_video_caption_meta (outbuf);
+    if (frames[i].cc_line == -1) {
+      fail_unless (cc_meta == NULL);
+    } else {
+      guint8 expected[6] = { 0x80 | (frames[i].cc_line - 9), cc[0], cc[1],
+        0x00, cc[2], cc[3]
+      };
+
+      fail_unless (cc_meta != NULL, "no CC in frame %u", i);
+      fail_unless_equals_int (cc_meta->caption_type,
+          GST_VIDEO_CAPTION_TYPE_CEA608_S334_1A);
+      fail_unless_equals_int (cc_meta->size, 6);
+      for (j = 0; j < 6; j++)
+        fail_unless_equals_int (cc_meta->data[j], expected[j]);
+    }
+#ifndef GST_DISABLE_GST_DEBUG
+    fail_unless_equals_string (lines->str, frames[i].decoded_lines);
+#endif
+
+    gst_buffer_unref (outbuf);
+  }
+
+#ifndef GST_DISABLE_GST_DEBUG
+  gst_debug_remove_log_function (collect_decoded_lines);
+#endif
+  g_string_free (lines, TRUE);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 line21_suite (void)
 {
@@ -137,6 +376,8 @@ line21_suite (void)
 
   tcase_add_test (tc, basic);
   tcase_add_test (tc, remove_caption_meta);
+  tcase_add_test (tc, decode_black_frames);
+  tcase_add_test (tc, decode_waveform);
 
   return s;
 }
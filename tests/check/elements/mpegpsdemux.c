@@ -0,0 +1,391 @@
+/* GStreamer
+ *
+ * unit test for mpegpsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+/* 10 s of video, one pack every 40 ms. The packs get 4 times smaller
+ * halfway, so interpolating between the first and last SCR is far off */
+#define N_PACKS 250
+#define N_LARGE_PACKS 125
+#define LARGE_PACK_SIZE 4096
+#define SMALL_PACK_SIZE 1024
+#define FIRST_SCR 90000
+#define SCR_STEP 3600
+#define PACK_PTS(i) \
+    gst_util_uint64_scale (FIRST_SCR + (i) * SCR_STEP, GST_SECOND, 90000)
+
+/* Seek positions are relative to the first SCR, the demuxer starts at the
+ * last pack before it */
+#define SEEK_POSITION (3300 * GST_MSECOND)
+#define SEEK_PACK 82
+
+static GstStaticPadTemplate mysrctemplate =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/mpeg, systemstream=true"));
+
+static GstStaticPadTemplate mysinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstPad *mysrcpad, *mysinkpad;
+static guint8 *ps_data;
+static gsize ps_size;
+
+static GMutex lock;
+static GCond cond;
+static GThread *seek_thread;
+static guint n_seek_pulls;
+static gboolean block_data, blocked, flushing, have_eos;
+static GstClockTime first_pts;
+
+static gsize
+pack_offset (guint i)
+{
+  if (i < N_LARGE_PACKS)
+    return i * LARGE_PACK_SIZE;
+
+  return N_LARGE_PACKS * LARGE_PACK_SIZE + (i - N_LARGE_PACKS) *
+      SMALL_PACK_SIZE;
+}
+
+/* Writes an MPEG-2 pack of @size bytes holding a video PES with the SCR as
+ * PTS */
+static void
+write_pack (guint8 * data, guint64 scr, guint size)
+{
+  guint mux_rate = size * 25 / 50;
+  guint pes_length = size - 14 - 6;
+  guint64 pts = scr;
+
+  GST_WRITE_UINT32_BE (data, 0x000001ba);
+  data[4] = 0x44 | ((scr >> 27) & 0x38) | ((scr >> 28) & 0x03);
+  data[5] = scr >> 20;
+  data[6] = ((scr >> 12) & 0xf8) | 0x04 | ((scr >> 13) & 0x03);
+  data[7] = scr >> 5;
+  data[8] = ((scr << 3) & 0xf8) | 0x04;
+  data[9] = 0x01;
+  data[10] = mux_rate >> 14;
+  data[11] = mux_rate >> 6;
+  data[12] = (mux_rate << 2) | 0x03;
+  data[13] = 0xf8;
+  data += 14;
+
+  GST_WRITE_UINT32_BE (data, 0x000001e0);
+  GST_WRITE_UINT16_BE (data + 4, pes_length);
+  data[6] = 0x80;
+  data[7] = 0x80;
+  data[8] = 5;
+  data[9] = 0x21 | ((pts >> 29) & 0x0e);
+  data[10] = pts >> 22;
+  data[11] = ((pts >> 14) & 0xfe) | 0x01;
+  data[12] = pts >> 7;
+  data[13] = (pts << 1) | 0x01;
+  memset (data + 14, 0xff, pes_length - 8);
+}
+
+static void
+create_ps_stream (void)
+{
+  guint i;
+
+  ps_size = pack_offset (N_PACKS) + 4;
+  ps_data = g_malloc (ps_size);
+
+  for (i = 0; i < N_PACKS; i++)
+    write_pack (ps_data + pack_offset (i), FIRST_SCR + i * SCR_STEP,
+        i < N_LARGE_PACKS ? LARGE_PACK_SIZE : SMALL_PACK_SIZE);
+  GST_WRITE_UINT32_BE (ps_data + pack_offset (N_PACKS), 0x000001b9);
+}
+
+static GstFlowReturn
+_src_getrange (GstPad * pad, GstObject * parent, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  g_mutex_lock (&lock);
+  if (g_thread_self () == seek_thread)
+    n_seek_pulls++;
+  g_mutex_unlock (&lock);
+
+  if (offset >= ps_size)
+    return GST_FLOW_EOS;
+  length = MIN (length, ps_size - offset);
+
+  *buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      ps_data + offset, length, 0, length, NULL, NULL);
+  GST_BUFFER_OFFSET (*buffer) = offset;
+  GST_BUFFER_OFFSET_END (*buffer) = offset + length;
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  gboolean res = FALSE;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_DURATION:{
+      GstFormat fmt;
+
+      gst_query_parse_duration (query, &fmt, NULL);
+      if (fmt != GST_FORMAT_BYTES)
+        break;
+
+      gst_query_set_duration (query, fmt, ps_size);
+      res = TRUE;
+      break;
+    }
+    case GST_QUERY_SCHEDULING:{
+      gst_query_set_scheduling (query, GST_SCHEDULING_FLAG_SEEKABLE, 1, -1, 0);
+      gst_query_add_scheduling_mode (query, GST_PAD_MODE_PULL);
+      res = TRUE;
+      break;
+    }
+    default:
+      break;
+  }
+
+  return res;
+}
+
+static GstFlowReturn
+_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&lock);
+  if (block_data) {
+    /* hold the streaming thread until the seek flushes it, so that only the
+     * first pack is indexed */
+    blocked = TRUE;
+    g_cond_broadcast (&cond);
+    while (!flushing)
+      g_cond_wait (&cond, &lock);
+    block_data = FALSE;
+    ret = GST_FLOW_FLUSHING;
+  } else if (!GST_CLOCK_TIME_IS_VALID (first_pts)) {
+    first_pts = GST_BUFFER_PTS (buffer);
+    g_cond_broadcast (&cond);
+  }
+  g_mutex_unlock (&lock);
+
+  gst_buffer_unref (buffer);
+
+  return ret;
+}
+
+static gboolean
+_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  g_mutex_lock (&lock);
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      flushing = TRUE;
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      flushing = FALSE;
+      break;
+    case GST_EVENT_EOS:
+      have_eos = TRUE;
+      break;
+    default:
+      break;
+  }
+  g_cond_broadcast (&cond);
+  g_mutex_unlock (&lock);
+
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static void
+_pad_added (GstElement * element, GstPad * pad, gpointer user_data)
+{
+  fail_unless (gst_pad_link (pad, mysinkpad) == GST_PAD_LINK_OK);
+}
+
+static void
+wait_for (gboolean * flag)
+{
+  g_mutex_lock (&lock);
+  while (!*flag)
+    g_cond_wait (&cond, &lock);
+  g_mutex_unlock (&lock);
+}
+
+/* Does a flushing seek to @position from this thread, checks where the
+ * demuxer restarts and returns how many ranges the seek pulled */
+static guint
+seek_and_check (GstClockTime position, guint pack)
+{
+  GstEvent *event;
+  GstClockTime pts;
+  guint n_pulls;
+
+  g_mutex_lock (&lock);
+  first_pts = GST_CLOCK_TIME_NONE;
+  have_eos = FALSE;
+  n_seek_pulls = 0;
+  seek_thread = g_thread_self ();
+  g_mutex_unlock (&lock);
+
+  event = gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+      GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, -1);
+  fail_unless (gst_pad_push_event (mysinkpad, event));
+
+  g_mutex_lock (&lock);
+  seek_thread = NULL;
+  n_pulls = n_seek_pulls;
+  while (!GST_CLOCK_TIME_IS_VALID (first_pts))
+    g_cond_wait (&cond, &lock);
+  pts = first_pts;
+  g_mutex_unlock (&lock);
+
+  fail_unless_equals_uint64 (pts, PACK_PTS (pack));
+
+  return n_pulls;
+}
+
+/* Checks that the index points at pack starts and that the packs read from
+ * @pack on are indexed about every half second */
+static void
+check_index (guint pack)
+{
+  const GstStructure *s;
+  const GValue *scrs, *offsets;
+  GstQuery *query;
+  guint64 prev_scr = 0, prev_index = 0;
+  guint i, n;
+
+  query = gst_query_new_custom (GST_QUERY_CUSTOM,
+      gst_structure_new_empty ("GstPsDemuxIndex"));
+  fail_unless (gst_pad_peer_query (mysinkpad, query));
+
+  s = gst_query_get_structure (query);
+  scrs = gst_structure_get_value (s, "scr");
+  offsets = gst_structure_get_value (s, "offset");
+  fail_unless (scrs != NULL && offsets != NULL);
+  n = gst_value_array_get_size (scrs);
+  fail_unless_equals_int (gst_value_array_get_size (offsets), n);
+  fail_unless (n > 0);
+
+  for (i = 0; i < n; i++) {
+    guint64 scr = g_value_get_uint64 (gst_value_array_get_value (scrs, i));
+    guint64 offset =
+        g_value_get_uint64 (gst_value_array_get_value (offsets, i));
+    guint64 index;
+
+    fail_unless_equals_int ((scr - FIRST_SCR) % SCR_STEP, 0);
+    index = (scr - FIRST_SCR) / SCR_STEP;
+    fail_unless (index < N_PACKS);
+    fail_unless_equals_uint64 (offset, pack_offset (index));
+
+    if (i > 0) {
+      fail_unless (scr >= prev_scr + 45000);
+      if (prev_index >= pack)
+        fail_unless (scr <= prev_scr + 90000);
+    }
+    prev_scr = scr;
+    prev_index = index;
+  }
+  fail_unless_equals_uint64 (prev_index, N_PACKS - 1);
+
+  gst_query_unref (query);
+}
+
+GST_START_TEST (test_seek_index)
+{
+  GstStateChangeReturn sret;
+  GstElement *demux;
+  GstPad *sinkpad;
+  guint scan_pulls, index_pulls;
+
+  create_ps_stream ();
+  block_data = TRUE;
+  blocked = flushing = have_eos = FALSE;
+  first_pts = GST_CLOCK_TIME_NONE;
+
+  demux = gst_element_factory_make ("mpegpsdemux", NULL);
+  fail_unless (demux != NULL);
+  g_signal_connect (demux, "pad-added", G_CALLBACK (_pad_added), NULL);
+  sinkpad = gst_element_get_static_pad (demux, "sink");
+  fail_unless (sinkpad != NULL);
+
+  mysinkpad = gst_pad_new_from_static_template (&mysinktemplate, "sink");
+  gst_pad_set_chain_function (mysinkpad, _sink_chain);
+  gst_pad_set_event_function (mysinkpad, _sink_event);
+  mysrcpad = gst_pad_new_from_static_template (&mysrctemplate, "src");
+  gst_pad_set_getrange_function (mysrcpad, _src_getrange);
+  gst_pad_set_query_function (mysrcpad, _src_query);
+
+  fail_unless (gst_pad_link (mysrcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_pad_set_active (mysinkpad, TRUE);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  sret = gst_element_set_state (demux, GST_STATE_PLAYING);
+  fail_unless_equals_int (sret, GST_STATE_CHANGE_SUCCESS);
+  wait_for (&blocked);
+
+  /* Only the first and the last pack are known, the seek has to search the
+   * whole file */
+  scan_pulls = seek_and_check (SEEK_POSITION, SEEK_PACK);
+  wait_for (&have_eos);
+  check_index (SEEK_PACK);
+
+  /* The same seek now starts between two indexed packs */
+  index_pulls = seek_and_check (SEEK_POSITION, SEEK_PACK);
+  GST_INFO ("%u pulls without the index, %u with it", scan_pulls,
+      index_pulls);
+  fail_unless (index_pulls < scan_pulls);
+  wait_for (&have_eos);
+
+  gst_element_set_state (demux, GST_STATE_NULL);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_pad_set_active (mysrcpad, FALSE);
+
+  gst_object_unref (demux);
+  gst_object_unref (mysinkpad);
+  gst_object_unref (mysrcpad);
+  g_free (ps_data);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpegpsdemux_suite (void)
+{
+  Suite *s = suite_create ("mpegpsdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_seek_index);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpegpsdemux);
@@ -21,13 +21,21 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
+#ifdef G_OS_WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 #include "mxfdemux.h"
 
 static GstPad *mysrcpad, *mysinkpad;
 static GMainLoop *loop = NULL;
 static gboolean have_eos = FALSE;
 static gboolean have_data = FALSE;
+static gchar *src_uri = NULL;
+static guint n_pulls = 0;
 
 static GstStaticPadTemplate mysrctemplate =
 GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
@@ -134,6 +142,8 @@ static GstFlowReturn
 _src_getrange (GstPad * pad, GstObject * parent, guint64 offset, guint length,
     GstBuffer ** buffer)
 {
+  n_pulls++;
+
   if (offset + length > sizeof (mxf_file))
     return GST_FLOW_EOS;
 
@@ -166,6 +176,12 @@ _src_query (GstPad * pad, GstObject * parent, GstQuery * query)
       res = TRUE;
       break;
     }
+    case GST_QUERY_URI:
+      if (src_uri) {
+        gst_query_set_uri (query, src_uri);
+        res = TRUE;
+      }
+      break;
     default:
       GST_DEBUG_OBJECT (pad, "unhandled %s query", GST_QUERY_TYPE_NAME (query));
       break;
@@ -184,7 +200,8 @@ _create_src_pad_pull (void)
   return mysrcpad;
 }
 
-GST_START_TEST (test_pull)
+static void
+run_pull (const gchar * index_cache_dir)
 {
   GstStateChangeReturn sret;
   GstElement *mxfdemux;
@@ -192,10 +209,16 @@ GST_START_TEST (test_pull)
 
   have_eos = FALSE;
   have_data = FALSE;
+  n_pulls = 0;
   loop = g_main_loop_new (NULL, FALSE);
 
   mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
   fail_unless (mxfdemux != NULL);
+  g_object_set (mxfdemux, "index-cache-dir", index_cache_dir, NULL);
+  /* with the read-ahead window, walking the partitions of this small file
+   * would not need any additional pull */
+  if (index_cache_dir)
+    g_object_set (mxfdemux, "read-ahead", 0, NULL);
   g_signal_connect (mxfdemux, "pad-added", G_CALLBACK (_pad_added), NULL);
   sinkpad = gst_element_get_static_pad (mxfdemux, "sink");
   fail_unless (sinkpad != NULL);
@@ -230,6 +253,85 @@ GST_START_TEST (test_pull)
   loop = NULL;
 }
 
+GST_START_TEST (test_pull)
+{
+  run_pull (NULL);
+}
+
+GST_END_TEST;
+
+static guint
+count_files (const gchar * dir)
+{
+  GDir *d;
+  guint n = 0;
+
+  d = g_dir_open (dir, 0, NULL);
+  fail_unless (d != NULL);
+  while (g_dir_read_name (d))
+    n++;
+  g_dir_close (d);
+
+  return n;
+}
+
+GST_START_TEST (test_pull_index_cache)
+{
+  struct utimbuf times = { 1000000000, 1000000000 };
+  const gchar *name;
+  gchar *dir, *cache_dir, *filename;
+  guint walk_pulls;
+  GDir *d;
+
+  dir = g_dir_make_tmp ("mxfdemux-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  cache_dir = g_build_filename (dir, "cache", NULL);
+  fail_unless (g_mkdir (cache_dir, 0700) == 0);
+
+  /* Only local files are cached, the source reports the URI of a copy of
+   * the test file */
+  filename = g_build_filename (dir, "test.mxf", NULL);
+  fail_unless (g_file_set_contents (filename, (const gchar *) mxf_file,
+          sizeof (mxf_file), NULL));
+  src_uri = g_filename_to_uri (filename, NULL, NULL);
+
+  /* The first run walks the partitions and stores them */
+  run_pull (cache_dir);
+  walk_pulls = n_pulls;
+  fail_unless_equals_int (count_files (cache_dir), 1);
+
+  /* The second one restores them from the cache and doesn't pull them */
+  run_pull (cache_dir);
+  GST_INFO ("%u pulls with the walk, %u with the cache", walk_pulls, n_pulls);
+  fail_unless (n_pulls < walk_pulls);
+  fail_unless_equals_int (count_files (cache_dir), 1);
+
+  /* A file modified since then misses the cache */
+  fail_unless (g_utime (filename, &times) == 0);
+  run_pull (cache_dir);
+  fail_unless_equals_int (n_pulls, walk_pulls);
+  fail_unless_equals_int (count_files (cache_dir), 2);
+
+  d = g_dir_open (cache_dir, 0, NULL);
+  fail_unless (d != NULL);
+  while ((name = g_dir_read_name (d))) {
+    gchar *path = g_build_filename (cache_dir, name, NULL);
+
+    g_unlink (path);
+    g_free (path);
+  }
+  g_dir_close (d);
+  g_unlink (filename);
+  g_rmdir (cache_dir);
+  g_rmdir (dir);
+
+  g_free (src_uri);
+  src_uri = NULL;
+  g_free (filename);
+  g_free (cache_dir);
+  g_free (dir);
+}
+
 GST_END_TEST;
 
 GST_START_TEST (test_push)
@@ -301,6 +403,7 @@ mxfdemux_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_set_timeout (tc_chain, 180);
   tcase_add_test (tc_chain, test_pull);
+  tcase_add_test (tc_chain, test_pull_index_cache);
   tcase_add_test (tc_chain, test_push);
 
   return s;
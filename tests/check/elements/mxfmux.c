@@ -21,6 +21,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
 static const gchar *
@@ -142,6 +143,299 @@ GST_START_TEST (test_raw_video_raw_audio)
 
 GST_END_TEST;
 
+static const guint8 partition_pack_prefix[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01
+};
+
+static const guint8 random_index_pack_key[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01, 0x11, 0x01, 0x00
+};
+
+static const guint8 index_table_segment_key[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x53, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01, 0x10, 0x01, 0x00
+};
+
+static const guint8 fill_key[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x01, 0x01, 0x01, 0x01,
+  0x03, 0x01, 0x02, 0x10, 0x01, 0x00, 0x00, 0x00
+};
+
+static const guint8 essence_element_prefix[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x01, 0x02, 0x01, 0x01,
+  0x0d, 0x01, 0x03, 0x01
+};
+
+/* Parses the KLV at @offset and returns the offset of its value */
+static gsize
+read_klv (const guint8 * data, gsize size, gsize offset, const guint8 ** key,
+    gsize * length)
+{
+  guint8 ber;
+
+  fail_unless (offset + 17 <= size);
+  *key = data + offset;
+  offset += 16;
+  ber = data[offset++];
+  if (ber & 0x80) {
+    guint i, n = ber & 0x7f;
+
+    fail_unless (n <= 8 && offset + n <= size);
+    *length = 0;
+    for (i = 0; i < n; i++)
+      *length = (*length << 8) | data[offset++];
+  } else {
+    *length = ber;
+  }
+  fail_unless (offset + *length <= size);
+
+  return offset;
+}
+
+/* Stores the temporal offsets of the entries of the index table segment in
+ * @temporal_offsets, indexed by position */
+static void
+parse_index_table_segment (const guint8 * data, gsize length,
+    gint * temporal_offsets, guint n_positions)
+{
+  guint64 start = 0;
+  gsize offset = 0;
+
+  while (offset + 4 <= length) {
+    guint16 tag = GST_READ_UINT16_BE (data + offset);
+    guint16 tag_length = GST_READ_UINT16_BE (data + offset + 2);
+    const guint8 *value = data + offset + 4;
+
+    fail_unless (offset + 4 + tag_length <= length);
+
+    if (tag == 0x3f0c) {
+      start = GST_READ_UINT64_BE (value);
+    } else if (tag == 0x3f0a) {
+      guint32 n = GST_READ_UINT32_BE (value);
+      guint32 entry_size = GST_READ_UINT32_BE (value + 4);
+      guint i;
+
+      /* the index start position comes first */
+      fail_unless (8 + n * entry_size <= tag_length);
+      for (i = 0; i < n; i++) {
+        fail_unless (start + i < n_positions);
+        temporal_offsets[start + i] = (gint8) value[8 + i * entry_size];
+      }
+    }
+
+    offset += 4 + tag_length;
+  }
+}
+
+/* Parses the index table segments following the partition pack at @offset,
+ * up to the first essence element or partition, and returns their number */
+static guint
+parse_partition_index (const guint8 * data, gsize size, gsize offset,
+    gint * temporal_offsets, guint n_positions)
+{
+  const guint8 *key;
+  gsize length;
+  guint n_segments = 0;
+
+  offset = read_klv (data, size, offset, &key, &length) + length;
+  while (offset < size) {
+    gsize value = read_klv (data, size, offset, &key, &length);
+
+    if (memcmp (key, partition_pack_prefix,
+            sizeof (partition_pack_prefix)) == 0
+        || memcmp (key, essence_element_prefix,
+            sizeof (essence_element_prefix)) == 0)
+      break;
+
+    if (memcmp (key, index_table_segment_key, 16) == 0) {
+      parse_index_table_segment (data + value, length, temporal_offsets,
+          n_positions);
+      n_segments++;
+    }
+
+    offset = value + length;
+  }
+
+  return n_segments;
+}
+
+/* Muxes @video into a file with a body partition every 2 seconds, and checks
+ * that each of them carries the index of the essence before it, with the
+ * same temporal offsets as the complete index in the footer */
+static void
+check_partitions (const gchar * video, guint n_frames)
+{
+  gint *body_offsets, *footer_offsets;
+  const guint8 *data, *key;
+  gchar *pipeline, *filename, *contents;
+  gsize size, length, offset, value;
+  guint i, n_entries, n_body_partitions = 0;
+  gint fd;
+
+  fd = g_file_open_tmp ("mxfmux-XXXXXX.mxf", &filename, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+
+  pipeline = g_strdup_printf ("%s ! mxfmux name=mux "
+      "partition-interval=2000000000 header-padding=4096 "
+      "write-batch-size=1048576 ! filesink location=\"%s\" "
+      "audiotestsrc num-buffers=250 ! audioconvert ! "
+      "audio/x-raw,rate=48000,channels=2 ! mux.", video, filename);
+  run_test (pipeline);
+  g_free (pipeline);
+
+  fail_unless (g_file_get_contents (filename, &contents, &size, NULL));
+  data = (const guint8 *) contents;
+
+  /* The random index pack ends with its own length */
+  fail_unless (size > 4);
+  offset = size - GST_READ_UINT32_BE (data + size - 4);
+  value = read_klv (data, size, offset, &key, &length);
+  fail_unless (memcmp (key, random_index_pack_key, 16) == 0);
+  fail_unless_equals_int ((length - 4) % 12, 0);
+  n_entries = (length - 4) / 12;
+  fail_unless (n_entries >= 3);
+
+  body_offsets = g_new (gint, n_frames);
+  footer_offsets = g_new (gint, n_frames);
+  for (i = 0; i < n_frames; i++)
+    body_offsets[i] = footer_offsets[i] = G_MININT;
+
+  for (i = 0; i < n_entries; i++) {
+    guint64 partition = GST_READ_UINT64_BE (data + value + i * 12 + 4);
+    const guint8 *pack;
+    guint n_segments;
+
+    fail_unless (partition < size);
+    pack = data + read_klv (data, size, partition, &key, &length);
+    fail_unless (memcmp (key, partition_pack_prefix,
+            sizeof (partition_pack_prefix)) == 0);
+    /* ThisPartition */
+    fail_unless_equals_uint64 (GST_READ_UINT64_BE (pack + 8), partition);
+
+    if (i == 0) {
+      fail_unless_equals_int (key[13], 0x02);
+    } else if (i == n_entries - 1) {
+      fail_unless_equals_int (key[13], 0x04);
+      fail_unless (parse_partition_index (data, size, partition,
+              footer_offsets, n_frames) > 0);
+    } else {
+      fail_unless_equals_int (key[13], 0x03);
+      n_body_partitions++;
+      n_segments = parse_partition_index (data, size, partition,
+          body_offsets, n_frames);
+
+      /* All but the first body partition, that starts before any essence,
+       * carry index table segments, and their IndexByteCount and IndexSID */
+      if (i > 1) {
+        fail_unless (n_segments > 0, "body partition %u has no index", i);
+        fail_unless (GST_READ_UINT64_BE (pack + 40) > 0);
+        fail_unless (GST_READ_UINT32_BE (pack + 48) != 0);
+      } else {
+        fail_unless_equals_int (n_segments, 0);
+      }
+    }
+  }
+
+  /* 10 seconds with a partition every 2 seconds */
+  GST_INFO ("%u body partitions", n_body_partitions);
+  fail_unless (n_body_partitions >= 4);
+
+  /* The body partitions carry the final temporal offsets */
+  for (i = 0; i < n_frames; i++) {
+    fail_unless (footer_offsets[i] != G_MININT, "edit unit %u not indexed", i);
+    if (body_offsets[i] != G_MININT)
+      fail_unless_equals_int (body_offsets[i], footer_offsets[i]);
+  }
+
+  g_free (body_offsets);
+  g_free (footer_offsets);
+  g_free (contents);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_START_TEST (test_raw_video_raw_audio_partitions)
+{
+  check_partitions ("videotestsrc num-buffers=250 ! "
+      "video/x-raw,format=(string)v308,width=160,height=120,framerate=25/1",
+      250);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_mpeg2_partitions)
+{
+  const gchar *mpeg2enc_name = get_mpeg2enc_element_name ();
+  gchar *video;
+
+  if (!mpeg2enc_name)
+    return;
+
+  /* Open GOPs, the B-frames after each keyframe are displayed before it */
+  video = g_strdup_printf ("videotestsrc num-buffers=250 ! "
+      "video/x-raw,framerate=25/1 ! %s", mpeg2enc_name);
+  check_partitions (video, 250);
+  g_free (video);
+}
+
+GST_END_TEST;
+
+/* With the default header-padding, the header partition is rewritten closed
+ * and complete, and its header metadata ends with a fill */
+GST_START_TEST (test_default_header_padding)
+{
+  const guint8 *data, *key, *pack, *last_key = NULL;
+  gchar *pipeline, *filename, *contents;
+  gsize size, length, offset, end;
+  gint fd;
+
+  fd = g_file_open_tmp ("mxfmux-XXXXXX.mxf", &filename, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+
+  pipeline = g_strdup_printf ("videotestsrc num-buffers=25 ! "
+      "video/x-raw,format=(string)v308,width=160,height=120,framerate=25/1 ! "
+      "mxfmux name=mux ! filesink location=\"%s\" "
+      "audiotestsrc num-buffers=25 ! audioconvert ! "
+      "audio/x-raw,rate=48000,channels=2 ! mux.", filename);
+  run_test (pipeline);
+  g_free (pipeline);
+
+  fail_unless (g_file_get_contents (filename, &contents, &size, NULL));
+  data = (const guint8 *) contents;
+
+  offset = read_klv (data, size, 0, &key, &length);
+  fail_unless (memcmp (key, partition_pack_prefix,
+          sizeof (partition_pack_prefix)) == 0);
+  fail_unless_equals_int (key[13], 0x02);
+  fail_unless_equals_int (key[14], 0x04);
+  pack = data + offset;
+
+  /* FooterPartition and HeaderByteCount */
+  fail_unless (GST_READ_UINT64_BE (pack + 24) > 0);
+  end = offset + length + GST_READ_UINT64_BE (pack + 32);
+  fail_unless (end <= size);
+
+  offset += length;
+  while (offset < end) {
+    offset = read_klv (data, size, offset, &last_key, &length) + length;
+    fail_unless (offset <= end);
+  }
+  fail_unless (last_key != NULL);
+  /* the registry version byte of the fill key varies */
+  fail_unless (memcmp (last_key, fill_key, 7) == 0);
+  fail_unless (memcmp (last_key + 8, fill_key + 8, 8) == 0);
+
+  g_free (contents);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_raw_video_stride_transform)
 {
   gchar *pipeline;
@@ -276,6 +570,9 @@ mxfmux_suite (void)
 
   tcase_add_test (tc_chain, test_mpeg2);
   tcase_add_test (tc_chain, test_raw_video_raw_audio);
+  tcase_add_test (tc_chain, test_raw_video_raw_audio_partitions);
+  tcase_add_test (tc_chain, test_mpeg2_partitions);
+  tcase_add_test (tc_chain, test_default_header_padding);
   tcase_add_test (tc_chain, test_raw_video_stride_transform);
   tcase_add_test (tc_chain, test_jpeg2000_alaw);
   tcase_add_test (tc_chain, test_dnxhd_mp3);
@@ -1,6 +1,7 @@
 #include "parser.h"
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
+#include <glib/gstdio.h>
 
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -114,6 +115,111 @@ GST_START_TEST (test_parse_zerosize_frames)
 
 GST_END_TEST;
 
+static void
+handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GList ** buffers)
+{
+  *buffers = g_list_append (*buffers, gst_buffer_ref (buffer));
+}
+
+static GstPadProbeReturn
+event_probe_cb (GstPad * pad, GstPadProbeInfo * info, GList ** events)
+{
+  *events = g_list_append (*events,
+      gst_event_ref (GST_PAD_PROBE_INFO_EVENT (info)));
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_parse_pull_mode)
+{
+  GstElement *pipeline, *sink;
+  GstMessage *msg;
+  GstPad *sinkpad;
+  GstCaps *caps, *expected_caps;
+  GList *buffers = NULL, *events = NULL, *l;
+  guint group_id;
+  GByteArray *data;
+  GError *error = NULL;
+  gchar *filename, *desc;
+  guint offset, size;
+  gint fd, i;
+
+  data = g_byte_array_new ();
+  g_byte_array_append (data, pcap_header, sizeof (pcap_header));
+  for (i = 0; i < 3; i++)
+    g_byte_array_append (data, pcap_frame_with_eth_padding,
+        sizeof (pcap_frame_with_eth_padding));
+
+  fd = g_file_open_tmp ("pcapparse-XXXXXX.pcap", &filename, &error);
+  fail_unless (fd >= 0, "%s", error ? error->message : "");
+  g_close (fd, NULL);
+  fail_unless (g_file_set_contents (filename, (const gchar *) data->data,
+          data->len, &error), "%s", error ? error->message : "");
+  g_byte_array_unref (data);
+
+  desc = g_strdup_printf ("filesrc location=%s ! pcapparse "
+      "caps=application/x-rtp ! fakesink name=sink signal-handoffs=true "
+      "sync=false", filename);
+  pipeline = gst_parse_launch (desc, &error);
+  fail_unless (pipeline != NULL, "%s", error ? error->message : "");
+  g_free (desc);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), &buffers);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) event_probe_cb, &events, NULL);
+  gst_object_unref (sinkpad);
+  gst_object_unref (sink);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  /* every packet is a sub-buffer with the payload only */
+  offset = pcap_frame_with_eth_padding_offset;
+  size = sizeof (pcap_frame_with_eth_padding) - offset - 2;
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  for (l = buffers; l; l = l->next) {
+    GstBuffer *buffer = l->data;
+
+    fail_unless_equals_int (gst_buffer_get_size (buffer), size);
+    fail_unless (gst_buffer_memcmp (buffer, 0,
+            pcap_frame_with_eth_padding + offset, size) == 0);
+    fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (buffer,
+            GST_BUFFER_FLAG_DISCONT), l == buffers);
+  }
+
+  /* the stream is started before the caps and the segment */
+  fail_unless_equals_int (g_list_length (events), 4);
+  fail_unless_equals_int (GST_EVENT_TYPE (events->data),
+      GST_EVENT_STREAM_START);
+  fail_unless (gst_event_parse_group_id (events->data, &group_id));
+  fail_unless_equals_int (GST_EVENT_TYPE (events->next->data),
+      GST_EVENT_CAPS);
+  gst_event_parse_caps (events->next->data, &caps);
+  expected_caps = gst_caps_new_empty_simple ("application/x-rtp");
+  fail_unless (gst_caps_is_equal (caps, expected_caps));
+  gst_caps_unref (expected_caps);
+  fail_unless_equals_int (GST_EVENT_TYPE (events->next->next->data),
+      GST_EVENT_SEGMENT);
+  fail_unless_equals_int (GST_EVENT_TYPE (events->next->next->next->data),
+      GST_EVENT_EOS);
+
+  g_list_free_full (events, (GDestroyNotify) gst_event_unref);
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
 static Suite *
 pcapparse_suite (void)
 {
@@ -132,6 +238,7 @@ pcapparse_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_parse_frames_with_eth_padding);
   tcase_add_test (tc_chain, test_parse_zerosize_frames);
+  tcase_add_test (tc_chain, test_parse_pull_mode);
 
   return s;
 }
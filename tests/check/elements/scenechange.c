@@ -0,0 +1,160 @@
+/* GStreamer
+ *
+ * unit test for scenechange
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#define WIDTH 160
+#define HEIGHT 120
+#define CAPS_STR "video/x-raw, format=I420, width=160, height=120, " \
+    "framerate=30/1"
+
+/* frames before the cut, enough to fill the history of scores */
+#define N_FRAMES_BEFORE_CUT 10
+#define N_FRAMES (N_FRAMES_BEFORE_CUT + 3)
+
+static const guint downsample[] = { 1, 4 };
+
+/* Slowly changing frames, then a hard cut to a much brighter scene */
+static GstBuffer *
+create_frame (GstHarness * h, guint index)
+{
+  GstVideoInfo info;
+  GstVideoFrame frame;
+  GstBuffer *buffer;
+  guint c;
+  gint x, y;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, WIDTH, HEIGHT);
+  buffer = gst_harness_create_buffer (h, GST_VIDEO_INFO_SIZE (&info));
+  fail_unless (gst_video_frame_map (&frame, &info, buffer, GST_MAP_WRITE));
+
+  for (c = 0; c < 3; c++) {
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, c); y++) {
+      guint8 *line = GST_VIDEO_FRAME_COMP_DATA (&frame, c) +
+          y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, c);
+
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, c); x++) {
+        if (c > 0)
+          line[x] = 128;
+        else if (index < N_FRAMES_BEFORE_CUT)
+          line[x] = 64 + ((x * 7 + y * 3 + index * 2) % 32);
+        else
+          line[x] = 224 - ((x + y + index) % 16);
+      }
+    }
+  }
+  gst_video_frame_unmap (&frame);
+
+  GST_BUFFER_PTS (buffer) = index * GST_SECOND / 30;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 30;
+
+  return buffer;
+}
+
+GST_START_TEST (test_scene_change_meta)
+{
+  GstHarness *h;
+  GstEvent *event;
+  guint i, n_key_units = 0;
+
+  h = gst_harness_new ("scenechange");
+  g_object_set (h->element, "score-meta", TRUE, "downsample",
+      downsample[__i__], NULL);
+  gst_harness_set_src_caps_str (h, CAPS_STR);
+
+  for (i = 0; i < N_FRAMES; i++) {
+    GstVideoRegionOfInterestMeta *meta;
+    GstBuffer *buffer;
+    GstStructure *s;
+    gboolean change;
+    gdouble score;
+
+    buffer = gst_harness_push_and_pull (h, create_frame (h, i));
+    fail_unless (buffer != NULL);
+
+    /* every frame but the first one gets its score, the cut is flagged as
+     * a scene change */
+    meta = gst_buffer_get_video_region_of_interest_meta_id (buffer, 0);
+    if (i == 0) {
+      fail_unless (meta == NULL);
+      gst_buffer_unref (buffer);
+      continue;
+    }
+    fail_unless (meta != NULL);
+    fail_unless_equals_string (g_quark_to_string (meta->roi_type),
+        "scene-change");
+    fail_unless_equals_int (meta->w, WIDTH);
+    fail_unless_equals_int (meta->h, HEIGHT);
+
+    s = gst_video_region_of_interest_meta_get_param (meta, "GstSceneChange");
+    fail_unless (s != NULL);
+    fail_unless (gst_structure_get_double (s, "score", &score));
+    fail_unless (gst_structure_get_boolean (s, "scene-change", &change));
+    GST_DEBUG ("frame %u: score %f, change %d", i, score, change);
+
+    if (i == N_FRAMES_BEFORE_CUT) {
+      fail_unless (change, "no scene change on the cut (score %f)", score);
+    } else {
+      fail_if (change, "unexpected scene change on frame %u (score %f)", i,
+          score);
+    }
+
+    gst_buffer_unref (buffer);
+  }
+
+  /* and a key unit is requested downstream for it */
+  while ((event = gst_harness_try_pull_event (h))) {
+    if (gst_video_event_is_force_key_unit (event)) {
+      GstClockTime timestamp;
+
+      fail_unless (gst_video_event_parse_downstream_force_key_unit (event,
+              &timestamp, NULL, NULL, NULL, NULL));
+      fail_unless_equals_uint64 (timestamp,
+          N_FRAMES_BEFORE_CUT * GST_SECOND / 30);
+      n_key_units++;
+    }
+    gst_event_unref (event);
+  }
+  fail_unless_equals_int (n_key_units, 1);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+scenechange_suite (void)
+{
+  Suite *s = suite_create ("scenechange");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_loop_test (tc_chain, test_scene_change_meta, 0,
+      G_N_ELEMENTS (downsample));
+
+  return s;
+}
+
+GST_CHECK_MAIN (scenechange);
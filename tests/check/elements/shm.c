@@ -169,6 +169,63 @@ GST_START_TEST (test_shm_alloc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_shm_send_meta)
+{
+  GstBuffer *buf;
+  GstCaps *caps = gst_caps_new_simple ("application/x-test",
+      "foo", G_TYPE_INT, 1, NULL);
+  GstCaps *ref_caps = gst_caps_new_empty_simple ("timestamp/x-test");
+  GstCaps *received_caps;
+  GstReferenceTimestampMeta *meta;
+  GstSegment segment;
+
+  g_object_set (sink, "send-meta", TRUE, "sync", FALSE, NULL);
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (srcpad, gst_event_new_caps (caps));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  buf = gst_buffer_new_allocate (NULL, 1000, NULL);
+  GST_BUFFER_PTS (buf) = 10 * GST_SECOND;
+  GST_BUFFER_DTS (buf) = 9 * GST_SECOND;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+  GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  gst_buffer_add_reference_timestamp_meta (buf, ref_caps, 42, 1);
+
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+  g_mutex_lock (&check_mutex);
+  while (buffers == NULL)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+  fail_unless (g_list_length (buffers) == 1);
+
+  buf = buffers->data;
+  fail_unless_equals_int (gst_buffer_get_size (buf), 1000);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), 10 * GST_SECOND);
+  fail_unless_equals_uint64 (GST_BUFFER_DTS (buf), 9 * GST_SECOND);
+  fail_unless_equals_uint64 (GST_BUFFER_DURATION (buf), GST_SECOND);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+
+  meta = gst_buffer_get_reference_timestamp_meta (buf, ref_caps);
+  fail_unless (meta != NULL);
+  fail_unless_equals_uint64 (meta->timestamp, 42);
+  fail_unless_equals_uint64 (meta->duration, 1);
+
+  received_caps = gst_pad_get_current_caps (sinkpad);
+  fail_unless (received_caps != NULL);
+  fail_unless (gst_caps_is_equal (received_caps, caps));
+  gst_caps_unref (received_caps);
+
+  gst_caps_unref (caps);
+  gst_caps_unref (ref_caps);
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_shm_live)
 {
   GstElement *producer, *consumer;
@@ -239,6 +296,7 @@ shm_suite (void)
   tcase_add_checked_fixture (tc, setup_shm, NULL);
   tcase_add_test (tc, test_shm_sysmem_alloc);
   tcase_add_test (tc, test_shm_alloc);
+  tcase_add_test (tc, test_shm_send_meta);
   suite_add_tcase (s, tc);
 
   tc = tcase_create ("shm2");
@@ -0,0 +1,136 @@
+/* GStreamer
+ *
+ * unit test for srtsrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define PORT 39031
+#define MESSAGE_SIZE 188
+#define N_MESSAGES 40
+#define MAX_MESSAGES 4
+
+/* srtsrc listens, srtsink connects to it and sends N_MESSAGES messages of
+ * MESSAGE_SIZE bytes, message n being filled with the byte n */
+static void
+start_srt (gboolean coalesce, GstHarness ** src, GstHarness ** sink)
+{
+  gchar *desc;
+  guint i;
+
+  desc = g_strdup_printf ("srtsrc uri=srt://:%d?mode=listener "
+      "max-messages=%d coalesce=%d", PORT, MAX_MESSAGES, coalesce);
+  *src = gst_harness_new_parse (desc);
+  g_free (desc);
+  gst_harness_play (*src);
+
+  desc = g_strdup_printf ("srtsink uri=srt://127.0.0.1:%d?mode=caller "
+      "sync=false", PORT);
+  *sink = gst_harness_new_parse (desc);
+  g_free (desc);
+  gst_harness_set_src_caps_str (*sink, "application/x-test");
+
+  for (i = 0; i < N_MESSAGES; i++) {
+    GstBuffer *buffer = gst_harness_create_buffer (*sink, MESSAGE_SIZE);
+
+    gst_buffer_memset (buffer, 0, i, MESSAGE_SIZE);
+    fail_unless_equals_int (gst_harness_push (*sink, buffer), GST_FLOW_OK);
+  }
+}
+
+GST_START_TEST (test_messages)
+{
+  GstHarness *src, *sink;
+  guint i;
+
+  start_srt (FALSE, &src, &sink);
+
+  /* however the messages were batched, each one is its own buffer */
+  for (i = 0; i < N_MESSAGES; i++) {
+    GstBuffer *buffer = gst_harness_pull (src);
+    guint8 data[MESSAGE_SIZE];
+
+    fail_unless (buffer != NULL);
+    fail_unless_equals_int (gst_buffer_get_size (buffer), MESSAGE_SIZE);
+    gst_buffer_extract (buffer, 0, data, MESSAGE_SIZE);
+    fail_unless_equals_int (data[0], i);
+    fail_unless_equals_int (data[MESSAGE_SIZE - 1], i);
+    gst_buffer_unref (buffer);
+  }
+
+  gst_harness_teardown (sink);
+  gst_harness_teardown (src);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_coalesce)
+{
+  GstHarness *src, *sink;
+  guint i = 0;
+
+  start_srt (TRUE, &src, &sink);
+
+  /* the messages of one wakeup are back to back in one buffer that is
+   * trimmed to what was received */
+  while (i < N_MESSAGES) {
+    GstBuffer *buffer = gst_harness_pull (src);
+    GstMapInfo map;
+    gsize offset;
+
+    fail_unless (buffer != NULL);
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    fail_unless (map.size > 0);
+    fail_unless (map.size <= MAX_MESSAGES * MESSAGE_SIZE);
+    fail_unless_equals_int (map.size % MESSAGE_SIZE, 0);
+
+    for (offset = 0; offset < map.size; offset += MESSAGE_SIZE, i++) {
+      fail_unless_equals_int (map.data[offset], i);
+      fail_unless_equals_int (map.data[offset + MESSAGE_SIZE - 1], i);
+    }
+
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+  }
+  fail_unless_equals_int (i, N_MESSAGES);
+
+  gst_harness_teardown (sink);
+  gst_harness_teardown (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+srtsrc_suite (void)
+{
+  Suite *s = suite_create ("srtsrc");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_messages);
+  tcase_add_test (tc_chain, test_coalesce);
+
+  return s;
+}
+
+GST_CHECK_MAIN (srtsrc);
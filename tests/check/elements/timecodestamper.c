@@ -0,0 +1,191 @@
+/* GStreamer
+ *
+ * unit test for timecodestamper
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
+#include <gst/video/video.h>
+#include <math.h>
+#include <string.h>
+
+#define RATE 48000
+#define FPS 25
+#define SAMPLES_PER_FRAME (RATE / FPS)
+/* 80 bits per LTC frame */
+#define SAMPLES_PER_BIT (SAMPLES_PER_FRAME / 80)
+#define CHANNELS 4
+#define LTC_CHANNEL 2
+#define N_FRAMES 25
+
+/* Sets the @n_bits bits of @value in the LTC frame @bits, LSB first */
+static void
+set_ltc_bits (guint8 * bits, guint offset, guint n_bits, guint value)
+{
+  guint i;
+
+  for (i = 0; i < n_bits; i++)
+    bits[offset + i] = (value >> i) & 1;
+}
+
+/* Writes the biphase mark coded LTC frame of @tc to @out, one sample every
+ * @stride, starting from @level, and returns the level it ends at */
+static gint16
+write_ltc_frame (const GstVideoTimeCode * tc, gint16 level, gint16 * out,
+    guint stride)
+{
+  guint8 bits[80] = { 0, };
+  guint i, j;
+
+  set_ltc_bits (bits, 0, 4, tc->frames % 10);
+  set_ltc_bits (bits, 8, 2, tc->frames / 10);
+  set_ltc_bits (bits, 16, 4, tc->seconds % 10);
+  set_ltc_bits (bits, 24, 3, tc->seconds / 10);
+  set_ltc_bits (bits, 32, 4, tc->minutes % 10);
+  set_ltc_bits (bits, 40, 3, tc->minutes / 10);
+  set_ltc_bits (bits, 48, 4, tc->hours % 10);
+  set_ltc_bits (bits, 56, 2, tc->hours / 10);
+  /* sync word */
+  set_ltc_bits (bits, 64, 16, 0xbffc);
+
+  /* Every bit starts with a transition, ones have another one halfway */
+  for (i = 0; i < 80; i++) {
+    level = -level;
+    for (j = 0; j < SAMPLES_PER_BIT; j++) {
+      if (bits[i] && j == SAMPLES_PER_BIT / 2)
+        level = -level;
+      out[(i * SAMPLES_PER_BIT + j) * stride] = level;
+    }
+  }
+
+  return level;
+}
+
+/* One frame worth of audio, with LTC on one channel, a tone on another one
+ * and silence on the others */
+static GstBuffer *
+create_audio_buffer (GstHarness * h, const GstVideoTimeCode * tc, guint index,
+    gint16 * level)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint16 *samples;
+  guint i;
+
+  buffer = gst_harness_create_buffer (h,
+      SAMPLES_PER_FRAME * CHANNELS * sizeof (gint16));
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+  samples = (gint16 *) map.data;
+  memset (samples, 0, map.size);
+
+  /* 440 Hz crosses zero too rarely to be LTC */
+  for (i = 0; i < SAMPLES_PER_FRAME; i++)
+    samples[i * CHANNELS + 1] = 8000 * sin (2 * G_PI * 440 *
+        (index * SAMPLES_PER_FRAME + i) / RATE);
+
+  *level = write_ltc_frame (tc, *level, samples + LTC_CHANNEL, CHANNELS);
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = gst_util_uint64_scale (index, GST_SECOND, FPS);
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / FPS;
+
+  return buffer;
+}
+
+GST_START_TEST (test_ltc_multichannel)
+{
+  GstHarness *h, *h_ltc;
+  GstVideoTimeCode *tc;
+  gint16 level = 16000;
+  guint i;
+
+  h = gst_harness_new_with_padnames ("timecodestamper", "sink", "src");
+  h_ltc = gst_harness_new_with_element (h->element, "ltc_sink", NULL);
+  gst_util_set_object_arg (G_OBJECT (h->element), "source", "ltc");
+  gst_util_set_object_arg (G_OBJECT (h->element), "set", "always");
+
+  /* non-live, the video waits for the LTC audio to be ahead or EOS */
+  gst_harness_set_live (h, FALSE);
+  gst_harness_set_live (h_ltc, FALSE);
+  gst_harness_set_src_caps_str (h, "video/x-raw, format=GRAY8, width=16, "
+      "height=16, framerate=25/1");
+  gst_harness_set_src_caps_str (h_ltc, "audio/x-raw, format="
+      GST_AUDIO_NE (S16) ", rate=48000, channels=4, layout=interleaved");
+
+  /* one LTC frame more than video frames, the last one is only complete
+   * once the next one starts */
+  tc = gst_video_time_code_new (FPS, 1, NULL, 0, 10, 59, 59, 20, 0);
+  for (i = 0; i <= N_FRAMES; i++) {
+    fail_unless_equals_int (gst_harness_push (h_ltc,
+            create_audio_buffer (h_ltc, tc, i, &level)), GST_FLOW_OK);
+    gst_video_time_code_increment_frame (tc);
+  }
+  fail_unless (gst_harness_push_event (h_ltc, gst_event_new_eos ()));
+  gst_video_time_code_free (tc);
+
+  tc = gst_video_time_code_new (FPS, 1, NULL, 0, 10, 59, 59, 20, 0);
+  for (i = 0; i < N_FRAMES; i++) {
+    GstBuffer *buffer;
+    GstVideoTimeCodeMeta *meta;
+
+    buffer = gst_harness_create_buffer (h, 16 * 16);
+    GST_BUFFER_PTS (buffer) = gst_util_uint64_scale (i, GST_SECOND, FPS);
+    GST_BUFFER_DURATION (buffer) = GST_SECOND / FPS;
+
+    buffer = gst_harness_push_and_pull (h, buffer);
+    fail_unless (buffer != NULL);
+    meta = gst_buffer_get_video_time_code_meta (buffer);
+    fail_unless (meta != NULL);
+
+    /* the decoder may need the first frame to lock onto the bit rate */
+    if (i > 0) {
+      fail_unless_equals_int (meta->tc.hours, tc->hours);
+      fail_unless_equals_int (meta->tc.minutes, tc->minutes);
+      fail_unless_equals_int (meta->tc.seconds, tc->seconds);
+      fail_unless_equals_int (meta->tc.frames, tc->frames);
+    }
+
+    gst_buffer_unref (buffer);
+    gst_video_time_code_increment_frame (tc);
+  }
+  gst_video_time_code_free (tc);
+
+  gst_harness_teardown (h_ltc);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+timecodestamper_suite (void)
+{
+  Suite *s = suite_create ("timecodestamper");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_ltc_multichannel);
+
+  return s;
+}
+
+GST_CHECK_MAIN (timecodestamper);
@@ -1588,6 +1588,335 @@ GST_START_TEST (test_session_stats)
 
 GST_END_TEST;
 
+static GstStructure *
+_get_stats_sync (GstElement * webrtc, const gchar * signal, gpointer target)
+{
+  GstPromise *p = gst_promise_new ();
+  GstStructure *s;
+
+  g_signal_emit_by_name (webrtc, signal, target, p);
+  fail_unless_equals_int (gst_promise_wait (p), GST_PROMISE_RESULT_REPLIED);
+  s = gst_structure_copy (gst_promise_get_reply (p));
+  gst_promise_unref (p);
+  validate_stats (s);
+
+  return s;
+}
+
+static gdouble
+_get_codec_stats_timestamp (const GstStructure * stats, const gchar * id)
+{
+  GstStructure *codec = NULL;
+  gdouble ts = 0.;
+
+  fail_unless (gst_structure_get (stats, id, GST_TYPE_STRUCTURE, &codec,
+          NULL));
+  fail_unless (gst_structure_get_double (codec, "timestamp", &ts));
+  gst_structure_free (codec);
+
+  return ts;
+}
+
+GST_START_TEST (test_transceiver_stats)
+{
+  struct test_webrtc *t = create_audio_test ();
+  GstWebRTCRTPTransceiver *trans;
+  GstHarness *h;
+  GstStructure *s;
+  gdouble ts0, ts1;
+  gint i;
+
+  g_signal_emit_by_name (t->webrtc1, "get-transceiver", 0, &trans);
+  fail_unless (trans != NULL);
+
+  /* the codec statistics carry the time their pad was collected at */
+  s = _get_stats_sync (t->webrtc1, "get-stats", NULL);
+  ts0 = _get_codec_stats_timestamp (s, "codec-stats-sink_0");
+  gst_structure_free (s);
+
+  /* nothing is negotiated yet, so nothing outdates the statistics and
+   * they are never collected again */
+  for (i = 0; i < 10; i++) {
+    s = _get_stats_sync (t->webrtc1, "get-transceiver-stats", trans);
+    fail_unless (gst_structure_has_field (s, "peer-connection-stats"));
+    fail_unless_equals_float (_get_codec_stats_timestamp (s,
+            "codec-stats-sink_0"), ts0);
+    gst_structure_free (s);
+  }
+
+  /* a new pad is collected on its own */
+  h = gst_harness_new_with_element (t->webrtc1, "sink_1", NULL);
+  add_fake_video_src_harness (h, 97);
+  t->harnesses = g_list_prepend (t->harnesses, h);
+
+  s = _get_stats_sync (t->webrtc1, "get-stats", NULL);
+  fail_unless_equals_float (_get_codec_stats_timestamp (s,
+          "codec-stats-sink_0"), ts0);
+  ts1 = _get_codec_stats_timestamp (s, "codec-stats-sink_1");
+  fail_unless (ts1 > ts0);
+  gst_structure_free (s);
+
+  /* get-transceiver-stats only reports the pads of the given transceiver */
+  s = _get_stats_sync (t->webrtc1, "get-transceiver-stats", trans);
+  fail_unless (gst_structure_has_field (s, "codec-stats-sink_0"));
+  fail_unless (!gst_structure_has_field (s, "codec-stats-sink_1"));
+  gst_structure_free (s);
+
+  /* a new session description outdates all of them */
+  test_validate_sdp (t, NULL, NULL);
+  s = _get_stats_sync (t->webrtc1, "get-stats", NULL);
+  fail_unless (_get_codec_stats_timestamp (s, "codec-stats-sink_0") > ts1);
+  fail_unless (_get_codec_stats_timestamp (s, "codec-stats-sink_1") > ts1);
+  gst_structure_free (s);
+
+  gst_object_unref (trans);
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
+#define N_FANOUT_PEERS 8
+
+static void
+_request_key_unit (GstElement * webrtc)
+{
+  GstPad *pad = gst_element_get_static_pad (webrtc, "sink_0");
+
+  fail_unless (pad != NULL);
+  gst_pad_push_event (pad, gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+          gst_structure_new ("GstForceKeyUnit", "all-headers",
+              G_TYPE_BOOLEAN, TRUE, NULL)));
+  gst_object_unref (pad);
+}
+
+static guint
+_count_key_unit_requests (GstHarness * h)
+{
+  GstEvent *event;
+  guint count = 0;
+
+  while ((event = gst_harness_try_pull_upstream_event (h))) {
+    if (gst_event_has_name (event, "GstForceKeyUnit"))
+      count++;
+    gst_event_unref (event);
+  }
+
+  return count;
+}
+
+static GstPad *
+_link_tee_to_webrtc (GstHarness * tee, GstElement * webrtc)
+{
+  GstPad *srcpad, *sinkpad;
+
+  srcpad = gst_element_request_pad_simple (tee->element, "src_%u");
+  sinkpad = gst_element_request_pad_simple (webrtc, "sink_0");
+  fail_unless_equals_int (gst_pad_link (srcpad, sinkpad), GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  return srcpad;
+}
+
+GST_START_TEST (test_fanout_key_unit_requests)
+{
+  struct test_webrtc *t[N_FANOUT_PEERS + 1];
+  GstPad *srcpad[N_FANOUT_PEERS + 1];
+  GstHarness *tee, *other_tee;
+  guint i;
+
+  /* the same payloaded stream is sent to many peers through a tee, and a
+   * separate stream with the same SSRC goes to one more peer */
+  tee = gst_harness_new_with_padnames ("tee", "sink", NULL);
+  other_tee = gst_harness_new_with_padnames ("tee", "sink", NULL);
+
+  for (i = 0; i <= N_FANOUT_PEERS; i++) {
+    t[i] = test_webrtc_new ();
+    t[i]->on_negotiation_needed = NULL;
+    t[i]->on_ice_candidate = NULL;
+    t[i]->on_pad_added = _pad_added_fakesink;
+
+    srcpad[i] = _link_tee_to_webrtc (i < N_FANOUT_PEERS ? tee : other_tee,
+        t[i]->webrtc1);
+  }
+
+  gst_harness_set_src_caps_str (tee, OPUS_RTP_CAPS (96));
+  gst_harness_set_src_caps_str (other_tee, OPUS_RTP_CAPS (96));
+
+  for (i = 0; i <= N_FANOUT_PEERS; i++)
+    test_validate_sdp (t[i], NULL, NULL);
+
+  /* every peer behind the tee asks for a key unit, only one request reaches
+   * the encoder */
+  for (i = 0; i < N_FANOUT_PEERS; i++)
+    _request_key_unit (t[i]->webrtc1);
+  fail_unless_equals_int (_count_key_unit_requests (tee), 1);
+
+  /* the other upstream is not affected by requests for the tee */
+  _request_key_unit (t[N_FANOUT_PEERS]->webrtc1);
+  fail_unless_equals_int (_count_key_unit_requests (other_tee), 1);
+
+  /* repeated requests from the peer that got through are not merged */
+  _request_key_unit (t[0]->webrtc1);
+  fail_unless_equals_int (_count_key_unit_requests (tee), 1);
+
+  for (i = 0; i <= N_FANOUT_PEERS; i++) {
+    test_webrtc_free (t[i]);
+    gst_element_release_request_pad (i < N_FANOUT_PEERS ? tee->element :
+        other_tee->element, srcpad[i]);
+    gst_object_unref (srcpad[i]);
+  }
+  gst_harness_teardown (tee);
+  gst_harness_teardown (other_tee);
+}
+
+GST_END_TEST;
+
+#define FANOUT_SSRC 3384078950u
+
+typedef struct
+{
+  gint caps_pt;
+  gint buffer_pt;
+  guint32 ssrc;
+  guint n_buffers;
+} FanoutPeerData;
+
+/* records what a peer's webrtcbin sends on after its sink pad and drops the
+ * buffers, the peers are not connected */
+static GstPadProbeReturn
+_fanout_peer_probe (GstPad * pad, GstPadProbeInfo * info, FanoutPeerData * data)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    guint8 header[12];
+
+    fail_unless_equals_int (gst_buffer_extract (buffer, 0, header, 12), 12);
+    data->buffer_pt = header[1] & 0x7f;
+    data->ssrc = GST_READ_UINT32_BE (header + 8);
+    data->n_buffers++;
+
+    return GST_PAD_PROBE_DROP;
+  } else {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      fail_unless (gst_structure_get_int (gst_caps_get_structure (caps, 0),
+              "payload", &data->caps_pt));
+    }
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstBuffer *
+_create_fanout_rtp_buffer (guint16 seqnum)
+{
+  guint8 packet[12 + 4] = { 0x80, 96, };
+
+  GST_WRITE_UINT16_BE (packet + 2, seqnum);
+  GST_WRITE_UINT32_BE (packet + 4, seqnum * 960);
+  GST_WRITE_UINT32_BE (packet + 8, FANOUT_SSRC);
+
+  return gst_buffer_new_memdup (packet, sizeof (packet));
+}
+
+GST_START_TEST (test_fanout_payload_type)
+{
+  struct test_webrtc *t[N_FANOUT_PEERS];
+  FanoutPeerData data[N_FANOUT_PEERS] = { {0,}, };
+  GstPad *srcpad[N_FANOUT_PEERS];
+  GstHarness *tee;
+  guint i;
+
+  /* one payloaded stream with payload type 96 is sent to several peers. The
+   * even ones accept 96, the odd ones offer their own payload type for the
+   * codec, which the stream is rewritten to */
+  tee = gst_harness_new_with_padnames ("tee", "sink", NULL);
+
+  for (i = 0; i < N_FANOUT_PEERS; i++) {
+    t[i] = test_webrtc_new ();
+    t[i]->on_negotiation_needed = NULL;
+    t[i]->on_ice_candidate = NULL;
+    t[i]->on_pad_added = _pad_added_fakesink;
+
+    srcpad[i] = _link_tee_to_webrtc (tee, t[i]->webrtc1);
+  }
+
+  /* the odd peers negotiate before the input caps are known, so the
+   * answer takes the offered payload type */
+  for (i = 1; i < N_FANOUT_PEERS; i += 2) {
+    GstWebRTCRTPTransceiver *trans;
+    GstCaps *caps;
+    GstPad *pad;
+
+    pad = gst_element_get_static_pad (t[i]->webrtc1, "sink_0");
+    g_object_get (pad, "transceiver", &trans, NULL);
+    caps = gst_caps_from_string ("application/x-rtp,media=audio,"
+        "encoding-name=OPUS,clock-rate=48000");
+    g_object_set (trans, "codec-preferences", caps, NULL);
+    gst_caps_unref (caps);
+    gst_object_unref (trans);
+    gst_object_unref (pad);
+
+    caps = gst_caps_from_string (OPUS_RTP_CAPS (100));
+    gst_caps_set_simple (caps, "payload", G_TYPE_INT, 100 + i, NULL);
+    g_signal_emit_by_name (t[i]->webrtc2, "add-transceiver",
+        GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY, caps, &trans);
+    gst_caps_unref (caps);
+    fail_unless (trans != NULL);
+    gst_object_unref (trans);
+
+    t[i]->offerror = 2;
+    test_validate_sdp (t[i], NULL, NULL);
+  }
+
+  gst_harness_set_src_caps_str (tee, OPUS_RTP_CAPS (96));
+
+  for (i = 0; i < N_FANOUT_PEERS; i += 2)
+    test_validate_sdp (t[i], NULL, NULL);
+
+  for (i = 0; i < N_FANOUT_PEERS; i++) {
+    GstPad *pad, *target;
+
+    pad = gst_element_get_static_pad (t[i]->webrtc1, "sink_0");
+    target = gst_ghost_pad_get_target (GST_GHOST_PAD (pad));
+    fail_unless (target != NULL);
+    gst_pad_add_probe (target, GST_PAD_PROBE_TYPE_BUFFER |
+        GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        (GstPadProbeCallback) _fanout_peer_probe, &data[i], NULL);
+    gst_object_unref (target);
+    gst_object_unref (pad);
+
+    fail_if (gst_element_set_state (t[i]->webrtc1,
+            GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  }
+
+  for (i = 0; i < 10; i++)
+    fail_unless_equals_int (gst_harness_push (tee,
+            _create_fanout_rtp_buffer (i)), GST_FLOW_OK);
+
+  for (i = 0; i < N_FANOUT_PEERS; i++) {
+    gint pt = i % 2 ? 100 + i : 96;
+
+    fail_unless_equals_int (data[i].n_buffers, 10);
+    fail_unless_equals_int (data[i].buffer_pt, pt);
+    fail_unless_equals_int (data[i].caps_pt, pt);
+    fail_unless_equals_int (data[i].ssrc, FANOUT_SSRC);
+  }
+
+  for (i = 0; i < N_FANOUT_PEERS; i++) {
+    test_webrtc_free (t[i]);
+    gst_element_release_request_pad (tee->element, srcpad[i]);
+    gst_object_unref (srcpad[i]);
+  }
+  gst_harness_teardown (tee);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_add_transceiver)
 {
   struct test_webrtc *t = test_webrtc_new ();
@@ -4250,6 +4579,9 @@ webrtcbin_suite (void)
   if (nicesrc && nicesink && dtlssrtpenc && dtlssrtpdec) {
     tcase_add_test (tc, test_sdp_no_media);
     tcase_add_test (tc, test_session_stats);
+    tcase_add_test (tc, test_transceiver_stats);
+    tcase_add_test (tc, test_fanout_key_unit_requests);
+    tcase_add_test (tc, test_fanout_payload_type);
     tcase_add_test (tc, test_audio);
     tcase_add_test (tc, test_ice_port_restriction);
     tcase_add_test (tc, test_audio_video);
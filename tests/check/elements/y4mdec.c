@@ -0,0 +1,291 @@
+/* GStreamer
+ *
+ * unit test for y4mdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+#include <glib/gstdio.h>
+
+/* the width is not a multiple of 4, so the packed Y4M layout differs from
+ * the default strides */
+#define WIDTH 10
+#define HEIGHT 4
+#define FRAME_SIZE (WIDTH * HEIGHT + 2 * (WIDTH / 2) * (HEIGHT / 2))
+#define N_FRAMES 10
+#define FRAME_TIME(n) gst_util_uint64_scale (n, GST_SECOND, 25)
+
+static guint8
+frame_sample (guint frame, guint i)
+{
+  return (frame * 23 + i * 7) & 0xff;
+}
+
+static gchar *
+create_y4m_file (void)
+{
+  GString *data;
+  GError *error = NULL;
+  gchar *filename;
+  guint frame, i;
+  gint fd;
+
+  data = g_string_new ("YUV4MPEG2 W10 H4 F25:1 Ip A1:1 C420\n");
+  for (frame = 0; frame < N_FRAMES; frame++) {
+    g_string_append (data, "FRAME\n");
+    for (i = 0; i < FRAME_SIZE; i++)
+      g_string_append_c (data, frame_sample (frame, i));
+  }
+
+  fd = g_file_open_tmp ("y4mdec-XXXXXX.y4m", &filename, &error);
+  fail_unless (fd >= 0, "%s", error ? error->message : "");
+  g_close (fd, NULL);
+  fail_unless (g_file_set_contents (filename, data->str, data->len, &error),
+      "%s", error ? error->message : "");
+  g_string_free (data, TRUE);
+
+  return filename;
+}
+
+/* y4mdec pulls from a filesrc, the harness only answers for downstream */
+static GstHarness *
+start_y4mdec (const gchar * filename, gboolean video_meta)
+{
+  GstHarness *h;
+  gchar *desc;
+
+  desc = g_strdup_printf ("filesrc location=%s ! y4mdec", filename);
+  h = gst_harness_new_parse (desc);
+  g_free (desc);
+
+  if (video_meta)
+    gst_harness_add_propose_allocation_meta (h, GST_VIDEO_META_API_TYPE, NULL);
+  gst_harness_play (h);
+
+  return h;
+}
+
+static GstEvent *
+pull_event (GstHarness * h, GstEventType type)
+{
+  GstEvent *event = gst_harness_pull_event (h);
+
+  fail_unless (event != NULL);
+  fail_unless_equals_string (GST_EVENT_TYPE_NAME (event),
+      gst_event_type_get_name (type));
+
+  return event;
+}
+
+static void
+check_segment (GstHarness * h, GstClockTime start, GstClockTime stop,
+    GstClockTime base, guint32 seqnum)
+{
+  GstEvent *event = pull_event (h, GST_EVENT_SEGMENT);
+  const GstSegment *segment;
+
+  gst_event_parse_segment (event, &segment);
+  fail_unless_equals_int (segment->format, GST_FORMAT_TIME);
+  fail_unless_equals_uint64 (segment->start, start);
+  fail_unless_equals_uint64 (segment->stop, stop);
+  fail_unless_equals_uint64 (segment->time, start);
+  fail_unless_equals_uint64 (segment->base, base);
+  if (seqnum != GST_SEQNUM_INVALID)
+    fail_unless_equals_int (gst_event_get_seqnum (event), seqnum);
+  gst_event_unref (event);
+}
+
+static void
+check_eos (GstHarness * h, guint32 seqnum)
+{
+  GstEvent *event = pull_event (h, GST_EVENT_EOS);
+
+  if (seqnum != GST_SEQNUM_INVALID)
+    fail_unless_equals_int (gst_event_get_seqnum (event), seqnum);
+  gst_event_unref (event);
+}
+
+/* Pulls frames @first to @last - 1 and checks their timestamps and that they
+ * hold the packed frame data, either as is or copied to the default strides */
+static void
+check_frames (GstHarness * h, guint first, guint last, gboolean video_meta)
+{
+  GstVideoInfo info;
+  guint frame;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, WIDTH, HEIGHT);
+  fail_if (GST_VIDEO_INFO_SIZE (&info) == FRAME_SIZE);
+
+  for (frame = first; frame < last; frame++) {
+    GstBuffer *buffer = gst_harness_pull (h);
+    GstVideoMeta *meta;
+    GstMapInfo map;
+
+    fail_unless (buffer != NULL);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), FRAME_TIME (frame));
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (buffer),
+        FRAME_TIME (frame + 1) - FRAME_TIME (frame));
+
+    meta = gst_buffer_get_video_meta (buffer);
+    if (video_meta) {
+      guint i;
+
+      /* the frame is passed on in the file layout */
+      fail_unless (meta != NULL);
+      fail_unless_equals_int (meta->stride[0], WIDTH);
+      fail_unless_equals_int (meta->stride[1], WIDTH / 2);
+      fail_unless_equals_int (meta->stride[2], WIDTH / 2);
+      fail_unless_equals_int (meta->offset[1], WIDTH * HEIGHT);
+
+      fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+      fail_unless_equals_int (map.size, FRAME_SIZE);
+      for (i = 0; i < FRAME_SIZE; i++)
+        fail_unless_equals_int (map.data[i], frame_sample (frame, i));
+      gst_buffer_unmap (buffer, &map);
+    } else {
+      GstVideoFrame vframe;
+      guint comp, x, y, i = 0;
+
+      /* the frame is copied to the default layout */
+      fail_unless (meta == NULL);
+      fail_unless_equals_int (gst_buffer_get_size (buffer),
+          GST_VIDEO_INFO_SIZE (&info));
+
+      fail_unless (gst_video_frame_map (&vframe, &info, buffer, GST_MAP_READ));
+      for (comp = 0; comp < 3; comp++) {
+        for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&vframe, comp); y++) {
+          const guint8 *line = GST_VIDEO_FRAME_COMP_DATA (&vframe, comp) +
+              y * GST_VIDEO_FRAME_COMP_STRIDE (&vframe, comp);
+
+          for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&vframe, comp); x++)
+            fail_unless_equals_int (line[x], frame_sample (frame, i++));
+        }
+      }
+      fail_unless_equals_int (i, FRAME_SIZE);
+      gst_video_frame_unmap (&vframe);
+    }
+
+    gst_buffer_unref (buffer);
+  }
+}
+
+GST_START_TEST (test_pull_mode)
+{
+  gboolean video_meta = __i__;
+  GstHarness *h;
+  GstEvent *event;
+  gchar *filename;
+  guint group_id;
+
+  filename = create_y4m_file ();
+  h = start_y4mdec (filename, video_meta);
+
+  /* the stream is started before the caps and the segment */
+  event = pull_event (h, GST_EVENT_STREAM_START);
+  fail_unless (gst_event_parse_group_id (event, &group_id));
+  gst_event_unref (event);
+  gst_event_unref (pull_event (h, GST_EVENT_CAPS));
+  check_segment (h, 0, GST_CLOCK_TIME_NONE, 0, GST_SEQNUM_INVALID);
+
+  check_frames (h, 0, N_FRAMES, video_meta);
+  check_eos (h, GST_SEQNUM_INVALID);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pull_mode_seek)
+{
+  GstHarness *h;
+  GstEvent *event;
+  gchar *filename;
+  guint32 seqnum;
+
+  filename = create_y4m_file ();
+  h = start_y4mdec (filename, TRUE);
+
+  gst_event_unref (pull_event (h, GST_EVENT_STREAM_START));
+  gst_event_unref (pull_event (h, GST_EVENT_CAPS));
+  check_segment (h, 0, GST_CLOCK_TIME_NONE, 0, GST_SEQNUM_INVALID);
+  check_frames (h, 0, N_FRAMES, TRUE);
+  check_eos (h, GST_SEQNUM_INVALID);
+
+  /* a flushing seek stops after the frame the stop position falls in */
+  event = gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+      GST_SEEK_TYPE_SET, FRAME_TIME (3), GST_SEEK_TYPE_SET,
+      FRAME_TIME (5) + GST_MSECOND);
+  seqnum = gst_event_get_seqnum (event);
+  fail_unless (gst_harness_push_upstream_event (h, event));
+
+  event = pull_event (h, GST_EVENT_FLUSH_START);
+  fail_unless_equals_int (gst_event_get_seqnum (event), seqnum);
+  gst_event_unref (event);
+  event = pull_event (h, GST_EVENT_FLUSH_STOP);
+  fail_unless_equals_int (gst_event_get_seqnum (event), seqnum);
+  gst_event_unref (event);
+  check_segment (h, FRAME_TIME (3), FRAME_TIME (6), 0, seqnum);
+  check_frames (h, 3, 6, TRUE);
+  check_eos (h, seqnum);
+
+  /* a non-flushing seek continues the running time where the previous
+   * segment stopped */
+  event = gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_NONE,
+      GST_SEEK_TYPE_SET, FRAME_TIME (7), GST_SEEK_TYPE_SET,
+      GST_CLOCK_TIME_NONE);
+  seqnum = gst_event_get_seqnum (event);
+  fail_unless (gst_harness_push_upstream_event (h, event));
+
+  check_segment (h, FRAME_TIME (7), GST_CLOCK_TIME_NONE,
+      FRAME_TIME (6) - FRAME_TIME (3), seqnum);
+  check_frames (h, 7, N_FRAMES, TRUE);
+  check_eos (h, seqnum);
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+  fail_unless_equals_int (gst_harness_events_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+static Suite *
+y4mdec_suite (void)
+{
+  Suite *s = suite_create ("y4mdec");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  /* without and with GstVideoMeta support downstream */
+  tcase_add_loop_test (tc_chain, test_pull_mode, 0, 2);
+  tcase_add_test (tc_chain, test_pull_mode_seek);
+
+  return s;
+}
+
+GST_CHECK_MAIN (y4mdec);
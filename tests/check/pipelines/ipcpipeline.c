@@ -5804,6 +5804,235 @@ GST_START_TEST (test_wavparse_master_process_crash)
 
 GST_END_TEST;
 
+/**** shm payload reconnect test ****/
+
+#define SHM_RECONNECT_N_BUFFERS 20
+
+static void
+shm_reconnect_handoff (GstElement * fakesink, GstBuffer * buf, GstPad * pad,
+    gpointer user_data)
+{
+  gint *n_buffers = user_data;
+
+  g_atomic_int_inc (n_buffers);
+}
+
+static GstElement *
+create_shm_reconnect_slave (int fd, gint * n_buffers)
+{
+  GstElement *pipeline, *ipcpipelinesrc, *fakesink;
+
+  pipeline = create_pipeline ("ipcslavepipeline");
+  ipcpipelinesrc = gst_element_factory_make ("ipcpipelinesrc", NULL);
+  g_object_set (ipcpipelinesrc, "fdin", fd, "fdout", fd, NULL);
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (fakesink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (fakesink, "handoff", G_CALLBACK (shm_reconnect_handoff),
+      n_buffers);
+  gst_bin_add_many (GST_BIN (pipeline), ipcpipelinesrc, fakesink, NULL);
+  FAIL_UNLESS (gst_element_link (ipcpipelinesrc, fakesink));
+
+  return pipeline;
+}
+
+static void
+run_shm_reconnect_master (GstElement * master)
+{
+  GstMessage *msg;
+  GstStateChangeReturn ret;
+
+  ret = gst_element_set_state (master, GST_STATE_PLAYING);
+  FAIL_IF (ret == GST_STATE_CHANGE_FAILURE);
+
+  /* well below ack-time, so a sender waiting on segments the previous
+   * peer never released would make this time out */
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (master), 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  FAIL_UNLESS (msg);
+  FAIL_UNLESS_EQUALS_INT (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  ret = gst_element_set_state (master, GST_STATE_NULL);
+  FAIL_UNLESS (ret == GST_STATE_CHANGE_SUCCESS);
+}
+
+GST_START_TEST (test_shm_payload_reconnect)
+{
+  GstElement *master, *ipcpipelinesink, *slave;
+  gint n_buffers = 0;
+  int sv[2];
+
+  master = gst_parse_launch ("fakesrc num-buffers="
+      G_STRINGIFY (SHM_RECONNECT_N_BUFFERS) " sizetype=fixed sizemax=8192 "
+      "filltype=pattern ! ipcpipelinesink name=sink shm-payload=true",
+      NULL);
+  FAIL_UNLESS (master);
+  ipcpipelinesink = gst_bin_get_by_name (GST_BIN (master), "sink");
+
+  /* first peer */
+  FAIL_IF (socketpair (PF_UNIX, SOCK_STREAM, 0, sv) < 0);
+  g_object_set (ipcpipelinesink, "fdin", sv[0], "fdout", sv[0], NULL);
+  slave = create_shm_reconnect_slave (sv[1], &n_buffers);
+  run_shm_reconnect_master (master);
+  FAIL_UNLESS_EQUALS_INT (g_atomic_int_get (&n_buffers),
+      SHM_RECONNECT_N_BUFFERS);
+  gst_object_unref (slave);
+  close (sv[0]);
+  close (sv[1]);
+
+  /* a new peer knows none of the segments the first one mapped */
+  g_atomic_int_set (&n_buffers, 0);
+  FAIL_IF (socketpair (PF_UNIX, SOCK_STREAM, 0, sv) < 0);
+  g_object_set (ipcpipelinesink, "fdin", sv[0], "fdout", sv[0], NULL);
+  slave = create_shm_reconnect_slave (sv[1], &n_buffers);
+  run_shm_reconnect_master (master);
+  FAIL_UNLESS_EQUALS_INT (g_atomic_int_get (&n_buffers),
+      SHM_RECONNECT_N_BUFFERS);
+
+  g_signal_emit_by_name (ipcpipelinesink, "disconnect", NULL);
+  gst_object_unref (ipcpipelinesink);
+  gst_object_unref (master);
+  gst_object_unref (slave);
+  close (sv[0]);
+  close (sv[1]);
+}
+
+GST_END_TEST;
+
+/**** shm payload allocator test ****/
+
+#define SHM_ALLOCATOR_N_BUFFERS 10
+#define SHM_ALLOCATOR_BUFFER_SIZE 8192
+
+typedef struct
+{
+  GMutex lock;
+  GstAllocator *allocator;
+  GPtrArray *memories;
+  gint n_received;
+  gboolean shared;
+} ShmAllocatorData;
+
+/* Replaces the data of each buffer with memory from the allocator the sink
+ * proposes */
+static void
+shm_allocator_src_handoff (GstElement * fakesrc, GstBuffer * buf, GstPad * pad,
+    gpointer user_data)
+{
+  ShmAllocatorData *data = user_data;
+  GstMemory *mem;
+  GstMapInfo map;
+
+  g_mutex_lock (&data->lock);
+  if (!data->allocator) {
+    GstQuery *query = gst_query_new_allocation (NULL, FALSE);
+
+    FAIL_UNLESS (gst_pad_peer_query (pad, query));
+    FAIL_UNLESS (gst_query_get_n_allocation_params (query) > 0);
+    gst_query_parse_nth_allocation_param (query, 0, &data->allocator, NULL);
+    FAIL_UNLESS (data->allocator);
+    gst_query_unref (query);
+  }
+
+  mem = gst_allocator_alloc (data->allocator, SHM_ALLOCATOR_BUFFER_SIZE, NULL);
+  FAIL_UNLESS (mem);
+  FAIL_UNLESS (gst_memory_map (mem, &map, GST_MAP_WRITE));
+  memset (map.data, data->memories->len, map.size);
+  gst_memory_unmap (mem, &map);
+
+  gst_buffer_replace_all_memory (buf, gst_memory_ref (mem));
+  g_ptr_array_add (data->memories, mem);
+  g_mutex_unlock (&data->lock);
+}
+
+static void
+shm_allocator_sink_handoff (GstElement * fakesink, GstBuffer * buf,
+    GstPad * pad, gpointer user_data)
+{
+  ShmAllocatorData *data = user_data;
+  GstMemory *mem;
+  GstMapInfo map;
+  gsize i;
+
+  g_mutex_lock (&data->lock);
+  FAIL_UNLESS (gst_buffer_map (buf, &map, GST_MAP_READ));
+  FAIL_UNLESS_EQUALS_INT (map.size, SHM_ALLOCATOR_BUFFER_SIZE);
+  for (i = 0; i < map.size; i++)
+    FAIL_UNLESS_EQUALS_INT (map.data[i], data->n_received);
+  gst_buffer_unmap (buf, &map);
+
+  /* the sender keeps the memory it passed locked while we use it, it
+   * would be writable if its data had been copied */
+  mem = g_ptr_array_index (data->memories, data->n_received);
+  if (gst_memory_is_writable (mem))
+    data->shared = FALSE;
+  data->n_received++;
+  g_mutex_unlock (&data->lock);
+}
+
+GST_START_TEST (test_shm_payload_allocator)
+{
+  GstElement *master, *slave, *ipcpipelinesink, *fakesrc, *ipcpipelinesrc,
+      *fakesink;
+  ShmAllocatorData data = { 0, };
+  guint i;
+  int sv[2];
+
+  g_mutex_init (&data.lock);
+  data.memories = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_memory_unref);
+  data.shared = TRUE;
+
+  master = gst_parse_launch ("fakesrc name=src num-buffers="
+      G_STRINGIFY (SHM_ALLOCATOR_N_BUFFERS) " sizetype=fixed sizemax=16 "
+      "signal-handoffs=true ! ipcpipelinesink name=sink shm-payload=true",
+      NULL);
+  FAIL_UNLESS (master);
+  fakesrc = gst_bin_get_by_name (GST_BIN (master), "src");
+  g_signal_connect (fakesrc, "handoff",
+      G_CALLBACK (shm_allocator_src_handoff), &data);
+  gst_object_unref (fakesrc);
+  ipcpipelinesink = gst_bin_get_by_name (GST_BIN (master), "sink");
+
+  FAIL_IF (socketpair (PF_UNIX, SOCK_STREAM, 0, sv) < 0);
+  g_object_set (ipcpipelinesink, "fdin", sv[0], "fdout", sv[0], NULL);
+
+  slave = create_pipeline ("ipcslavepipeline");
+  ipcpipelinesrc = gst_element_factory_make ("ipcpipelinesrc", NULL);
+  g_object_set (ipcpipelinesrc, "fdin", sv[1], "fdout", sv[1], NULL);
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (fakesink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (fakesink, "handoff",
+      G_CALLBACK (shm_allocator_sink_handoff), &data);
+  gst_bin_add_many (GST_BIN (slave), ipcpipelinesrc, fakesink, NULL);
+  FAIL_UNLESS (gst_element_link (ipcpipelinesrc, fakesink));
+
+  run_shm_reconnect_master (master);
+  g_signal_emit_by_name (ipcpipelinesink, "disconnect", NULL);
+
+  FAIL_UNLESS_EQUALS_INT (data.n_received, SHM_ALLOCATOR_N_BUFFERS);
+  FAIL_UNLESS (data.shared);
+
+  /* nothing holds on the memories anymore */
+  for (i = 0; i < data.memories->len; i++) {
+    GstMemory *mem = g_ptr_array_index (data.memories, i);
+
+    FAIL_UNLESS (gst_memory_is_writable (mem));
+    FAIL_UNLESS_EQUALS_INT (GST_MINI_OBJECT_REFCOUNT_VALUE (mem), 1);
+  }
+
+  gst_object_unref (ipcpipelinesink);
+  gst_object_unref (master);
+  gst_object_unref (slave);
+  g_ptr_array_unref (data.memories);
+  gst_object_unref (data.allocator);
+  g_mutex_clear (&data.lock);
+  close (sv[0]);
+  close (sv[1]);
+}
+
+GST_END_TEST;
+
 static Suite *
 ipcpipeline_suite (void)
 {
@@ -6061,6 +6290,14 @@ ipcpipeline_suite (void)
      with the master pipeline. */
   tcase_add_test (tc_chain, test_wavparse_master_process_crash);
 
+  /* shm_payload_reconnect checks that buffers passed through shared
+     memory keep flowing when the sink is connected to a new peer. */
+  tcase_add_test (tc_chain, test_shm_payload_reconnect);
+
+  /* shm_payload_allocator checks that buffers allocated from the allocator
+     ipcpipelinesink proposes are passed without copying their data. */
+  tcase_add_test (tc_chain, test_shm_payload_allocator);
+
   return s;
 }
 